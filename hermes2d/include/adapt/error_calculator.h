@@ -117,6 +117,10 @@ namespace Hermes
       /// Initialize the data storage.
       void init_data_storage();
 
+      /// Estimates the cost of evaluating the error forms on each state (from the orders of the solutions),
+      /// for the scheduling of the states among threads.
+      void estimate_state_costs(Traverse::State** states, unsigned int num_states, double* costs) const;
+
       /// Sums calculation & error postprocessing (make it relative).
       /// Called at the end of error_calculation.
       void postprocess_error();
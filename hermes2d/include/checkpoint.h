@@ -0,0 +1,79 @@
+// This file is part of Hermes2D.
+//
+// Hermes2D is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 2 of the License, or
+// (at your option) any later version.
+//
+// Hermes2D is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with Hermes2D.  If not, see <http://www.gnu.org/licenses/>.
+
+#ifndef __H2D_CHECKPOINT_H
+#define __H2D_CHECKPOINT_H
+
+#include "global.h"
+#include "mesh/mesh.h"
+#include "space/space.h"
+#include "function/solution.h"
+
+namespace Hermes
+{
+  namespace Hermes2D
+  {
+    /// Checkpoint stores a mesh, spaces on it and solutions on these spaces in one binary file
+    /// (Hermes::BinaryIO::BinaryContainer). The file is written by large sequential writes and
+    /// read through a memory mapping, the solution coefficients are not copied when loading.
+    ///
+    /// Typical usage:
+    /// Checkpoint<double>::save("step.h2dc", mesh, spaces, solutions);
+    /// ...
+    /// Checkpoint<double> checkpoint("step.h2dc");
+    /// MeshSharedPtr mesh(new Mesh);
+    /// checkpoint.load_mesh(mesh);
+    /// SpaceSharedPtr<double> space = checkpoint.load_space(0, mesh, &bcs);
+    /// (or std::vector<SpaceSharedPtr<double> > spaces = checkpoint.load_spaces(mesh, { &bcs_0, &bcs_1 }); for systems)
+    /// MeshFunctionSharedPtr<double> sln(new Solution<double>);
+    /// checkpoint.load_solution(0, space, sln);
+    template<typename Scalar>
+    class HERMES_API Checkpoint : public Hermes::Mixins::Loggable
+    {
+    public:
+      /// Opens (maps) a checkpoint file.
+      Checkpoint(const char* filename);
+
+      /// Saves the mesh, the spaces (all on the mesh) and the solutions (Solution instances, on the spaces).
+      static void save(const char* filename, MeshSharedPtr mesh, std::vector<SpaceSharedPtr<Scalar> > spaces, std::vector<MeshFunctionSharedPtr<Scalar> > solutions = std::vector<MeshFunctionSharedPtr<Scalar> >());
+
+      int get_num_spaces() const;
+      int get_num_solutions() const;
+
+      /// Loads the mesh (including refinements).
+      void load_mesh(MeshSharedPtr mesh);
+
+      /// Loads the space 'index' on the (loaded) mesh.
+      /// Not possible for spaces renumbered jointly (see Space::set_dof_renumbering()), these are loaded by load_spaces().
+      SpaceSharedPtr<Scalar> load_space(int index, MeshSharedPtr mesh, EssentialBCs<Scalar>* essential_bcs = nullptr, Shapeset* shapeset = nullptr);
+
+      /// Loads all spaces on the (loaded) mesh, the DOFs are assigned as when saved - also if the spaces were renumbered jointly.
+      /// \param[in] essential_bcs Boundary conditions of the spaces (none if empty).
+      /// \param[in] shapesets Shapesets of the spaces (the default ones if empty).
+      std::vector<SpaceSharedPtr<Scalar> > load_spaces(MeshSharedPtr mesh, std::vector<EssentialBCs<Scalar>*> essential_bcs = std::vector<EssentialBCs<Scalar>*>(), std::vector<Shapeset*> shapesets = std::vector<Shapeset*>());
+
+      /// Loads the solution 'index' on the (loaded) space, 'solution' must be a Solution instance.
+      /// The solution keeps the file mapped.
+      void load_solution(int index, SpaceSharedPtr<Scalar> space, MeshFunctionSharedPtr<Scalar> solution);
+
+    private:
+      BinaryContainerSharedPtr container;
+
+      /// Version, number of spaces, number of solutions, complexness.
+      int* info;
+    };
+  }
+}
+#endif
@@ -31,6 +31,43 @@ namespace Hermes
 {
   namespace Hermes2D
   {
+    /// \brief Precomputed DG interfaces of the states of a traversal plan - the NeighborSearches (neighbors, transformations,
+    /// orientations) of the inner edges after the multi-mesh consolidation (MultimeshDGNeighborTree::process_edge).
+    /// The list is valid for one TraversalPlan (i.e. as long as the meshes do not change), the interfaces are built on their first use.
+    template<typename Scalar>
+    class HERMES_API DGInterfaceList
+    {
+    public:
+      DGInterfaceList(TraversalPlanSharedPtr traversal_plan, const std::vector<SpaceSharedPtr<Scalar> >& spaces);
+      ~DGInterfaceList();
+
+      /// The list was created for this plan and spaces of these types.
+      bool is_valid_for(TraversalPlanSharedPtr traversal_plan, const std::vector<SpaceSharedPtr<Scalar> >& spaces) const;
+
+      /// One edge of a state.
+      struct Interface
+      {
+        /// One per mesh, the meshes with the same element share the instance.
+        NeighborSearch<Scalar>** neighbor_searches;
+        /// Number of the (consolidated) neighbors, 0 if the edge is not a DG one.
+        unsigned int num_neighbors;
+      };
+
+      /// The interface of the edge isurf (not a boundary one) of the state, built on the first call.
+      /// Not thread-safe, called in the critical section of DiscreteProblemDGAssembler::assemble_one_state().
+      Interface* get(Traverse::State* state, unsigned char isurf, const std::vector<MeshSharedPtr>& meshes);
+
+    private:
+      TraversalPlanSharedPtr traversal_plan;
+      std::vector<SpaceSharedPtr<Scalar> > spaces;
+      std::vector<SpaceType> space_types;
+
+      /// Interfaces of the state i are at [i * H2D_MAX_NUMBER_EDGES, (i + 1) * H2D_MAX_NUMBER_EDGES), nullptr if not built yet.
+      Interface** interfaces;
+      unsigned int num_interfaces;
+      unsigned short num;
+    };
+
     /// Discrete problem DG assembling class.
     ///
     /// This class provides methods for assembling DG forms (forms evaluated on internal edges) into external matrix / vector structures.
@@ -40,7 +77,7 @@ namespace Hermes
     {
     public:
       /// Constructor copying data from DiscreteProblemThreadAssembler.
-      DiscreteProblemDGAssembler(DiscreteProblemThreadAssembler<Scalar>* threadAssembler, const std::vector<SpaceSharedPtr<Scalar> > spaces, std::vector<MeshSharedPtr>& meshes);
+      DiscreteProblemDGAssembler(DiscreteProblemThreadAssembler<Scalar>* threadAssembler, const std::vector<SpaceSharedPtr<Scalar> > spaces, std::vector<MeshSharedPtr>& meshes, DGInterfaceList<Scalar>* interface_list);
 
       /// Destructor.
       ~DiscreteProblemDGAssembler();
@@ -71,15 +108,18 @@ namespace Hermes
       DiscontinuousFunc<Scalar>** init_ext_fns(std::vector<MeshFunctionSharedPtr<Scalar> > ext,
         NeighborSearch<Scalar>** neighbor_searches, int order);
 
-      /// Initialize neighbors.
-      bool init_neighbors(NeighborSearch<Scalar>** neighbor_searches, Traverse::State* current_state);
-      /// Deinitialize neighbors.
-      void deinit_neighbors(NeighborSearch<Scalar>** neighbor_searches, Traverse::State* current_state);
-
-      NeighborSearch<Scalar>*** neighbor_searches;
-      unsigned int* num_neighbors;
+      /// Precomputed interfaces (shared by the threads).
+      DGInterfaceList<Scalar>* interface_list;
+      /// Interfaces of the edges of the current state (nullptr for the boundary ones).
+      typename DGInterfaceList<Scalar>::Interface** interfaces;
       bool** processed;
 
+      /// Scratch memory of this thread, reset after each state.
+      MemoryArena* arena;
+
+      /// Extended shapesets (one per space), reused for all neighbors.
+      typename NeighborSearch<Scalar>::ExtendedShapeset* ext_asmlist[H2D_MAX_COMPONENTS];
+
       // Neighbor psss, refmaps.
       PrecalcShapesetAssembling ** npss;
       RefMap ** nrefmaps;
@@ -106,6 +146,7 @@ namespace Hermes
 
       template<typename T> friend class DiscreteProblem;
       template<typename T> friend class DiscreteProblemIntegrationOrderCalculator;
+      template<typename T> friend class DGInterfaceList;
 
       /// Finds the correct NeighborSearch.
       static NeighborSearch<Scalar>* get_neighbor_search_ext(WeakFormSharedPtr<Scalar> wf, NeighborSearch<Scalar>** neighbor_searches, int index);
@@ -33,6 +33,13 @@ namespace Hermes
       /// The main method, for the passed neighbor searches, it will process all multi-mesh neighbor consolidation.
       static void process_edge(NeighborSearch<Scalar>** neighbor_searches, unsigned char num_neighbor_searches, unsigned int& num_neighbors, bool*& processed);
 
+      /// Version of process_edge() that does not determine the processed neighbors (only depends on the meshes).
+      static void process_edge(NeighborSearch<Scalar>** neighbor_searches, unsigned char num_neighbor_searches, unsigned int& num_neighbors);
+
+      /// Determines the neighbors (segments of the edge) already processed when the neighbor element was assembled.
+      /// \param[out] processed Array of num_neighbors items.
+      static void set_processed(NeighborSearch<Scalar>** neighbor_searches, unsigned char num_neighbor_searches, unsigned int num_neighbors, bool* processed);
+
     private:
       /// Initialize the tree for traversing multimesh neighbors.
       static void build_multimesh_tree(MultimeshDGNeighborTreeNode* root, NeighborSearch<Scalar>** neighbor_searches, int number);
@@ -29,6 +29,7 @@ namespace Hermes
   namespace Hermes2D
   {
     class PrecalcShapeset;
+    template<typename Scalar> class DGInterfaceList;
     /// Discrete problem class.
     ///
     /// This class does assembling into external matrix / vector structures.
@@ -97,6 +98,11 @@ namespace Hermes
       /// Get all spaces as a std::vector.
       std::vector<SpaceSharedPtr<Scalar> > get_spaces();
 
+      /// Evaluate the previous iterations of nonlinear problems directly from the coefficient vector as linear combinations of the
+      /// precalculated basis functions, instead of through Solutions (monomial expansion, a copy in each thread).
+      /// Used where possible (not with DG forms and vector-valued spaces), on by default.
+      void set_u_ext_from_coefficients(bool to_set);
+
       /// Experimental.
       typedef void(*reassembled_states_reuse_linear_system_fn)(Traverse::State**& states, unsigned int& num_states, SparseMatrix<Scalar>* mat, Vector<Scalar>* rhs, Vector<Scalar>* dirichlet_lift_rhs, Scalar*& coeff_vec);
       void set_reassembled_states_reuse_linear_system_fn(reassembled_states_reuse_linear_system_fn fn) {
@@ -120,6 +126,16 @@ namespace Hermes
       void init_assembling(Traverse::State**& states, unsigned int& num_states, std::vector<MeshSharedPtr>& meshes);
       void deinit_assembling(Traverse::State** states, unsigned  int num_states);
 
+      /// The traversal plan of the current assembling, owns the states.
+      TraversalPlanSharedPtr traversal_plan;
+
+      /// DG interfaces of the states, kept between assemblings as long as the traversal plan does not change.
+      DGInterfaceList<Scalar>* dg_interface_list;
+
+      /// Estimates the assembling cost of each state (basis functions and integration points over all volumetric forms)
+      /// for the scheduling of the states among threads.
+      void estimate_state_costs(Traverse::State** states, unsigned int num_states, double* costs) const;
+
       /// RungeKutta helpers.
       void set_RK(int original_spaces_count, bool force_diagonal_blocks = nullptr, Table* block_weights = nullptr);
 
@@ -130,6 +146,10 @@ namespace Hermes
       /// Init function. Common code for the constructors.
       void init(bool linear, bool dirichlet_lift_accordingly, bool use_direct_for_Dirichlet_lift);
 
+      /// Whether the previous iterations can be evaluated from the coefficient vector in the current setting (see set_u_ext_from_coefficients()).
+      bool u_ext_from_coefficients_possible() const;
+      bool u_ext_from_coefficients;
+
       /// Space instances for all equations in the system.
       std::vector<SpaceSharedPtr<Scalar> > spaces;
       int spaces_size;
@@ -54,8 +54,20 @@ namespace Hermes
       int calc_order_vector_form(const std::vector<SpaceSharedPtr<Scalar> >& spaces, VectorFormType* vf, RefMap** current_refmaps, Func<Hermes::Ord>** ext, Func<Hermes::Ord>** u_ext);
 
       /// Order calculation.
+      /// Memoized in integration_order_cache by the order signature of the current state.
       int calculate_order(const std::vector<SpaceSharedPtr<Scalar> >& spaces, RefMap** current_refmaps, WeakFormSharedPtr<Scalar> current_wf);
 
+      /// Order calculation - evaluation of ord() of all forms.
+      int calculate_order_forms(const std::vector<SpaceSharedPtr<Scalar> >& spaces, RefMap** current_refmaps, WeakFormSharedPtr<Scalar> current_wf);
+
+      /// Fills order_signature with everything the order calculated by calculate_order_forms() depends on:
+      /// element mode, (element and edge) orders of spaces, orders of reference maps, orders of previous iterations and external functions,
+      /// and the forms to be assembled on the element and its boundary edges.
+      void calculate_order_signature(const std::vector<SpaceSharedPtr<Scalar> >& spaces, RefMap** current_refmaps, WeakFormSharedPtr<Scalar> current_wf);
+
+      /// Helper for calculate_order_signature() - appends orders of external functions.
+      void add_ext_orders_to_signature(std::vector<MeshFunctionSharedPtr<Scalar> >& ext, bool surface);
+
       /// \ingroup Helper methods inside {calc_order_*, assemble_*}
       /// Calculates orders for previous nonlinear iterations.
       Func<Hermes::Ord>** init_u_ext_orders();
@@ -92,10 +104,20 @@ namespace Hermes
 
       /// For initialization of external functions.
       Solution<Scalar>** u_ext;
+      /// Orders of the previous iterations if these are evaluated directly from the coefficient vector (u_ext is then nullptr), -1 without an element.
+      int* u_ext_element_orders;
       Func<Hermes::Ord>** ext_orders;
       Func<Hermes::Ord>** u_ext_orders;
       Traverse::State* current_state;
 
+      /// Order signature of the current state (see calculate_order_signature()).
+      std::vector<int> order_signature;
+
+      /// Integration orders calculated by this (thread's) calculator, keyed by the order signature.
+      /// Valid for the WeakForm::integration_order_seq integration_order_cache_seq, kept across assemblings.
+      std::map<std::vector<int>, int> integration_order_cache;
+      unsigned int integration_order_cache_seq;
+
       template<typename T> friend class DiscreteProblem;
       template<typename T> friend class DiscreteProblemThreadAssembler;
     };
@@ -49,10 +49,12 @@ namespace Hermes
       /// Initialization of the weak formulation.
       void set_weak_formulation(WeakFormSharedPtr<Scalar> wf);
       /// Initialization of previous iterations for non-linear solvers.
-      void init_u_ext(const std::vector<SpaceSharedPtr<Scalar> > spaces, Solution<Scalar>** u_ext_sln);
+      /// \param[in] u_ext_coeff_vec If not nullptr, the previous iterations are evaluated directly from this vector (u_ext_sln is not used).
+      /// \param[in] u_ext_add_dir_lift Whether to add the Dirichlet lift to the previous iterations evaluated from u_ext_coeff_vec.
+      void init_u_ext(const std::vector<SpaceSharedPtr<Scalar> > spaces, Solution<Scalar>** u_ext_sln, const Scalar* u_ext_coeff_vec = nullptr, bool u_ext_add_dir_lift = true);
 
       /// Initializes the Transformable array for doing transformations.
-      void init_assembling(Solution<Scalar>** u_ext_sln, const std::vector<SpaceSharedPtr<Scalar> >& spaces, bool add_dirichlet_lift);
+      void init_assembling(Solution<Scalar>** u_ext_sln, const std::vector<SpaceSharedPtr<Scalar> >& spaces, bool add_dirichlet_lift, const Scalar* u_ext_coeff_vec = nullptr, bool u_ext_add_dir_lift = true);
 
       /// Initialize Func storages.
       void init_funcs_wf();
@@ -60,6 +62,10 @@ namespace Hermes
       /// Func Memory Pool
       pj_pool_t *FuncMemoryPool;
       void init_funcs_memory_pool();
+      /// Storage of the values of all Funcs below, packed & sized to the current integration order, reset in each state.
+      MemoryArena FuncValuesArena;
+      /// Scratch memory of the DG assembling (DiscreteProblemDGAssembler) in this thread.
+      MemoryArena DGMemoryArena;
 
       /// De-initialize Func storages.
       void deinit_funcs();
@@ -69,7 +75,10 @@ namespace Hermes
       void deinit_funcs_wf();
       bool funcs_wf_initialized;
       /// Initializitation of u-ext values into Funcs
-      void init_u_ext_values(int order);
+      /// \param[in] isurf The edge for surface forms, -1 for volumetric forms.
+      void init_u_ext_values(int order, int isurf = -1);
+      /// Initializitation of u-ext values into Funcs as the linear combination of the basis functions with the coefficients from u_ext_coeff_vec.
+      void init_u_ext_values_from_coefficients(int order, int isurf);
       /// Initializitation of ext values into Funcs
       template<typename Geom>
       void init_ext_values(Func<Scalar>** target_array, std::vector<MeshFunctionSharedPtr<Scalar> >& ext, std::vector<UExtFunctionSharedPtr<Scalar> >& u_ext_fns, int order, Func<Scalar>** u_ext_func, Geom* geometry);
@@ -82,6 +91,13 @@ namespace Hermes
       template<typename MatrixFormType, typename Geom>
       void assemble_matrix_form(MatrixFormType* form, int order, Func<double>** base_fns, Func<double>** test_fns,
         AsmList<Scalar>* current_als_i, AsmList<Scalar>* current_als_j, int n_quadrature_points, Geom* geometry, double* jacobian_x_weights);
+      /// Matrix volumetric forms - batched evaluation of the form for all basis & test functions into local_form_values.
+      /// \return False if the form does not provide the batched evaluation (MatrixFormVol::value_block).
+      bool evaluate_matrix_form_block(MatrixFormVol<Scalar>* form, int n_quadrature_points, double* jacobian_x_weights, Func<Scalar>** u_ext_local,
+        Func<double>** base_fns, unsigned short base_fns_count, Func<double>** test_fns, unsigned short test_fns_count, GeomVol<double>* geometry, Func<Scalar>** ext_local);
+      /// Matrix surface forms - batched evaluation is not available, always returns false.
+      bool evaluate_matrix_form_block(MatrixFormSurf<Scalar>* form, int n_quadrature_points, double* jacobian_x_weights, Func<Scalar>** u_ext_local,
+        Func<double>** base_fns, unsigned short base_fns_count, Func<double>** test_fns, unsigned short test_fns_count, GeomSurf<double>* geometry, Func<Scalar>** ext_local);
       /// Vector volumetric forms - assemble the form.
       template<typename VectorFormType, typename Geom>
       void assemble_vector_form(VectorFormType* form, int order, Func<double>** test_fns, AsmList<Scalar>* current_als,
@@ -108,6 +124,15 @@ namespace Hermes
       Solution<Scalar>** u_ext;
       std::vector<Transformable *> fns;
 
+      /// Previous iterations evaluated directly from the coefficient vector (nullptr if by the Solutions u_ext).
+      const Scalar* u_ext_coeff_vec;
+      /// Position of the coefficient of a DOF of each space in u_ext_coeff_vec relative to the DOF number.
+      int u_ext_coeff_offsets[H2D_MAX_COMPONENTS];
+      /// Coefficient of the Dirichlet lift (0 or 1).
+      double u_ext_dir_lift_coeff;
+      /// Orders of the previous iterations on the current state (see DiscreteProblemIntegrationOrderCalculator::u_ext_element_orders).
+      int u_ext_orders[H2D_MAX_COMPONENTS];
+
       /// For selective reassembling.
       DiscreteProblemSelectiveAssembler<Scalar>* selectiveAssembler;
 
@@ -115,6 +140,8 @@ namespace Hermes
       Traverse::State* current_state;
       /// Current local matrix.
       Scalar local_stiffness_matrix[H2D_MAX_LOCAL_BASIS_SIZE * H2D_MAX_LOCAL_BASIS_SIZE * 4];
+      /// Values of the currently assembled form for all (test, basis) function pairs - batched evaluation.
+      Scalar local_form_values[H2D_MAX_LOCAL_BASIS_SIZE * H2D_MAX_LOCAL_BASIS_SIZE];
 
       /// Integration orders for the currently assembled state.
       /// - calculator
@@ -203,45 +203,50 @@ namespace Hermes
 
 #pragma region Func
     /// Calculated function values (from the class Function) on an element for assembling.
-    /// Internal.
+    /// The values are stored in one block sized to the number of integration points and to the number of components:
+    /// val, dx, dy (and laplace with H2D_USE_SECOND_DERIVATIVES) for nc == 1, val0, val1, curl, div for nc == 2.
     template<typename Scalar>
     class HERMES_API Func
     {
-    };
-
-    /// Calculated function values (from the class Function) on an element for assembling.
-    template<>
-    class HERMES_API Func < double >
-    {
     public:
       /// Constructor.
+      /// The storage is allocated (and owned) by this instance when the values are initialized.
       Func();
       /// Constructor.
+      /// The storage is taken from the arena each time the values are initialized, it is therefore valid until the arena is reset.
+      Func(MemoryArena* arena);
+      /// Constructor.
       /** \param[in] num_gip A number of integration points.
       *  \param[in] num_comps A number of components. */
       Func(int np, int nc);
+      ~Func();
+
+      /// Sets the number of integration points and components, and points the values to storage of the corresponding size.
+      /// The owned storage is reused if large enough, the previous values are not preserved.
+      void allocate(int np, int nc);
+
       union
       {
-        double val[H2D_MAX_INTEGRATION_POINTS_COUNT];
-        double val0[H2D_MAX_INTEGRATION_POINTS_COUNT];
+        Scalar* val;
+        Scalar* val0;
       };
 
       union
       {
-        double dx[H2D_MAX_INTEGRATION_POINTS_COUNT];
-        double val1[H2D_MAX_INTEGRATION_POINTS_COUNT];
+        Scalar* dx;
+        Scalar* val1;
       };
 
       union
       {
-        double dy[H2D_MAX_INTEGRATION_POINTS_COUNT];
-        double curl[H2D_MAX_INTEGRATION_POINTS_COUNT];
+        Scalar* dy;
+        Scalar* curl;
       };
 
       union
       {
-        double laplace[H2D_MAX_INTEGRATION_POINTS_COUNT];
-        double div[H2D_MAX_INTEGRATION_POINTS_COUNT];
+        Scalar* laplace;
+        Scalar* div;
       };
 
       /// Number of integration points used by this intance.
@@ -250,54 +255,28 @@ namespace Hermes
       int nc;
       /// Calculate this -= func for each function expations and each integration point.
       /** \param[in] func A function which is added to *this. A number of integratioN points and a number of component has to match. */
-      void subtract(Func<double>* func);
+      void subtract(Func<Scalar>* func);
       /// Subtract version specifying just one attribute.
-      void subtract(double* attribute, double* other_attribute);
+      void subtract(Scalar* attribute, Scalar* other_attribute);
       /// Calculate this += func for each function expations and each integration point.
       /** \param[in] func A function which is added to *this. A number of integratioN points and a number of component has to match. */
-      void add(Func<double>* func);
+      void add(Func<Scalar>* func);
       /// Add version specifying just one attribute.
-      void add(double* attribute, double* other_attribute);
-    };
-
-    /// Calculated function values (from the class Function) on an element for assembling.
-    template<>
-    class HERMES_API Func < std::complex<double> >
-    {
-    public:
-      /// Constructor.
-      Func();
-      /// Constructor.
-      /** \param[in] num_gip A number of integration points.
-      *  \param[in] num_comps A number of components. */
-      Func(int np, int nc);
-
-      std::complex<double> val[H2D_MAX_INTEGRATION_POINTS_COUNT];
-      std::complex<double> val0[H2D_MAX_INTEGRATION_POINTS_COUNT];
-
-      std::complex<double> dx[H2D_MAX_INTEGRATION_POINTS_COUNT];
-      std::complex<double> val1[H2D_MAX_INTEGRATION_POINTS_COUNT];
-
-      std::complex<double> dy[H2D_MAX_INTEGRATION_POINTS_COUNT];
-      std::complex<double> curl[H2D_MAX_INTEGRATION_POINTS_COUNT];
-
-      std::complex<double> laplace[H2D_MAX_INTEGRATION_POINTS_COUNT];
-      std::complex<double> div[H2D_MAX_INTEGRATION_POINTS_COUNT];
+      void add(Scalar* attribute, Scalar* other_attribute);
 
-      /// Number of integration points used by this intance.
-      int np;
-      /// Number of components. Currently accepted values are 1 (H1, L2 space) and 2 (Hcurl, Hdiv space).
-      int nc;
-      /// Calculate this -= func for each function expations and each integration point.
-      /** \param[in] func A function which is added to *this. A number of integratioN points and a number of component has to match. */
-      void subtract(Func<std::complex<double> >* func);
-      /// Subtract version specifying just one attribute.
-      void subtract(std::complex<double> * attribute, std::complex<double> * other_attribute);
-      /// Calculate this += func for each function expations and each integration point.
-      /** \param[in] func A function which is added to *this. A number of integratioN points and a number of component has to match. */
-      void add(Func<std::complex<double> >* func);
-      /// Add version specifying just one attribute.
-      void add(std::complex<double> * attribute, std::complex<double> * other_attribute);
+    private:
+      /// Not copyable - the storage is owned (freed in the destructor), the value pointers point into it.
+      Func(const Func<Scalar>& other);
+      Func<Scalar>& operator=(const Func<Scalar>& other);
+
+      /// Number of the value arrays stored for nc components.
+      static int get_array_count(int nc);
+
+      /// Where the storage comes from (nullptr - owned).
+      MemoryArena* arena;
+      /// Owned storage & its size.
+      Scalar* storage;
+      int storage_size;
     };
 
     template<>
@@ -365,6 +344,11 @@ namespace Hermes
       ///
       DiscontinuousFunc(Func<T>* fn_c, Func<T>* fn_n, bool reverse = false);
 
+      /// Versions of the constructors with all the memory (the instance, the reversed neighbor values) taken from the arena.
+      /// Such instances are not to be deleted (nor the passed components, which should also come from the arena).
+      static DiscontinuousFunc<T>* create(MemoryArena* arena, Func<T>* fn, bool support_on_neighbor, bool reverse = false);
+      static DiscontinuousFunc<T>* create(MemoryArena* arena, Func<T>* fn_c, Func<T>* fn_n, bool reverse = false);
+
       virtual ~DiscontinuousFunc();
       void free();
 
@@ -376,6 +360,10 @@ namespace Hermes
       ///< (when retrieving values on an edge that is oriented differently in both elements).
       /// Zero value used for the zero-extension.
       static T zero;
+
+    private:
+      /// Used by create() - stores the reversed neighbor values in the arena.
+      void reverse_neighbor_values(MemoryArena* arena);
     };
 
     template<>
@@ -425,8 +413,9 @@ namespace Hermes
     HERMES_API Func<Scalar>* init_fn(MeshFunction<Scalar>* fu, const int order);
 
     /// Preallocate the Func (all we need is np & nc).
+    /// \param[in] arena If not nullptr, the values storage is taken from there, see Func::Func(MemoryArena*).
     template<typename Scalar>
-    HERMES_API Func<Scalar>* preallocate_fn(pj_pool_t* memoryPool = nullptr);
+    HERMES_API Func<Scalar>* preallocate_fn(pj_pool_t* memoryPool = nullptr, MemoryArena* arena = nullptr);
 
     /// Init the shape function for the evaluation of the volumetric/surface integral (transformation of values) - preallocated version.
     HERMES_API void init_fn_preallocated(Func<double>* u, PrecalcShapeset *fu, RefMap *rm, const int order);
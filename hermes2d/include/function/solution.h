@@ -106,6 +106,13 @@ namespace Hermes
       void load_bson(const char* filename, SpaceSharedPtr<Scalar> space);
 #endif
 
+      /// Adds the solution arrays to a binary container (see Checkpoint), the array names start with 'prefix'.
+      /// The coefficients are not copied, the solution must not change before the container is written.
+      void save_binary(BinaryIO::BinaryContainerWriter& writer, const char* prefix) const;
+      /// Loads the solution from a binary container. The monomial coefficients are not copied,
+      /// they are a view into the (copy-on-write) mapping of the file, which is kept alive by this solution.
+      void load_binary(BinaryContainerSharedPtr container, const char* prefix, SpaceSharedPtr<Scalar> space);
+
       /// Returns solution value or derivatives at element e, in its reference domain point (xi1, xi2).
       /// 'item' controls the returned value: 0 = value, 1 = dx, 2 = dy, 3 = dxx, 4 = dyy, 5 = dxy.
       /// NOTE: This function should be used for postprocessing only, it is not effective
@@ -194,8 +201,21 @@ namespace Hermes
 
       double** calc_mono_matrix(int mode, unsigned char o);
 
+      /// Monomial coefficients of the shape function 'index' in the Chebyshev points of the order 'o'.
+      /// Calculated once per shapeset (see Shapeset::MonomialTable), thread-safe - the rows are published only once complete.
+      static const double* get_shape_mono_coeffs(Shapeset* shapeset, int index, unsigned char o, unsigned short component, ElementMode2D mode);
+
+      /// mono += coef * (monomial coefficients of the shape function 'index'), also for constrained edge functions.
+      static void add_shape_mono_coeffs(Shapeset* shapeset, int index, Scalar coef, unsigned char o, unsigned short component, ElementMode2D mode, Scalar* mono, unsigned char np);
+
       void init_dxdy_buffer();
 
+      /// If set, mono_coeffs point into this container (see load_binary()) and are not owned by the solution.
+      BinaryContainerSharedPtr mono_coeffs_container;
+
+      /// Frees mono_coeffs, or releases the container they point into.
+      void free_mono_coeffs();
+
       /// Internal, checks the compliance of the passed space type and owned space type.
       void check_space_type_compliance(const char* space_type_to_check) const;
 
@@ -213,6 +233,7 @@ namespace Hermes
       template<typename T> friend class Views::VectorBaseView;
       template<typename T> friend class OGProjectionNOX;
       template<typename T> friend class Adapt;
+      template<typename T> friend class ErrorCalculator;
       template<typename T> friend class Func;
       template<typename T> friend class DiscontinuousFunc;
       template<typename T> friend class DiscreteProblem;
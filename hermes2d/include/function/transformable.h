@@ -124,6 +124,7 @@ namespace Hermes
       template<typename T> friend class DiscreteProblemDGAssembler;
       template<typename T> friend class DiscreteProblemThreadAssembler;
       template<typename T> friend class NeighborSearch;
+      template<typename T> friend class OGProjection;
       friend class CurvMap;
       friend class Traverse;
     };
@@ -132,6 +132,18 @@ namespace Hermes
       HERMES_INVALID_SPACE = -9999
     };
 
+    /// Renumbering of the DOFs of a Space, applied at the end of Space::assign_dofs().
+    /// Reduces the bandwidth / fill-in of the assembled matrices, see Space::set_dof_renumbering().
+    /// Systems of spaces with the same renumbering are renumbered as a whole, see Space::assign_dofs(spaces).
+    enum DofRenumberingType {
+      /// DOFs are numbered vertices first, then edges, then bubbles (the default).
+      HERMES_DOF_RENUMBERING_NONE = 0,
+      /// Reverse Cuthill-McKee - small bandwidth, suitable for banded / skyline solvers and ILU preconditioners.
+      HERMES_DOF_RENUMBERING_RCM = 1,
+      /// Geometric nested dissection - small fill-in of sparse direct solvers.
+      HERMES_DOF_RENUMBERING_NESTED_DISSECTION = 2
+    };
+
     /// Important not to change the indices - used in an array enumeration
     enum ShapesetType {
       HERMES_H1_JACOBI = 0,
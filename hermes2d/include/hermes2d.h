@@ -37,6 +37,7 @@
 #include "mesh/mesh_reader_h2d.h"
 #include "mesh/mesh_reader_h2d_xml.h"
 #include "mesh/mesh_reader_h2d_bson.h"
+#include "mesh/mesh_reader_h2d_binary.h"
 #include "mesh/mesh_reader_h1d_xml.h"
 #include "mesh/mesh_reader_exodusii.h"
 
@@ -67,6 +68,7 @@
 #include "function/postprocessing.h"
 
 #include "graph.h"
+#include "checkpoint.h"
 
 #include "views/view.h"
 #include "views/base_view.h"
@@ -75,6 +77,7 @@
 #include "views/scalar_view.h"
 #include "views/vector_base_view.h"
 #include "views/vector_view.h"
+#include "views/vtu_output.h"
 
 #include "refinement_selectors/element_to_refine.h"
 #include "refinement_selectors/selector.h"
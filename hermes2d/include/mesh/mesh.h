@@ -385,6 +385,7 @@ namespace Hermes
       friend class MeshHashGrid;
       friend class MeshReaderH2D;
       friend class MeshReaderH2DBSON;
+      friend class MeshReaderH2DBinary;
       friend class MeshReaderH2DXML;
       friend class MeshReaderH1DXML;
       friend class MeshReaderExodusII;
@@ -0,0 +1,72 @@
+// This file is part of Hermes2D
+//
+// Hermes2D is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 2 of the License, or
+// (at your option) any later version.
+//
+// Hermes2D is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with Hermes2D; if not, see <http://www.gnu.prg/licenses/>.
+
+#ifndef _MESH_READER_H2D_BINARY_H_
+#define _MESH_READER_H2D_BINARY_H_
+
+#include "mesh_reader.h"
+#include "util/binary_container.h"
+
+namespace Hermes
+{
+  namespace Hermes2D
+  {
+    /// Mesh reader from the binary format (Hermes::BinaryIO::BinaryContainer).
+    /// Vertices, base elements, boundary edges, curves (arcs and general NURBS) and refinements
+    /// are stored as flat arrays, the element markers as the internal ones with the conversion table.
+    ///
+    /// Typical usage:
+    /// MeshSharedPtr mesh(new Mesh);
+    /// Hermes::Hermes2D::MeshReaderH2DBinary mloader;
+    /// try
+    /// {
+    ///&nbsp;mloader.load("mesh.h2db", mesh);
+    /// }
+    /// catch(Exceptions::Exception& e)
+    /// {
+    ///&nbsp;e.print_msg();
+    ///&nbsp;return -1;
+    /// }
+    ///
+    /// @ingroup mesh_readers
+    class HERMES_API MeshReaderH2DBinary : public MeshReader
+    {
+    public:
+      MeshReaderH2DBinary();
+      virtual ~MeshReaderH2DBinary();
+
+      /// This method loads a single mesh from a file.
+      virtual void load(const char *filename, MeshSharedPtr mesh);
+
+      /// This method saves a single mesh to a file.
+      void save(const char *filename, MeshSharedPtr mesh);
+
+      /// Loads the mesh from an opened container (e.g. a checkpoint, see Checkpoint).
+      void load(const BinaryIO::BinaryContainer& container, MeshSharedPtr mesh);
+
+      /// Adds the mesh arrays to a container being written.
+      /// The arrays are copies, the mesh may change before writing.
+      void save(BinaryIO::BinaryContainerWriter& writer, MeshSharedPtr mesh);
+
+    private:
+      /// Adds the used internal markers with their user markers (zero-terminated, concatenated) as two arrays.
+      void save_markers(BinaryIO::BinaryContainerWriter& writer, const Mesh::MarkersConversion& markers_conversion, const std::set<int>& used_markers, const char* ids_name, const char* names_name);
+
+      /// Inserts the saved markers into the conversion table, returns the map from the saved internal markers to the new ones.
+      std::map<int, int> load_markers(const BinaryIO::BinaryContainer& container, Mesh::MarkersConversion& markers_conversion, const char* ids_name, const char* names_name);
+    };
+  }
+}
+#endif
@@ -48,6 +48,10 @@ namespace Hermes
     class Mesh;
     class Transformable;
     struct Rect;
+    class TraversalPlan;
+
+    /// Used to pass the instances of TraversalPlan around.
+    typedef std::tr1::shared_ptr<TraversalPlan> TraversalPlanSharedPtr;
 
     struct UniData
     {
@@ -96,6 +100,7 @@ namespace Hermes
         template<typename Scalar> friend class DiscreteProblem;
         template<typename T> friend class DiscreteProblemDGAssembler;
         template<typename T> friend class DiscreteProblemThreadAssembler;
+        friend class TraversalPlan;
       };
 
       /// Returns all states on the passed meshes.
@@ -110,7 +115,25 @@ namespace Hermes
       template<typename Scalar>
       State** get_states(std::vector<MeshFunctionSharedPtr<Scalar> > mesh_functions, unsigned int& states_count);
 
+      /// Returns the (shared, read-only) plan with all states on the passed meshes.
+      /// The plans are cached by the meshes and their seq numbers, so as long as no mesh changes,
+      /// the meshes are not traversed again.
+      /// \param[in] meshes Meshes.
+      /// \param[in] spaces_size Number of meshes (from the beginning) that determine the representing element, see State::rep.
+      static TraversalPlanSharedPtr get_plan(std::vector<MeshSharedPtr> meshes, int spaces_size);
+
+      /// Returns the (shared, read-only) plan with all states on the passed meshes.
+      /// Overload for mesh functions.
+      template<typename Scalar>
+      static TraversalPlanSharedPtr get_plan(std::vector<MeshFunctionSharedPtr<Scalar> > mesh_functions, int spaces_size);
+
+      /// Removes the cached plans containing the mesh, called when the mesh is freed.
+      static void invalidate_plans(const Mesh* mesh);
+
     private:
+      /// Traverses the meshes over the base elements [base_element_begin, base_element_end), adds all leaf states to the plan.
+      void traverse(MeshSharedPtr* meshes, unsigned short meshes_count, TraversalPlan* plan, int base_element_begin, int base_element_end);
+
       /// Used by get_states.
       void begin(int n);
       /// Used by get_states.
@@ -152,6 +175,73 @@ namespace Hermes
       template<typename T> friend class Filter;
       template<typename T> friend class SimpleFilter;
       friend class Views::Orderizer;
+      friend class TraversalPlan;
+    };
+
+    /// \brief All leaf states of the multi-mesh traversal of the given meshes, see Traverse::get_plan().
+    /// The elements and sub-element indices of all states are stored in one arena (structure of arrays), the State
+    /// instances only point there. The plan is shared by its users (DiscreteProblem, ErrorCalculator, ...), the states
+    /// must not be deleted or changed (apart from State::isurf, which the users iterate through when processing a state).
+    class HERMES_API TraversalPlan
+    {
+    public:
+      /// Traverses the meshes.
+      /// \param[in] spaces_size Number of meshes (from the beginning) that determine the representing element, see Traverse::State::rep.
+      TraversalPlan(std::vector<MeshSharedPtr> meshes, int spaces_size);
+      ~TraversalPlan();
+
+      /// The states (owned by the plan).
+      Traverse::State** get_states() const;
+
+      /// Number of the states.
+      unsigned int get_num_states() const;
+
+      /// Index of the state in get_states(), -1 if the state does not belong to this plan.
+      int get_state_index(const Traverse::State* state) const;
+
+      /// The plan was created for these meshes (in their current state).
+      bool is_valid_for(const std::vector<MeshSharedPtr>& meshes, int spaces_size) const;
+
+      /// The plan contains this mesh.
+      bool contains(const Mesh* mesh) const;
+
+    private:
+      /// Empty plan, used for the parts of the parallel traversal.
+      TraversalPlan(unsigned short num);
+
+      /// Appends a leaf state to the arena.
+      void add_state(Traverse::State* s);
+      /// Appends all states of the other (not finalized) plan.
+      void append(const TraversalPlan& other);
+      /// Creates the State instances over the arena.
+      void finalize();
+
+      unsigned short num;
+      int spaces_size;
+      unsigned int num_states;
+
+      /// The meshes and their seq numbers at the time of the traversal.
+      std::vector<const Mesh*> meshes;
+      std::vector<unsigned int> mesh_seqs;
+
+      /// Arena - the elements and sub-element indices of the state i are at [i * num, (i + 1) * num).
+      std::vector<Element*> elements;
+      std::vector<uint64_t> sub_idx;
+
+      /// Per-state data.
+      struct StateInfo
+      {
+        bool bnd[H2D_MAX_NUMBER_EDGES];
+        bool isBnd;
+        unsigned short rep_i;
+      };
+      std::vector<StateInfo> state_info;
+
+      /// The states pointing to the arena.
+      Traverse::State* state_data;
+      Traverse::State** states;
+
+      friend class Traverse;
     };
   }
 }
@@ -34,13 +34,45 @@ namespace Hermes
       };
 
       /// \brief Class utilizes parallel calculation
+      /// Work items (typically Traverse states) are handed out to the threads dynamically, in the order of decreasing
+      /// estimated cost, and the busy / idle times of the threads in the last run are recorded.
       class HERMES_API Parallel
       {
+      public:
+        /// Time (in seconds) the thread spent processing the work items in the last scheduled run.
+        double get_thread_busy_time(unsigned char thread_number) const;
+        /// Time (in seconds) the thread spent waiting for the other threads in the last scheduled run.
+        double get_thread_idle_time(unsigned char thread_number) const;
+
       protected:
         Parallel();
+
+        /// Initializes the scheduling of work items 0, ..., num_items - 1.
+        /// \param[in] costs Estimated costs of the items. If nullptr, the items are handed out in their natural order.
+        void init_scheduling(unsigned int num_items, const double* costs = nullptr);
+
+        /// The next item the thread should process, -1 if there are none left.
+        /// To be called from within the parallel block, the first call starts, and the call returning -1 ends
+        /// the measurement of the busy time of the thread.
+        int get_next_scheduled_item(unsigned char thread_number);
+
+        /// Estimated number of basis functions on an element of the given (maximum directional) order.
+        static double estimated_basis_count(unsigned short order, bool triangle);
+        /// Estimated number of integration points of a quadrature of the given order.
+        static double estimated_quadrature_points_count(unsigned short order, bool triangle);
+
       protected:
         unsigned char num_threads_used;
         std::string exceptionMessageCaughtInParallelBlock;
+
+      private:
+        /// Work items in the order they are handed out.
+        std::vector<unsigned int> scheduled_items;
+        /// The position in scheduled_items of the next item to hand out, incremented atomically by get_next_scheduled_item().
+        unsigned int next_scheduled_item;
+        /// Start / end times (omp_get_wtime()) of the threads in the last scheduled run, negative if not recorded.
+        std::vector<double> thread_start_times;
+        std::vector<double> thread_end_times;
       };
     }
   }
@@ -144,6 +144,9 @@ namespace Hermes
       ///
       DiscontinuousFunc<Scalar>* init_ext_fn(MeshFunction<Scalar>* fu);
 
+      /// Version of init_ext_fn() with all the memory taken from the arena, the result is not to be deleted.
+      DiscontinuousFunc<Scalar>* init_ext_fn(MeshFunction<Scalar>* fu, MemoryArena* arena);
+
       class ExtendedShapeset;
       /// Object allowing to set/get a particular shape function from the extended
       ExtendedShapeset *supported_shapes;
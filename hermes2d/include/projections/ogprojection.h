@@ -81,6 +81,7 @@ namespace Hermes
         NormType proj_norm = HERMES_UNSET_NORM);
 
       /// Wrapper for multiple source MeshFunctions that delivers coefficient vector.
+      /// For jointly renumbered spaces (see Space::assign_dofs()) the vector is indexed by the DOFs of the system.
       static void project_global(std::vector<SpaceSharedPtr<Scalar> > spaces, std::vector<MeshFunctionSharedPtr<Scalar> > source_meshfns,
         Scalar* target_vec, std::vector<NormType> proj_norms = std::vector<NormType>());
 
@@ -91,6 +92,26 @@ namespace Hermes
         std::vector<MeshFunctionSharedPtr<Scalar> > source_slns, std::vector<MeshFunctionSharedPtr<Scalar> > target_slns,
         std::vector<NormType> proj_norms = std::vector<NormType>(), bool delete_old_mesh = false);
 
+      /// Projection of several source functions onto one space (in the same norm).
+      /// The right-hand sides of all source functions are assembled, then solved with one factorization of the projection matrix.
+      /// \param[out] target_vecs Coefficient vectors (of size space->get_num_dofs()), one per each source function.
+      static void project_global(SpaceSharedPtr<Scalar> space, std::vector<MeshFunctionSharedPtr<Scalar> > source_meshfns,
+        std::vector<Scalar*> target_vecs, NormType proj_norm = HERMES_UNSET_NORM);
+
+      /// Switches on / off caching of the assembled projection matrices and their factorizations.
+      /// If on, the projections of source functions (project_global with a NormType) onto a space that has already been projected onto
+      /// (with the same norm) only assemble the right-hand side and reuse the factorization (direct solvers) / preconditioner (iterative solvers).
+      /// The cache entries are keyed by the seq of the space, the seq of its mesh and the norm type - they do not keep the spaces alive.
+      /// At most 8 entries are kept, the least recently used ones are freed.
+      /// Default: off.
+      static void set_factorization_caching(bool to_set);
+
+      /// Frees all cached projection matrices and factorizations.
+      static void free_factorization_cache();
+
+      /// Number of the projections that have reused a cached factorization.
+      static unsigned int get_factorization_cache_hits();
+
     protected:
       /// Underlying function for global orthogonal projection.
       /// Not intended for the user. NOTE: the weak form here must be
@@ -98,6 +119,30 @@ namespace Hermes
       /// the weak form of the PDE. If you supply a weak form of the
       /// PDE, the PDE will just be solved.
       static void project_internal(SpaceSharedPtr<Scalar> space, WeakFormSharedPtr<Scalar> proj_wf, Scalar* target_vec);
+
+      /// Projection in the norm, reusing the cached matrix (factorization) if possible.
+      static void project_cached(SpaceSharedPtr<Scalar> space, const std::vector<MeshFunctionSharedPtr<Scalar> >& source_meshfns,
+        const std::vector<Scalar*>& target_vecs, NormType norm, bool store_in_cache);
+
+      /// Element-local projection for spaces with a block-diagonal projection matrix (L2Space, L2MarkerWiseConstSpace in the L2 norm):
+      /// the (dense) blocks are assembled and solved by the Cholesky decomposition in parallel, no global matrix is assembled.
+      /// Returns false if the space is not of this kind (then nothing is done).
+      static bool project_element_local(SpaceSharedPtr<Scalar> space, MeshFunctionSharedPtr<Scalar> source_meshfn, Scalar* target_vec, NormType norm);
+
+      /// Default norm for the space type.
+      static NormType get_default_norm(SpaceSharedPtr<Scalar> space);
+
+      /// Assembled projection matrix with its linear solver (factorization).
+      class CachedFactorization;
+
+      /// The cached matrices, the most recently used first.
+      static std::vector<CachedFactorization*> factorization_cache;
+
+      /// The caching switch.
+      static bool factorization_caching;
+
+      /// See get_factorization_cache_hits().
+      static unsigned int factorization_cache_hits;
     };
   }
 }
@@ -84,6 +84,10 @@ namespace Hermes
 
       inline double2* get_ref_vertex(int n, ElementMode2D mode) { return &ref_vert[mode][n]; }
 
+      /// For tensor-product rules on quads, returns the 1D points (the point n = i * np_1d + j is [x_1d[i], x_1d[j]]).
+      /// Returns nullptr if the rule for the order is not a tensor-product one.
+      virtual double2* get_tensor_points(int order, ElementMode2D mode, unsigned char& np_1d) const { return nullptr; }
+
       virtual unsigned char get_id() = 0;
     protected:
       double3*** tables;
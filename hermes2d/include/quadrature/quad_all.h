@@ -42,6 +42,9 @@ namespace Hermes
                return 1;
              };
 
+             /// The quad rules (not the edge ones) are Cartesian products of the 1D rules.
+             virtual double2* get_tensor_points(int order, ElementMode2D mode, unsigned char& np_1d) const;
+
              virtual void dummy_fn() {}
     };
 
@@ -18,6 +18,7 @@
 
 #include "../function/function.h"
 #include "../shapeset/shapeset.h"
+#include <list>
 
 namespace Hermes
 {
@@ -70,7 +71,8 @@ namespace Hermes
       unsigned short max_index[H2D_NUM_MODES];
 
       /// Transformed points to the reference domain, used by precalculate.
-      double2 ref_points[H2D_MAX_INTEGRATION_POINTS_COUNT];
+      double ref_x[H2D_MAX_INTEGRATION_POINTS_COUNT];
+      double ref_y[H2D_MAX_INTEGRATION_POINTS_COUNT];
 
       virtual void precalculate(unsigned short order, unsigned short mask);
 
@@ -86,9 +88,56 @@ namespace Hermes
       template<typename T> friend class DiscreteProblemDGAssembler;
       template<typename T> friend class DiscreteProblemThreadAssembler;
       template<typename T> friend class NeighborSearch;
+      template<typename T> friend class OGProjection;
       friend class CurvMap;
     };
 
+    /// Number of the values (function values, dx, dy) stored by PrecalcShapesetAssemblingStorage.
+#define H2D_PSS_STORED_VALUES 3
+    /// Maximum number of entries in one PrecalcShapesetSubElementCache.
+#define H2D_PSS_SUB_ELEMENT_CACHE_SIZE 1024
+    /// Maximum number of threads having their own PrecalcShapesetSubElementCache.
+#define H2D_PSS_MAX_THREADS 256
+
+    /// \brief Bounded LRU cache of the shape function values on sub-elements (non-zero sub_idx) for PrecalcShapesetAssembling.
+    /// Each entry holds H2D_PSS_STORED_VALUES arrays of np values per component.
+    class PrecalcShapesetSubElementCache
+    {
+    public:
+      PrecalcShapesetSubElementCache(unsigned int capacity);
+      ~PrecalcShapesetSubElementCache();
+
+      struct Key
+      {
+        Key(unsigned char mode, unsigned short order, int index, uint64_t sub_idx);
+        unsigned char mode;
+        unsigned short order;
+        int index;
+        uint64_t sub_idx;
+        bool operator<(const Key& other) const;
+      };
+
+      /// Returns the cached values (nullptr if not present), the entry becomes the most recently used one.
+      double* get(const Key& key);
+
+      /// Adds an entry (replacing the least recently used one if full) and returns the storage for its values.
+      /// The returned pointers (also from get()) stay valid for at least (capacity - 1) further insertions.
+      double* insert(const Key& key, int size);
+
+    private:
+      struct Entry
+      {
+        Key key;
+        double* values;
+        int size;
+      };
+
+      /// The most recently used first.
+      std::list<Entry> entries;
+      std::map<Key, std::list<Entry>::iterator> lookup;
+      unsigned int capacity;
+    };
+
     /// \brief PrecalcShapesetAssembling common storage.
     class HERMES_API PrecalcShapesetAssemblingStorage
     {
@@ -98,10 +147,18 @@ namespace Hermes
       unsigned char shapeset_id;
       unsigned short max_index[2];
       unsigned short ref_count;
+      unsigned char num_components;
 
     private:
-      double*** PrecalculatedValues[H2D_NUM_MODES][H2D_NUM_FUNCTION_VALUES];
+      /// Values on the whole element (sub_idx == 0) - [mode][component][value][order][index][point].
+      double*** PrecalculatedValues[H2D_NUM_MODES][H2D_MAX_SOLUTION_COMPONENTS][H2D_PSS_STORED_VALUES];
       bool** PrecalculatedInfo[H2D_NUM_MODES];
+
+      /// Values on sub-elements, one cache per thread so that no locking is needed.
+      PrecalcShapesetSubElementCache* sub_element_caches[H2D_PSS_MAX_THREADS];
+      /// The cache of the calling thread (created on the first use), nullptr for too many threads.
+      PrecalcShapesetSubElementCache* get_sub_element_cache();
+
       friend class PrecalcShapesetAssembling;
     };
 
@@ -156,10 +213,18 @@ namespace Hermes
     private:
       virtual void precalculate(unsigned short order, unsigned short mask);
 
+      /// Evaluates the value 'item' (function value, dx, ...) of the component of the active shape in the points ref_x, ref_y.
+      void calculate_values(unsigned short item, unsigned short component, unsigned char np, double* result);
+
       PrecalcShapesetAssemblingStorage* storage;
 
       bool attempt_to_reuse(unsigned short order) const;
       bool reuse_possible() const;
+      bool sub_element_reuse_possible(unsigned short mask) const;
+
+      /// Values from the sub-element cache set by the last precalculate() (nullptr if not used).
+      double* sub_element_values;
+      unsigned char sub_element_np;
     };
 
     /// Intentionally not exported - for internal purposes.
@@ -137,6 +137,10 @@ namespace Hermes
       /// domain, component is 0 for Scalar shapesets and 0 or 1 for vector shapesets.
       double get_value(int n, int index, double x, double y, unsigned short component, ElementMode2D mode);
 
+      /// Obtains the values of the given shape function in np points at once, result[i] is the value in (x[i], y[i]).
+      /// The shape function is looked up once for all the points, shapesets may reimplement this by a vectorizable evaluation.
+      virtual void get_values(int n, int index, int np, const double* x, const double* y, unsigned short component, ElementMode2D mode, double* result);
+
       double get_fn_value(int index, double x, double y, unsigned short component, ElementMode2D mode);
       double get_dx_value(int index, double x, double y, unsigned short component, ElementMode2D mode);
       double get_dy_value(int index, double x, double y, unsigned short component, ElementMode2D mode);
@@ -230,6 +234,32 @@ namespace Hermes
       ///
       double get_constrained_value(int n, int index, double x, double y, unsigned short component, ElementMode2D mode);
 
+      /// Constructs the linear combination of edge functions, forming a constrained edge function, in np points.
+      void get_constrained_values(int n, int index, int np, const double* x, const double* y, unsigned short component, ElementMode2D mode, double* result);
+
+      /// Monomial expansions of the (unconstrained) shape functions interpolated in the Chebyshev points, as used
+      /// by Solution::set_coeff_vector(), so that projecting a coefficient vector is a linear combination of these.
+      /// The expansions are calculated on first use (by Solution) and kept for the lifetime of the shapeset.
+      class HERMES_API MonomialTable
+      {
+      public:
+        MonomialTable();
+        /// The (lazily filled) table is not shared with the copy, see clone().
+        MonomialTable(const MonomialTable& other);
+        ~MonomialTable();
+
+        /// Number of the Chebyshev point sets (orders 0, 1, ..., num_orders - 1).
+        static const unsigned char num_orders = 11;
+
+        /// For every mode, component and order an array (indexed by the shape function index) of the expansions.
+        double** coeffs[H2D_NUM_MODES][H2D_MAX_SOLUTION_COMPONENTS][num_orders];
+        /// Lengths of the arrays in coeffs.
+        unsigned short size[H2D_NUM_MODES][H2D_MAX_SOLUTION_COMPONENTS][num_orders];
+      private:
+        MonomialTable& operator=(const MonomialTable& other);
+      };
+      MonomialTable mono_table;
+
       template<typename Scalar> friend class DiscreteProblem;
       template<typename Scalar> friend class DiscreteProblemIntegrationOrderCalculator;
       template<typename Scalar> friend class Solution;
@@ -34,6 +34,9 @@ namespace Hermes
       virtual unsigned short get_max_index(ElementMode2D mode) const;
       virtual unsigned char get_id() const { return HERMES_L2_LEGENDRE; }
 
+      /// Reimplemented - on quads, the products of Legendre polynomials are evaluated by the (vectorizable) three-term recurrence.
+      virtual void get_values(int n, int index, int np, const double* x, const double* y, unsigned short component, ElementMode2D mode, double* result);
+
       static const unsigned short max_index[H2D_NUM_MODES];
     };
 
@@ -105,6 +105,9 @@ namespace Hermes
       /// \return Information if the jacobian structure was reused.
       virtual bool assemble(bool store_previous_jacobian, bool store_previous_residual);
 
+      /// Residual for the Jacobian-free mode.
+      virtual void evaluate_residual(Scalar* coeff_vec, Vector<Scalar>* residual);
+
       /// Initialization - called at the beginning of solving.
       virtual void init_solving(Scalar* coeff_vec);
 
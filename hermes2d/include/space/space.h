@@ -184,6 +184,7 @@ namespace Hermes
       EssentialBCs<Scalar>* get_essential_bcs() const;
 
       /// Obtains an assembly list for the given element.
+      /// If the table of assembly lists built by assign_dofs() is up to date, the list is copied from there.
       virtual void get_element_assembly_list(Element* e, AsmList<Scalar>* al) const;
 
       /// Internal. Obtains the order of an edge, according to the minimum rule.
@@ -192,6 +193,10 @@ namespace Hermes
       /// \brief Returns the DOF number of the last basis function.
       int get_max_dof() const;
 
+      /// Returns the DOF that the basis function numbered 'dof' when the space is assigned alone (from first_dof) has in the
+      /// jointly renumbered system, see assign_dofs(spaces). The same 'dof' if the space was not renumbered jointly.
+      int get_system_dof(int dof) const;
+
       /// Obtains an edge assembly list (contains shape functions that are nonzero on the specified edge).
       void get_boundary_assembly_list(Element* e, int surf_num, AsmList<Scalar>* al) const;
 
@@ -210,6 +215,16 @@ namespace Hermes
 
       /// Sets the boundary condition.
       void set_essential_bcs(EssentialBCs<Scalar>* essential_bcs);
+
+      /// Sets the renumbering of the DOFs done at the end of assign_dofs(), see DofRenumberingType.
+      /// A space assigned alone is permuted within [first_dof, first_dof + ndof). If all spaces of a system have the same
+      /// renumbering, the static assign_dofs(spaces) renumbers the whole system at once, so the DOFs of different spaces
+      /// are interleaved (see get_system_dof()).
+      /// If the DOFs are already assigned, they are reassigned.
+      void set_dof_renumbering(DofRenumberingType dof_renumbering);
+
+      /// Returns the renumbering of the DOFs.
+      DofRenumberingType get_dof_renumbering() const;
 #pragma endregion
 
 #pragma region Order setting
@@ -241,7 +256,18 @@ namespace Hermes
       virtual int assign_dofs(int first_dof = 0);
 
       /// \brief Assings the degrees of freedom to all Spaces in the std::vector.
-      static int assign_dofs(std::vector<SpaceSharedPtr<Scalar> > spaces);
+      /// The spaces are first numbered one after another, each one as if assigned alone. If all of them have the same
+      /// renumbering (see set_dof_renumbering()), one graph over the DOFs of all spaces is then built and a single permutation
+      /// of the whole system is applied - the DOFs of the spaces are interleaved, the coupling blocks get a small bandwidth too.
+      /// Coefficient vectors of the system are indexed by these DOFs; Solution::vector_to_solution() reads them transparently,
+      /// OGProjection::project_global() of all spaces produces them.
+      /// \param[in] renumber_jointly Set to false to keep the ranges of the spaces contiguous (each renumbered within its range).
+      static int assign_dofs(std::vector<SpaceSharedPtr<Scalar> > spaces, bool renumber_jointly = true);
+
+      /// Reorders a coefficient vector of the spaces from the layout with the spaces one after another, each numbered as if
+      /// assigned alone (results of per-space projections), to the layout of the DOFs assigned by assign_dofs(spaces), which is
+      /// called. Nothing happens if the spaces are not renumbered jointly.
+      static void reorder_to_system(std::vector<SpaceSharedPtr<Scalar> > spaces, Scalar* coeff_vec);
 #pragma endregion
 
 #pragma region Mesh handling
@@ -286,6 +312,14 @@ namespace Hermes
       /// This method is here for rapid re-loading.
       void load_bson(const char *filename);
 #endif
+
+      /// Adds the element data, first DOF, DOF renumbering (and whether it was joint with other spaces) and the DOF map
+      /// (assembly lists of the active elements) to a binary container (see Checkpoint), the array names start with 'prefix'.
+      void save_binary(BinaryIO::BinaryContainerWriter& writer, const char* prefix) const;
+      /// Loads a space from a binary container, the DOFs are assigned anew (from the saved first DOF, with the saved renumbering)
+      /// and checked against the saved DOF map.
+      /// A space renumbered jointly with other spaces (see set_dof_renumbering()) can only be loaded with them, see Checkpoint::load_spaces().
+      static SpaceSharedPtr<Scalar> load_binary(const BinaryIO::BinaryContainer& container, const char* prefix, MeshSharedPtr mesh, EssentialBCs<Scalar>* essential_bcs = nullptr, Shapeset* shapeset = nullptr);
 #pragma endregion
 
       /// Copy from Space instance 'space'
@@ -457,6 +491,47 @@ namespace Hermes
       virtual void assign_edge_dofs() = 0;
       virtual void assign_bubble_dofs() = 0;
 
+      /// Permutes the assigned DOFs according to dof_renumbering.
+      /// All DOFs of one node (element bubble) stay contiguous, only these blocks are reordered.
+      void renumber_dofs();
+
+      /// Permutes the DOFs of the spaces (assigned one after another) by one renumbering of the whole system.
+      /// Stores the permutation in system_dofs of the spaces.
+      static void renumber_dofs(const std::vector<Space<Scalar>*>& spaces, DofRenumberingType dof_renumbering);
+
+      /// True if assign_dofs(spaces) renumbers the spaces jointly - more than one space, all distinct, with the same renumbering.
+      static bool is_renumbered_jointly(const std::vector<SpaceSharedPtr<Scalar> >& spaces);
+
+      /// DOF renumbering done in assign_dofs().
+      DofRenumberingType dof_renumbering;
+
+      /// Loads everything saved by save_binary() except for the DOFs, which are left to be assigned.
+      static SpaceSharedPtr<Scalar> load_binary_data(const BinaryIO::BinaryContainer& container, const char* prefix, MeshSharedPtr mesh, EssentialBCs<Scalar>* essential_bcs, Shapeset* shapeset);
+      /// Checks the assigned DOFs against the DOF map saved by save_binary().
+      void check_binary_dof_map(const BinaryIO::BinaryContainer& container, const char* prefix) const;
+
+      /// Joint renumbering of a system - system_dofs[i] is the DOF of the basis function numbered first_dof + i when the space
+      /// is assigned alone. Empty if the space was assigned alone (first_dof then stays the start of its range in both cases).
+      std::vector<int> system_dofs;
+
+      /// Builds the table of assembly lists of all active elements.
+      /// Called at the end of assign_dofs() and update_essential_bc_values(), so that repeated assembling
+      /// on an unchanged space (Newton iterations, time stepping) does not walk the nodes and constraints again.
+      void build_assembly_list_table();
+      /// Copies the assembly list of the element from the table, returns false if the table is not available for the element.
+      bool get_element_assembly_list_from_table(Element* e, AsmList<Scalar>* al) const;
+
+      /// Table of assembly lists (CSR-style) - the list of the element with id i occupies the positions
+      /// asm_table_offsets[i], ..., asm_table_offsets[i + 1] - 1 of asm_table_idx, asm_table_dof and asm_table_coef.
+      std::vector<int> asm_table_offsets;
+      std::vector<int> asm_table_idx;
+      std::vector<int> asm_table_dof;
+      std::vector<Scalar> asm_table_coef;
+      /// The table is valid for this (space) seq and mesh seq.
+      bool asm_table_valid;
+      unsigned int asm_table_seq;
+      int asm_table_mesh_seq;
+
       virtual void get_vertex_assembly_list(Element* e, int iv, AsmList<Scalar>* al) const = 0;
       virtual void get_boundary_assembly_list_internal(Element* e, int surf_num, AsmList<Scalar>* al) const = 0;
       virtual void get_bubble_assembly_list(Element* e, AsmList<Scalar>* al) const;
@@ -494,6 +569,7 @@ namespace Hermes
       };
 
       template<typename T> friend class OGProjection;
+      template<typename T> friend class Checkpoint;
       template<typename T> friend class NewtonSolver;
       template<typename T> friend class PicardSolver;
       template<typename T> friend class LinearSolver;
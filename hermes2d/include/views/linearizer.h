@@ -62,6 +62,13 @@ namespace Hermes
         void save_solution_vtk(MeshFunctionSharedPtr<double> sln, const char* filename, const char* quantity_name, bool mode_3D = true, int item = H2D_FN_VAL_0);
         /// Save multiple MeshFunctions (Solutions, Filters) in VTK format.
         void save_solution_vtk(std::vector<MeshFunctionSharedPtr<double> > slns, std::vector<int> items, const char* filename, const char* quantity_name, bool mode_3D = true);
+        /// Save a MeshFunction (Solution, Filter) in the VTK XML format (.vtu) with binary appended data.
+        /// \param[in] compress Compress the data by zlib (requires Hermes built with WITH_ZLIB).
+        /// Time steps and multiple fields may be collected in a ParaView collection, see PVDCollection.
+        void save_solution_vtu(MeshFunctionSharedPtr<double> sln, const char* filename, const char* quantity_name, bool mode_3D = true, int item = H2D_FN_VAL_0, bool compress = false);
+        /// Save multiple MeshFunctions (Solutions, Filters) in the VTK XML format (.vtu) with binary appended data.
+        /// The data are streamed from the linearized data structures, no copy of them is made.
+        void save_solution_vtu(std::vector<MeshFunctionSharedPtr<double> > slns, std::vector<int> items, const char* filename, const char* quantity_name, bool mode_3D = true, bool compress = false);
         /// Save a MeshFunction (Solution, Filter) in Tecplot format.
         void save_solution_tecplot(MeshFunctionSharedPtr<double> sln, const char* filename, const char* quantity_name, int item = H2D_FN_VAL_0);
         /// Save multiple MeshFunctions (Solutions, Filters) in Tecplot format.
@@ -194,6 +201,13 @@ namespace Hermes
 
         void find_min_max();
 
+        /// FileExport - merges the vertices of all threads into one mesh without duplicities
+        /// (vertices on the boundaries of the parts processed by different threads).
+        /// Vertices are put into a lock-free hash table keyed by their parents
+        /// (ThreadLinearizerMultidimensional::calculate_vertex_keys()), all steps run in parallel.
+        /// The triangle indices are then global.
+        void merge_vertices();
+
         friend class ThreadLinearizerMultidimensional < LinearizerDataDimensions > ;
       };
 
@@ -77,6 +77,14 @@ namespace Hermes
         /// Return the [existing|new] vertex between p1 and p2, uses add_vertex() for new vertex creation.
         int get_vertex(int p1, int p2, double x, double y, double* value);
 
+        /// Fill keys[i] with a key of the vertex i identifying it across threads.
+        /// Mesh vertices are keyed by their id, midpoints by the keys of their parents, so that
+        /// vertices created by different threads on the same place of the mesh get the same key.
+        /// Uses info, i.e. must be called before the next processing run.
+        void calculate_vertex_keys(unsigned long long* keys) const;
+        /// Whether the two vertices (created by any threads) are the same - see get_vertex().
+        static bool vertices_match(const typename LinearizerDataDimensions::vertex_t& a, const typename LinearizerDataDimensions::vertex_t& b);
+
         /// Process a triangle with vertices iv0, iv1, iv2.
         /// Recursive.
         /// \param[in] level The current level of refinement
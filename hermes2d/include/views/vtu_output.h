@@ -0,0 +1,109 @@
+// This file is part of Hermes2D.
+//
+// Hermes2D is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 2 of the License, or
+// (at your option) any later version.
+//
+// Hermes2D is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with Hermes2D.  If not, see <http://www.gnu.org/licenses/>.
+/*! \file vtu_output.h
+\brief Streaming output of VTK XML unstructured grids (.vtu) with binary appended data, and their collections (.pvd).
+*/
+
+#ifndef __H2D_VTU_OUTPUT_H
+#define __H2D_VTU_OUTPUT_H
+
+#include "global.h"
+
+namespace Hermes
+{
+  namespace Hermes2D
+  {
+    namespace Views
+    {
+      /// Size of the blocks the appended data are compressed by.
+      const int H2D_VTU_BLOCK_SIZE = 1 << 16;
+
+      /// \brief Writes the data arrays of the appended section of a .vtu file, in the raw encoding
+      /// (UInt64 headers), compressed by zlib (vtkZLibDataCompressor) if requested.
+      /// The data are streamed through one block buffer, so that no copy of the arrays is made.
+      /// The writer is created right after the '_' starting the appended data has been written.
+      class HERMES_API VTUAppendedDataWriter
+      {
+      public:
+        VTUAppendedDataWriter(FILE* file, bool compress);
+        ~VTUAppendedDataWriter();
+
+        /// Whether the compression is supported (Hermes built with WITH_ZLIB).
+        static bool compression_available();
+
+        /// Starts an array, the total size in bytes has to be known.
+        void begin_array(unsigned long long byte_count);
+        /// Appends data to the current array.
+        void write(const void* data, unsigned long long byte_count);
+        /// Finishes the current array.
+        /// \return The offset of the array in the appended section (to be put in the DataArray 'offset' attribute).
+        unsigned long long end_array();
+
+        /// Position in the file.
+        static long long tell(FILE* file);
+        static void seek(FILE* file, long long position);
+
+      private:
+        /// Writes the contents of the block buffer (compressed if requested).
+        void flush_block();
+
+        FILE* file;
+        bool compress;
+
+        /// Start of the appended data, and of the current array.
+        long long appended_start, array_start;
+        unsigned long long array_byte_count, array_bytes_written;
+
+        char* block;
+        unsigned int block_fill;
+        char* compressed_block;
+        unsigned long long compressed_block_size;
+        std::vector<unsigned long long> compressed_sizes;
+      };
+
+      /// \brief A ParaView collection (.pvd) of .vtu files - time steps, and fields as separate parts.
+      /// The collection file is rewritten by every add_dataset(), so that it is valid during the computation.
+      /// Typical usage:
+      /// PVDCollection collection("results.pvd");
+      /// for(time step ...)
+      /// {
+      ///&nbsp;linearizer.save_solution_vtu(sln, "temperature_10.vtu", "T", false, H2D_FN_VAL_0, true);
+      ///&nbsp;collection.add_dataset(time, "temperature_10.vtu", 0);
+      /// }
+      class HERMES_API PVDCollection
+      {
+      public:
+        PVDCollection(const char* filename);
+
+        /// Adds a .vtu file (relative to the collection file) for the time step 'time', 'part' distinguishes the fields.
+        void add_dataset(double time, const char* vtu_filename, int part = 0);
+
+      private:
+        void save() const;
+
+        struct DataSet
+        {
+          double time;
+          int part;
+          std::string filename;
+        };
+
+        std::string filename;
+        std::vector<DataSet> datasets;
+      };
+    }
+  }
+}
+#endif
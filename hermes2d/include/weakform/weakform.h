@@ -198,6 +198,10 @@ namespace Hermes
       /// Deletes all volumetric and surface forms.
       void delete_all();
 
+      /// Internal.
+      /// Invalidates the integration orders cached by the assembling threads (see integration_order_seq).
+      void invalidate_integration_order_cache();
+
     protected:
       /// External solutions.
       std::vector<MeshFunctionSharedPtr<Scalar> > ext;
@@ -237,6 +241,11 @@ namespace Hermes
 
       bool** get_blocks(bool force_diagonal_blocks) const;
 
+      /// Internal - identifies the forms, external functions and spaces of the problem, a new (globally unique) value is assigned
+      /// whenever those change. Copied to the clones made for the assembling threads (see cloneMembers).
+      /// Each DiscreteProblemIntegrationOrderCalculator caches integration orders for one value of this.
+      unsigned int integration_order_seq;
+
       friend class DiscreteProblem < Scalar > ;
       friend class Form < Scalar > ;
       friend class DiscreteProblemDGAssembler < Scalar > ;
@@ -389,6 +398,14 @@ namespace Hermes
       virtual Hermes::Ord ord(int n, double *wt, Func<Hermes::Ord> **u_ext, Func<Hermes::Ord> *u, Func<Hermes::Ord> *v,
         GeomVol<Hermes::Ord> *e, Func<Ord> **ext) const;
 
+      /// Batched version of value() - evaluates the form for all (basis, test) function pairs of the element at once.
+      /// On return, result[i * result_stride + j] holds value(n, wt, u_ext, u[j], v[i], e, ext).
+      /// The default implementation does nothing and returns false, in which case value() is called for each pair separately.
+      /// An override has to return false for subclasses that override value() - otherwise their value() is never called.
+      /// \return True if the block has been filled.
+      virtual bool value_block(int n, double *wt, Func<Scalar> **u_ext, Func<double> **u, unsigned short u_count, Func<double> **v, unsigned short v_count,
+        GeomVol<double> *e, Func<Scalar> **ext, Scalar* result, unsigned short result_stride) const;
+
       virtual MatrixFormVol* clone() const;
     };
 
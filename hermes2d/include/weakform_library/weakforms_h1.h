@@ -50,6 +50,10 @@ namespace Hermes
         virtual Hermes::Ord ord(int n, double *wt, Func<Hermes::Ord> *u_ext[], Func<Hermes::Ord> *u,
           Func<Hermes::Ord> *v, GeomVol<Hermes::Ord> *e, Func<Ord> **ext) const;
 
+        /// Used only by this very class, subclasses overriding value() are evaluated per pair.
+        virtual bool value_block(int n, double *wt, Func<Scalar> *u_ext[], Func<double> **u, unsigned short u_count, Func<double> **v, unsigned short v_count,
+          GeomVol<double> *e, Func<Scalar> **ext, Scalar* result, unsigned short result_stride) const;
+
         virtual MatrixFormVol<Scalar>* clone() const;
 
       private:
@@ -83,6 +87,10 @@ namespace Hermes
         virtual Hermes::Ord ord(int n, double *wt, Func<Hermes::Ord> *u_ext[], Func<Hermes::Ord> *u, Func<Hermes::Ord> *v,
           GeomVol<Hermes::Ord> *e, Func<Ord> **ext) const;
 
+        /// Used only by this very class, subclasses overriding value() are evaluated per pair.
+        virtual bool value_block(int n, double *wt, Func<Scalar> *u_ext[], Func<double> **u, unsigned short u_count, Func<double> **v, unsigned short v_count,
+          GeomVol<double> *e, Func<Scalar> **ext, Scalar* result, unsigned short result_stride) const;
+
         virtual MatrixFormVol<Scalar>* clone() const;
 
       private:
@@ -109,6 +117,10 @@ namespace Hermes
         virtual Hermes::Ord ord(int n, double *wt, Func<Hermes::Ord> *u_ext[], Func<Hermes::Ord> *u, Func<Hermes::Ord> *v,
           GeomVol<Hermes::Ord> *e, Func<Ord> **ext) const;
 
+        /// Used only by this very class, subclasses overriding value() are evaluated per pair.
+        virtual bool value_block(int n, double *wt, Func<Scalar> *u_ext[], Func<double> **u, unsigned short u_count, Func<double> **v, unsigned short v_count,
+          GeomVol<double> *e, Func<Scalar> **ext, Scalar* result, unsigned short result_stride) const;
+
         virtual MatrixFormVol<Scalar>* clone() const;
 
       private:
@@ -144,6 +156,10 @@ namespace Hermes
         virtual Hermes::Ord ord(int n, double *wt, Func<Hermes::Ord> *u_ext[], Func<Hermes::Ord> *u, Func<Hermes::Ord> *v,
           GeomVol<Hermes::Ord> *e, Func<Ord> **ext) const;
 
+        /// Used only by this very class, subclasses overriding value() are evaluated per pair.
+        virtual bool value_block(int n, double *wt, Func<Scalar> *u_ext[], Func<double> **u, unsigned short u_count, Func<double> **v, unsigned short v_count,
+          GeomVol<double> *e, Func<Scalar> **ext, Scalar* result, unsigned short result_stride) const;
+
         virtual MatrixFormVol<Scalar>* clone() const;
 
       private:
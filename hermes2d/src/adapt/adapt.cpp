@@ -256,6 +256,7 @@ namespace Hermes
     template<typename Scalar>
     bool Adapt<Scalar>::adapt(std::vector<RefinementSelectors::Selector<Scalar> *> refinement_selectors)
     {
+      HERMES_PROFILE_SCOPE("adapt");
       // Initialize.
       MeshSharedPtr meshes[H2D_MAX_COMPONENTS];
       ElementToRefine** element_refinement_location[H2D_MAX_COMPONENTS];
@@ -292,21 +293,31 @@ namespace Hermes
           rslns.push_back(this->errorCalculator->fine_solutions[i]);
       }
 
+      // Cost-weighted scheduling - the number of refinement candidates and the cost of their projections grow with the element order.
+      std::vector<double> refinement_costs(attempted_element_refinements_count);
+      for (int id_to_refine = 0; id_to_refine < attempted_element_refinements_count; id_to_refine++)
+      {
+        typename ErrorCalculator<Scalar>::ElementReference element_reference = this->errorCalculator->get_element_reference(id_to_refine);
+        int order = this->spaces[element_reference.comp]->get_element_order(element_reference.element_id);
+        bool triangle = this->meshes[element_reference.comp]->get_element(element_reference.element_id)->is_triangle();
+        double basis_count = estimated_basis_count(std::max(H2D_GET_H_ORDER(order), H2D_GET_V_ORDER(order)), triangle);
+        refinement_costs[id_to_refine] = basis_count * basis_count;
+      }
+      this->init_scheduling(attempted_element_refinements_count, attempted_element_refinements_count > 0 ? &refinement_costs[0] : nullptr);
+
       // Parallel section
+      HERMES_PROFILE_PARENT_PHASE(adapt_phase);
 #pragma omp parallel num_threads(this->num_threads_used)
       {
+        HERMES_PROFILE_PARALLEL_REGION(adapt_phase);
         int thread_number = omp_get_thread_num();
-        int start = (attempted_element_refinements_count / this->num_threads_used) * thread_number;
-        int end = (attempted_element_refinements_count / this->num_threads_used) * (thread_number + 1);
-        if (thread_number == this->num_threads_used - 1)
-          end = attempted_element_refinements_count;
 
         // rslns cloning.
         std::vector<MeshFunctionSharedPtr<Scalar> > current_rslns;
         for (unsigned int i = 0; i < this->num; i++)
           current_rslns.push_back(rslns[i]->clone());
 
-        for (int id_to_refine = start; id_to_refine < end; id_to_refine++)
+        for (int id_to_refine = this->get_next_scheduled_item(thread_number); id_to_refine != -1; id_to_refine = this->get_next_scheduled_item(thread_number))
         {
           try
           {
@@ -320,6 +331,7 @@ namespace Hermes
             ElementToRefine elem_ref(element_id, component);
 
             // Rsln[comp] may be unset if refinement_selectors[comp] == HOnlySelector or POnlySelector
+            HERMES_PROFILE_SCOPE("selector");
             if (refinement_selectors[component]->select_refinement(meshes[component]->get_element(element_id), current_order, current_rslns[component].get(), elem_ref))
             {
               // Put this refinement to the storage.
@@ -353,6 +365,8 @@ namespace Hermes
       // Time measurement.
       this->tick();
       this->info("\tAdaptivity: refinement selection duration: %f s.", this->last());
+      for (int thread_i = 0; thread_i < this->num_threads_used; thread_i++)
+        this->info("\tAdaptivity: Thread %i: busy %f s, idle %f s.", thread_i, this->get_thread_busy_time(thread_i), this->get_thread_idle_time(thread_i));
 
       // Before applying, fix the shared mesh refinements.
       fix_shared_mesh_refinements(meshes, elements_to_refine, attempted_element_refinements_count, element_refinement_location, &refinement_selectors.front());
@@ -437,9 +451,10 @@ namespace Hermes
         int* info_array = calloc_with_check<Adapt<Scalar>, int>(union_mesh->get_num_elements(), this);
         // Traverse
         this->meshes.push_back(union_mesh);
-        Traverse trav(this->meshes.size());
-        unsigned int num_states;
-        Traverse::State** states = trav.get_states(meshes, num_states);
+        // The union mesh is new every time, so the plan is not cached.
+        TraversalPlan traversal_plan(this->meshes, this->meshes.size());
+        Traverse::State** states = traversal_plan.get_states();
+        unsigned int num_states = traversal_plan.get_num_states();
 #pragma omp parallel num_threads(this->num_threads_used)
         {
           int thread_number = omp_get_thread_num();
@@ -640,6 +655,7 @@ namespace Hermes
     template<typename Scalar>
     void Adapt<Scalar>::apply_refinements(ElementToRefine* elems_to_refine, int num_elem_to_process)
     {
+      HERMES_PROFILE_SCOPE("refinement");
       for (int i = 0; i < num_elem_to_process; i++)
         apply_refinement(elems_to_refine[i]);
     }
@@ -380,7 +380,7 @@ namespace Hermes
         {
           if (newSpace_elements_to_reassemble[space_i].find(states[state_i]->e[space_i]->id) != newSpace_elements_to_reassemble[space_i].end())
           {
-            new_states[new_num_states++] = Traverse::State::clone(states[state_i]);
+            new_states[new_num_states++] = states[state_i];
 #ifdef DEBUG_VIEWS
             reassembled_0[states[state_i]->e[0]->id] = true;
             reassembled_1[states[state_i]->e[1]->id] = true;
@@ -402,9 +402,7 @@ namespace Hermes
       ::free(reassembled_1);
 #endif
 
-      for (unsigned int i = 0; i < num_states; i++)
-        delete states[i];
-      free_with_check(states);
+      // The states are owned by the traversal plan of the DiscreteProblem, only the array is replaced.
       new_states = realloc_with_check<Traverse::State*>(new_states, new_num_states);
       states = new_states;
 
@@ -446,13 +444,15 @@ namespace Hermes
       }
       if (dirichlet_lift_rhs && StateReassemblyHelper<Scalar>::use_Dirichlet)
       {
-        unsigned int running_count = 0;
+        int running_count = 0;
         for (unsigned short space_i = 0; space_i < StateReassemblyHelper<Scalar>::current_number_of_equations; space_i++)
         {
           if ((*StateReassemblyHelper<Scalar>::reusable_Dirichlet)[space_i])
           {
-            for (unsigned int dof_i = running_count; dof_i < running_count + prev_ref_spaces[space_i]->get_num_dofs(); dof_i++)
+            for (int i = running_count; i < running_count + prev_ref_spaces[space_i]->get_num_dofs(); i++)
             {
+              // The DOFs of the space are not contiguous if the spaces were renumbered jointly.
+              int dof_i = prev_ref_spaces[space_i]->get_system_dof(i);
               if (DOF_to_DOF_map[dof_i] != -1)
                 dirichlet_lift_rhs->add(DOF_to_DOF_map[dof_i], StateReassemblyHelper<Scalar>::current_prev_dirichlet_lift_rhs->get(dof_i));
             }
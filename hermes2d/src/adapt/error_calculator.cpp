@@ -153,6 +153,7 @@ namespace Hermes
     template<typename Scalar>
     void ErrorCalculator<Scalar>::calculate_errors(std::vector<MeshFunctionSharedPtr<Scalar> > coarse_solutions_, std::vector<MeshFunctionSharedPtr<Scalar> > fine_solutions_, bool sort_and_store)
     {
+      HERMES_PROFILE_SCOPE("error calculation");
       this->coarse_solutions = coarse_solutions_;
       this->fine_solutions = fine_solutions_;
       this->component_count = this->coarse_solutions.size();
@@ -169,17 +170,19 @@ namespace Hermes
       for (int i = 0; i < this->component_count; i++)
         meshes.push_back(fine_solutions[i]->get_mesh());
 
-      unsigned int num_states;
-      Traverse trav(this->component_count);
-      Traverse::State** states = trav.get_states(meshes, num_states);
+      TraversalPlanSharedPtr traversal_plan = Traverse::get_plan(meshes, this->component_count);
+      Traverse::State** states = traversal_plan->get_states();
+      unsigned int num_states = traversal_plan->get_num_states();
+
+      // Cost-weighted scheduling of the states.
+      std::vector<double> state_costs(num_states);
+      if (num_states > 0)
+        this->estimate_state_costs(states, num_states, &state_costs[0]);
+      this->init_scheduling(num_states, num_states > 0 ? &state_costs[0] : nullptr);
 
 #pragma omp parallel num_threads(this->num_threads_used)
       {
         int thread_number = omp_get_thread_num();
-        int start = (num_states / this->num_threads_used) * thread_number;
-        int end = (num_states / this->num_threads_used) * (thread_number + 1);
-        if (thread_number == this->num_threads_used - 1)
-          end = num_states;
 
         try
         {
@@ -187,7 +190,7 @@ namespace Hermes
           ErrorThreadCalculator<Scalar> errorThreadCalculator(this);
 
           // Do the work.
-          for (int state_i = start; state_i < end; state_i++)
+          for (int state_i = this->get_next_scheduled_item(thread_number); state_i != -1; state_i = this->get_next_scheduled_item(thread_number))
             errorThreadCalculator.evaluate_one_state(states[state_i]);
         }
         catch (Hermes::Exceptions::Exception& e)
@@ -202,9 +205,8 @@ namespace Hermes
         }
       }
 
-      for (int i = 0; i < num_states; i++)
-        delete states[i];
-      free_with_check(states);
+      for (int thread_i = 0; thread_i < this->num_threads_used; thread_i++)
+        this->info("\tErrorCalculator: Thread %i: busy %f s, idle %f s.", thread_i, this->get_thread_busy_time(thread_i), this->get_thread_idle_time(thread_i));
 
       // Clean after ourselves.
       for (int i = 0; i < this->component_count; i++)
@@ -231,6 +233,43 @@ namespace Hermes
         elements_stored = false;
     }
 
+    template<typename Scalar>
+    void ErrorCalculator<Scalar>::estimate_state_costs(Traverse::State** states, unsigned int num_states, double* costs) const
+    {
+      // Solution orders are known only for Solution instances of type HERMES_SLN.
+      std::vector<int*> elem_orders(2 * this->component_count);
+      for (int i = 0; i < this->component_count; i++)
+      {
+        Solution<Scalar>* coarse_solution = dynamic_cast<Solution<Scalar>*>(this->coarse_solutions[i].get());
+        elem_orders[i] = (coarse_solution && coarse_solution->get_type() == HERMES_SLN) ? coarse_solution->elem_orders : nullptr;
+        Solution<Scalar>* fine_solution = dynamic_cast<Solution<Scalar>*>(this->fine_solutions[i].get());
+        elem_orders[this->component_count + i] = (fine_solution && fine_solution->get_type() == HERMES_SLN) ? fine_solution->elem_orders : nullptr;
+      }
+
+      std::vector<unsigned short> orders(this->component_count);
+      for (unsigned int state_i = 0; state_i < num_states; state_i++)
+      {
+        Traverse::State* current_state = states[state_i];
+        bool triangle = current_state->rep->is_triangle();
+        for (int i = 0; i < this->component_count; i++)
+        {
+          orders[i] = 0;
+          for (int solution_i = i; solution_i < 2 * this->component_count; solution_i += this->component_count)
+          {
+            if (elem_orders[solution_i] && current_state->e[solution_i])
+              orders[i] = std::max(orders[i], (unsigned short)elem_orders[solution_i][current_state->e[solution_i]->id]);
+          }
+        }
+
+        // Every form is evaluated in all integration points.
+        double cost = 1.;
+        for (unsigned short form_i = 0; form_i < this->mfvol.size(); form_i++)
+          cost += estimated_quadrature_points_count(orders[this->mfvol[form_i]->i] + orders[this->mfvol[form_i]->j], triangle);
+
+        costs[state_i] = cost;
+      }
+    }
+
     template<typename Scalar>
     void ErrorCalculator<Scalar>::postprocess_error()
     {
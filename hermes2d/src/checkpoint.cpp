@@ -0,0 +1,150 @@
+// This file is part of Hermes2D.
+//
+// Hermes2D is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 2 of the License, or
+// (at your option) any later version.
+//
+// Hermes2D is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with Hermes2D.  If not, see <http://www.gnu.org/licenses/>.
+
+#include "checkpoint.h"
+#include "mesh/mesh_reader_h2d_binary.h"
+
+namespace Hermes
+{
+  namespace Hermes2D
+  {
+    static const int H2D_CHECKPOINT_VERSION = 3;
+
+    static std::string checkpoint_prefix(const char* kind, int index)
+    {
+      char prefix[32];
+      sprintf(prefix, "%s%i.", kind, index);
+      return prefix;
+    }
+
+    template<typename Scalar>
+    Checkpoint<Scalar>::Checkpoint(const char* filename) : container(new BinaryIO::BinaryContainer(filename))
+    {
+      this->info = this->container->get_array_of_size<int>("checkpoint.info", 4);
+      if (this->info[0] != H2D_CHECKPOINT_VERSION)
+        throw Exceptions::Exception("Checkpoint %s has version %i, expected %i.", filename, this->info[0], H2D_CHECKPOINT_VERSION);
+      if (this->info[3] != (BinaryIO::binary_array_type<Scalar>() == BinaryIO::BinaryArrayComplex))
+        throw Exceptions::Exception("Real / complex mismatch in loading the checkpoint %s.", filename);
+    }
+
+    template<typename Scalar>
+    void Checkpoint<Scalar>::save(const char* filename, MeshSharedPtr mesh, std::vector<SpaceSharedPtr<Scalar> > spaces, std::vector<MeshFunctionSharedPtr<Scalar> > solutions)
+    {
+      BinaryIO::BinaryContainerWriter writer;
+
+      int* info = writer.allocate_array<int>("checkpoint.info", 4);
+      info[0] = H2D_CHECKPOINT_VERSION;
+      info[1] = spaces.size();
+      info[2] = solutions.size();
+      info[3] = (BinaryIO::binary_array_type<Scalar>() == BinaryIO::BinaryArrayComplex);
+
+      MeshReaderH2DBinary mesh_writer;
+      mesh_writer.save(writer, mesh);
+
+      for (unsigned int space_i = 0; space_i < spaces.size(); space_i++)
+      {
+        if (spaces[space_i]->get_mesh() != mesh)
+          throw Exceptions::Exception("Space %i is not on the checkpoint mesh in Checkpoint::save().", space_i);
+        spaces[space_i]->save_binary(writer, checkpoint_prefix("space", space_i).c_str());
+      }
+
+      for (unsigned int solution_i = 0; solution_i < solutions.size(); solution_i++)
+      {
+        Solution<Scalar>* solution = dynamic_cast<Solution<Scalar>*>(solutions[solution_i].get());
+        if (!solution)
+          throw Exceptions::Exception("Function %i is not a Solution in Checkpoint::save().", solution_i);
+        solution->save_binary(writer, checkpoint_prefix("solution", solution_i).c_str());
+      }
+
+      writer.write(filename);
+    }
+
+    template<typename Scalar>
+    int Checkpoint<Scalar>::get_num_spaces() const
+    {
+      return this->info[1];
+    }
+
+    template<typename Scalar>
+    int Checkpoint<Scalar>::get_num_solutions() const
+    {
+      return this->info[2];
+    }
+
+    template<typename Scalar>
+    void Checkpoint<Scalar>::load_mesh(MeshSharedPtr mesh)
+    {
+      MeshReaderH2DBinary mesh_reader;
+      mesh_reader.load(*this->container, mesh);
+    }
+
+    template<typename Scalar>
+    SpaceSharedPtr<Scalar> Checkpoint<Scalar>::load_space(int index, MeshSharedPtr mesh, EssentialBCs<Scalar>* essential_bcs, Shapeset* shapeset)
+    {
+      if (index < 0 || index >= this->get_num_spaces())
+        throw Exceptions::ValueException("index", index, 0, this->get_num_spaces());
+      return Space<Scalar>::load_binary(*this->container, checkpoint_prefix("space", index).c_str(), mesh, essential_bcs, shapeset);
+    }
+
+    template<typename Scalar>
+    std::vector<SpaceSharedPtr<Scalar> > Checkpoint<Scalar>::load_spaces(MeshSharedPtr mesh, std::vector<EssentialBCs<Scalar>*> essential_bcs, std::vector<Shapeset*> shapesets)
+    {
+      if (!essential_bcs.empty())
+        Helpers::check_length(essential_bcs, this->get_num_spaces());
+      if (!shapesets.empty())
+        Helpers::check_length(shapesets, this->get_num_spaces());
+
+      std::vector<SpaceSharedPtr<Scalar> > spaces;
+      int jointly_renumbered_count = 0;
+      for (int space_i = 0; space_i < this->get_num_spaces(); space_i++)
+      {
+        std::string prefix = checkpoint_prefix("space", space_i);
+        spaces.push_back(Space<Scalar>::load_binary_data(*this->container, prefix.c_str(), mesh, essential_bcs.empty() ? nullptr : essential_bcs[space_i], shapesets.empty() ? nullptr : shapesets[space_i]));
+        if (this->container->get_array_of_size<int>((prefix + "info").c_str(), 6)[5])
+          jointly_renumbered_count++;
+      }
+
+      // Spaces renumbered jointly are assigned together (in the saved order), the others each from its saved first DOF.
+      if (jointly_renumbered_count == this->get_num_spaces() && jointly_renumbered_count > 0)
+        Space<Scalar>::assign_dofs(spaces);
+      else if (jointly_renumbered_count > 0)
+        throw Exceptions::Exception("Some of the spaces in the checkpoint were renumbered jointly with spaces that are not in it in Checkpoint::load_spaces().");
+      else
+      {
+        for (int space_i = 0; space_i < this->get_num_spaces(); space_i++)
+          spaces[space_i]->assign_dofs(this->container->get_array_of_size<int>((checkpoint_prefix("space", space_i) + "info").c_str(), 6)[3]);
+      }
+
+      for (int space_i = 0; space_i < this->get_num_spaces(); space_i++)
+        spaces[space_i]->check_binary_dof_map(*this->container, checkpoint_prefix("space", space_i).c_str());
+
+      return spaces;
+    }
+
+    template<typename Scalar>
+    void Checkpoint<Scalar>::load_solution(int index, SpaceSharedPtr<Scalar> space, MeshFunctionSharedPtr<Scalar> solution)
+    {
+      if (index < 0 || index >= this->get_num_solutions())
+        throw Exceptions::ValueException("index", index, 0, this->get_num_solutions());
+      Solution<Scalar>* sln = dynamic_cast<Solution<Scalar>*>(solution.get());
+      if (!sln)
+        throw Exceptions::Exception("The function is not a Solution in Checkpoint::load_solution().");
+      sln->load_binary(this->container, checkpoint_prefix("solution", index).c_str(), space);
+    }
+
+    template class HERMES_API Checkpoint<double>;
+    template class HERMES_API Checkpoint<std::complex<double> >;
+  }
+}
@@ -31,7 +31,103 @@ namespace Hermes
     unsigned int DiscreteProblemDGAssembler<Scalar>::dg_order = 20;
 
     template<typename Scalar>
-    DiscreteProblemDGAssembler<Scalar>::DiscreteProblemDGAssembler(DiscreteProblemThreadAssembler<Scalar>* threadAssembler, const std::vector<SpaceSharedPtr<Scalar> > spaces, std::vector<MeshSharedPtr>& meshes)
+    DGInterfaceList<Scalar>::DGInterfaceList(TraversalPlanSharedPtr traversal_plan, const std::vector<SpaceSharedPtr<Scalar> >& spaces)
+      : traversal_plan(traversal_plan), spaces(spaces), num(0)
+    {
+      for (unsigned int i = 0; i < spaces.size(); i++)
+        this->space_types.push_back(spaces[i]->get_type());
+
+      this->num_interfaces = traversal_plan->get_num_states() * H2D_MAX_NUMBER_EDGES;
+      this->interfaces = calloc_with_check<Interface*>(this->num_interfaces, true);
+    }
+
+    template<typename Scalar>
+    DGInterfaceList<Scalar>::~DGInterfaceList()
+    {
+      for (unsigned int interface_i = 0; interface_i < this->num_interfaces; interface_i++)
+      {
+        Interface* current_interface = this->interfaces[interface_i];
+        if (!current_interface)
+          continue;
+
+        // The shared instances are deleted only once.
+        for (unsigned int i = 0; i < this->num; i++)
+        {
+          bool existing_ns = false;
+          for (int j = i - 1; j >= 0; j--)
+            if (current_interface->neighbor_searches[i] == current_interface->neighbor_searches[j])
+            {
+            existing_ns = true;
+            break;
+            }
+          if (!existing_ns)
+            delete current_interface->neighbor_searches[i];
+        }
+        free_with_check(current_interface->neighbor_searches, true);
+        delete current_interface;
+      }
+      free_with_check(this->interfaces, true);
+    }
+
+    template<typename Scalar>
+    bool DGInterfaceList<Scalar>::is_valid_for(TraversalPlanSharedPtr traversal_plan, const std::vector<SpaceSharedPtr<Scalar> >& spaces) const
+    {
+      if (this->traversal_plan != traversal_plan || this->space_types.size() != spaces.size())
+        return false;
+      for (unsigned int i = 0; i < spaces.size(); i++)
+        if (spaces[i]->get_type() != this->space_types[i])
+          return false;
+      return true;
+    }
+
+    template<typename Scalar>
+    typename DGInterfaceList<Scalar>::Interface* DGInterfaceList<Scalar>::get(Traverse::State* state, unsigned char isurf, const std::vector<MeshSharedPtr>& meshes)
+    {
+      int state_index = this->traversal_plan->get_state_index(state);
+      if (state_index == -1)
+        throw Hermes::Exceptions::Exception("DGInterfaceList: the state does not belong to the traversal plan.");
+
+      Interface*& current_interface = this->interfaces[state_index * H2D_MAX_NUMBER_EDGES + isurf];
+      if (current_interface)
+        return current_interface;
+
+      this->num = state->num;
+      current_interface = new Interface;
+      current_interface->neighbor_searches = malloc_with_check<NeighborSearch<Scalar>*>(state->num, true);
+      current_interface->num_neighbors = 0;
+
+      // Initialize the NeighborSearches.
+      bool DG_intra = false;
+      for (unsigned int i = 0; i < state->num; i++)
+      {
+        bool existing_ns = false;
+        for (int j = i - 1; j >= 0; j--)
+          if (state->e[i] == state->e[j])
+          {
+          current_interface->neighbor_searches[i] = current_interface->neighbor_searches[j];
+          existing_ns = true;
+          break;
+          }
+        if (!existing_ns)
+        {
+          NeighborSearch<Scalar>* ns = new NeighborSearch<Scalar>(state->e[i], meshes[i]);
+          ns->original_central_el_transform = state->sub_idx[i];
+          current_interface->neighbor_searches[i] = ns;
+          if (ns->set_active_edge_multimesh(isurf) && (i >= this->space_types.size() || this->space_types[i] == HERMES_L2_SPACE))
+            DG_intra = true;
+          ns->clear_initial_sub_idx();
+        }
+      }
+
+      // Create a multimesh tree, if this edge is an inter-element one on all meshes.
+      if (DG_intra)
+        MultimeshDGNeighborTree<Scalar>::process_edge(current_interface->neighbor_searches, state->num, current_interface->num_neighbors);
+
+      return current_interface;
+    }
+
+    template<typename Scalar>
+    DiscreteProblemDGAssembler<Scalar>::DiscreteProblemDGAssembler(DiscreteProblemThreadAssembler<Scalar>* threadAssembler, const std::vector<SpaceSharedPtr<Scalar> > spaces, std::vector<MeshSharedPtr>& meshes, DGInterfaceList<Scalar>* interface_list)
       : pss(threadAssembler->pss),
       refmaps(threadAssembler->refmaps),
       u_ext(threadAssembler->u_ext),
@@ -44,7 +140,9 @@ namespace Hermes
       current_state(nullptr),
       selectiveAssembler(threadAssembler->selectiveAssembler),
       spaces(spaces),
-      meshes(meshes)
+      meshes(meshes),
+      interface_list(interface_list),
+      arena(&threadAssembler->DGMemoryArena)
     {
       this->DG_matrix_forms_present = false;
       this->DG_vector_forms_present = false;
@@ -69,6 +167,9 @@ namespace Hermes
         }
       }
       this->als = threadAssembler->als;
+
+      for (unsigned int j = 0; j < H2D_MAX_COMPONENTS; j++)
+        this->ext_asmlist[j] = nullptr;
     }
 
     template<typename Scalar>
@@ -90,6 +191,9 @@ namespace Hermes
         free_with_check(npss);
         free_with_check(nrefmaps);
       }
+
+      for (unsigned int j = 0; j < H2D_MAX_COMPONENTS; j++)
+        delete this->ext_asmlist[j];
     }
 
     template<typename Scalar>
@@ -97,11 +201,8 @@ namespace Hermes
     {
       this->current_state = current_state_;
 
-      this->neighbor_searches = new NeighborSearch<Scalar>**[this->current_state->rep->nvert];
-      for (int i = 0; i < this->current_state->rep->nvert; i++)
-        this->neighbor_searches[i] = new NeighborSearch<Scalar>*[this->current_state->num];
-      this->num_neighbors = new unsigned int[this->current_state->rep->nvert];
-      processed = new bool*[current_state->rep->nvert];
+      this->interfaces = this->arena->template allocate<typename DGInterfaceList<Scalar>::Interface*>(this->current_state->rep->nvert);
+      this->processed = this->arena->template allocate<bool*>(this->current_state->rep->nvert);
 
       if (DG_matrix_forms_present)
       {
@@ -125,12 +226,16 @@ namespace Hermes
         {
           if (!current_state->bnd[current_state->isurf])
           {
-            // If this edge is an inter-element one on all meshes.
-            if (!init_neighbors(neighbor_searches[current_state->isurf], current_state))
-              continue;
-
-            // Create a multimesh tree;
-            MultimeshDGNeighborTree<Scalar>::process_edge(neighbor_searches[current_state->isurf], this->current_state->num, this->num_neighbors[current_state->isurf], this->processed[current_state->isurf]);
+            // The neighbors are precomputed, only the already processed ones depend on the assembling order.
+            typename DGInterfaceList<Scalar>::Interface* current_interface = this->interface_list->get(current_state, current_state->isurf, this->meshes);
+            this->interfaces[current_state->isurf] = current_interface;
+            this->processed[current_state->isurf] = this->arena->template allocate<bool>(current_interface->num_neighbors);
+            MultimeshDGNeighborTree<Scalar>::set_processed(current_interface->neighbor_searches, this->current_state->num, current_interface->num_neighbors, this->processed[current_state->isurf]);
+          }
+          else
+          {
+            this->interfaces[current_state->isurf] = nullptr;
+            this->processed[current_state->isurf] = nullptr;
           }
         }
         for (current_state->isurf = 0; current_state->isurf < current_state->rep->nvert; current_state->isurf++)
@@ -140,7 +245,8 @@ namespace Hermes
 #ifdef DEBUG_DG_ASSEMBLING
             debug();
 #endif
-            for (unsigned int neighbor_i = 0; neighbor_i < num_neighbors[current_state->isurf]; neighbor_i++)
+            typename DGInterfaceList<Scalar>::Interface* current_interface = this->interfaces[current_state->isurf];
+            for (unsigned int neighbor_i = 0; neighbor_i < current_interface->num_neighbors; neighbor_i++)
             {
               if (!DG_vector_forms_present && processed[current_state->isurf][neighbor_i])
                 continue;
@@ -148,13 +254,9 @@ namespace Hermes
               // DG-inner-edge-wise parameters for WeakForm.
               wf->set_active_DG_state(current_state->e, current_state->isurf);
 
-              assemble_one_neighbor(processed[current_state->isurf][neighbor_i], neighbor_i, neighbor_searches[current_state->isurf]);
+              assemble_one_neighbor(processed[current_state->isurf][neighbor_i], neighbor_i, current_interface->neighbor_searches);
             }
-
-            deinit_neighbors(neighbor_searches[current_state->isurf], current_state);
           }
-          else
-            processed[current_state->isurf] = nullptr;
         }
       }
     }
@@ -162,14 +264,7 @@ namespace Hermes
     template<typename Scalar>
     void DiscreteProblemDGAssembler<Scalar>::deinit_assembling_one_state()
     {
-      for (int i = 0; i < this->current_state->rep->nvert; i++)
-      {
-        free_with_check(neighbor_searches[i]);
-        free_with_check(processed[i]);
-      }
-      free_with_check(neighbor_searches);
-      free_with_check(num_neighbors);
-      free_with_check(processed);
+      this->arena->reset();
     }
 
     template<typename Scalar>
@@ -225,12 +320,12 @@ namespace Hermes
 
       /***/
       // The computation takes place here.
-      typename NeighborSearch<Scalar>::ExtendedShapeset** ext_asmlist = new typename NeighborSearch<Scalar>::ExtendedShapeset*[this->spaces_size];
+      // All the data of this neighbor come from the arena (released in deinit_assembling_one_state()).
       int n_quadrature_points;
-      GeomSurf<double>* geometry = malloc_with_check<GeomSurf<double>>(this->spaces_size);
-      double** jacobian_x_weights = malloc_with_check<double*>(this->spaces_size);
-      InterfaceGeom<double>** e = malloc_with_check<InterfaceGeom<double>*>(this->spaces_size);
-      DiscontinuousFunc<double>*** testFunctions = malloc_with_check<DiscontinuousFunc<double>**>(this->spaces_size);
+      GeomSurf<double>* geometry = this->arena->template allocate<GeomSurf<double> >(this->spaces_size);
+      double** jacobian_x_weights = this->arena->template allocate<double*>(this->spaces_size);
+      InterfaceGeom<double>** e = this->arena->template allocate<InterfaceGeom<double>*>(this->spaces_size);
+      DiscontinuousFunc<double>*** testFunctions = this->arena->template allocate<DiscontinuousFunc<double>**>(this->spaces_size);
 
       // Create the extended shapeset on the union of the central element and its current neighbor.
       int order = DiscreteProblemDGAssembler<Scalar>::dg_order;
@@ -241,29 +336,37 @@ namespace Hermes
           continue;
         current_neighbor_searches[i]->set_quad_order(order);
         order_base = order;
-        jacobian_x_weights[i] = new double[refmaps[i]->get_quad_2d()->get_num_points(order_base, current_state->e[i]->get_mode())];
+        jacobian_x_weights[i] = this->arena->template allocate<double>(refmaps[i]->get_quad_2d()->get_num_points(order_base, current_state->e[i]->get_mode()));
         n_quadrature_points = init_surface_geometry_points_allocated(refmaps, this->spaces_size, order_base, current_state->isurf, current_state->rep->marker, geometry[i], jacobian_x_weights[i]);
-        e[i] = new InterfaceGeom<double>(&geometry[i], current_neighbor_searches[i]->central_el, current_neighbor_searches[i]->neighb_el);
+        e[i] = new (this->arena->template allocate<InterfaceGeom<double> >(1)) InterfaceGeom<double>(&geometry[i], current_neighbor_searches[i]->central_el, current_neighbor_searches[i]->neighb_el);
 
         if (current_mat && DG_matrix_forms_present && !edge_processed)
         {
-          ext_asmlist[i] = current_neighbor_searches[i]->create_extended_asmlist(spaces[i], &als[i]);
-          testFunctions[i] = malloc_with_check<DiscontinuousFunc<double>*>(ext_asmlist[i]->cnt);
+          if (this->ext_asmlist[i])
+            this->ext_asmlist[i]->update(current_neighbor_searches[i], spaces[i]);
+          else
+            this->ext_asmlist[i] = current_neighbor_searches[i]->create_extended_asmlist(spaces[i], &als[i]);
+
+          testFunctions[i] = this->arena->template allocate<DiscontinuousFunc<double>*>(ext_asmlist[i]->cnt);
           for (int func_i = 0; func_i < ext_asmlist[i]->cnt; func_i++)
           {
             if (ext_asmlist[i]->dof[func_i] < 0)
               continue;
 
+            Func<double>* fn = new (this->arena->template allocate<Func<double> >(1)) Func<double>(this->arena);
+
             // Choose the correct shapeset for the test function.
             if (ext_asmlist[i]->has_support_on_neighbor(func_i))
             {
               npss[i]->set_active_shape(ext_asmlist[i]->neighbor_al->idx[func_i - ext_asmlist[i]->central_al->cnt]);
-              testFunctions[i][func_i] = new DiscontinuousFunc<double>(init_fn(npss[i], nrefmaps[i], current_neighbor_searches[i]->get_quad_eo(true)), true, current_neighbor_searches[i]->neighbor_edge.orientation);
+              init_fn_preallocated(fn, npss[i], nrefmaps[i], current_neighbor_searches[i]->get_quad_eo(true));
+              testFunctions[i][func_i] = DiscontinuousFunc<double>::create(this->arena, fn, true, current_neighbor_searches[i]->neighbor_edge.orientation);
             }
             else
             {
               pss[i]->set_active_shape(ext_asmlist[i]->central_al->idx[func_i]);
-              testFunctions[i][func_i] = new DiscontinuousFunc<double>(init_fn(pss[i], refmaps[i], current_neighbor_searches[i]->get_quad_eo(false)), false, current_neighbor_searches[i]->neighbor_edge.orientation);
+              init_fn_preallocated(fn, pss[i], refmaps[i], current_neighbor_searches[i]->get_quad_eo(false));
+              testFunctions[i][func_i] = DiscontinuousFunc<double>::create(this->arena, fn, false, current_neighbor_searches[i]->neighbor_edge.orientation);
             }
           }
         }
@@ -271,7 +374,7 @@ namespace Hermes
 
       DiscontinuousFunc<Scalar>** ext = init_ext_fns(wf->ext, current_neighbor_searches, order);
 
-      DiscontinuousFunc<Scalar>** u_ext_func = malloc_with_check<DiscontinuousFunc<Scalar>*>(this->spaces_size);
+      DiscontinuousFunc<Scalar>** u_ext_func = this->arena->template allocate<DiscontinuousFunc<Scalar>*>(this->spaces_size);
       if (this->nonlinear)
       {
         if (u_ext)
@@ -280,7 +383,7 @@ namespace Hermes
             if (u_ext[u_ext_func_i])
             {
             current_neighbor_searches[u_ext_func_i]->set_quad_order(order);
-            u_ext_func[u_ext_func_i] = current_neighbor_searches[u_ext_func_i]->init_ext_fn(u_ext[u_ext_func_i]);
+            u_ext_func[u_ext_func_i] = current_neighbor_searches[u_ext_func_i]->init_ext_fn(u_ext[u_ext_func_i], this->arena);
             }
             else
               u_ext_func[u_ext_func_i] = nullptr;
@@ -336,25 +439,13 @@ namespace Hermes
 
           current_mat->add(ext_asmlist_v->cnt, ext_asmlist_u->cnt, this->local_stiffness_matrix, ext_asmlist_v->dof, ext_asmlist_u->dof, H2D_MAX_LOCAL_BASIS_SIZE * 2);
         }
-
-        for (int i = 0; i < this->spaces_size; i++)
-        {
-          for (int func_i = 0; func_i < ext_asmlist[i]->cnt; func_i++)
-          {
-            if (ext_asmlist[i]->dof[func_i] < 0)
-              continue;
-            delete testFunctions[i][func_i];
-          }
-          delete ext_asmlist[i];
-          free_with_check(testFunctions[i]);
-        }
       }
 
-      free_with_check(testFunctions);
-      free_with_check(ext_asmlist);
-      
       if (current_rhs && DG_vector_forms_present)
       {
+        // One function reused for all test functions.
+        Func<double>* v = new (this->arena->template allocate<Func<double> >(1)) Func<double>(this->arena);
+
         for (unsigned int ww = 0; ww < wf->vfDG.size(); ww++)
         {
           VectorFormDG<Scalar>* vfs = wf->vfDG[ww];
@@ -375,49 +466,13 @@ namespace Hermes
               continue;
             pss[n]->set_active_shape(als[n].idx[dof_i]);
 
-            Func<double>* v = init_fn(pss[n], refmaps[n], current_neighbor_searches_v->get_quad_eo());
+            init_fn_preallocated(v, pss[n], refmaps[n], current_neighbor_searches_v->get_quad_eo());
 
             current_rhs->add(als[n].dof[dof_i], 0.5 * vfs->value(n_quadrature_points, jacobian_x_weights[n], u_ext_func, v, e[n], ext) * vfs->scaling_factor * als[n].coef[dof_i]);
-            delete v;
           }
         }
       }
 
-      if (ext)
-      {
-        for (unsigned int i = 0; i < wf->ext.size(); i++)
-        {
-          delete ext[i];
-        }
-        delete[] ext;
-      }
-
-      if (this->nonlinear)
-      {
-        if (u_ext)
-        {
-          for (int u_ext_i = 0; u_ext_i < this->spaces_size; u_ext_i++)
-            if (u_ext[u_ext_i])
-            {
-            delete u_ext_func[u_ext_i];
-            }
-        }
-      }
-
-      delete[] u_ext_func;
-
-      for (int i = 0; i < this->spaces_size; i++)
-      {
-        if (this->spaces[i]->get_type() != HERMES_L2_SPACE)
-          continue;
-        delete[] jacobian_x_weights[i];
-        delete e[i];
-      }
-
-      free_with_check(geometry);
-      free_with_check(jacobian_x_weights);
-      free_with_check(e);
-
       // This is just cleaning after ourselves.
       // Clear the transformations from the RefMaps and all functions.
       for (unsigned int fns_i = 0; fns_i < current_state->num; fns_i++)
@@ -439,63 +494,17 @@ namespace Hermes
     DiscontinuousFunc<Scalar>** DiscreteProblemDGAssembler<Scalar>::init_ext_fns(std::vector<MeshFunctionSharedPtr<Scalar> > ext,
       NeighborSearch<Scalar>** current_neighbor_searches, int order)
     {
-      DiscontinuousFunc<Scalar>** ext_fns = new DiscontinuousFunc<Scalar>*[ext.size()];
+      DiscontinuousFunc<Scalar>** ext_fns = this->arena->template allocate<DiscontinuousFunc<Scalar>*>(ext.size());
       for (unsigned int j = 0; j < ext.size(); j++)
       {
         NeighborSearch<Scalar>* ns = get_neighbor_search_ext(this->wf, current_neighbor_searches, j);
         ns->set_quad_order(order);
-        ext_fns[j] = ns->init_ext_fn(ext[j].get());
+        ext_fns[j] = ns->init_ext_fn(ext[j].get(), this->arena);
       }
 
       return ext_fns;
     }
 
-    template<typename Scalar>
-    bool DiscreteProblemDGAssembler<Scalar>::init_neighbors(NeighborSearch<Scalar>** current_neighbor_searches, Traverse::State* current_state)
-    {
-      // Initialize the NeighborSearches.
-      bool DG_intra = false;
-      for (unsigned int i = 0; i < current_state->num; i++)
-      {
-        bool existing_ns = false;
-        for (int j = i - 1; j >= 0; j--)
-          if (current_state->e[i] == current_state->e[j])
-          {
-          current_neighbor_searches[i] = current_neighbor_searches[j];
-          existing_ns = true;
-          break;
-          }
-        if (!existing_ns)
-        {
-          NeighborSearch<Scalar>* ns = new NeighborSearch<Scalar>(current_state->e[i], this->meshes[i]);
-          ns->original_central_el_transform = current_state->sub_idx[i];
-          current_neighbor_searches[i] = ns;
-          if (current_neighbor_searches[i]->set_active_edge_multimesh(current_state->isurf) && (i >= this->spaces_size || spaces[i]->get_type() == HERMES_L2_SPACE))
-            DG_intra = true;
-          current_neighbor_searches[i]->clear_initial_sub_idx();
-        }
-      }
-
-      return DG_intra;
-    }
-
-    template<typename Scalar>
-    void DiscreteProblemDGAssembler<Scalar>::deinit_neighbors(NeighborSearch<Scalar>** current_neighbor_searches, Traverse::State* current_state)
-    {
-      for (unsigned int i = 0; i < current_state->num; i++)
-      {
-        bool existing_ns = false;
-        for (int j = i - 1; j >= 0; j--)
-          if (current_state->e[i] == current_state->e[j])
-          {
-          existing_ns = true;
-          break;
-          }
-        if (!existing_ns)
-          delete current_neighbor_searches[i];
-      }
-    }
-
 #ifdef DEBUG_DG_ASSEMBLING
     template<typename Scalar>
     void DiscreteProblemDGAssembler<Scalar>::debug()
@@ -506,7 +515,7 @@ namespace Hermes
         if (DEBUG_DG_ASSEMBLING_ELEMENT != -1)
         {
           for (unsigned int i = 0; i < this->current_state->num; i++)
-            if (neighbor_searches[current_state->isurf][i]->central_el->id == DEBUG_DG_ASSEMBLING_ELEMENT)
+            if (interfaces[current_state->isurf]->neighbor_searches[i]->central_el->id == DEBUG_DG_ASSEMBLING_ELEMENT)
               pass = false;
         }
         else
@@ -522,7 +531,7 @@ namespace Hermes
           int id = 0;
           for (unsigned int i = 0; i < this->current_state->num; i++)
           {
-            NeighborSearch<Scalar>* ns = neighbor_searches[current_state->isurf][i];
+            NeighborSearch<Scalar>* ns = interfaces[current_state->isurf]->neighbor_searches[i];
             std::cout << "The " << ++id << "-th Neighbor search: " << ns->n_neighbors << " neighbors." << std::endl;
             std::cout << "\tCentral element: " << ns->central_el->id << ", Isurf: " << current_state->isurf << ", Original sub_idx: " << ns->original_central_el_transform << std::endl;
             for (int j = 0; j < ns->n_neighbors; j++)
@@ -547,6 +556,8 @@ namespace Hermes
     }
 #endif
 
+    template class HERMES_API DGInterfaceList < double > ;
+    template class HERMES_API DGInterfaceList < std::complex<double> > ;
     template class HERMES_API DiscreteProblemDGAssembler < double > ;
     template class HERMES_API DiscreteProblemDGAssembler < std::complex<double> > ;
   }
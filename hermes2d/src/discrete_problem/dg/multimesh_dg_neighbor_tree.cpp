@@ -21,6 +21,15 @@ namespace Hermes
   {
     template<typename Scalar>
     void MultimeshDGNeighborTree<Scalar>::process_edge(NeighborSearch<Scalar>** neighbor_searches, unsigned char num_neighbor_searches, unsigned int& num_neighbors, bool*& processed)
+    {
+      process_edge(neighbor_searches, num_neighbor_searches, num_neighbors);
+
+      processed = new bool[num_neighbors];
+      set_processed(neighbor_searches, num_neighbor_searches, num_neighbors, processed);
+    }
+
+    template<typename Scalar>
+    void MultimeshDGNeighborTree<Scalar>::process_edge(NeighborSearch<Scalar>** neighbor_searches, unsigned char num_neighbor_searches, unsigned int& num_neighbors)
     {
       MultimeshDGNeighborTreeNode root(nullptr, 0);
 
@@ -43,9 +52,11 @@ namespace Hermes
         if (ns->n_neighbors != num_neighbors)
           throw Hermes::Exceptions::Exception("Num_neighbors of different NeighborSearches not matching in assemble_one_state().");
       }
+    }
 
-      processed = new bool[num_neighbors];
-
+    template<typename Scalar>
+    void MultimeshDGNeighborTree<Scalar>::set_processed(NeighborSearch<Scalar>** neighbor_searches, unsigned char num_neighbor_searches, unsigned int num_neighbors, bool* processed)
+    {
       for (unsigned int neighbor_i = 0; neighbor_i < num_neighbors; neighbor_i++)
       {
         // If the active segment has already been processed (when the neighbor element was assembled), it is skipped.
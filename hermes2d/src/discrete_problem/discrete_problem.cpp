@@ -54,6 +54,8 @@ namespace Hermes
     void DiscreteProblem<Scalar>::init(bool to_set, bool dirichlet_lift_accordingly, bool use_direct_for_Dirichlet_lift)
     {
       this->reassembled_states_reuse_linear_system = nullptr;
+      this->dg_interface_list = nullptr;
+      this->u_ext_from_coefficients = true;
 
       this->spaces_size = this->spaces.size();
 
@@ -84,6 +86,9 @@ namespace Hermes
 
       if (this->dirichlet_lift_rhs)
         delete this->dirichlet_lift_rhs;
+
+      if (this->dg_interface_list)
+        delete this->dg_interface_list;
     }
 
     template<typename Scalar>
@@ -113,6 +118,26 @@ namespace Hermes
       this->selectiveAssembler.set_verbose_output(to_set);
     }
 
+    template<typename Scalar>
+    void DiscreteProblem<Scalar>::set_u_ext_from_coefficients(bool to_set)
+    {
+      this->u_ext_from_coefficients = to_set;
+    }
+
+    template<typename Scalar>
+    bool DiscreteProblem<Scalar>::u_ext_from_coefficients_possible() const
+    {
+      if (!this->u_ext_from_coefficients || this->wf->is_DG())
+        return false;
+
+      // Funcs of vector-valued basis functions carry either the curl, or the div.
+      for (int i = 0; i < this->spaces_size; i++)
+        if (this->spaces[i]->get_shapeset()->get_num_components() > 1)
+          return false;
+
+      return true;
+    }
+
     template<typename Scalar>
     void DiscreteProblem<Scalar>::set_time(double time)
     {
@@ -208,6 +233,13 @@ namespace Hermes
         spacesToSet[i]->check();
       }
 
+      // Cached integration orders were calculated for the previous spaces.
+      bool spaces_changed = this->spaces.size() != spacesToSet.size();
+      for (unsigned int i = 0; i < spacesToSet.size() && !spaces_changed; i++)
+        spaces_changed = this->spaces[i] != spacesToSet[i];
+      if (spaces_changed && this->wf)
+        this->wf->invalidate_integration_order_cache();
+
       this->spaces_size = spacesToSet.size();
       this->spaces = spacesToSet;
 
@@ -271,8 +303,10 @@ namespace Hermes
       for (unsigned char i = 0; i < this->num_threads_used; i++)
         this->threadAssembler[i]->set_weak_formulation(this->wf);
 
-      Traverse trav(this->spaces_size);
-      states = trav.get_states(meshes, num_states);
+      // The plan is cached by the meshes, so it is only created again if some of them change.
+      this->traversal_plan = Traverse::get_plan(meshes, this->spaces_size);
+      states = this->traversal_plan->get_states();
+      num_states = this->traversal_plan->get_num_states();
 
       // Init the caught parallel exception message.
       this->exceptionMessageCaughtInParallelBlock.clear();
@@ -285,9 +319,44 @@ namespace Hermes
       }
     }
 
+    template<typename Scalar>
+    void DiscreteProblem<Scalar>::estimate_state_costs(Traverse::State** states, unsigned int num_states, double* costs) const
+    {
+      std::vector<MatrixFormVol<Scalar>*> mfvol = this->wf->get_mfvol();
+      std::vector<VectorFormVol<Scalar>*> vfvol = this->wf->get_vfvol();
+
+      std::vector<unsigned short> orders(this->spaces_size);
+      for (unsigned int state_i = 0; state_i < num_states; state_i++)
+      {
+        Traverse::State* current_state = states[state_i];
+        bool triangle = current_state->rep->is_triangle();
+        for (unsigned char space_i = 0; space_i < this->spaces_size; space_i++)
+        {
+          int order = current_state->e[space_i] ? this->spaces[space_i]->get_element_order(current_state->e[space_i]->id) : 0;
+          orders[space_i] = order < 0 ? 0 : std::max(H2D_GET_H_ORDER(order), H2D_GET_V_ORDER(order));
+        }
+
+        // Every form is evaluated for (all pairs of) basis functions in all integration points.
+        double cost = 1.;
+        for (unsigned short form_i = 0; form_i < mfvol.size(); form_i++)
+        {
+          unsigned short order_i = orders[mfvol[form_i]->i], order_j = orders[mfvol[form_i]->j];
+          cost += estimated_basis_count(order_i, triangle) * estimated_basis_count(order_j, triangle) * estimated_quadrature_points_count(order_i + order_j, triangle);
+        }
+        for (unsigned short form_i = 0; form_i < vfvol.size(); form_i++)
+        {
+          unsigned short order_i = orders[vfvol[form_i]->i];
+          cost += estimated_basis_count(order_i, triangle) * estimated_quadrature_points_count(2 * order_i, triangle);
+        }
+
+        costs[state_i] = cost;
+      }
+    }
+
     template<typename Scalar>
     bool DiscreteProblem<Scalar>::assemble(Scalar*& coeff_vec, SparseMatrix<Scalar>* mat, Vector<Scalar>* rhs)
     {
+      HERMES_PROFILE_SCOPE("assemble");
       // Check.
       this->check();
       this->tick();
@@ -315,8 +384,10 @@ namespace Hermes
         if (this->current_mat && this->reassembled_states_reuse_linear_system)
           this->reassembled_states_reuse_linear_system(states, num_states, this->current_mat, this->current_rhs, this->dirichlet_lift_rhs, coeff_vec);
 
+        // Previous iterations - either directly from the coefficient vector, or through Solutions.
+        bool u_ext_from_coefficients = this->nonlinear && coeff_vec && this->u_ext_from_coefficients_possible();
         Solution<Scalar>** u_ext_sln = nullptr;
-        if (this->nonlinear && coeff_vec)
+        if (this->nonlinear && coeff_vec && !u_ext_from_coefficients)
         {
           u_ext_sln = new Solution<Scalar>*[spaces_size];
           int first_dof = 0;
@@ -333,23 +404,41 @@ namespace Hermes
           // Is this a DG assembling.
           bool is_DG = this->wf->is_DG();
 
+          // The DG interfaces are built during the first assembling on these meshes.
+          if (is_DG && !(this->dg_interface_list && this->dg_interface_list->is_valid_for(this->traversal_plan, this->spaces)))
+          {
+            if (this->dg_interface_list)
+              delete this->dg_interface_list;
+            this->dg_interface_list = new DGInterfaceList<Scalar>(this->traversal_plan, this->spaces);
+          }
+
+          // Cost-weighted scheduling of the states.
+          std::vector<double> state_costs(num_states);
+          this->estimate_state_costs(states, num_states, &state_costs[0]);
+          this->init_scheduling(num_states, &state_costs[0]);
+
+          // Local matrices from each thread are accumulated into a private copy of the CS matrix data, merged in finish().
+          // The copies are kept by the matrix for the next assembling; if they would exceed the memory limit, atomic additions are used.
+          CSMatrix<Scalar>* cs_matrix = dynamic_cast<CSMatrix<Scalar>*>(this->current_mat);
+          if (cs_matrix)
+            cs_matrix->set_thread_private_accumulation(HermesCommonApi.get_integral_param_value(Hermes::useThreadPrivateAccumulation) ? this->num_threads_used : 0,
+            HermesCommonApi.get_integral_param_value(Hermes::threadPrivateAccumulationMemoryLimit));
+
+          HERMES_PROFILE_PARENT_PHASE(assemble_phase);
 #pragma omp parallel num_threads(this->num_threads_used)
           {
+            HERMES_PROFILE_PARALLEL_REGION(assemble_phase);
             int thread_number = omp_get_thread_num();
-            int start = (num_states / this->num_threads_used) * thread_number;
-            int end = (num_states / this->num_threads_used) * (thread_number + 1);
-            if (thread_number == this->num_threads_used - 1)
-              end = num_states;
 
             try
             {
-              this->threadAssembler[thread_number]->init_assembling(u_ext_sln, spaces, this->add_dirichlet_lift);
+              this->threadAssembler[thread_number]->init_assembling(u_ext_sln, spaces, this->add_dirichlet_lift, u_ext_from_coefficients ? coeff_vec : nullptr, !this->rungeKutta);
 
               DiscreteProblemDGAssembler<Scalar>* dgAssembler;
               if (is_DG)
-                dgAssembler = new DiscreteProblemDGAssembler<Scalar>(this->threadAssembler[thread_number], this->spaces, meshes);
+                dgAssembler = new DiscreteProblemDGAssembler<Scalar>(this->threadAssembler[thread_number], this->spaces, meshes, this->dg_interface_list);
 
-              for (int state_i = start; state_i < end; state_i++)
+              for (int state_i = this->get_next_scheduled_item(thread_number); state_i != -1; state_i = this->get_next_scheduled_item(thread_number))
               {
                 // Exception already thrown -> exit the loop.
                 if (!this->exceptionMessageCaughtInParallelBlock.empty())
@@ -388,7 +477,13 @@ namespace Hermes
           }
         }
 
-        if (this->nonlinear && coeff_vec)
+        if (num_states > 0)
+        {
+          for (int thread_i = 0; thread_i < this->num_threads_used; thread_i++)
+            this->info("\tDiscreteProblem: Thread %i: busy %f s, idle %f s.", thread_i, this->get_thread_busy_time(thread_i), this->get_thread_idle_time(thread_i));
+        }
+
+        if (u_ext_sln)
         {
           for (int i = 0; i < this->spaces_size; i++)
             delete u_ext_sln[i];
@@ -429,9 +524,10 @@ namespace Hermes
     template<typename Scalar>
     void DiscreteProblem<Scalar>::deinit_assembling(Traverse::State** states, unsigned int num_states)
     {
-      for (unsigned int i = 0; i < num_states; i++)
-        delete states[i];
-      free_with_check(states);
+      // The states belong to the traversal plan, only the array may have been replaced (reassembled_states_reuse_linear_system).
+      if (states != this->traversal_plan->get_states())
+        free_with_check(states);
+      this->traversal_plan.reset();
 
       // Very important.
       if (this->add_dirichlet_lift && this->current_rhs)
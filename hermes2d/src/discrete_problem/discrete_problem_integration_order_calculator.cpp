@@ -73,10 +73,15 @@ namespace Hermes
     DiscreteProblemIntegrationOrderCalculator<Scalar>::DiscreteProblemIntegrationOrderCalculator(DiscreteProblemSelectiveAssembler<Scalar>* selectiveAssembler) :
       selectiveAssembler(selectiveAssembler),
       current_state(nullptr),
-      u_ext(nullptr)
+      u_ext(nullptr),
+      u_ext_element_orders(nullptr),
+      integration_order_cache_seq(0)
     {
     }
 
+    /// Maximum number of integration orders cached by one calculator, the cache is cleared when exceeded.
+    static const unsigned int H2D_MAX_INTEGRATION_ORDER_CACHE_SIZE = 10000;
+
     template<typename Scalar>
     int DiscreteProblemIntegrationOrderCalculator<Scalar>::calculate_order(const std::vector<SpaceSharedPtr<Scalar> >& spaces, RefMap** current_refmaps, WeakFormSharedPtr<Scalar> current_wf)
     {
@@ -84,6 +89,131 @@ namespace Hermes
       if (current_wf->global_integration_order_set)
         return current_wf->global_integration_order;
 
+      // The forms, external functions or spaces have changed.
+      if (this->integration_order_cache_seq != current_wf->integration_order_seq)
+      {
+        this->integration_order_cache.clear();
+        this->integration_order_cache_seq = current_wf->integration_order_seq;
+      }
+
+      // The order only depends on the signature, which repeats across most of the mesh.
+      this->calculate_order_signature(spaces, current_refmaps, current_wf);
+      std::map<std::vector<int>, int>::const_iterator it = this->integration_order_cache.find(this->order_signature);
+      if (it != this->integration_order_cache.end())
+      {
+        HERMES_PROFILE_COUNT("integration order cache hits", 1);
+        return it->second;
+      }
+      HERMES_PROFILE_COUNT("integration order cache misses", 1);
+
+      int order = this->calculate_order_forms(spaces, current_refmaps, current_wf);
+
+      if (this->integration_order_cache.size() >= H2D_MAX_INTEGRATION_ORDER_CACHE_SIZE)
+        this->integration_order_cache.clear();
+      this->integration_order_cache.insert(std::pair<std::vector<int>, int>(this->order_signature, order));
+
+      return order;
+    }
+
+    template<typename Scalar>
+    void DiscreteProblemIntegrationOrderCalculator<Scalar>::add_ext_orders_to_signature(std::vector<MeshFunctionSharedPtr<Scalar> >& ext, bool surface)
+    {
+      for (unsigned short ext_i = 0; ext_i < ext.size(); ext_i++)
+      {
+        if (!ext[ext_i] || !ext[ext_i]->get_active_element())
+          this->order_signature.push_back(-1);
+        else
+          this->order_signature.push_back(surface ? ext[ext_i]->get_edge_fn_order(this->current_state->isurf) : ext[ext_i]->get_fn_order());
+      }
+    }
+
+    template<typename Scalar>
+    void DiscreteProblemIntegrationOrderCalculator<Scalar>::calculate_order_signature(const std::vector<SpaceSharedPtr<Scalar> >& spaces, RefMap** current_refmaps, WeakFormSharedPtr<Scalar> current_wf)
+    {
+      this->order_signature.clear();
+      this->order_signature.push_back(this->current_state->rep->get_mode());
+
+      // Spaces - the same maximum of element and edge orders as in calc_order_*_form.
+      for (unsigned short space_i = 0; space_i < spaces.size(); space_i++)
+      {
+        Element* e = this->current_state->e[space_i];
+        if (!e)
+        {
+          this->order_signature.push_back(-1);
+          continue;
+        }
+
+        int max_order = spaces[space_i]->get_element_order(e->id);
+        max_order = std::max(H2D_GET_H_ORDER(max_order), H2D_GET_V_ORDER(max_order));
+        for (unsigned int k = 0; k < this->current_state->rep->nvert; k++)
+          max_order = std::max(max_order, spaces[space_i]->get_edge_order(e, k));
+        this->order_signature.push_back(max_order);
+        this->order_signature.push_back(spaces[space_i]->shapeset->num_components);
+        this->order_signature.push_back(current_refmaps[space_i]->get_inv_ref_order());
+      }
+
+      // Previous iterations.
+      this->order_signature.push_back((this->u_ext || this->u_ext_element_orders) ? 1 : 0);
+      if (this->u_ext)
+      {
+        for (int i = 0; i < this->selectiveAssembler->spaces_size; i++)
+          this->order_signature.push_back(this->u_ext[i]->get_active_element() ? this->u_ext[i]->get_fn_order() : -1);
+      }
+      else if (this->u_ext_element_orders)
+      {
+        for (int i = 0; i < this->selectiveAssembler->spaces_size; i++)
+          this->order_signature.push_back(this->u_ext_element_orders[i]);
+      }
+
+      // External functions.
+      this->add_ext_orders_to_signature(current_wf->ext, false);
+      for (unsigned short form_i = 0; form_i < current_wf->forms.size(); form_i++)
+        this->add_ext_orders_to_signature(current_wf->forms[form_i]->ext, false);
+
+      // Forms to be assembled.
+      for (unsigned short form_i = 0; form_i < current_wf->mfvol.size(); form_i++)
+        this->order_signature.push_back(selectiveAssembler->form_to_be_assembled(current_wf->mfvol[form_i], current_state) ? 1 : 0);
+      for (unsigned short form_i = 0; form_i < current_wf->vfvol.size(); form_i++)
+        this->order_signature.push_back(selectiveAssembler->form_to_be_assembled(current_wf->vfvol[form_i], current_state) ? 1 : 0);
+
+      // Boundary edges.
+      if (current_state->isBnd && (current_wf->mfsurf.size() > 0 || current_wf->vfsurf.size() > 0))
+      {
+        int isurf = current_state->isurf;
+        for (current_state->isurf = 0; current_state->isurf < current_state->rep->nvert; current_state->isurf++)
+        {
+          if (!current_state->bnd[current_state->isurf])
+          {
+            this->order_signature.push_back(-1);
+            continue;
+          }
+
+          if (this->u_ext)
+          {
+            for (int i = 0; i < this->selectiveAssembler->spaces_size; i++)
+              this->order_signature.push_back(this->u_ext[i]->get_active_element() ? this->u_ext[i]->get_edge_fn_order(this->current_state->isurf) : -1);
+          }
+          else if (this->u_ext_element_orders)
+          {
+            for (int i = 0; i < this->selectiveAssembler->spaces_size; i++)
+              this->order_signature.push_back(this->u_ext_element_orders[i]);
+          }
+          this->add_ext_orders_to_signature(current_wf->ext, true);
+          for (unsigned short form_i = 0; form_i < current_wf->forms.size(); form_i++)
+            this->add_ext_orders_to_signature(current_wf->forms[form_i]->ext, true);
+
+          for (unsigned short form_i = 0; form_i < current_wf->mfsurf.size(); form_i++)
+            this->order_signature.push_back(selectiveAssembler->form_to_be_assembled(current_wf->mfsurf[form_i], current_state) ? 1 : 0);
+          for (unsigned short form_i = 0; form_i < current_wf->vfsurf.size(); form_i++)
+            this->order_signature.push_back(selectiveAssembler->form_to_be_assembled(current_wf->vfsurf[form_i], current_state) ? 1 : 0);
+        }
+        current_state->isurf = isurf;
+      }
+    }
+
+    template<typename Scalar>
+    int DiscreteProblemIntegrationOrderCalculator<Scalar>::calculate_order_forms(const std::vector<SpaceSharedPtr<Scalar> >& spaces, RefMap** current_refmaps, WeakFormSharedPtr<Scalar> current_wf)
+    {
       // Order calculation.
       int order = 0;
 
@@ -286,6 +416,14 @@ namespace Hermes
             u_ext_func[i] = &func_order[0];
         }
       }
+      // Evaluated from the coefficient vector - the same orders as of the corresponding Solutions (scalar spaces only).
+      else if (this->u_ext_element_orders)
+      {
+        u_ext_func = new Func<Hermes::Ord>*[this->selectiveAssembler->spaces_size];
+
+        for (int i = 0; i < this->selectiveAssembler->spaces_size; i++)
+          u_ext_func[i] = &func_order[std::max(this->u_ext_element_orders[i], 0)];
+      }
 
       return u_ext_func;
     }
@@ -26,7 +26,7 @@ namespace Hermes
   {
     template<typename Scalar>
     DiscreteProblemThreadAssembler<Scalar>::DiscreteProblemThreadAssembler(DiscreteProblemSelectiveAssembler<Scalar>* selectiveAssembler, bool nonlinear) :
-      pss(nullptr), refmaps(nullptr), u_ext(nullptr),
+      pss(nullptr), refmaps(nullptr), u_ext(nullptr), u_ext_coeff_vec(nullptr),
       selectiveAssembler(selectiveAssembler), integrationOrderCalculator(selectiveAssembler),
       ext_funcs(nullptr), ext_funcs_allocated_size(0), ext_funcs_local(nullptr), ext_funcs_local_allocated_size(0),
       funcs_wf_initialized(false), funcs_space_initialized(false), spaces_size(0), nonlinear(nonlinear), reusable_DOFs(nullptr), reusable_Dirichlet(nullptr)
@@ -80,11 +80,29 @@ namespace Hermes
     }
 
     template<typename Scalar>
-    void DiscreteProblemThreadAssembler<Scalar>::init_u_ext(const std::vector<SpaceSharedPtr<Scalar> > spaces, Solution<Scalar>** u_ext_sln)
+    void DiscreteProblemThreadAssembler<Scalar>::init_u_ext(const std::vector<SpaceSharedPtr<Scalar> > spaces, Solution<Scalar>** u_ext_sln, const Scalar* u_ext_coeff_vec, bool u_ext_add_dir_lift)
     {
       assert(this->spaces_size == spaces.size() && this->pss);
 
       free_u_ext();
+
+      // Evaluated directly from the coefficient vector, no Solutions.
+      this->u_ext_coeff_vec = u_ext_coeff_vec;
+      if (u_ext_coeff_vec)
+      {
+        int start_index = 0;
+        for (unsigned int j = 0; j < spaces_size; j++)
+        {
+          this->u_ext_coeff_offsets[j] = start_index - spaces[j]->first_dof;
+          start_index += spaces[j]->get_num_dofs();
+        }
+        this->u_ext_dir_lift_coeff = u_ext_add_dir_lift ? 1.0 : 0.0;
+
+        this->integrationOrderCalculator.u_ext = nullptr;
+        this->integrationOrderCalculator.u_ext_element_orders = this->u_ext_orders;
+        return;
+      }
+
       u_ext = malloc_with_check<Solution<Scalar>*>(spaces_size);
 
       for (unsigned int j = 0; j < spaces_size; j++)
@@ -104,10 +122,11 @@ namespace Hermes
       }
 
       this->integrationOrderCalculator.u_ext = this->u_ext;
+      this->integrationOrderCalculator.u_ext_element_orders = nullptr;
     }
 
     template<typename Scalar>
-    void DiscreteProblemThreadAssembler<Scalar>::init_assembling(Solution<Scalar>** u_ext_sln, const std::vector<SpaceSharedPtr<Scalar> >& spaces, bool add_dirichlet_lift_)
+    void DiscreteProblemThreadAssembler<Scalar>::init_assembling(Solution<Scalar>** u_ext_sln, const std::vector<SpaceSharedPtr<Scalar> >& spaces, bool add_dirichlet_lift_, const Scalar* u_ext_coeff_vec, bool u_ext_add_dir_lift)
     {
       // Basic settings.
       this->add_dirichlet_lift = add_dirichlet_lift_;
@@ -142,11 +161,14 @@ namespace Hermes
       // - u_ext.
       if (this->nonlinear)
       {
-        init_u_ext(spaces, u_ext_sln);
-        for (unsigned j = 0; j < this->wf->get_neq(); j++)
+        init_u_ext(spaces, u_ext_sln, u_ext_coeff_vec, u_ext_add_dir_lift);
+        if (u_ext)
         {
-          fns.push_back(u_ext[j]);
-          u_ext[j]->set_quad_2d(&g_quad_2d_std);
+          for (unsigned j = 0; j < this->wf->get_neq(); j++)
+          {
+            fns.push_back(u_ext[j]);
+            u_ext[j]->set_quad_2d(&g_quad_2d_std);
+          }
         }
       }
 
@@ -183,14 +205,14 @@ namespace Hermes
       for (unsigned short space_i = 0; space_i < this->spaces_size; space_i++)
       {
         for (unsigned int j = 0; j < H2D_MAX_LOCAL_BASIS_SIZE; j++)
-          this->funcs[space_i][j] = preallocate_fn<double>(this->FuncMemoryPool);
+          this->funcs[space_i][j] = preallocate_fn<double>(this->FuncMemoryPool, &this->FuncValuesArena);
 
         for (int edge_i = 0; edge_i < H2D_MAX_NUMBER_EDGES; edge_i++)
           for (unsigned int j = 0; j < H2D_MAX_LOCAL_BASIS_SIZE; j++)
-            this->funcsSurface[edge_i][space_i][j] = preallocate_fn<double>(this->FuncMemoryPool);
+            this->funcsSurface[edge_i][space_i][j] = preallocate_fn<double>(this->FuncMemoryPool, &this->FuncValuesArena);
 
         if (this->nonlinear)
-          this->u_ext_funcs[space_i] = preallocate_fn<Scalar>(this->FuncMemoryPool);
+          this->u_ext_funcs[space_i] = preallocate_fn<Scalar>(this->FuncMemoryPool, &this->FuncValuesArena);
       }
     }
 
@@ -213,10 +235,10 @@ namespace Hermes
       if (ext_size > 0 || u_ext_fns_size > 0)
       {
         for (int ext_i = 0; ext_i < u_ext_fns_size; ext_i++)
-          this->ext_funcs[ext_i] = preallocate_fn<Scalar>(this->FuncMemoryPool);
+          this->ext_funcs[ext_i] = preallocate_fn<Scalar>(this->FuncMemoryPool, &this->FuncValuesArena);
 
         for (int ext_i = 0; ext_i < ext_size; ext_i++)
-          this->ext_funcs[u_ext_fns_size + ext_i] = preallocate_fn<Scalar>(this->FuncMemoryPool);
+          this->ext_funcs[u_ext_fns_size + ext_i] = preallocate_fn<Scalar>(this->FuncMemoryPool, &this->FuncValuesArena);
       }
 
       // Calculating local sizes.
@@ -242,10 +264,10 @@ namespace Hermes
 
         // Initializaton of form-(local-)ext funcs
         for (int ext_i = 0; ext_i < local_u_ext_fns_size; ext_i++)
-          this->ext_funcs_local[ext_i] = preallocate_fn<Scalar>(this->FuncMemoryPool);
+          this->ext_funcs_local[ext_i] = preallocate_fn<Scalar>(this->FuncMemoryPool, &this->FuncValuesArena);
 
         for (int ext_i = 0; ext_i < local_ext_size; ext_i++)
-          this->ext_funcs_local[local_u_ext_fns_size + ext_i] = preallocate_fn<Scalar>(this->FuncMemoryPool);
+          this->ext_funcs_local[local_u_ext_fns_size + ext_i] = preallocate_fn<Scalar>(this->FuncMemoryPool, &this->FuncValuesArena);
       }
     }
 
@@ -331,6 +353,9 @@ namespace Hermes
       current_state = current_state_;
       this->integrationOrderCalculator.current_state = this->current_state;
 
+      // All Funcs are re-initialized for this state.
+      this->FuncValuesArena.reset();
+
       // Active elements.
       for (unsigned short j = 0; j < fns.size(); j++)
       {
@@ -369,8 +394,31 @@ namespace Hermes
         }
       }
 
+      // Orders of the previous iterations evaluated from the coefficient vector - as of the corresponding Solutions.
+      if (this->nonlinear && this->u_ext_coeff_vec)
+      {
+        for (int j = 0; j < this->spaces_size; j++)
+        {
+          Element* e = current_state->e[j];
+          if (!e)
+          {
+            this->u_ext_orders[j] = -1;
+            continue;
+          }
+
+          int o = spaces[j]->get_element_order(e->id);
+          o = std::max(H2D_GET_H_ORDER(o), H2D_GET_V_ORDER(o));
+          for (unsigned char k = 0; k < e->get_nvert(); k++)
+            o = std::max(o, spaces[j]->get_edge_order(e, k));
+          this->u_ext_orders[j] = o;
+        }
+      }
+
       // Volumetric integration order.
-      this->order = this->integrationOrderCalculator.calculate_order(spaces, this->refmaps, this->wf);
+      {
+        HERMES_PROFILE_SCOPE("order calculation");
+        this->order = this->integrationOrderCalculator.calculate_order(spaces, this->refmaps, this->wf);
+      }
 
       // Init the variables (funcs, geometry, ...)
       this->init_calculation_variables();
@@ -379,6 +427,7 @@ namespace Hermes
     template<typename Scalar>
     void DiscreteProblemThreadAssembler<Scalar>::init_calculation_variables()
     {
+      HERMES_PROFILE_SCOPE("precalc");
       for (unsigned short space_i = 0; space_i < this->spaces_size; space_i++)
       {
         if (current_state->e[space_i] == nullptr)
@@ -427,10 +476,16 @@ namespace Hermes
     }
 
     template<typename Scalar>
-    void DiscreteProblemThreadAssembler<Scalar>::init_u_ext_values(int order)
+    void DiscreteProblemThreadAssembler<Scalar>::init_u_ext_values(int order, int isurf)
     {
       if (this->nonlinear)
       {
+        if (this->u_ext_coeff_vec)
+        {
+          this->init_u_ext_values_from_coefficients(order, isurf);
+          return;
+        }
+
         for (int i = 0; i < spaces_size; i++)
         {
           if (u_ext[i]->get_active_element())
@@ -439,6 +494,56 @@ namespace Hermes
       }
     }
 
+    template<typename Scalar>
+    void DiscreteProblemThreadAssembler<Scalar>::init_u_ext_values_from_coefficients(int order, int isurf)
+    {
+      int np = (isurf == -1) ? this->n_quadrature_points : this->n_quadrature_pointsSurface[isurf];
+
+      // On edges, all the element basis functions (not only the edge ones in funcsSurface) are needed for the derivatives.
+      Func<double> surface_fn(&this->FuncValuesArena);
+
+      for (unsigned short space_i = 0; space_i < this->spaces_size; space_i++)
+      {
+        if (!current_state->e[space_i])
+          continue;
+
+        Func<Scalar>* u = this->u_ext_funcs[space_i];
+        u->allocate(np, 1);
+        memset(u->val, 0, np * sizeof(Scalar));
+        memset(u->dx, 0, np * sizeof(Scalar));
+        memset(u->dy, 0, np * sizeof(Scalar));
+#ifdef H2D_USE_SECOND_DERIVATIVES
+        memset(u->laplace, 0, np * sizeof(Scalar));
+#endif
+
+        AsmList<Scalar>* al = &this->als[space_i];
+        for (unsigned int j = 0; j < al->cnt; j++)
+        {
+          Scalar coef = al->coef[j] * (al->dof[j] >= 0 ? this->u_ext_coeff_vec[al->dof[j] + this->u_ext_coeff_offsets[space_i]] : this->u_ext_dir_lift_coeff);
+          if (coef == 0.)
+            continue;
+
+          Func<double>* fn = this->funcs[space_i][j];
+          if (isurf != -1)
+          {
+            pss[space_i]->set_active_shape(al->idx[j]);
+            init_fn_preallocated(&surface_fn, pss[space_i], refmaps[space_i], order);
+            fn = &surface_fn;
+          }
+
+          for (int i = 0; i < np; i++)
+          {
+            u->val[i] += coef * fn->val[i];
+            u->dx[i] += coef * fn->dx[i];
+            u->dy[i] += coef * fn->dy[i];
+#ifdef H2D_USE_SECOND_DERIVATIVES
+            u->laplace[i] += coef * fn->laplace[i];
+#endif
+          }
+        }
+      }
+    }
+
     template<typename Scalar>
     template<typename Geom>
     void DiscreteProblemThreadAssembler<Scalar>::init_ext_values(Func<Scalar>** target_array, std::vector<MeshFunctionSharedPtr<Scalar> >& ext, std::vector<UExtFunctionSharedPtr<Scalar> >& u_ext_fns, int order, Func<Scalar>** u_ext_func, Geom* geometry)
@@ -474,6 +579,8 @@ namespace Hermes
     template<typename Scalar>
     void DiscreteProblemThreadAssembler<Scalar>::assemble_one_state()
     {
+      HERMES_PROFILE_SCOPE("form evaluation");
+      HERMES_PROFILE_COUNT("quadrature points", this->n_quadrature_points);
       // init - u_ext_func
       this->init_u_ext_values(this->order);
 
@@ -520,7 +627,7 @@ namespace Hermes
           this->wf->set_active_edge_state(current_state->e, isurf);
 
           // init - u_ext_func
-          this->init_u_ext_values(this->orderSurface[isurf]);
+          this->init_u_ext_values(this->orderSurface[isurf], isurf);
 
           // init - ext
           this->init_ext_values(this->ext_funcs, this->wf->ext, this->wf->u_ext_fn, this->orderSurface[isurf], this->u_ext_funcs, &this->geometrySurface[isurf]);
@@ -562,6 +669,7 @@ namespace Hermes
     void DiscreteProblemThreadAssembler<Scalar>::assemble_matrix_form(MatrixFormType* form, int order, Func<double>** base_fns, Func<double>** test_fns,
       AsmList<Scalar>* current_als_i, AsmList<Scalar>* current_als_j, int n_quadrature_points, Geom* geometry, double* jacobian_x_weights)
     {
+      HERMES_PROFILE_COUNT("matrix forms evaluated", 1);
       bool surface_form = (dynamic_cast<MatrixFormVol<Scalar>*>(form) == nullptr);
 
       double block_scaling_coefficient = this->block_scaling_coeff(form);
@@ -582,6 +690,12 @@ namespace Hermes
       if (this->rungeKutta)
         u_ext_local += form->u_ext_offset;
 
+      // Batched evaluation of all the (i, j) pairs at once, if the form supports it.
+      // Only worth it if the matrix is assembled, otherwise just the Dirichlet lift pairs are needed.
+      bool block_evaluated = false;
+      if (this->current_mat)
+        block_evaluated = this->evaluate_matrix_form_block(form, n_quadrature_points, jacobian_x_weights, u_ext_local, base_fns, current_als_j->cnt, test_fns, current_als_i->cnt, geometry, ext_local);
+
       // Actual form-specific calculation.
       for (unsigned int i = 0; i < current_als_i->cnt; i++)
       {
@@ -624,10 +738,17 @@ namespace Hermes
           if (std::abs(current_als_j->coef[j]) < Hermes::HermesEpsilon)
             continue;
 
-          Func<double>* u = base_fns[j];
-          Func<double>* v = test_fns[i];
+          Scalar form_value;
+          if (block_evaluated)
+            form_value = local_form_values[i * H2D_MAX_LOCAL_BASIS_SIZE + j];
+          else
+          {
+            Func<double>* u = base_fns[j];
+            Func<double>* v = test_fns[i];
+            form_value = form->value(n_quadrature_points, jacobian_x_weights, u_ext_local, u, v, geometry, ext_local);
+          }
 
-          Scalar val = block_scaling_coefficient * form->value(n_quadrature_points, jacobian_x_weights, u_ext_local, u, v, geometry, ext_local) * form->scaling_factor * current_als_j->coef[j] * current_als_i->coef[i];
+          Scalar val = block_scaling_coefficient * form_value * form->scaling_factor * current_als_j->coef[j] * current_als_i->coef[i];
 
           if (current_als_j->dof[j] >= 0)
           {
@@ -653,7 +774,10 @@ namespace Hermes
 
       // Insert the local stiffness matrix into the global one.
       if (this->current_mat)
+      {
+        HERMES_PROFILE_SCOPE("matrix scatter");
         this->current_mat->add(current_als_i->cnt, current_als_j->cnt, local_stiffness_matrix, current_als_i->dof, current_als_j->dof, H2D_MAX_LOCAL_BASIS_SIZE);
+      }
 
       // Insert also the off-diagonal (anti-)symmetric block, if required.
       if (tra)
@@ -663,7 +787,10 @@ namespace Hermes
         transpose(local_stiffness_matrix, current_als_i->cnt, current_als_j->cnt, H2D_MAX_LOCAL_BASIS_SIZE);
 
         if (this->current_mat)
+        {
+          HERMES_PROFILE_SCOPE("matrix scatter");
           this->current_mat->add(current_als_j->cnt, current_als_i->cnt, local_stiffness_matrix, current_als_j->dof, current_als_i->dof, H2D_MAX_LOCAL_BASIS_SIZE);
+        }
 
         if (this->add_dirichlet_lift && this->current_rhs)
         {
@@ -685,11 +812,26 @@ namespace Hermes
       }
     }
 
+    template<typename Scalar>
+    bool DiscreteProblemThreadAssembler<Scalar>::evaluate_matrix_form_block(MatrixFormVol<Scalar>* form, int n_quadrature_points, double* jacobian_x_weights, Func<Scalar>** u_ext_local,
+      Func<double>** base_fns, unsigned short base_fns_count, Func<double>** test_fns, unsigned short test_fns_count, GeomVol<double>* geometry, Func<Scalar>** ext_local)
+    {
+      return form->value_block(n_quadrature_points, jacobian_x_weights, u_ext_local, base_fns, base_fns_count, test_fns, test_fns_count, geometry, ext_local, this->local_form_values, H2D_MAX_LOCAL_BASIS_SIZE);
+    }
+
+    template<typename Scalar>
+    bool DiscreteProblemThreadAssembler<Scalar>::evaluate_matrix_form_block(MatrixFormSurf<Scalar>* form, int n_quadrature_points, double* jacobian_x_weights, Func<Scalar>** u_ext_local,
+      Func<double>** base_fns, unsigned short base_fns_count, Func<double>** test_fns, unsigned short test_fns_count, GeomSurf<double>* geometry, Func<Scalar>** ext_local)
+    {
+      return false;
+    }
+
     template<typename Scalar>
     template<typename VectorFormType, typename Geom>
     void DiscreteProblemThreadAssembler<Scalar>::assemble_vector_form(VectorFormType* form, int order, Func<double>** test_fns,
       AsmList<Scalar>* current_als_i, int n_quadrature_points, Geom* geometry, double* jacobian_x_weights)
     {
+      HERMES_PROFILE_COUNT("vector forms evaluated", 1);
       bool surface_form = (dynamic_cast<VectorFormVol<Scalar>*>(form) == nullptr);
 
       Func<Scalar>** ext_local = this->ext_funcs;
@@ -23,20 +23,65 @@ namespace Hermes
 {
   namespace Hermes2D
   {
-    Func<double>::Func() : np(-1), nc(-1)
+    template<typename Scalar>
+    Func<Scalar>::Func() : val(nullptr), dx(nullptr), dy(nullptr), laplace(nullptr), np(-1), nc(-1), arena(nullptr), storage(nullptr), storage_size(0)
     {
     }
 
-    Func<double>::Func(int np, int nc) : np(np), nc(nc)
+    template<typename Scalar>
+    Func<Scalar>::Func(MemoryArena* arena) : val(nullptr), dx(nullptr), dy(nullptr), laplace(nullptr), np(-1), nc(-1), arena(arena), storage(nullptr), storage_size(0)
     {
     }
 
-    Func<std::complex<double> >::Func() : np(-1), nc(-1)
+    template<typename Scalar>
+    Func<Scalar>::Func(int np, int nc) : val(nullptr), dx(nullptr), dy(nullptr), laplace(nullptr), np(-1), nc(-1), arena(nullptr), storage(nullptr), storage_size(0)
+    {
+      this->allocate(np, nc);
+    }
+
+    template<typename Scalar>
+    Func<Scalar>::~Func()
     {
+      free_with_check(this->storage);
     }
 
-    Func<std::complex<double> >::Func(int np, int nc) : np(np), nc(nc)
+    template<typename Scalar>
+    int Func<Scalar>::get_array_count(int nc)
     {
+#ifdef H2D_USE_SECOND_DERIVATIVES
+      return 4;
+#else
+      return nc == 1 ? 3 : 4;
+#endif
+    }
+
+    template<typename Scalar>
+    void Func<Scalar>::allocate(int np, int nc)
+    {
+      this->np = np;
+      this->nc = nc;
+
+      int array_count = get_array_count(nc);
+      int size = array_count * np;
+
+      Scalar* data;
+      if (this->arena)
+        data = this->arena->template allocate<Scalar>(size);
+      else
+      {
+        if (size > this->storage_size)
+        {
+          free_with_check(this->storage);
+          this->storage = malloc_with_check<Scalar>(size);
+          this->storage_size = size;
+        }
+        data = this->storage;
+      }
+
+      this->val = data;
+      this->dx = data + np;
+      this->dy = data + 2 * np;
+      this->laplace = (array_count == 4) ? data + 3 * np : nullptr;
     }
 
     Func<Hermes::Ord>::Func(const int order) : order(order)
@@ -53,64 +98,23 @@ namespace Hermes
 #endif
     }
 
-    void Func<double>::subtract(Func<double>* func)
-    {
-      if (this->np != func->np)
-        throw Hermes::Exceptions::Exception("Unable to subtract a function due to a different number of integration points (this: %d, other: %d)", np, func->np);
-      if (nc != func->nc)
-        throw Hermes::Exceptions::Exception("Unable to subtract a function due to a different number of components (this: %d, other: %d)", nc, func->nc);
-
-      subtract(this->val, func->val);
-      subtract(this->dx, func->dx);
-      subtract(this->dy, func->dy);
-
-#ifdef H2D_USE_SECOND_DERIVATIVES
-      subtract(this->laplace, func->laplace);
-#endif
-
-      if (nc > 1)
-      {
-        subtract(this->val0, func->val0);
-        subtract(this->val1, func->val1);
-        subtract(this->curl, func->curl);
-        subtract(this->div, func->div);
-      }
-    };
-
-    void Func<std::complex<double> >::subtract(Func<std::complex<double> >* func)
+    template<typename Scalar>
+    void Func<Scalar>::subtract(Func<Scalar>* func)
     {
       if (this->np != func->np)
         throw Hermes::Exceptions::Exception("Unable to subtract a function due to a different number of integration points (this: %d, other: %d)", np, func->np);
       if (nc != func->nc)
         throw Hermes::Exceptions::Exception("Unable to subtract a function due to a different number of components (this: %d, other: %d)", nc, func->nc);
 
+      // val0, val1, curl, div share the storage with val, dx, dy, laplace.
       subtract(this->val, func->val);
       subtract(this->dx, func->dx);
       subtract(this->dy, func->dy);
-
-#ifdef H2D_USE_SECOND_DERIVATIVES
       subtract(this->laplace, func->laplace);
-#endif
-
-      if (nc > 1)
-      {
-        subtract(this->val0, func->val0);
-        subtract(this->val1, func->val1);
-        subtract(this->curl, func->curl);
-        subtract(this->div, func->div);
-      }
     };
 
-    void Func<double>::subtract(double* attribute, double* other_attribute)
-    {
-      if (attribute != nullptr && other_attribute != nullptr)
-      {
-        for (int i = 0; i < this->np; i++)
-          attribute[i] -= other_attribute[i];
-      }
-    }
-
-    void Func<std::complex<double> >::subtract(std::complex<double> * attribute, std::complex<double> * other_attribute)
+    template<typename Scalar>
+    void Func<Scalar>::subtract(Scalar* attribute, Scalar* other_attribute)
     {
       if (attribute != nullptr && other_attribute != nullptr)
       {
@@ -119,67 +123,23 @@ namespace Hermes
       }
     }
 
-    void Func<double>::add(Func<double>* func)
-    {
-      if (this->np != func->np)
-        throw Hermes::Exceptions::Exception("Unable to add a function due to a different number of integration points (this: %d, other: %d)", np, func->np);
-      if (nc != func->nc)
-        throw Hermes::Exceptions::Exception("Unable to add a function due to a different number of components (this: %d, other: %d)", nc, func->nc);
-
-      add(this->val, func->val);
-      add(this->dx, func->dx);
-      add(this->dy, func->dy);
-
-#ifdef H2D_USE_SECOND_DERIVATIVES
-      add(this->laplace, func->laplace);
-#endif
-
-      if (nc > 1)
-      {
-        add(this->val0, func->val0);
-        add(this->val1, func->val1);
-        add(this->curl, func->curl);
-        add(this->div, func->div);
-      }
-    };
-
-#ifdef H2D_USE_SECOND_DERIVATIVES
-    template<>
-#endif
-    void Func<std::complex<double> >::add(Func<std::complex<double> >* func)
+    template<typename Scalar>
+    void Func<Scalar>::add(Func<Scalar>* func)
     {
       if (this->np != func->np)
         throw Hermes::Exceptions::Exception("Unable to add a function due to a different number of integration points (this: %d, other: %d)", np, func->np);
       if (nc != func->nc)
         throw Hermes::Exceptions::Exception("Unable to add a function due to a different number of components (this: %d, other: %d)", nc, func->nc);
 
+      // val0, val1, curl, div share the storage with val, dx, dy, laplace.
       add(this->val, func->val);
       add(this->dx, func->dx);
       add(this->dy, func->dy);
-
-#ifdef H2D_USE_SECOND_DERIVATIVES
       add(this->laplace, func->laplace);
-#endif
-
-      if (nc > 1)
-      {
-        add(this->val0, func->val0);
-        add(this->val1, func->val1);
-        add(this->curl, func->curl);
-        add(this->div, func->div);
-      }
     };
 
-    void Func<double>::add(double* attribute, double* other_attribute)
-    {
-      if (attribute != nullptr && other_attribute != nullptr)
-      {
-        for (int i = 0; i < this->np; i++)
-          attribute[i] += other_attribute[i];
-      }
-    }
-
-    void Func<std::complex<double> >::add(std::complex<double> * attribute, std::complex<double> * other_attribute)
+    template<typename Scalar>
+    void Func<Scalar>::add(Scalar* attribute, Scalar* other_attribute)
     {
       if (attribute != nullptr && other_attribute != nullptr)
       {
@@ -190,10 +150,13 @@ namespace Hermes
 
     template<typename T>
     DiscontinuousFunc<T>::DiscontinuousFunc(Func<T>* fn, bool support_on_neighbor, bool reverse) :
-      Func<T>(fn->np, fn->nc), fn_central(nullptr), fn_neighbor(nullptr), reverse_neighbor_side(reverse)
+      Func<T>(), fn_central(nullptr), fn_neighbor(nullptr), reverse_neighbor_side(reverse)
     {
       if (fn == nullptr)
         throw Hermes::Exceptions::Exception("Invalid arguments to DiscontinuousFunc constructor.");
+      // The values are those of the components, no own storage.
+      this->np = fn->np;
+      this->nc = fn->nc;
       if (support_on_neighbor)
       {
         fn_neighbor = fn;
@@ -230,8 +193,11 @@ namespace Hermes
 
     template<typename T>
     DiscontinuousFunc<T>::DiscontinuousFunc(Func<T>* fn_c, Func<T>* fn_n, bool reverse) :
-      Func<T>(fn_c->np, fn_c->nc), fn_central(fn_c), fn_neighbor(fn_n), reverse_neighbor_side(reverse)
+      Func<T>(), fn_central(fn_c), fn_neighbor(fn_n), reverse_neighbor_side(reverse)
     {
+      // The values are those of the components, no own storage.
+      this->np = fn_c->np;
+      this->nc = fn_c->nc;
       if (reverse_neighbor_side)
       {
         this->val_neighbor = malloc_with_check<DiscontinuousFunc<T>, T>(this->np, this);
@@ -305,6 +271,39 @@ namespace Hermes
       }
     }
 
+    template<typename T>
+    DiscontinuousFunc<T>* DiscontinuousFunc<T>::create(MemoryArena* arena, Func<T>* fn, bool support_on_neighbor, bool reverse)
+    {
+      DiscontinuousFunc<T>* result = new (arena->allocate<DiscontinuousFunc<T> >(1)) DiscontinuousFunc<T>(fn, support_on_neighbor);
+      if (reverse && support_on_neighbor)
+        result->reverse_neighbor_values(arena);
+      return result;
+    }
+
+    template<typename T>
+    DiscontinuousFunc<T>* DiscontinuousFunc<T>::create(MemoryArena* arena, Func<T>* fn_c, Func<T>* fn_n, bool reverse)
+    {
+      DiscontinuousFunc<T>* result = new (arena->allocate<DiscontinuousFunc<T> >(1)) DiscontinuousFunc<T>(fn_c, fn_n);
+      if (reverse)
+        result->reverse_neighbor_values(arena);
+      return result;
+    }
+
+    template<typename T>
+    void DiscontinuousFunc<T>::reverse_neighbor_values(MemoryArena* arena)
+    {
+      this->reverse_neighbor_side = true;
+      this->val_neighbor = arena->allocate<T>(3 * this->np);
+      this->dx_neighbor = this->val_neighbor + this->np;
+      this->dy_neighbor = this->dx_neighbor + this->np;
+      for (int i = 0; i < this->np; i++)
+      {
+        this->val_neighbor[i] = fn_neighbor->val[this->np - i - 1];
+        this->dx_neighbor[i] = fn_neighbor->dx[this->np - i - 1];
+        this->dy_neighbor[i] = fn_neighbor->dy[this->np - i - 1];
+      }
+    }
+
     template<typename T>
     DiscontinuousFunc<T>::~DiscontinuousFunc()
     {
@@ -486,12 +485,12 @@ namespace Hermes
     }
 
     template<typename Scalar>
-    Func<Scalar>* preallocate_fn(pj_pool_t* memoryPool)
+    Func<Scalar>* preallocate_fn(pj_pool_t* memoryPool, MemoryArena* arena)
     {
       if (memoryPool)
-        return (Func<Scalar>*)pj_pool_alloc(memoryPool, sizeof(Func<Scalar>));
+        return new (pj_pool_alloc(memoryPool, sizeof(Func<Scalar>))) Func<Scalar>(arena);
       else
-        return new Func<Scalar>();
+        return new Func<Scalar>(arena);
     }
 
     void init_fn_preallocated(Func<double>* u, PrecalcShapeset *fu, RefMap *rm, const int order)
@@ -509,8 +508,7 @@ namespace Hermes
 
       int nc = fu->get_num_components();
       unsigned char np = fu->get_quad_2d()->get_num_points(order, fu->get_active_element()->get_mode());
-      u->np = np;
-      u->nc = nc;
+      u->allocate(np, nc);
 
       // H1 & L2 space.
       if (space_type == HERMES_H1_SPACE || space_type == HERMES_L2_SPACE)
@@ -680,8 +678,7 @@ namespace Hermes
 #endif
       int nc = fu->get_num_components();
       unsigned char np = quad->get_num_points(order, fu->get_active_element()->get_mode());
-      u->np = np;
-      u->nc = nc;
+      u->allocate(np, nc);
 
       if (u->nc == 1)
       {
@@ -725,6 +722,7 @@ namespace Hermes
 
       Quad2D* quad = &g_quad_2d_std;
       unsigned char np = quad->get_num_points(order, mode);
+      u->allocate(np, 1);
 
       fu->value(np, ext, u_ext, u, geometry);
     }
@@ -775,8 +773,8 @@ namespace Hermes
     template HERMES_API Func<double>* init_fn(MeshFunction<double>* fu, const int order);
     template HERMES_API Func<std::complex<double> >* init_fn(MeshFunction<std::complex<double> >* fu, const int order);
 
-    template HERMES_API Func<double>* preallocate_fn(pj_pool_t* memoryPool);
-    template HERMES_API Func<std::complex<double> >* preallocate_fn(pj_pool_t* memoryPool);
+    template HERMES_API Func<double>* preallocate_fn(pj_pool_t* memoryPool, MemoryArena* arena);
+    template HERMES_API Func<std::complex<double> >* preallocate_fn(pj_pool_t* memoryPool, MemoryArena* arena);
 
     template HERMES_API void init_fn_preallocated(Func<double>* u, MeshFunction<double>* fu, const int order);
     template HERMES_API void init_fn_preallocated(Func<std::complex<double> >* u, MeshFunction<std::complex<double> >* fu, const int order);
@@ -790,6 +788,8 @@ namespace Hermes
     template HERMES_API Func<double>* init_fn(UExtFunction<double>* fu, Func<double>** ext, Func<double>** u_ext, const int order, Geom<double>* geometry, ElementMode2D mode);
     template HERMES_API Func<std::complex<double> >* init_fn(UExtFunction<std::complex<double> >* fu, Func<std::complex<double> >** ext, Func<std::complex<double> >** u_ext, const int order, Geom<double>* geometry, ElementMode2D mode);
 
+    template class HERMES_API Func < double > ;
+    template class HERMES_API Func < std::complex<double> > ;
     template class HERMES_API DiscontinuousFunc < double > ;
     template class HERMES_API DiscontinuousFunc < std::complex<double> > ;
     template class HERMES_API GeomVol < double > ;
@@ -658,9 +658,9 @@ namespace Hermes
 
         int source_functions_size = this->source_functions.size();
 
-        Traverse trav(source_functions_size);
-        unsigned int num_states;
-        Traverse::State** states = trav.get_states(this->source_functions, num_states);
+        TraversalPlanSharedPtr traversal_plan = Traverse::get_plan(this->source_functions, source_functions_size);
+        Traverse::State** states = traversal_plan->get_states();
+        unsigned int num_states = traversal_plan->get_num_states();
 
         for (int i = 0; i < source_functions_size; i++)
           this->source_functions[i]->set_quad_2d(&g_quad_2d_std);
@@ -795,10 +795,6 @@ namespace Hermes
           delete refmap;
         }
 
-        for (int i = 0; i < num_states; i++)
-          delete states[i];
-        free_with_check(states);
-
         return result;
       }
 
@@ -851,9 +847,9 @@ namespace Hermes
 #endif
 
         int source_functions_size = this->source_functions.size();
-        Traverse trav(source_functions_size);
-        unsigned int num_states;
-        Traverse::State** states = trav.get_states(this->source_functions, num_states);
+        TraversalPlanSharedPtr traversal_plan = Traverse::get_plan(this->source_functions, source_functions_size);
+        Traverse::State** states = traversal_plan->get_states();
+        unsigned int num_states = traversal_plan->get_num_states();
 
         for (int i = 0; i < source_functions_size; i++)
           this->source_functions[i]->set_quad_2d(&g_quad_2d_std);
@@ -986,10 +982,6 @@ namespace Hermes
           delete refmap;
         }
 
-        for (int i = 0; i < num_states; i++)
-          delete states[i];
-        free_with_check(states);
-
         return result;
       }
 
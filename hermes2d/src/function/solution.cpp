@@ -224,10 +224,22 @@ namespace Hermes
       return sln;
     }
 
+    template<typename Scalar>
+    void Solution<Scalar>::free_mono_coeffs()
+    {
+      if (this->mono_coeffs_container)
+      {
+        mono_coeffs = nullptr;
+        this->mono_coeffs_container.reset();
+      }
+      else
+        free_with_check(mono_coeffs);
+    }
+
     template<typename Scalar>
     void Solution<Scalar>::free()
     {
-      free_with_check(mono_coeffs);
+      this->free_mono_coeffs();
       free_with_check(elem_orders);
       free_with_check(dxdy_buffer);
 
@@ -247,17 +259,40 @@ namespace Hermes
     {
     public:
       // this is a set of LU-decomposed matrices shared by all Solutions
+      // all of them are calculated here, so that they can be used from multiple threads
       double** mat[2][11];
       unsigned char* perm[2][11];
 
       mono_lu_init()
       {
-        for (int m = 0; m <= 1; m++)
+        for (int mode = 0; mode <= 1; mode++)
         {
-          for (int i = 0; i <= 10; i++)
+          for (unsigned char o = 0; o <= 10; o++)
           {
-            mat[m][i] = nullptr;
-            perm[m][i] = nullptr;
+            unsigned char i, j, m, row;
+            char k, l;
+            double x, y, xn, yn;
+            unsigned char n = mode ? sqr(o + 1) : (o + 1)*(o + 2) / 2;
+
+            // loop through all chebyshev points
+            mat[mode][o] = new_matrix<double>(n, n);
+            for (k = o, row = 0; k >= 0; k--)
+            {
+              y = o ? cos(k * M_PI / o) : 1.0;
+              for (l = o; l >= (mode ? 0 : o - k); l--, row++)
+              {
+                x = o ? cos(l * M_PI / o) : 1.0;
+
+                // each row of the matrix contains all the monomials x^i*y^j
+                for (i = 0, yn = 1.0, m = n - 1; i <= o; i++, yn *= y)
+                  for (j = (mode ? 0 : i), xn = 1.0; j <= o; j++, xn *= x, m--)
+                    mat[mode][o][row][m] = xn * yn;
+              }
+            }
+
+            double d;
+            perm[mode][o] = malloc_with_check<unsigned char>(n);
+            ludcmp(mat[mode][o], n, perm[mode][o], &d);
           }
         }
       }
@@ -279,36 +314,80 @@ namespace Hermes
     template<typename Scalar>
     double** Solution<Scalar>::calc_mono_matrix(int mode, unsigned char o)
     {
-      if (mono_lu.mat[mode][o] == nullptr)
+      return mono_lu.mat[mode][o];
+    }
+
+    template<typename Scalar>
+    const double* Solution<Scalar>::get_shape_mono_coeffs(Shapeset* shapeset, int index, unsigned char o, unsigned short component, ElementMode2D mode)
+    {
+      // The table and its rows are only published (the pointers stored) once filled, with a flush before the store,
+      // and a flush after the pointers are read without the lock, so that the contents are visible to the reading thread.
+      double**& table = shapeset->mono_table.coeffs[mode][component][o];
+      double** coeffs = table;
+#pragma omp flush
+      if (!coeffs)
       {
-        unsigned char i, j, m, row;
-        char k, l;
-        double x, y, xn, yn;
-        unsigned char n = this->mode ? sqr(o + 1) : (o + 1)*(o + 2) / 2;
-
-        // loop through all chebyshev points
-        mono_lu.mat[mode][o] = new_matrix<double>(n, n);
-        for (k = o, row = 0; k >= 0; k--)
+#pragma omp critical (ShapesetMonomialTable)
         {
-          y = o ? cos(k * M_PI / o) : 1.0;
-          for (l = o; l >= (this->mode ? 0 : o - k); l--, row++)
+          coeffs = table;
+          if (!coeffs)
           {
-            x = o ? cos(l * M_PI / o) : 1.0;
-
-            // each row of the matrix contains all the monomials x^i*y^j
-            for (i = 0, yn = 1.0, m = n - 1; i <= o; i++, yn *= y)
-              for (j = (this->mode ? 0 : i), xn = 1.0; j <= o; j++, xn *= x, m--)
-                mono_lu.mat[mode][o][row][m] = xn * yn;
+            shapeset->mono_table.size[mode][component][o] = shapeset->get_max_index(mode) + 1;
+            coeffs = calloc_with_check<double*>(shapeset->mono_table.size[mode][component][o], true);
+#pragma omp flush
+            table = coeffs;
           }
         }
+      }
 
-        double d;
-        if (mono_lu.perm[mode][o] == nullptr)
-          mono_lu.perm[mode][o] = malloc_with_check<Solution<Scalar>, unsigned char>(n, this);
-        ludcmp(mono_lu.mat[mode][o], n, mono_lu.perm[mode][o], &d);
+      double* row = coeffs[index];
+#pragma omp flush
+      if (!row)
+      {
+#pragma omp critical (ShapesetMonomialTable)
+        {
+          row = coeffs[index];
+          if (!row)
+          {
+            // values in the chebyshev points, solved for the monomial coefficients
+            unsigned char np = g_quad_2d_cheb.get_num_points(o, mode);
+            double3* pt = g_quad_2d_cheb.get_points(o, mode);
+            row = malloc_with_check<double>(np);
+            for (int i = 0; i < np; i++)
+              row[i] = shapeset->get_fn_value(index, pt[i][0], pt[i][1], component, mode);
+            lubksb(mono_lu.mat[mode][o], np, mono_lu.perm[mode][o], row);
+#pragma omp flush
+            coeffs[index] = row;
+          }
+        }
       }
 
-      return mono_lu.mat[mode][o];
+      return row;
+    }
+
+    template<typename Scalar>
+    void Solution<Scalar>::add_shape_mono_coeffs(Shapeset* shapeset, int index, Scalar coef, unsigned char o, unsigned short component, ElementMode2D mode, Scalar* mono, unsigned char np)
+    {
+      if (index >= 0)
+      {
+        const double* shape_mono = get_shape_mono_coeffs(shapeset, index, o, component, mode);
+        for (int i = 0; i < np; i++)
+          mono[i] += shape_mono[i] * coef;
+      }
+      else
+      {
+        // constrained edge function - a linear combination of standard edge functions, see Shapeset::get_constrained_value()
+        index = -1 - index;
+        unsigned short part = (unsigned)index >> 7;
+        unsigned short order = (index >> 3) & 15;
+        unsigned short edge = (index >> 1) & 3;
+        unsigned short ori = index & 1;
+
+        unsigned short nc;
+        double* comb = shapeset->get_constrained_edge_combination(order, part, ori, nc, mode);
+        for (unsigned short j = 0; j < nc; j++)
+          add_shape_mono_coeffs(shapeset, shapeset->get_edge_index(edge, ori, j + shapeset->ebias, mode), comb[j] * coef, o, component, mode, mono, np);
+      }
     }
 
     template<typename Scalar>
@@ -329,8 +408,6 @@ namespace Hermes
     void Solution<Scalar>::set_coeff_vector(SpaceSharedPtr<Scalar> space,
       const Scalar* coeff_vec, bool add_dir_lift, int start_index)
     {
-      PrecalcShapeset pss(space->shapeset);
-
       if (Solution<Scalar>::static_verbose_output)
         Hermes::Mixins::Loggable::Static::info("Solution: set_coeff_vector called.");
 
@@ -349,7 +426,7 @@ namespace Hermes
       this->free();
 
       this->space_type = space->get_type();
-      this->num_components = pss.get_num_components();
+      this->num_components = space->shapeset->get_num_components();
       this->sln_type = HERMES_SLN;
       this->mesh = space->get_mesh();
 
@@ -367,6 +444,7 @@ namespace Hermes
       Element* e;
       int o;
       num_coeffs = 0;
+      std::vector<Element*> elements;
       for_all_active_elements(e, this->mesh)
       {
         this->mode = e->get_mode();
@@ -384,52 +462,50 @@ namespace Hermes
           if (o < space->shapeset->get_max_order())
             o++;
 
-        num_coeffs += this->mode ? sqr(o + 1) : (o + 1)*(o + 2) / 2;
+        // the monomial coefficients of the components are stored one after another
+        int np = this->mode ? sqr(o + 1) : (o + 1)*(o + 2) / 2;
+        for (int l = 0; l < this->num_components; l++)
+        {
+          elem_coeffs[l][e->id] = num_coeffs;
+          num_coeffs += np;
+        }
         elem_orders[e->id] = o;
+        elements.push_back(e);
       }
-      num_coeffs *= this->num_components;
-      free_with_check(mono_coeffs);
+      this->free_mono_coeffs();
       mono_coeffs = malloc_with_check<Solution<Scalar>, Scalar>(num_coeffs, this);
 
       // Express the solution on elements as a linear combination of monomials.
-      Quad2D* quad = &g_quad_2d_cheb;
-      pss.set_quad_2d(quad);
-      Scalar* mono = mono_coeffs;
-      for_all_active_elements(e, this->mesh)
+      // The monomial expansions of the shape functions are stored in the shapeset, so this is
+      // just a linear combination of them on each element, independent of other elements.
+      Shapeset* shapeset = space->shapeset;
+      double dir_lift_coeff = add_dir_lift ? 1.0 : 0.0;
+      int num_elements = elements.size();
+      int num_threads_used = std::max(1, std::min(HermesCommonApi.get_integral_param_value(numThreads), num_elements));
+#pragma omp parallel for num_threads(num_threads_used) schedule(static)
+      for (int element_i = 0; element_i < num_elements; element_i++)
       {
-        this->mode = e->get_mode();
-        o = elem_orders[e->id];
-        unsigned char np = quad->get_num_points(o, e->get_mode());
+        Element* e = elements[element_i];
+        ElementMode2D mode = e->get_mode();
+        unsigned char o = elem_orders[e->id];
+        unsigned char np = g_quad_2d_cheb.get_num_points(o, mode);
 
         AsmList<Scalar> al;
         space->get_element_assembly_list(e, &al);
-        pss.set_active_element(e);
 
         for (int l = 0; l < this->num_components; l++)
         {
-          // Obtain solution values for the current element.
-          Scalar* val = mono;
-          elem_coeffs[l][e->id] = (int)(mono - mono_coeffs);
-          memset(val, 0, sizeof(Scalar)*np);
+          Scalar* mono = mono_coeffs + elem_coeffs[l][e->id];
+          memset(mono, 0, sizeof(Scalar)*np);
           for (unsigned int k = 0; k < al.cnt; k++)
           {
-            pss.set_active_shape(al.idx[k]);
-            pss.set_quad_order(o, H2D_FN_VAL);
             int dof = al.dof[k];
-            double dir_lift_coeff = add_dir_lift ? 1.0 : 0.0;
             // By subtracting space->first_dof we make sure that it does not matter where the
             // enumeration of dofs in the space starts. This ca be either zero or there can be some
             // offset. By adding start_index we move to the desired section of coeff_vec.
             Scalar coef = al.coef[k] * (dof >= 0 ? coeff_vec[dof - space->first_dof + start_index] : dir_lift_coeff);
-            const double* shape = pss.get_fn_values(l);
-            for (int i = 0; i < np; i++)
-              val[i] += shape[i] * coef;
+            add_shape_mono_coeffs(shapeset, al.idx[k], coef, o, l, mode, mono, np);
           }
-          mono += np;
-
-          // solve for the monomial coefficients
-          calc_mono_matrix(this->mode, o);
-          lubksb(mono_lu.mat[this->mode][o], np, mono_lu.perm[this->mode][o], val);
         }
       }
 
@@ -877,36 +953,87 @@ namespace Hermes
           }
         }
 
-        // transform integration points by the current matrix
-        double3* pt = quad->get_points(order, this->element->get_mode());
-        for (i = 0; i < np; i++)
-        {
-          x[i] = pt[i][0] * this->ctm->m[0] + this->ctm->t[0];
-          y[i] = pt[i][1] * this->ctm->m[1] + this->ctm->t[1];
-        }
-
-        // obtain the solution values, this is the core of the whole module
         int o = elem_orders[this->element->id];
-        for (l = 0; l < this->num_components; l++)
+
+        // tensor-product rule on a quad: the points are [x_1d[a], x_1d[b]]
+        unsigned char np_1d;
+        double2* pt_1d = quad->get_tensor_points(order, this->element->get_mode(), np_1d);
+
+        if (pt_1d)
         {
-          for (k = 0; k < H2D_NUM_FUNCTION_VALUES; k++)
+          // transform the 1D points by the current matrix
+          for (i = 0; i < np_1d; i++)
           {
-            if (mask & this->idx2mask[k][l])
+            x[i] = pt_1d[i][0] * this->ctm->m[0] + this->ctm->t[0];
+            y[i] = pt_1d[i][0] * this->ctm->m[1] + this->ctm->t[1];
+          }
+
+          // obtain the solution values by sum factorization - O(p^3) instead of O(p^4)
+          for (l = 0; l < this->num_components; l++)
+          {
+            for (k = 0; k < H2D_NUM_FUNCTION_VALUES; k++)
             {
-              Scalar* result = this->values[l][k];
+              if (mask & this->idx2mask[k][l])
+              {
+                Scalar* result = this->values[l][k];
+
+                // the polynomials in x (one per power of y) at the 1D points, Horner's scheme
+                Scalar* mono = dxdy_coeffs[l][k];
+                for (i = 0; i <= o; i++)
+                {
+                  Scalar* row = tx + i * np_1d;
+                  set_vec_num(np_1d, row, *mono++);
+                  for (j = 1; j <= o; j++)
+                    vec_x_vec_p_num(np_1d, row, x, *mono++);
+                }
+
+                // contraction with the powers of y, Horner's scheme
+                for (int a = 0; a < np_1d; a++)
+                {
+                  for (int b = 0; b < np_1d; b++)
+                  {
+                    Scalar value = tx[a];
+                    for (i = 1; i <= o; i++)
+                      value = value * y[b] + tx[i * np_1d + a];
+                    result[a * np_1d + b] = value;
+                  }
+                }
+              }
+            }
+          }
+        }
+        else
+        {
+          // transform integration points by the current matrix
+          double3* pt = quad->get_points(order, this->element->get_mode());
+          for (i = 0; i < np; i++)
+          {
+            x[i] = pt[i][0] * this->ctm->m[0] + this->ctm->t[0];
+            y[i] = pt[i][1] * this->ctm->m[1] + this->ctm->t[1];
+          }
 
-              // calculate the solution values using Horner's scheme
-              Scalar* mono = dxdy_coeffs[l][k];
-              for (i = 0; i <= o; i++)
+          // obtain the solution values, this is the core of the whole module
+          for (l = 0; l < this->num_components; l++)
+          {
+            for (k = 0; k < H2D_NUM_FUNCTION_VALUES; k++)
+            {
+              if (mask & this->idx2mask[k][l])
               {
-                set_vec_num(np, tx, *mono++);
-                for (j = 1; j <= (this->mode ? o : i); j++)
-                  vec_x_vec_p_num(np, tx, x, *mono++);
-
-                if (!i)
-                  memcpy(result, tx, sizeof(Scalar)*np);
-                else
-                  vec_x_vec_p_vec(np, result, y, tx);
+                Scalar* result = this->values[l][k];
+
+                // calculate the solution values using Horner's scheme
+                Scalar* mono = dxdy_coeffs[l][k];
+                for (i = 0; i <= o; i++)
+                {
+                  set_vec_num(np, tx, *mono++);
+                  for (j = 1; j <= (this->mode ? o : i); j++)
+                    vec_x_vec_p_num(np, tx, x, *mono++);
+
+                  if (!i)
+                    memcpy(result, tx, sizeof(Scalar)*np);
+                  else
+                    vec_x_vec_p_vec(np, result, y, tx);
+                }
               }
             }
           }
@@ -1650,6 +1777,80 @@ namespace Hermes
       return okay;
     }
 
+    template<typename Scalar>
+    void Solution<Scalar>::save_binary(BinaryIO::BinaryContainerWriter& writer, const char* prefix) const
+    {
+      // Check.
+      this->check();
+
+      if (this->sln_type != HERMES_SLN)
+        throw Exceptions::Exception("Only solutions coming from computation can be saved in Solution::save_binary().");
+
+      // Space type, counts, complexness for checking.
+      int* info = writer.allocate_array<int>((std::string(prefix) + "info").c_str(), 5);
+      info[0] = this->space_type;
+      info[1] = this->num_components;
+      info[2] = this->num_coeffs;
+      info[3] = this->num_elems;
+      info[4] = (BinaryIO::binary_array_type<Scalar>() == BinaryIO::BinaryArrayComplex);
+
+      // Coefficients, not copied.
+      writer.add_array<Scalar>((std::string(prefix) + "coeffs").c_str(), this->mono_coeffs, this->num_coeffs);
+
+      // Orders.
+      writer.add_array<int>((std::string(prefix) + "orders").c_str(), this->elem_orders, this->num_elems);
+
+      // Element offsets for each component, one after another.
+      int* components = writer.allocate_array<int>((std::string(prefix) + "components").c_str(), this->num_components * this->num_elems);
+      for (int component_i = 0; component_i < this->num_components; component_i++)
+        memcpy(components + component_i * this->num_elems, this->elem_coeffs[component_i], sizeof(int)* this->num_elems);
+    }
+
+    template<typename Scalar>
+    void Solution<Scalar>::load_binary(BinaryContainerSharedPtr container, const char* prefix, SpaceSharedPtr<Scalar> space)
+    {
+      free();
+      this->mesh = space->get_mesh();
+      this->space_type = space->get_type();
+      this->sln_type = HERMES_SLN;
+
+      int* info = container->get_array_of_size<int>((std::string(prefix) + "info").c_str(), 5);
+
+      if (info[4] != (BinaryIO::binary_array_type<Scalar>() == BinaryIO::BinaryArrayComplex))
+        throw Exceptions::Exception("Real / complex solution mismatch in Solution::load_binary().");
+
+      if (info[1] != space->get_shapeset()->get_num_components())
+        throw Exceptions::Exception("Mismatched space / saved solution.");
+      this->num_components = info[1];
+
+      this->check_space_type_compliance(spaceTypeToString((SpaceType)info[0]));
+
+      if (info[3] != this->mesh->get_max_element_id())
+        throw Exceptions::Exception("Mismatched mesh / saved solution.");
+      this->num_coeffs = info[2];
+      this->num_elems = info[3];
+
+      // Coefficients, a view into the mapping.
+      this->mono_coeffs = container->get_array_of_size<Scalar>((std::string(prefix) + "coeffs").c_str(), this->num_coeffs);
+      this->mono_coeffs_container = container;
+
+      // Orders, offsets, small and copied.
+      int* orders = container->get_array_of_size<int>((std::string(prefix) + "orders").c_str(), this->num_elems);
+      this->elem_orders = malloc_with_check<Solution<Scalar>, int>(this->num_elems, this);
+      memcpy(this->elem_orders, orders, sizeof(int)* this->num_elems);
+
+      int* components = container->get_array_of_size<int>((std::string(prefix) + "components").c_str(), this->num_components * this->num_elems);
+      for (int component_i = 0; component_i < this->num_components; component_i++)
+      {
+        this->elem_coeffs[component_i] = malloc_with_check<Solution<Scalar>, int>(this->num_elems, this);
+        memcpy(this->elem_coeffs[component_i], components + component_i * this->num_elems, sizeof(int)* this->num_elems);
+      }
+
+      init_dxdy_buffer();
+
+      this->element = nullptr;
+    }
+
     template<typename Scalar>
     void Solution<Scalar>::check_space_type_compliance(const char* space_type_to_check) const
     {
@@ -1891,7 +2092,6 @@ namespace Hermes
             toReturn->dy[0] = m[1][0] * dx + m[1][1] * dy;
 
 #ifdef H2D_USE_SECOND_DERIVATIVES
-            toReturn->laplace = malloc_with_check(1, this);
             double2x2 mat;
             double3x2 mat2;
 
@@ -1249,6 +1249,9 @@ namespace Hermes
 
     void Mesh::free()
     {
+      // The cached traversal plans point to the elements.
+      Traverse::invalidate_plans(this);
+
       Element* e;
       for_all_elements(e, this)
       {
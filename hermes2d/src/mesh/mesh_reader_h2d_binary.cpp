@@ -0,0 +1,339 @@
+// This file is part of Hermes2D
+//
+// Hermes2D is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 2 of the License, or
+// (at your option) any later version.
+//
+// Hermes2D is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with Hermes2D; if not, see <http://www.gnu.prg/licenses/>.
+
+#include "mesh_reader_h2d_binary.h"
+#include "mesh.h"
+#include "refmap.h"
+#include "api2d.h"
+
+using namespace std;
+
+namespace Hermes
+{
+  namespace Hermes2D
+  {
+    MeshReaderH2DBinary::MeshReaderH2DBinary()
+    {
+    }
+
+    MeshReaderH2DBinary::~MeshReaderH2DBinary()
+    {
+    }
+
+    void MeshReaderH2DBinary::load(const char *filename, MeshSharedPtr mesh)
+    {
+      BinaryIO::BinaryContainer container(filename);
+      this->load(container, mesh);
+    }
+
+    void MeshReaderH2DBinary::save(const char *filename, MeshSharedPtr mesh)
+    {
+      BinaryIO::BinaryContainerWriter writer;
+      this->save(writer, mesh);
+      writer.write(filename);
+    }
+
+    void MeshReaderH2DBinary::save_markers(BinaryIO::BinaryContainerWriter& writer, const Mesh::MarkersConversion& markers_conversion, const std::set<int>& used_markers, const char* ids_name, const char* names_name)
+    {
+      int* ids = writer.allocate_array<int>(ids_name, used_markers.size());
+      std::string names;
+      int marker_i = 0;
+      for (std::set<int>::const_iterator it = used_markers.begin(); it != used_markers.end(); ++it)
+      {
+        ids[marker_i++] = *it;
+        names += markers_conversion.get_user_marker(*it).marker;
+        names += '\0';
+      }
+
+      char* names_data = writer.allocate_array<char>(names_name, names.size());
+      memcpy(names_data, names.data(), names.size());
+    }
+
+    std::map<int, int> MeshReaderH2DBinary::load_markers(const BinaryIO::BinaryContainer& container, Mesh::MarkersConversion& markers_conversion, const char* ids_name, const char* names_name)
+    {
+      unsigned long long ids_count, names_size;
+      int* ids = container.get_array<int>(ids_name, ids_count);
+      char* names = container.get_array<char>(names_name, names_size);
+
+      std::map<int, int> markers;
+      unsigned long long name_start = 0;
+      for (unsigned long long marker_i = 0; marker_i < ids_count; marker_i++)
+      {
+        unsigned long long name_end = name_start;
+        while (name_end < names_size && names[name_end] != '\0')
+          name_end++;
+        if (name_end == names_size)
+          throw Hermes::Exceptions::MeshLoadFailureException("Array %s is corrupted.", names_name);
+
+        markers[ids[marker_i]] = markers_conversion.insert_marker(std::string(names + name_start, name_end - name_start));
+        name_start = name_end + 1;
+      }
+
+      return markers;
+    }
+
+    void MeshReaderH2DBinary::save(BinaryIO::BinaryContainerWriter& writer, MeshSharedPtr mesh)
+    {
+      // Utility pointer.
+      Element* e;
+      int nbase = mesh->get_num_base_elements();
+
+      // Vertices.
+      double* vertices = writer.allocate_array<double>("mesh.vertices", 2 * mesh->ntopvert);
+      for (int i = 0; i < mesh->ntopvert; i++)
+      {
+        vertices[2 * i] = mesh->nodes[i].x;
+        vertices[2 * i + 1] = mesh->nodes[i].y;
+      }
+
+      // Elements, their markers.
+      int* elements = writer.allocate_array<int>("mesh.elements", 4 * nbase);
+      int* element_markers = writer.allocate_array<int>("mesh.element_markers", nbase);
+      std::set<int> used_element_markers;
+      for (int i = 0; i < nbase; i++)
+      {
+        e = mesh->get_element_fast(i);
+        for (int j = 0; j < 4; j++)
+          elements[4 * i + j] = j < e->get_nvert() ? e->vn[j]->id : -1;
+        element_markers[i] = e->marker;
+        used_element_markers.insert(e->marker);
+      }
+      this->save_markers(writer, mesh->element_markers_conversion, used_element_markers, "mesh.element_marker_ids", "mesh.element_marker_names");
+
+      // Boundary edges (first vertex, second vertex, internal marker), and curves, both collected in one pass.
+      std::vector<int> edges;
+      std::set<int> used_boundary_markers;
+      std::set<Curve*> saved_curves;
+      std::vector<int> arcs;
+      std::vector<double> arc_angles;
+      std::vector<int> nurbs;
+      std::vector<double> nurbs_points;
+      std::vector<double> nurbs_knots;
+      for_all_base_elements(e, mesh)
+      {
+        for (unsigned char i = 0; i < e->get_nvert(); i++)
+        {
+          Node* en = MeshUtil::get_base_edge_node(e, i);
+          if (en->marker)
+          {
+            edges.push_back(e->vn[i]->id);
+            edges.push_back(e->vn[e->next_vert(i)]->id);
+            edges.push_back(en->marker);
+            used_boundary_markers.insert(en->marker);
+          }
+
+          if (!e->is_curved() || e->cm->curves[i] == nullptr || saved_curves.find(e->cm->curves[i]) != saved_curves.end())
+            continue;
+          Curve* curve = e->cm->curves[i];
+          saved_curves.insert(curve);
+
+          if (curve->type == ArcType)
+          {
+            arcs.push_back(e->vn[i]->id);
+            arcs.push_back(e->vn[e->next_vert(i)]->id);
+            arc_angles.push_back(((Arc*)curve)->angle);
+          }
+          else
+          {
+            Nurbs* curve_nurbs = (Nurbs*)curve;
+            nurbs.push_back(e->vn[i]->id);
+            nurbs.push_back(e->vn[e->next_vert(i)]->id);
+            nurbs.push_back(curve_nurbs->degree);
+            nurbs.push_back(curve_nurbs->np);
+            nurbs.push_back(curve_nurbs->nk);
+            for (int point_i = 0; point_i < curve_nurbs->np; point_i++)
+              for (int j = 0; j < 3; j++)
+                nurbs_points.push_back(curve_nurbs->pt[point_i][j]);
+            for (int knot_i = 0; knot_i < curve_nurbs->nk; knot_i++)
+              nurbs_knots.push_back(curve_nurbs->kv[knot_i]);
+          }
+        }
+      }
+      this->save_markers(writer, mesh->boundary_markers_conversion, used_boundary_markers, "mesh.boundary_marker_ids", "mesh.boundary_marker_names");
+
+      memcpy(writer.allocate_array<int>("mesh.edges", edges.size()), edges.data(), edges.size() * sizeof(int));
+      memcpy(writer.allocate_array<int>("mesh.arcs", arcs.size()), arcs.data(), arcs.size() * sizeof(int));
+      memcpy(writer.allocate_array<double>("mesh.arc_angles", arc_angles.size()), arc_angles.data(), arc_angles.size() * sizeof(double));
+      memcpy(writer.allocate_array<int>("mesh.nurbs", nurbs.size()), nurbs.data(), nurbs.size() * sizeof(int));
+      memcpy(writer.allocate_array<double>("mesh.nurbs_points", nurbs_points.size()), nurbs_points.data(), nurbs_points.size() * sizeof(double));
+      memcpy(writer.allocate_array<double>("mesh.nurbs_knots", nurbs_knots.size()), nurbs_knots.data(), nurbs_knots.size() * sizeof(double));
+
+      // Refinements (element id, refinement type).
+      int* refinements = writer.allocate_array<int>("mesh.refinements", 2 * mesh->refinements.size());
+      for (unsigned int refinement_i = 0; refinement_i < mesh->refinements.size(); refinement_i++)
+      {
+        refinements[2 * refinement_i] = mesh->refinements[refinement_i].first;
+        refinements[2 * refinement_i + 1] = mesh->refinements[refinement_i].second;
+      }
+    }
+
+    void MeshReaderH2DBinary::load(const BinaryIO::BinaryContainer& container, MeshSharedPtr mesh)
+    {
+      if (!mesh)
+        throw Exceptions::NullException(1);
+
+      mesh->free();
+
+      // Vertices //
+      unsigned long long count;
+      double* vertices = container.get_array<double>("mesh.vertices", count);
+      int vertices_count = (int)(count / 2);
+
+      // Initialize mesh.
+      int mesh_size = HashTable::H2D_DEFAULT_HASH_SIZE;
+      while (mesh_size < 8 * vertices_count)
+        mesh_size *= 2;
+      mesh->init(mesh_size);
+
+      // Create top-level vertex nodes.
+      for (int vertex_i = 0; vertex_i < vertices_count; vertex_i++)
+      {
+        Node* node = mesh->nodes.add();
+        assert(node->id == vertex_i);
+        node->ref = TOP_LEVEL_REF;
+        node->type = HERMES_TYPE_VERTEX;
+        node->bnd = 0;
+        node->p1 = node->p2 = -1;
+        node->next_hash = nullptr;
+        node->x = vertices[2 * vertex_i];
+        node->y = vertices[2 * vertex_i + 1];
+      }
+      mesh->ntopvert = vertices_count;
+
+      // Elements //
+      std::map<int, int> element_markers_map = this->load_markers(container, mesh->element_markers_conversion, "mesh.element_marker_ids", "mesh.element_marker_names");
+      int* element_markers = container.get_array<int>("mesh.element_markers", count);
+      int element_count = (int)count;
+      int* elements = container.get_array_of_size<int>("mesh.elements", 4 * count);
+      mesh->nbase = mesh->nactive = mesh->ninitial = element_count;
+
+      Element* e;
+      for (int element_i = 0; element_i < element_count; element_i++)
+      {
+        int* vn = elements + 4 * element_i;
+        for (int j = 0; j < 4; j++)
+          if (vn[j] >= vertices_count || (vn[j] < 0 && !(j == 3 && vn[j] == -1)))
+            throw Hermes::Exceptions::MeshLoadFailureException("Element #%d: vertex %d does not exist.", element_i, vn[j]);
+
+        int marker = element_markers_map[element_markers[element_i]];
+        if (vn[3] != -1)
+          e = mesh->create_quad(marker, &mesh->nodes[vn[0]], &mesh->nodes[vn[1]], &mesh->nodes[vn[2]], &mesh->nodes[vn[3]], nullptr);
+        else
+          e = mesh->create_triangle(marker, &mesh->nodes[vn[0]], &mesh->nodes[vn[1]], &mesh->nodes[vn[2]], nullptr);
+      }
+
+      // Boundaries //
+      std::map<int, int> boundary_markers_map = this->load_markers(container, mesh->boundary_markers_conversion, "mesh.boundary_marker_ids", "mesh.boundary_marker_names");
+      int* edges = container.get_array<int>("mesh.edges", count);
+      int edges_count = (int)(count / 3);
+
+      Node* en;
+      for (int edge_i = 0; edge_i < edges_count; edge_i++)
+      {
+        en = mesh->peek_edge_node(edges[3 * edge_i], edges[3 * edge_i + 1]);
+        if (en == nullptr)
+          throw Hermes::Exceptions::MeshLoadFailureException("Boundary data #%d: edge %d-%d does not exist.", edge_i, edges[3 * edge_i], edges[3 * edge_i + 1]);
+
+        en->marker = boundary_markers_map[edges[3 * edge_i + 2]];
+      }
+
+      Node* node;
+      for_all_edge_nodes(node, mesh)
+      {
+        if (node->ref < 2)
+        {
+          mesh->nodes[node->p1].bnd = 1;
+          mesh->nodes[node->p2].bnd = 1;
+          node->bnd = 1;
+        }
+      }
+
+      // check that all boundary edges have a marker assigned
+      for_all_edge_nodes(en, mesh)
+        if (en->ref < 2 && en->marker == 0)
+          this->warn("Boundary edge node does not have a boundary marker.");
+
+      // Curves //
+      int* arcs = container.get_array<int>("mesh.arcs", count);
+      int arc_count = (int)(count / 2);
+      double* arc_angles = container.get_array_of_size<double>("mesh.arc_angles", arc_count);
+      for (int curves_i = 0; curves_i < arc_count; curves_i++)
+      {
+        int p1 = arcs[2 * curves_i];
+        int p2 = arcs[2 * curves_i + 1];
+        Curve* curve = MeshUtil::load_arc(mesh, curves_i, &en, p1, p2, arc_angles[curves_i]);
+
+        // assign the arc to the elements sharing the edge node
+        MeshUtil::assign_curve(en, curve, p1, p2);
+      }
+
+      unsigned long long points_count, knots_count;
+      int* nurbs = container.get_array<int>("mesh.nurbs", count);
+      int nurbs_count = (int)(count / 5);
+      double* nurbs_points = container.get_array<double>("mesh.nurbs_points", points_count);
+      double* nurbs_knots = container.get_array<double>("mesh.nurbs_knots", knots_count);
+      unsigned long long point_offset = 0, knot_offset = 0;
+      for (int curves_i = 0; curves_i < nurbs_count; curves_i++)
+      {
+        int p1 = nurbs[5 * curves_i];
+        int p2 = nurbs[5 * curves_i + 1];
+        en = mesh->peek_edge_node(p1, p2);
+        if (en == nullptr)
+          throw Hermes::Exceptions::MeshLoadFailureException("Curve #%d: edge %d-%d does not exist.", curves_i, p1, p2);
+
+        Nurbs* curve = new Nurbs;
+        curve->degree = nurbs[5 * curves_i + 2];
+        curve->np = nurbs[5 * curves_i + 3];
+        curve->nk = nurbs[5 * curves_i + 4];
+        if (point_offset + 3 * curve->np > points_count || knot_offset + curve->nk > knots_count)
+        {
+          delete curve;
+          throw Hermes::Exceptions::MeshLoadFailureException("Curve #%d: control points or knots are missing.", curves_i);
+        }
+        curve->pt = malloc_with_check<double3>(curve->np);
+        memcpy(curve->pt, nurbs_points + point_offset, 3 * curve->np * sizeof(double));
+        curve->kv = malloc_with_check<double>(curve->nk);
+        memcpy(curve->kv, nurbs_knots + knot_offset, curve->nk * sizeof(double));
+        point_offset += 3 * curve->np;
+        knot_offset += curve->nk;
+
+        MeshUtil::assign_curve(en, curve, p1, p2);
+      }
+
+      // update refmap coeffs of curvilinear elements
+      for_all_used_elements(e, mesh)
+      {
+        if (e->cm != nullptr)
+          e->cm->update_refmap_coeffs(e);
+        RefMap::set_element_iro_cache(e);
+      }
+
+      // perform initial refinements
+      int* refinements = container.get_array<int>("mesh.refinements", count);
+      for (unsigned long long refinement_i = 0; refinement_i < count / 2; refinement_i++)
+      {
+        int element_id = refinements[2 * refinement_i];
+        int refinement_type = refinements[2 * refinement_i + 1];
+        if (refinement_type == -1)
+          mesh->unrefine_element_id(element_id);
+        else
+          mesh->refine_element_id(element_id, refinement_type);
+      }
+
+      if (HermesCommonApi.get_integral_param_value(checkMeshesOnLoad))
+        mesh->initial_single_check();
+    }
+  }
+}
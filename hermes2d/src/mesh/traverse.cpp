@@ -296,17 +296,24 @@ namespace Hermes
 
     Traverse::State** Traverse::get_states(MeshSharedPtr* meshes, unsigned short meshes_count, unsigned int& states_count)
     {
+      std::vector<MeshSharedPtr> meshes_vector(meshes, meshes + meshes_count);
+      TraversalPlan plan(meshes_vector, this->spaces_size);
+
       // This will be returned.
-      int count = 0, predictedCount = 0;
-      this->num = meshes_count;
-      for (int i = 0; i < meshes_count; i++)
-        if (meshes[i]->get_num_active_elements() > predictedCount)
-          predictedCount = meshes[i]->get_num_active_elements();
-      State** states = malloc_with_check<State*>(predictedCount);
+      states_count = plan.get_num_states();
+      State** states = malloc_with_check<State*>(states_count);
+      for (unsigned int i = 0; i < states_count; i++)
+        states[i] = State::clone(plan.get_states()[i]);
+
+      return states;
+    }
 
+    void Traverse::traverse(MeshSharedPtr* meshes, unsigned short meshes_count, TraversalPlan* plan, int base_element_begin, int base_element_end)
+    {
+      this->num = meshes_count;
       this->begin(num);
 
-      int id = 0;
+      int id = base_element_begin;
 
       while (1)
       {
@@ -330,12 +337,11 @@ namespace Hermes
           while (1)
           {
             // No more base elements? we're finished.
-            // Id is set to zero at the beginning by the function trav.begin(..).
-            if (id >= meshes[0]->get_num_base_elements())
+            // Id starts at base_element_begin.
+            if (id >= base_element_end)
             {
               this->finish();
-              states_count = count;
-              return states;
+              return;
             }
 
             int nused = 0;
@@ -397,12 +403,6 @@ namespace Hermes
         // if yes, set boundary flags and return the state
         if (leaf)
         {
-          if (count > predictedCount - 1)
-          {
-            predictedCount *= 1.5;
-            states = realloc_with_check<State*>(states, predictedCount);
-          }
-
           set_boundary_info(s);
           s->rep = nullptr;
           // EXTREMELY IMPORTANT.
@@ -417,7 +417,7 @@ namespace Hermes
             s->rep_i = j;
             }
           if (s->rep)
-            states[count++] = State::clone(s);
+            plan->add_state(s);
           continue;
         }
 
@@ -901,7 +901,228 @@ namespace Hermes
       return traverse.unidata;
     }
 
+    /// Minimum number of base elements per thread for the traversal to run in parallel.
+    static const int H2D_MIN_BASE_ELEMENTS_PER_TRAVERSAL_THREAD = 64;
+    /// Number of chunks of base elements per thread (for load balancing).
+    static const int H2D_TRAVERSAL_CHUNKS_PER_THREAD = 4;
+
+    TraversalPlan::TraversalPlan(std::vector<MeshSharedPtr> meshes, int spaces_size) : num(meshes.size()), spaces_size(spaces_size), num_states(0), state_data(nullptr), states(nullptr)
+    {
+      for (unsigned short i = 0; i < this->num; i++)
+      {
+        this->meshes.push_back(meshes[i].get());
+        this->mesh_seqs.push_back(meshes[i]->get_seq());
+      }
+
+      // The base elements are split into chunks traversed in parallel, the states of the chunks are then
+      // concatenated in the order of the chunks, so the result is the same as of the serial traversal.
+      int num_base_elements = meshes[0]->get_num_base_elements();
+      int num_threads_used = std::max(1, std::min(HermesCommonApi.get_integral_param_value(numThreads), num_base_elements / H2D_MIN_BASE_ELEMENTS_PER_TRAVERSAL_THREAD));
+      if (num_threads_used == 1)
+      {
+        Traverse trav(spaces_size);
+        trav.traverse(&meshes[0], this->num, this, 0, num_base_elements);
+      }
+      else
+      {
+        int num_chunks = std::min(num_base_elements, num_threads_used * H2D_TRAVERSAL_CHUNKS_PER_THREAD);
+        std::vector<TraversalPlan*> chunks(num_chunks);
+        std::string exceptionMessageCaughtInParallelBlock;
+
+#pragma omp parallel for num_threads(num_threads_used) schedule(dynamic, 1)
+        for (int chunk_i = 0; chunk_i < num_chunks; chunk_i++)
+        {
+          chunks[chunk_i] = new TraversalPlan(this->num);
+          try
+          {
+            Traverse trav(spaces_size);
+            trav.traverse(&meshes[0], this->num, chunks[chunk_i], (int)(((int64_t)num_base_elements * chunk_i) / num_chunks), (int)(((int64_t)num_base_elements * (chunk_i + 1)) / num_chunks));
+          }
+          catch (Hermes::Exceptions::Exception& e)
+          {
+#pragma omp critical (exceptionMessageCaughtInParallelBlock)
+            exceptionMessageCaughtInParallelBlock = e.info();
+          }
+          catch (std::exception& e)
+          {
+#pragma omp critical (exceptionMessageCaughtInParallelBlock)
+            exceptionMessageCaughtInParallelBlock = e.what();
+          }
+        }
+
+        for (int chunk_i = 0; chunk_i < num_chunks; chunk_i++)
+        {
+          this->append(*chunks[chunk_i]);
+          delete chunks[chunk_i];
+        }
+
+        if (!exceptionMessageCaughtInParallelBlock.empty())
+          throw Hermes::Exceptions::Exception(exceptionMessageCaughtInParallelBlock.c_str());
+      }
+
+      this->finalize();
+    }
+
+    TraversalPlan::TraversalPlan(unsigned short num) : num(num), spaces_size(0), num_states(0), state_data(nullptr), states(nullptr)
+    {
+    }
+
+    void TraversalPlan::append(const TraversalPlan& other)
+    {
+      this->elements.insert(this->elements.end(), other.elements.begin(), other.elements.end());
+      this->sub_idx.insert(this->sub_idx.end(), other.sub_idx.begin(), other.sub_idx.end());
+      this->state_info.insert(this->state_info.end(), other.state_info.begin(), other.state_info.end());
+    }
+
+    TraversalPlan::~TraversalPlan()
+    {
+      // The states do not own their arrays.
+      for (unsigned int i = 0; i < this->num_states; i++)
+      {
+        this->state_data[i].e = nullptr;
+        this->state_data[i].sub_idx = nullptr;
+      }
+      delete[] this->state_data;
+      free_with_check(this->states);
+    }
+
+    void TraversalPlan::add_state(Traverse::State* s)
+    {
+      this->elements.insert(this->elements.end(), s->e, s->e + this->num);
+      this->sub_idx.insert(this->sub_idx.end(), s->sub_idx, s->sub_idx + this->num);
+
+      StateInfo info;
+      memcpy(info.bnd, s->bnd, sizeof(info.bnd));
+      info.isBnd = s->isBnd;
+      info.rep_i = s->rep_i;
+      this->state_info.push_back(info);
+    }
+
+    void TraversalPlan::finalize()
+    {
+      this->num_states = this->state_info.size();
+      if (this->num_states == 0)
+        return;
+
+      this->state_data = new Traverse::State[this->num_states];
+      this->states = malloc_with_check<Traverse::State*>(this->num_states);
+      for (unsigned int i = 0; i < this->num_states; i++)
+      {
+        Traverse::State* state = this->state_data + i;
+        state->num = this->num;
+        state->e = &this->elements[i * this->num];
+        state->sub_idx = &this->sub_idx[i * this->num];
+        memcpy(state->bnd, this->state_info[i].bnd, sizeof(state->bnd));
+        state->isBnd = this->state_info[i].isBnd;
+        state->rep_i = this->state_info[i].rep_i;
+        state->rep = state->e[state->rep_i];
+        state->visited = true;
+        state->isurf = -1;
+        this->states[i] = state;
+      }
+    }
+
+    Traverse::State** TraversalPlan::get_states() const
+    {
+      return this->states;
+    }
+
+    unsigned int TraversalPlan::get_num_states() const
+    {
+      return this->num_states;
+    }
+
+    int TraversalPlan::get_state_index(const Traverse::State* state) const
+    {
+      if (this->num_states == 0 || state < this->state_data || state >= this->state_data + this->num_states)
+        return -1;
+      return state - this->state_data;
+    }
+
+    bool TraversalPlan::is_valid_for(const std::vector<MeshSharedPtr>& meshes, int spaces_size) const
+    {
+      if (meshes.size() != this->num || spaces_size != this->spaces_size)
+        return false;
+      for (unsigned short i = 0; i < this->num; i++)
+        if (meshes[i].get() != this->meshes[i] || meshes[i]->get_seq() != this->mesh_seqs[i])
+          return false;
+      return true;
+    }
+
+    bool TraversalPlan::contains(const Mesh* mesh) const
+    {
+      return std::find(this->meshes.begin(), this->meshes.end(), mesh) != this->meshes.end();
+    }
+
+    /// Maximum number of the cached traversal plans.
+    static const unsigned int H2D_TRAVERSAL_PLAN_CACHE_SIZE = 16;
+
+    /// The cached plans, the most recently used first.
+    static std::vector<TraversalPlanSharedPtr> traversal_plan_cache;
+
+    TraversalPlanSharedPtr Traverse::get_plan(std::vector<MeshSharedPtr> meshes, int spaces_size)
+    {
+      HERMES_PROFILE_SCOPE("traverse");
+      TraversalPlanSharedPtr plan;
+#pragma omp critical (TraversalPlanCache)
+      {
+        for (std::vector<TraversalPlanSharedPtr>::iterator it = traversal_plan_cache.begin(); it != traversal_plan_cache.end(); ++it)
+        {
+          if ((*it)->is_valid_for(meshes, spaces_size))
+          {
+            plan = *it;
+            traversal_plan_cache.erase(it);
+            traversal_plan_cache.insert(traversal_plan_cache.begin(), plan);
+            break;
+          }
+        }
+      }
+
+      if (plan)
+      {
+        HERMES_PROFILE_COUNT("traversal plan cache hits", 1);
+      }
+      else
+      {
+        HERMES_PROFILE_COUNT("traversal plan cache misses", 1);
+        plan.reset(new TraversalPlan(meshes, spaces_size));
+#pragma omp critical (TraversalPlanCache)
+        {
+          traversal_plan_cache.insert(traversal_plan_cache.begin(), plan);
+          if (traversal_plan_cache.size() > H2D_TRAVERSAL_PLAN_CACHE_SIZE)
+            traversal_plan_cache.pop_back();
+        }
+      }
+
+      return plan;
+    }
+
+    template<typename Scalar>
+    TraversalPlanSharedPtr Traverse::get_plan(std::vector<MeshFunctionSharedPtr<Scalar> > mesh_functions, int spaces_size)
+    {
+      std::vector<MeshSharedPtr> meshes;
+      for (unsigned short i = 0; i < mesh_functions.size(); i++)
+        meshes.push_back(mesh_functions[i]->get_mesh());
+      return get_plan(meshes, spaces_size);
+    }
+
+    void Traverse::invalidate_plans(const Mesh* mesh)
+    {
+#pragma omp critical (TraversalPlanCache)
+      {
+        for (std::vector<TraversalPlanSharedPtr>::iterator it = traversal_plan_cache.begin(); it != traversal_plan_cache.end();)
+        {
+          if ((*it)->contains(mesh))
+            it = traversal_plan_cache.erase(it);
+          else
+            ++it;
+        }
+      }
+    }
+
     template HERMES_API Traverse::State** Traverse::get_states<double>(std::vector<MeshFunctionSharedPtr<double> > mesh_functions, unsigned int& states_count);
     template HERMES_API Traverse::State** Traverse::get_states<std::complex<double> >(std::vector<MeshFunctionSharedPtr<std::complex<double> > > mesh_functions, unsigned int& states_count);
+    template HERMES_API TraversalPlanSharedPtr Traverse::get_plan<double>(std::vector<MeshFunctionSharedPtr<double> > mesh_functions, int spaces_size);
+    template HERMES_API TraversalPlanSharedPtr Traverse::get_plan<std::complex<double> >(std::vector<MeshFunctionSharedPtr<std::complex<double> > > mesh_functions, int spaces_size);
   }
 }
\ No newline at end of file
@@ -29,9 +29,96 @@ namespace Hermes
         this->validate = to_set;
       }
 
-      Parallel::Parallel() : num_threads_used(HermesCommonApi.get_integral_param_value(numThreads))
+      Parallel::Parallel() : num_threads_used(HermesCommonApi.get_integral_param_value(numThreads)), next_scheduled_item(0)
       {
       }
+
+      /// Ordering of work items by decreasing cost.
+      struct DecreasingCost
+      {
+        DecreasingCost(const double* costs) : costs(costs) {}
+        bool operator()(unsigned int a, unsigned int b) const { return costs[a] > costs[b]; }
+        const double* costs;
+      };
+
+      void Parallel::init_scheduling(unsigned int num_items, const double* costs)
+      {
+        this->scheduled_items.resize(num_items);
+        for (unsigned int i = 0; i < num_items; i++)
+          this->scheduled_items[i] = i;
+
+        // Expensive items first, so that the cheap ones fill the gaps at the end of the run.
+        // Stable - items of equal cost keep their (traversal) order.
+        if (costs && this->num_threads_used > 1)
+          std::stable_sort(this->scheduled_items.begin(), this->scheduled_items.end(), DecreasingCost(costs));
+
+        this->next_scheduled_item = 0;
+        this->thread_start_times.assign(this->num_threads_used, -1.);
+        this->thread_end_times.assign(this->num_threads_used, -1.);
+      }
+
+      int Parallel::get_next_scheduled_item(unsigned char thread_number)
+      {
+        if (this->thread_start_times[thread_number] < 0.)
+          this->thread_start_times[thread_number] = omp_get_wtime();
+
+        // Claim the next position, the counter runs past the end by at most one per thread.
+        unsigned int position;
+#if defined(_OPENMP) && _OPENMP >= 201107
+#pragma omp atomic capture
+        position = this->next_scheduled_item++;
+#else
+        // OpenMP < 3.1 (MSVC) has no atomic capture.
+#pragma omp critical (ParallelScheduling)
+        position = this->next_scheduled_item++;
+#endif
+
+        int item = position < this->scheduled_items.size() ? this->scheduled_items[position] : -1;
+
+        if (item == -1 && this->thread_end_times[thread_number] < 0.)
+          this->thread_end_times[thread_number] = omp_get_wtime();
+
+        return item;
+      }
+
+      double Parallel::get_thread_busy_time(unsigned char thread_number) const
+      {
+        if (thread_number >= this->thread_start_times.size() || this->thread_start_times[thread_number] < 0. || this->thread_end_times[thread_number] < 0.)
+          return 0.;
+        return this->thread_end_times[thread_number] - this->thread_start_times[thread_number];
+      }
+
+      double Parallel::get_thread_idle_time(unsigned char thread_number) const
+      {
+        if (thread_number >= this->thread_start_times.size())
+          return 0.;
+
+        // The run lasts from the first start to the last end.
+        double run_start = -1., run_end = -1.;
+        for (unsigned int i = 0; i < this->thread_start_times.size(); i++)
+        {
+          if (this->thread_start_times[i] >= 0. && (run_start < 0. || this->thread_start_times[i] < run_start))
+            run_start = this->thread_start_times[i];
+          if (this->thread_end_times[i] > run_end)
+            run_end = this->thread_end_times[i];
+        }
+        if (run_start < 0. || run_end < 0.)
+          return 0.;
+
+        return (run_end - run_start) - this->get_thread_busy_time(thread_number);
+      }
+
+      double Parallel::estimated_basis_count(unsigned short order, bool triangle)
+      {
+        return triangle ? (order + 1) * (order + 2) / 2. : (order + 1) * (order + 1);
+      }
+
+      double Parallel::estimated_quadrature_points_count(unsigned short order, bool triangle)
+      {
+        // Gauss quadrature: (order / 2 + 1) points per direction.
+        double points_per_direction = order / 2 + 1;
+        return triangle ? points_per_direction * (points_per_direction + 1) / 2. : points_per_direction * points_per_direction;
+      }
     }
   }
 }
\ No newline at end of file
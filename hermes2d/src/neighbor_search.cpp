@@ -907,7 +907,7 @@ namespace Hermes
     {
       this->central_al = new AsmList<Scalar>(*other.central_al);
       this->cnt = other.cnt;
-      this->dof = other.dof;
+      this->dof = nullptr;
       this->neighbor_al = new AsmList<Scalar>(*other.neighbor_al);
       this->combine_assembly_lists();
     }
@@ -1046,9 +1046,33 @@ namespace Hermes
       // test functions), would be actually more efficient than this. This would require implementing copy for Filters.
     }
 
+    template<typename Scalar>
+    DiscontinuousFunc<Scalar>* NeighborSearch<Scalar>::init_ext_fn(MeshFunction<Scalar>* fu, MemoryArena* arena)
+    {
+      Func<Scalar>* fn_central = new (arena->allocate<Func<Scalar> >(1)) Func<Scalar>(arena);
+      init_fn_preallocated(fn_central, fu, get_quad_eo(false));
+
+      uint64_t original_transform = fu->get_transform();
+
+      // Change the active element of the function. Note that this also resets the transformations on the function.
+      fu->set_active_element(neighbors[active_segment]);
+
+      if (active_segment < this->neighbor_transformations_alloc_size && neighbor_transformations[active_segment])
+        neighbor_transformations[active_segment]->apply_on(fu);
+
+      Func<Scalar>* fn_neighbor = new (arena->allocate<Func<Scalar> >(1)) Func<Scalar>(arena);
+      init_fn_preallocated(fn_neighbor, fu, get_quad_eo(true));
+
+      // Restore the original function.
+      fu->set_active_element(central_el);
+      fu->set_transform(original_transform);
+
+      return DiscontinuousFunc<Scalar>::create(arena, fn_central, fn_neighbor, (neighbor_edge.orientation == 1));
+    }
+
     template<typename Scalar>
     NeighborSearch<Scalar>::ExtendedShapeset::ExtendedShapeset(NeighborSearch* neighborhood, AsmList<Scalar>* central_al, SpaceSharedPtr<Scalar> space) :
-      central_al(central_al)
+      central_al(central_al), dof(nullptr)
     {
       neighbor_al = new AsmList<Scalar>();
       space->get_boundary_assembly_list(neighborhood->neighb_el, neighborhood->neighbor_edge.local_num_of_edge, neighbor_al);
@@ -1060,7 +1084,9 @@ namespace Hermes
     {
       assert(central_al != nullptr && neighbor_al != nullptr);
       cnt = central_al->cnt + neighbor_al->cnt;
-      dof = malloc_with_check<int>(cnt);
+      // Allocated for the largest possible count, so that update() does not reallocate.
+      if (!dof)
+        dof = malloc_with_check<int>(2 * H2D_MAX_LOCAL_BASIS_SIZE);
       memcpy(dof, central_al->dof, sizeof(int)*central_al->cnt);
       memcpy(dof + central_al->cnt, neighbor_al->dof, sizeof(int)*neighbor_al->cnt);
     }
@@ -1081,7 +1107,6 @@ namespace Hermes
     template<typename Scalar>
     void NeighborSearch<Scalar>::ExtendedShapeset::update(NeighborSearch* neighborhood, SpaceSharedPtr<Scalar> space)
     {
-      free_with_check(this->dof);
       space->get_boundary_assembly_list(neighborhood->neighb_el, neighborhood->neighbor_edge.local_num_of_edge, neighbor_al);
       combine_assembly_lists();
     }
@@ -16,11 +16,427 @@
 #include "projections/ogprojection.h"
 #include "space.h"
 #include "solver/linear_solver.h"
+#include "discrete_problem/discrete_problem.h"
+#include "solvers/linear_matrix_solver.h"
+#include "discrete_problem/discrete_problem_helpers.h"
+#include "quadrature/limit_order.h"
+#include "algebra/dense_matrix_operations.h"
 
 namespace Hermes
 {
   namespace Hermes2D
   {
+    /// Maximum number of the cached projection matrices.
+    static const unsigned int H2D_OG_PROJECTION_CACHE_SIZE = 8;
+
+    template<typename Scalar>
+    class OGProjection<Scalar>::CachedFactorization
+    {
+    public:
+      CachedFactorization(SpaceSharedPtr<Scalar> space, NormType norm) : space_seq(space->get_seq()), mesh_seq(space->get_mesh()->get_seq()), ndof(space->get_num_dofs()), norm(norm), factorized(false)
+      {
+        this->wf = WeakFormSharedPtr<Scalar>(new WeakForm<Scalar>(1));
+        this->wf->set_verbose_output(false);
+        this->wf->add_matrix_form(new MatrixDefaultNormFormVol<Scalar>(0, 0, norm));
+        this->wf->add_vector_form(new VectorDefaultNormFormVol<Scalar>(0, norm));
+
+        this->matrix = create_matrix<Scalar>(true);
+        this->rhs = create_vector<Scalar>(true);
+        this->linear_matrix_solver = Hermes::Solvers::create_linear_solver<Scalar>(this->matrix, this->rhs, true);
+        this->linear_matrix_solver->set_verbose_output(false);
+      }
+
+      ~CachedFactorization()
+      {
+        delete this->linear_matrix_solver;
+        delete this->matrix;
+        delete this->rhs;
+      }
+
+      /// The key - the seqs change with every change of the space (mesh), so the space itself is not referenced.
+      bool matches(SpaceSharedPtr<Scalar> space, NormType norm) const
+      {
+        return this->space_seq == space->get_seq() && this->mesh_seq == space->get_mesh()->get_seq()
+          && this->ndof == space->get_num_dofs() && this->norm == norm;
+      }
+
+      bool matches(const CachedFactorization* other) const
+      {
+        return this->space_seq == other->space_seq && this->mesh_seq == other->mesh_seq && this->ndof == other->ndof && this->norm == other->norm;
+      }
+
+      /// Projects the source functions: the right-hand sides of all of them are assembled first, then solved with one factorization
+      /// of the matrix, which is assembled and factorized only if this has not been done in a previous call.
+      void project(SpaceSharedPtr<Scalar> space, const std::vector<MeshFunctionSharedPtr<Scalar> >& source_meshfns, const std::vector<Scalar*>& target_vecs)
+      {
+        int rhs_count = source_meshfns.size();
+        Scalar* rhs_block = malloc_with_check<Scalar>(this->ndof * rhs_count);
+
+        try
+        {
+          // The discrete problem holds the space, so it lives only for this call.
+          DiscreteProblem<Scalar> dp(this->wf, space, true, true, true);
+          dp.set_verbose_output(false);
+
+          for (int rhs_i = 0; rhs_i < rhs_count; rhs_i++)
+          {
+            this->wf->set_ext(source_meshfns[rhs_i]);
+            if (rhs_i == 0 && !this->factorized)
+              dp.assemble(this->matrix, this->rhs);
+            else
+              dp.assemble(this->rhs);
+            this->rhs->extract(rhs_block + rhs_i * this->ndof);
+          }
+
+          // Do not keep the source functions alive.
+          this->wf->set_ext(std::vector<MeshFunctionSharedPtr<Scalar> >());
+
+          HERMES_PROFILE_SCOPE("solve");
+          for (int rhs_i = 0; rhs_i < rhs_count; rhs_i++)
+          {
+            this->linear_matrix_solver->set_reuse_scheme(this->factorized ? Hermes::Solvers::HERMES_REUSE_MATRIX_STRUCTURE_COMPLETELY : Hermes::Solvers::HERMES_CREATE_STRUCTURE_FROM_SCRATCH);
+            this->rhs->set_vector(rhs_block + rhs_i * this->ndof);
+            this->linear_matrix_solver->solve();
+            this->factorized = true;
+
+            memcpy(target_vecs[rhs_i], this->linear_matrix_solver->get_sln_vector(), this->ndof * sizeof(Scalar));
+          }
+        }
+        catch (...)
+        {
+          this->wf->set_ext(std::vector<MeshFunctionSharedPtr<Scalar> >());
+          free_with_check(rhs_block);
+          throw;
+        }
+
+        free_with_check(rhs_block);
+      }
+
+    private:
+      /// Key.
+      int space_seq;
+      unsigned int mesh_seq;
+      int ndof;
+      NormType norm;
+
+      WeakFormSharedPtr<Scalar> wf;
+      SparseMatrix<Scalar>* matrix;
+      Vector<Scalar>* rhs;
+      Hermes::Solvers::LinearMatrixSolver<Scalar>* linear_matrix_solver;
+
+      /// The matrix has been assembled and factorized.
+      bool factorized;
+    };
+
+    template<typename Scalar>
+    std::vector<typename OGProjection<Scalar>::CachedFactorization*> OGProjection<Scalar>::factorization_cache;
+
+    template<typename Scalar>
+    bool OGProjection<Scalar>::factorization_caching = false;
+
+    template<typename Scalar>
+    unsigned int OGProjection<Scalar>::factorization_cache_hits = 0;
+
+    template<typename Scalar>
+    void OGProjection<Scalar>::set_factorization_caching(bool to_set)
+    {
+      factorization_caching = to_set;
+      if (!to_set)
+        free_factorization_cache();
+    }
+
+    template<typename Scalar>
+    void OGProjection<Scalar>::free_factorization_cache()
+    {
+      std::vector<CachedFactorization*> to_delete;
+#pragma omp critical (OGProjectionCache)
+      to_delete.swap(factorization_cache);
+
+      for (unsigned int i = 0; i < to_delete.size(); i++)
+        delete to_delete[i];
+    }
+
+    template<typename Scalar>
+    unsigned int OGProjection<Scalar>::get_factorization_cache_hits()
+    {
+      unsigned int hits;
+#pragma omp critical (OGProjectionCache)
+      hits = factorization_cache_hits;
+      return hits;
+    }
+
+    template<typename Scalar>
+    NormType OGProjection<Scalar>::get_default_norm(SpaceSharedPtr<Scalar> space)
+    {
+      SpaceType space_type = space->get_type();
+      switch (space_type)
+      {
+      case HERMES_H1_SPACE: return HERMES_H1_NORM;
+      case HERMES_HCURL_SPACE: return HERMES_HCURL_NORM;
+      case HERMES_HDIV_SPACE: return HERMES_HDIV_NORM;
+      case HERMES_L2_SPACE: return HERMES_L2_NORM;
+      case HERMES_L2_MARKERWISE_CONST_SPACE: return HERMES_L2_NORM;
+      default: throw Hermes::Exceptions::Exception("Unknown space type in OGProjection<Scalar>::project_global().");
+      }
+    }
+
+    template<typename Scalar>
+    bool OGProjection<Scalar>::project_element_local(SpaceSharedPtr<Scalar> space, MeshFunctionSharedPtr<Scalar> source_meshfn, Scalar* target_vec, NormType norm)
+    {
+      SpaceType space_type = space->get_type();
+      if (norm != HERMES_L2_NORM || (space_type != HERMES_L2_SPACE && space_type != HERMES_L2_MARKERWISE_CONST_SPACE))
+        return false;
+      if (source_meshfn->get_num_components() != 1)
+        return false;
+
+      // Extremely important.
+      Space<Scalar>::assign_dofs(std::vector<SpaceSharedPtr<Scalar> >(1, space));
+      int ndof = space->get_num_dofs();
+      MeshSharedPtr mesh = space->get_mesh();
+
+      // Blocks of the matrix. An element either has its own DOFs (L2Space), or exactly the same DOFs
+      // as other elements (L2MarkerWiseConstSpace: one DOF per marker), otherwise the matrix is not block-diagonal.
+      std::vector<int> dof_block(ndof, -1);
+      std::vector<int> element_block(mesh->get_max_element_id() + 1, -1);
+      std::vector<int> block_offsets(1, 0);
+      std::vector<int> block_dofs;
+      AsmList<Scalar> al;
+      Element* e;
+      for_all_active_elements(e, mesh)
+      {
+        space->get_element_assembly_list(e, &al);
+        if (al.cnt == 0)
+          continue;
+        if (al.dof[0] < 0)
+          return false;
+
+        int block = dof_block[al.dof[0]];
+        if (block == -1)
+        {
+          block = block_offsets.size() - 1;
+          for (unsigned int i = 0; i < al.cnt; i++)
+          {
+            if (al.dof[i] < 0 || dof_block[al.dof[i]] != -1)
+              return false;
+            dof_block[al.dof[i]] = block;
+            block_dofs.push_back(al.dof[i]);
+          }
+          block_offsets.push_back(block_dofs.size());
+        }
+        else
+        {
+          if (al.cnt != block_offsets[block + 1] - block_offsets[block])
+            return false;
+          for (unsigned int i = 0; i < al.cnt; i++)
+            if (al.dof[i] != block_dofs[block_offsets[block] + i])
+              return false;
+        }
+        element_block[e->id] = block;
+      }
+      int num_blocks = block_offsets.size() - 1;
+
+      // Union of the space mesh and the source mesh, the states are distributed to the blocks.
+      std::vector<MeshSharedPtr> meshes;
+      meshes.push_back(mesh);
+      meshes.push_back(source_meshfn->get_mesh());
+      TraversalPlanSharedPtr traversal_plan = Traverse::get_plan(meshes, 1);
+      Traverse::State** states = traversal_plan->get_states();
+      unsigned int num_states = traversal_plan->get_num_states();
+
+      std::vector<std::vector<unsigned int> > block_states(num_blocks);
+      for (unsigned int state_i = 0; state_i < num_states; state_i++)
+      {
+        if (states[state_i]->e[0] && element_block[states[state_i]->e[0]->id] != -1)
+          block_states[element_block[states[state_i]->e[0]->id]].push_back(state_i);
+      }
+
+      memset(target_vec, 0, ndof * sizeof(Scalar));
+
+      int num_threads_used = HermesCommonApi.get_integral_param_value(numThreads);
+      std::string exceptionMessageCaughtInParallelBlock;
+
+#pragma omp parallel num_threads(num_threads_used)
+      {
+        PrecalcShapeset pss(space->get_shapeset());
+        pss.set_quad_2d(&g_quad_2d_std);
+        RefMap refmap;
+        refmap.set_quad_2d(&g_quad_2d_std);
+        MeshFunction<Scalar>* source = source_meshfn->clone();
+        source->set_quad_2d(&g_quad_2d_std);
+
+        AsmList<Scalar> al_local;
+        double** mass_matrix = new_matrix<double>(H2D_MAX_LOCAL_BASIS_SIZE, H2D_MAX_LOCAL_BASIS_SIZE);
+        double mass_matrix_diagonal[H2D_MAX_LOCAL_BASIS_SIZE];
+        Scalar rhs[H2D_MAX_LOCAL_BASIS_SIZE];
+        Func<double>* shape_fns[H2D_MAX_LOCAL_BASIS_SIZE];
+        double jacobian_x_weights[H2D_MAX_INTEGRATION_POINTS_COUNT];
+
+#pragma omp for schedule(dynamic, 16)
+        for (int block_i = 0; block_i < num_blocks; block_i++)
+        {
+          try
+          {
+            unsigned short cnt = block_offsets[block_i + 1] - block_offsets[block_i];
+            for (unsigned short i = 0; i < cnt; i++)
+            {
+              memset(mass_matrix[i], 0, cnt * sizeof(double));
+              rhs[i] = 0.;
+            }
+
+            for (unsigned int block_state_i = 0; block_state_i < block_states[block_i].size(); block_state_i++)
+            {
+              Traverse::State* current_state = states[block_states[block_i][block_state_i]];
+              Element* space_element = current_state->e[0];
+              space->get_element_assembly_list(space_element, &al_local);
+
+              pss.set_active_element(space_element);
+              pss.set_transform(current_state->sub_idx[0]);
+              refmap.set_active_element(space_element);
+              refmap.force_transform(pss.get_transform(), pss.get_ctm());
+
+              // Integration order.
+              int space_order = space->get_element_order(space_element->id);
+              space_order = space_order < 0 ? 0 : std::max(H2D_GET_H_ORDER(space_order), H2D_GET_V_ORDER(space_order));
+              int source_order = 0;
+              if (current_state->e[1])
+              {
+                source->set_active_element(current_state->e[1]);
+                source->set_transform(current_state->sub_idx[1]);
+                source_order = source->get_fn_order();
+              }
+              int order = space_order + std::max(space_order, source_order) + refmap.get_inv_ref_order();
+              limit_order(order, space_element->get_mode());
+
+              GeomVol<double> geometry;
+              unsigned char n = init_geometry_points_allocated(&refmap, order, geometry, jacobian_x_weights);
+
+              Func<Scalar>* source_fn = current_state->e[1] ? init_fn(source, order) : init_zero_fn<Scalar>(space_element->get_mode(), order);
+              for (unsigned short i = 0; i < cnt; i++)
+              {
+                pss.set_active_shape(al_local.idx[i]);
+                shape_fns[i] = init_fn(&pss, &refmap, order);
+              }
+
+              // The coefficients of L2 assembly lists are all one.
+              for (unsigned short i = 0; i < cnt; i++)
+              {
+                for (unsigned short j = i; j < cnt; j++)
+                {
+                  double value = 0.;
+                  for (unsigned char k = 0; k < n; k++)
+                    value += jacobian_x_weights[k] * shape_fns[i]->val[k] * shape_fns[j]->val[k];
+                  mass_matrix[i][j] += value;
+                }
+
+                Scalar value = 0.;
+                for (unsigned char k = 0; k < n; k++)
+                  value += jacobian_x_weights[k] * source_fn->val[k] * shape_fns[i]->val[k];
+                rhs[i] += value;
+              }
+
+              for (unsigned short i = 0; i < cnt; i++)
+                delete shape_fns[i];
+              delete source_fn;
+            }
+
+            choldc(mass_matrix, cnt, mass_matrix_diagonal);
+            cholsl(mass_matrix, cnt, mass_matrix_diagonal, rhs, rhs);
+
+            for (unsigned short i = 0; i < cnt; i++)
+              target_vec[block_dofs[block_offsets[block_i] + i]] = rhs[i];
+          }
+          catch (Hermes::Exceptions::Exception& exception)
+          {
+#pragma omp critical (exceptionMessageCaughtInParallelBlock)
+            exceptionMessageCaughtInParallelBlock = exception.info();
+          }
+          catch (std::exception& exception)
+          {
+#pragma omp critical (exceptionMessageCaughtInParallelBlock)
+            exceptionMessageCaughtInParallelBlock = exception.what();
+          }
+        }
+
+        free_with_check(mass_matrix, true);
+        delete source;
+      }
+
+      if (!exceptionMessageCaughtInParallelBlock.empty())
+        throw Hermes::Exceptions::Exception(exceptionMessageCaughtInParallelBlock.c_str());
+
+      return true;
+    }
+
+    template<typename Scalar>
+    void OGProjection<Scalar>::project_cached(SpaceSharedPtr<Scalar> space, const std::vector<MeshFunctionSharedPtr<Scalar> >& source_meshfns,
+      const std::vector<Scalar*>& target_vecs, NormType norm, bool store_in_cache)
+    {
+      // Extremely important.
+      Space<Scalar>::assign_dofs(std::vector<SpaceSharedPtr<Scalar> >(1, space));
+
+      // The cached linear solvers are not reentrant - the entry is checked out of the cache for the time of the projection,
+      // the lock is held only for the lookup and for the check-in.
+      CachedFactorization* cached = nullptr;
+#pragma omp critical (OGProjectionCache)
+      {
+        for (unsigned int cached_i = 0; cached_i < factorization_cache.size(); cached_i++)
+        {
+          if (factorization_cache[cached_i]->matches(space, norm))
+          {
+            cached = factorization_cache[cached_i];
+            factorization_cache.erase(factorization_cache.begin() + cached_i);
+            factorization_cache_hits++;
+            break;
+          }
+        }
+      }
+
+      if (cached)
+        HERMES_PROFILE_COUNT("projection factorization cache hits", 1);
+      else
+      {
+        HERMES_PROFILE_COUNT("projection factorization cache misses", 1);
+        cached = new CachedFactorization(space, norm);
+      }
+
+      try
+      {
+        cached->project(space, source_meshfns, target_vecs);
+      }
+      catch (...)
+      {
+        // The state of the entry is not known.
+        delete cached;
+        throw;
+      }
+
+      if (!store_in_cache)
+      {
+        delete cached;
+        return;
+      }
+
+      // Check the entry in, unless another thread has stored one with the same key in the meantime.
+      CachedFactorization* to_delete = nullptr;
+#pragma omp critical (OGProjectionCache)
+      {
+        for (unsigned int cached_i = 0; cached_i < factorization_cache.size() && !to_delete; cached_i++)
+          if (factorization_cache[cached_i]->matches(cached))
+            to_delete = cached;
+
+        if (!to_delete)
+        {
+          factorization_cache.insert(factorization_cache.begin(), cached);
+          if (factorization_cache.size() > H2D_OG_PROJECTION_CACHE_SIZE)
+          {
+            to_delete = factorization_cache.back();
+            factorization_cache.pop_back();
+          }
+        }
+      }
+      delete to_delete;
+    }
+
     template<typename Scalar>
     void OGProjection<Scalar>::project_internal(SpaceSharedPtr<Scalar> space, WeakFormSharedPtr<Scalar> wf, Scalar* target_vec)
     {
@@ -91,6 +507,9 @@ namespace Hermes
         project_global(spaces[i], custom_projection_jacobians[i], custom_projection_residuals[i], target_vec + start_index);
         start_index += spaces[i]->get_num_dofs();
       }
+
+      // Jointly renumbered spaces - the vector follows the DOFs of the system.
+      Space<Scalar>::reorder_to_system(spaces, target_vec);
     }
 
     template<typename Scalar>
@@ -134,21 +553,17 @@ namespace Hermes
 
       // If projection norm is not provided, set it
       // to match the type of the space.
-      NormType norm = HERMES_UNSET_NORM;
-      if (proj_norm == HERMES_UNSET_NORM)
+      NormType norm = (proj_norm == HERMES_UNSET_NORM) ? get_default_norm(space) : proj_norm;
+
+      // Block-diagonal projection matrix (L2 spaces).
+      if (project_element_local(space, source_meshfn, target_vec, norm))
+        return;
+
+      if (factorization_caching)
       {
-        SpaceType space_type = space->get_type();
-        switch (space_type)
-        {
-        case HERMES_H1_SPACE: norm = HERMES_H1_NORM; break;
-        case HERMES_HCURL_SPACE: norm = HERMES_HCURL_NORM; break;
-        case HERMES_HDIV_SPACE: norm = HERMES_HDIV_NORM; break;
-        case HERMES_L2_SPACE: norm = HERMES_L2_NORM; break;
-        case HERMES_L2_MARKERWISE_CONST_SPACE: norm = HERMES_L2_NORM; break;
-        default: throw Hermes::Exceptions::Exception("Unknown space type in OGProjection<Scalar>::project_global().");
-        }
+        project_cached(space, std::vector<MeshFunctionSharedPtr<Scalar> >(1, source_meshfn), std::vector<Scalar*>(1, target_vec), norm, true);
+        return;
       }
-      else norm = proj_norm;
 
       // Define temporary projection weak form.
       WeakFormSharedPtr<Scalar> proj_wf(new WeakForm<Scalar>(1));
@@ -169,18 +584,7 @@ namespace Hermes
       NormType proj_norm)
     {
       if (proj_norm == HERMES_UNSET_NORM)
-      {
-        SpaceType space_type = space->get_type();
-        switch (space_type)
-        {
-        case HERMES_H1_SPACE: proj_norm = HERMES_H1_NORM; break;
-        case HERMES_HCURL_SPACE: proj_norm = HERMES_HCURL_NORM; break;
-        case HERMES_HDIV_SPACE: proj_norm = HERMES_HDIV_NORM; break;
-        case HERMES_L2_SPACE: proj_norm = HERMES_L2_NORM; break;
-        case HERMES_L2_MARKERWISE_CONST_SPACE: proj_norm = HERMES_L2_NORM; break;
-        default: throw Hermes::Exceptions::Exception("Unknown space type in OGProjection<Scalar>::project_global().");
-        }
-      }
+        proj_norm = get_default_norm(space);
 
       // Calculate the coefficient vector.
       Scalar* target_vec = malloc_with_check<Scalar>(space->get_num_dofs());
@@ -213,6 +617,9 @@ namespace Hermes
           project_global(spaces[i], source_slns[i], target_vec + start_index, proj_norms[i]);
         start_index += spaces[i]->get_num_dofs();
       }
+
+      // Jointly renumbered spaces - the vector follows the DOFs of the system.
+      Space<Scalar>::reorder_to_system(spaces, target_vec);
     }
 
     template<typename Scalar>
@@ -251,6 +658,28 @@ namespace Hermes
       }
     }
 
+    template<typename Scalar>
+    void OGProjection<Scalar>::project_global(SpaceSharedPtr<Scalar> space, std::vector<MeshFunctionSharedPtr<Scalar> > source_meshfns,
+      std::vector<Scalar*> target_vecs, NormType proj_norm)
+    {
+      // Sanity checks.
+      Helpers::check_length(target_vecs, source_meshfns);
+      for (unsigned int i = 0; i < target_vecs.size(); i++)
+        if (target_vecs[i] == nullptr)
+          throw Exceptions::NullException(3);
+
+      NormType norm = (proj_norm == HERMES_UNSET_NORM) ? get_default_norm(space) : proj_norm;
+
+      // Block-diagonal projection matrix (L2 spaces).
+      bool element_local = true;
+      for (unsigned int i = 0; i < source_meshfns.size() && element_local; i++)
+        element_local = project_element_local(space, source_meshfns[i], target_vecs[i], norm);
+      if (element_local)
+        return;
+
+      project_cached(space, source_meshfns, target_vecs, norm, factorization_caching);
+    }
+
     template class HERMES_API OGProjection < double > ;
     template class HERMES_API OGProjection < std::complex<double> > ;
   }
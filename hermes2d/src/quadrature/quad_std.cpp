@@ -2529,6 +2529,15 @@ namespace Hermes
       np = std_np_2d;
     }
 
+    double2* Quad2DStd::get_tensor_points(int order, ElementMode2D mode, unsigned char& np_1d) const
+    {
+      if (mode != HERMES_MODE_QUAD || order > max_order[mode])
+        return nullptr;
+
+      np_1d = std_np_1d[order];
+      return std_tables_1d[order];
+    }
+
     Quad2DStd::~Quad2DStd()
     {
       unsigned short i, j, k, l;
@@ -40,6 +40,11 @@ namespace Hermes
       template<typename Scalar>
       void HcurlProjBasedSelector<Scalar>::precalc_shapes(const double3* gip_points, const int num_gip_points, const Trf* trfs, const int num_noni_trfs, const std::vector<typename OptimumSelector<Scalar>::ShapeInx>& shapes, const int max_shape_inx, typename ProjBasedSelector<Scalar>::TrfShape& svals, ElementMode2D mode)
       {
+        //transformed coordinates of GIP points
+        double* ref_x = malloc_with_check<double>(num_gip_points);
+        double* ref_y = malloc_with_check<double>(num_gip_points);
+        double* d0dy = malloc_with_check<double>(num_gip_points);
+
         //for all transformations
         bool done = false;
         int inx_trf = 0;
@@ -52,6 +57,13 @@ namespace Hermes
           //allocate
           trf_svals.resize(max_shape_inx + 1);
 
+          //transform coordinates
+          for (int k = 0; k < num_gip_points; k++)
+          {
+            ref_x[k] = gip_points[k][H2D_GIP2D_X] * trf.m[0] + trf.t[0];
+            ref_y[k] = gip_points[k][H2D_GIP2D_Y] * trf.m[1] + trf.t[1];
+          }
+
           //for all shapes
           const int num_shapes = (int)shapes.size();
           for (int i = 0; i < num_shapes; i++)
@@ -62,18 +74,13 @@ namespace Hermes
             //allocate
             shape_exp.allocate(H2D_HCFE_NUM, num_gip_points);
 
-            //for all GIP points
+            //for all expansions: retrieve values
+            this->shapeset->get_values(H2D_FEI_VALUE, inx_shape, num_gip_points, ref_x, ref_y, 0, mode, shape_exp[H2D_HCFE_VALUE0]);
+            this->shapeset->get_values(H2D_FEI_VALUE, inx_shape, num_gip_points, ref_x, ref_y, 1, mode, shape_exp[H2D_HCFE_VALUE1]);
+            this->shapeset->get_values(H2D_FEI_DX, inx_shape, num_gip_points, ref_x, ref_y, 1, mode, shape_exp[H2D_HCFE_CURL]);
+            this->shapeset->get_values(H2D_FEI_DY, inx_shape, num_gip_points, ref_x, ref_y, 0, mode, d0dy);
             for (int k = 0; k < num_gip_points; k++)
-            {
-              //transform coordinates
-              double ref_x = gip_points[k][H2D_GIP2D_X] * trf.m[0] + trf.t[0];
-              double ref_y = gip_points[k][H2D_GIP2D_Y] * trf.m[1] + trf.t[1];
-
-              //for all expansions: retrieve values
-              shape_exp[H2D_HCFE_VALUE0][k] = this->shapeset->get_fn_value(inx_shape, ref_x, ref_y, 0, mode);
-              shape_exp[H2D_HCFE_VALUE1][k] = this->shapeset->get_fn_value(inx_shape, ref_x, ref_y, 1, mode);
-              shape_exp[H2D_HCFE_CURL][k] = this->shapeset->get_dx_value(inx_shape, ref_x, ref_y, 1, mode) - this->shapeset->get_dy_value(inx_shape, ref_x, ref_y, 0, mode);
-            }
+              shape_exp[H2D_HCFE_CURL][k] -= d0dy[k];
           }
 
           //move to the next transformation
@@ -86,6 +93,11 @@ namespace Hermes
               inx_trf = H2D_TRF_IDENTITY;
           }
         }
+
+        free_with_check(ref_x);
+        free_with_check(ref_y);
+        free_with_check(d0dy);
+
         if (!done)
           //identity transformation has to be the last transformation
           throw Exceptions::Exception("All transformation processed but identity transformation not found.");
@@ -225,36 +237,55 @@ namespace Hermes
         //allocate
         double** matrix = new_matrix<double>(num_shapes, num_shapes);
 
+        //evaluate shape functions at GIP points
+        double* gip_x = malloc_with_check<double>(num_gip_points);
+        double* gip_y = malloc_with_check<double>(num_gip_points);
+        for (int j = 0; j < num_gip_points; j++)
+        {
+          gip_x[j] = gip_points[j][H2D_GIP2D_X];
+          gip_y[j] = gip_points[j][H2D_GIP2D_Y];
+        }
+        double* d0dy = malloc_with_check<double>(num_gip_points);
+        double* shape_values = malloc_with_check<double>(num_shapes * H2D_HCFE_NUM * num_gip_points);
+        for (int i = 0; i < num_shapes; i++)
+        {
+          double* value0 = shape_values + (i * H2D_HCFE_NUM + H2D_HCFE_VALUE0) * num_gip_points;
+          double* value1 = shape_values + (i * H2D_HCFE_NUM + H2D_HCFE_VALUE1) * num_gip_points;
+          double* curl = shape_values + (i * H2D_HCFE_NUM + H2D_HCFE_CURL) * num_gip_points;
+          this->shapeset->get_values(H2D_FEI_VALUE, shape_inx[i], num_gip_points, gip_x, gip_y, 0, mode, value0);
+          this->shapeset->get_values(H2D_FEI_VALUE, shape_inx[i], num_gip_points, gip_x, gip_y, 1, mode, value1);
+          this->shapeset->get_values(H2D_FEI_DX, shape_inx[i], num_gip_points, gip_x, gip_y, 1, mode, curl);
+          this->shapeset->get_values(H2D_FEI_DY, shape_inx[i], num_gip_points, gip_x, gip_y, 0, mode, d0dy);
+          for (int j = 0; j < num_gip_points; j++)
+            curl[j] -= d0dy[j];
+        }
+
         //calculate products
-        int inx_row = 0;
-        for (int i = 0; i < num_shapes; i++, inx_row += num_shapes)
+        for (int i = 0; i < num_shapes; i++)
         {
           double* matrix_row = matrix[i];
-          int shape0_inx = shape_inx[i];
+          const double* value00 = shape_values + (i * H2D_HCFE_NUM + H2D_HCFE_VALUE0) * num_gip_points;
+          const double* value01 = shape_values + (i * H2D_HCFE_NUM + H2D_HCFE_VALUE1) * num_gip_points;
+          const double* curl0 = shape_values + (i * H2D_HCFE_NUM + H2D_HCFE_CURL) * num_gip_points;
           for (int k = 0; k < num_shapes; k++)
           {
-            int shape1_inx = shape_inx[k];
+            const double* value10 = shape_values + (k * H2D_HCFE_NUM + H2D_HCFE_VALUE0) * num_gip_points;
+            const double* value11 = shape_values + (k * H2D_HCFE_NUM + H2D_HCFE_VALUE1) * num_gip_points;
+            const double* curl1 = shape_values + (k * H2D_HCFE_NUM + H2D_HCFE_CURL) * num_gip_points;
 
             double value = 0.0;
             for (int j = 0; j < num_gip_points; j++)
-            {
-              double gip_x = gip_points[j][H2D_GIP2D_X], gip_y = gip_points[j][H2D_GIP2D_Y];
-              double value0[2] = { this->shapeset->get_value(H2D_FEI_VALUE, shape0_inx, gip_x, gip_y, 0, mode), this->shapeset->get_value(H2D_FEI_VALUE, shape0_inx, gip_x, gip_y, 1, mode) };
-              double value1[2] = { this->shapeset->get_value(H2D_FEI_VALUE, shape1_inx, gip_x, gip_y, 0, mode), this->shapeset->get_value(H2D_FEI_VALUE, shape1_inx, gip_x, gip_y, 1, mode) };
-              double d1dx0 = this->shapeset->get_value(H2D_FEI_DX, shape0_inx, gip_x, gip_y, 1, mode);
-              double d1dx1 = this->shapeset->get_value(H2D_FEI_DX, shape1_inx, gip_x, gip_y, 1, mode);
-              double d0dy0 = this->shapeset->get_value(H2D_FEI_DY, shape0_inx, gip_x, gip_y, 0, mode);
-              double d0dy1 = this->shapeset->get_value(H2D_FEI_DY, shape1_inx, gip_x, gip_y, 0, mode);
-              double curl0 = d1dx0 - d0dy0;
-              double curl1 = d1dx1 - d0dy1;
-
-              value += gip_points[j][H2D_GIP2D_W] * (value0[0] * value1[0] + value0[1] * value1[1] + curl0*curl1);
-            }
+              value += gip_points[j][H2D_GIP2D_W] * (value00[j] * value10[j] + value01[j] * value11[j] + curl0[j] * curl1[j]);
 
             matrix_row[k] = value;
           }
         }
 
+        free_with_check(gip_x);
+        free_with_check(gip_y);
+        free_with_check(d0dy);
+        free_with_check(shape_values);
+
         return matrix;
       }
 
@@ -39,6 +39,10 @@ namespace Hermes
       template<typename Scalar>
       void L2ProjBasedSelector<Scalar>::precalc_shapes(const double3* gip_points, const int num_gip_points, const Trf* trfs, const int num_noni_trfs, const std::vector<typename OptimumSelector<Scalar>::ShapeInx>& shapes, const int max_shape_inx, typename ProjBasedSelector<Scalar>::TrfShape& svals, ElementMode2D mode)
       {
+        //transformed coordinates of GIP points
+        double* ref_x = malloc_with_check<double>(num_gip_points);
+        double* ref_y = malloc_with_check<double>(num_gip_points);
+
         //for all transformations
         bool done = false;
         int inx_trf = 0;
@@ -51,6 +55,13 @@ namespace Hermes
           //allocate
           trf_svals.resize(max_shape_inx + 1);
 
+          //transform coordinates
+          for (int k = 0; k < num_gip_points; k++)
+          {
+            ref_x[k] = gip_points[k][H2D_GIP2D_X] * trf.m[0] + trf.t[0];
+            ref_y[k] = gip_points[k][H2D_GIP2D_Y] * trf.m[1] + trf.t[1];
+          }
+
           //for all shapes
           const int num_shapes = (int)shapes.size();
           for (int i = 0; i < num_shapes; i++)
@@ -61,16 +72,8 @@ namespace Hermes
             //allocate
             shape_exp.allocate(H2D_L2FE_NUM, num_gip_points);
 
-            //for all GIP points
-            for (int k = 0; k < num_gip_points; k++)
-            {
-              //transform coordinates
-              double ref_x = gip_points[k][H2D_GIP2D_X] * trf.m[0] + trf.t[0];
-              double ref_y = gip_points[k][H2D_GIP2D_Y] * trf.m[1] + trf.t[1];
-
-              //for all expansions: retrieve values
-              shape_exp[H2D_L2FE_VALUE][k] = this->shapeset->get_fn_value(inx_shape, ref_x, ref_y, 0, mode);
-            }
+            //for all expansions: retrieve values
+            this->shapeset->get_values(H2D_FEI_VALUE, inx_shape, num_gip_points, ref_x, ref_y, 0, mode, shape_exp[H2D_L2FE_VALUE]);
           }
 
           //move to the next transformation
@@ -83,6 +86,10 @@ namespace Hermes
               inx_trf = H2D_TRF_IDENTITY;
           }
         }
+
+        free_with_check(ref_x);
+        free_with_check(ref_y);
+
         if (!done)
           throw Exceptions::Exception("All transformation processed but identity transformation not found.");
       }
@@ -200,30 +207,39 @@ namespace Hermes
         //allocate
         double** matrix = new_matrix<double>(num_shapes, num_shapes);
 
+        //evaluate shape functions at GIP points
+        double* gip_x = malloc_with_check<double>(num_gip_points);
+        double* gip_y = malloc_with_check<double>(num_gip_points);
+        for (int j = 0; j < num_gip_points; j++)
+        {
+          gip_x[j] = gip_points[j][H2D_GIP2D_X];
+          gip_y[j] = gip_points[j][H2D_GIP2D_Y];
+        }
+        double* shape_values = malloc_with_check<double>(num_shapes * num_gip_points);
+        for (int i = 0; i < num_shapes; i++)
+          this->shapeset->get_values(H2D_FEI_VALUE, shape_inx[i], num_gip_points, gip_x, gip_y, 0, mode, shape_values + i * num_gip_points);
+
         //calculate products
-        int inx_row = 0;
-        for (int i = 0; i < num_shapes; i++, inx_row += num_shapes)
+        for (int i = 0; i < num_shapes; i++)
         {
           double* matrix_row = matrix[i];
-          int shape0_inx = shape_inx[i];
+          const double* values0 = shape_values + i * num_gip_points;
           for (int k = 0; k < num_shapes; k++)
           {
-            int shape1_inx = shape_inx[k];
+            const double* values1 = shape_values + k * num_gip_points;
 
             double value = 0.0;
             for (int j = 0; j < num_gip_points; j++)
-            {
-              double gip_x = gip_points[j][H2D_GIP2D_X], gip_y = gip_points[j][H2D_GIP2D_Y];
-              double value0 = this->shapeset->get_value(H2D_FEI_VALUE, shape0_inx, gip_x, gip_y, 0, mode);
-              double value1 = this->shapeset->get_value(H2D_FEI_VALUE, shape1_inx, gip_x, gip_y, 0, mode);
-
-              value += gip_points[j][H2D_GIP2D_W] * (value0*value1);
-            }
+              value += gip_points[j][H2D_GIP2D_W] * (values0[j] * values1[j]);
 
             matrix_row[k] = value;
           }
         }
 
+        free_with_check(gip_x);
+        free_with_check(gip_y);
+        free_with_check(shape_values);
+
         return matrix;
       }
 
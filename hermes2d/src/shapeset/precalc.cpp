@@ -72,54 +72,23 @@ namespace Hermes
       {
         for (short i = 0; i < np; i++)
         {
-          ref_points[i][0] = ctm->m[0] * pt[i][0] + ctm->t[0];
-          ref_points[i][1] = ctm->m[1] * pt[i][1] + ctm->t[1];
+          ref_x[i] = ctm->m[0] * pt[i][0] + ctm->t[0];
+          ref_y[i] = ctm->m[1] * pt[i][1] + ctm->t[1];
         }
-
-        for (j = 0; j < num_components; j++)
-          for (k = 0; k < H2D_NUM_FUNCTION_VALUES; k++)
-            if (mask & idx2mask[k][j])
-              for (short i = 0; i < np; i++)
-                this->values[j][k][i] = shapeset->get_value(k, index, ref_points[i][0], ref_points[i][1], j, mode);
       }
       else
       {
-        if (this->num_components == 1)
-        {
-          if (mode == HERMES_MODE_TRIANGLE)
-          {
-            if (mask & idx2mask[0][0])
-              for (short i = 0; i < np; i++)
-                this->values[0][0][i] = shapeset->get_fn_value_0_tri(index, pt[i][0], pt[i][1]);
-            if (mask & idx2mask[1][0])
-              for (short i = 0; i < np; i++)
-                this->values[0][1][i] = shapeset->get_dx_value_0_tri(index, pt[i][0], pt[i][1]);
-            if (mask & idx2mask[2][0])
-              for (short i = 0; i < np; i++)
-                this->values[0][2][i] = shapeset->get_dy_value_0_tri(index, pt[i][0], pt[i][1]);
-          }
-          else
-          {
-            if (mask & idx2mask[0][0])
-              for (short i = 0; i < np; i++)
-                this->values[0][0][i] = shapeset->get_fn_value_0_quad(index, pt[i][0], pt[i][1]);
-            if (mask & idx2mask[1][0])
-              for (short i = 0; i < np; i++)
-                this->values[0][1][i] = shapeset->get_dx_value_0_quad(index, pt[i][0], pt[i][1]);
-            if (mask & idx2mask[2][0])
-              for (short i = 0; i < np; i++)
-                this->values[0][2][i] = shapeset->get_dy_value_0_quad(index, pt[i][0], pt[i][1]);
-          }
-        }
-        else
+        for (short i = 0; i < np; i++)
         {
-          for (j = 0; j < num_components; j++)
-            for (k = 0; k < H2D_NUM_FUNCTION_VALUES; k++)
-              if (mask & idx2mask[k][j])
-                for (short i = 0; i < np; i++)
-                  this->values[j][k][i] = shapeset->get_value(k, index, pt[i][0], pt[i][1], j, mode);
+          ref_x[i] = pt[i][0];
+          ref_y[i] = pt[i][1];
         }
       }
+
+      for (j = 0; j < num_components; j++)
+        for (k = 0; k < H2D_NUM_FUNCTION_VALUES; k++)
+          if (mask & idx2mask[k][j])
+            shapeset->get_values(k, index, np, ref_x, ref_y, j, mode, this->values[j][k]);
     }
 
     void PrecalcShapeset::free()
@@ -172,7 +141,7 @@ namespace Hermes
       delete this->shapeset;
     }
 
-    PrecalcShapesetAssembling::PrecalcShapesetAssembling(Shapeset* shapeset) : PrecalcShapeset(shapeset), storage(nullptr)
+    PrecalcShapesetAssembling::PrecalcShapesetAssembling(Shapeset* shapeset) : PrecalcShapeset(shapeset), storage(nullptr), sub_element_values(nullptr), sub_element_np(0)
     {
       if (PrecalcShapesetAssemblingTables[(int)shapeset->get_id()])
       {
@@ -190,7 +159,7 @@ namespace Hermes
       }
     }
 
-    PrecalcShapesetAssembling::PrecalcShapesetAssembling(const PrecalcShapesetAssembling& other) : PrecalcShapeset(other.shapeset)
+    PrecalcShapesetAssembling::PrecalcShapesetAssembling(const PrecalcShapesetAssembling& other) : PrecalcShapeset(other.shapeset), sub_element_values(nullptr), sub_element_np(0)
     {
       this->storage = other.storage;
       this->storage->ref_count++;
@@ -203,7 +172,9 @@ namespace Hermes
     const double* PrecalcShapesetAssembling::get_fn_values(int component) const
     {
       if (this->attempt_to_reuse(this->order))
-        return this->storage->PrecalculatedValues[this->element->get_mode()][0][this->order][this->index];
+        return this->storage->PrecalculatedValues[this->element->get_mode()][component][0][this->order][this->index];
+      if (this->sub_element_values)
+        return this->sub_element_values + (component * H2D_PSS_STORED_VALUES + 0) * this->sub_element_np;
       assert(this->values_valid);
       return &values[component][0][0];
     }
@@ -211,7 +182,9 @@ namespace Hermes
     const double* PrecalcShapesetAssembling::get_dx_values(int component) const
     {
       if (this->attempt_to_reuse(this->order))
-        return this->storage->PrecalculatedValues[this->element->get_mode()][1][this->order][this->index];
+        return this->storage->PrecalculatedValues[this->element->get_mode()][component][1][this->order][this->index];
+      if (this->sub_element_values)
+        return this->sub_element_values + (component * H2D_PSS_STORED_VALUES + 1) * this->sub_element_np;
       assert(this->values_valid);
       return &values[component][1][0];
     }
@@ -219,7 +192,9 @@ namespace Hermes
     const double* PrecalcShapesetAssembling::get_dy_values(int component) const
     {
       if (this->attempt_to_reuse(this->order))
-        return this->storage->PrecalculatedValues[this->element->get_mode()][2][this->order][this->index];
+        return this->storage->PrecalculatedValues[this->element->get_mode()][component][2][this->order][this->index];
+      if (this->sub_element_values)
+        return this->sub_element_values + (component * H2D_PSS_STORED_VALUES + 2) * this->sub_element_np;
       assert(this->values_valid);
       return &values[component][2][0];
     }
@@ -251,7 +226,13 @@ namespace Hermes
 
     bool PrecalcShapesetAssembling::reuse_possible() const
     {
-      return (this->index >= 0 && this->get_quad_2d()->get_id() == 1 && this->sub_idx == 0 && this->num_components == 1);
+      return (this->index >= 0 && this->get_quad_2d()->get_id() == 1 && this->sub_idx == 0);
+    }
+
+    bool PrecalcShapesetAssembling::sub_element_reuse_possible(unsigned short mask) const
+    {
+      // Second derivatives are not stored.
+      return (this->index >= 0 && this->get_quad_2d()->get_id() == 1 && this->sub_idx != 0 && !(mask & ~H2D_FN_DEFAULT));
     }
 
     const double* PrecalcShapesetAssembling::get_values(int component, unsigned short item) const
@@ -266,134 +247,88 @@ namespace Hermes
         return Function<double>::get_values(component, item);
     }
 
+    void PrecalcShapesetAssembling::calculate_values(unsigned short item, unsigned short component, unsigned char np, double* result)
+    {
+      shapeset->get_values(item, index, np, ref_x, ref_y, component, this->element->get_mode(), result);
+    }
+
     void PrecalcShapesetAssembling::precalculate(unsigned short order_, unsigned short mask)
     {
+      this->sub_element_values = nullptr;
+
       if (this->attempt_to_reuse(order_))
         return;
-      else
-      {
-        Function<double>::precalculate(order_, mask);
 
-        unsigned char np = this->quads[cur_quad]->get_num_points(order_, this->element->get_mode());
-        double3* pt = this->quads[cur_quad]->get_points(order_, this->element->get_mode());
+      Function<double>::precalculate(order_, mask);
 
-        unsigned short j, k;
+      unsigned char np = this->quads[cur_quad]->get_num_points(order_, this->element->get_mode());
+      double3* pt = this->quads[cur_quad]->get_points(order_, this->element->get_mode());
 
-        ElementMode2D mode = element->get_mode();
+      ElementMode2D mode = element->get_mode();
 
-        if (this->num_components == 1)
+      // Correction of points for sub-element mappings.
+      if (this->sub_idx != 0)
+      {
+        for (short i = 0; i < np; i++)
         {
-          if (this->reuse_possible())
-          {
-#pragma omp critical (precalculatingPSS)
-                    {
-                      double* valuePointer;
-                      if (mode == HERMES_MODE_TRIANGLE)
-                      {
-                        valuePointer = this->storage->PrecalculatedValues[HERMES_MODE_TRIANGLE][0][order_][index];
-                        for (short i = 0; i < np; i++)
-                          valuePointer[i] = shapeset->get_fn_value_0_tri(index, pt[i][0], pt[i][1]);
-
-                        valuePointer = this->storage->PrecalculatedValues[HERMES_MODE_TRIANGLE][1][order_][index];
-                        for (short i = 0; i < np; i++)
-                          valuePointer[i] = shapeset->get_dx_value_0_tri(index, pt[i][0], pt[i][1]);
-
-                        valuePointer = this->storage->PrecalculatedValues[HERMES_MODE_TRIANGLE][2][order_][index];
-                        for (short i = 0; i < np; i++)
-                          valuePointer[i] = shapeset->get_dy_value_0_tri(index, pt[i][0], pt[i][1]);
-
-                        this->storage->PrecalculatedInfo[HERMES_MODE_TRIANGLE][order_][index] = true;
-                      }
-                      else
-                      {
-                        valuePointer = this->storage->PrecalculatedValues[HERMES_MODE_QUAD][0][order_][index];
-                        for (short i = 0; i < np; i++)
-                          valuePointer[i] = shapeset->get_fn_value_0_quad(index, pt[i][0], pt[i][1]);
-
-                        valuePointer = this->storage->PrecalculatedValues[HERMES_MODE_QUAD][1][order_][index];
-                        for (short i = 0; i < np; i++)
-                          valuePointer[i] = shapeset->get_dx_value_0_quad(index, pt[i][0], pt[i][1]);
-
-                        valuePointer = this->storage->PrecalculatedValues[HERMES_MODE_QUAD][2][order_][index];
-                        for (short i = 0; i < np; i++)
-                          valuePointer[i] = shapeset->get_dy_value_0_quad(index, pt[i][0], pt[i][1]);
-
-                        this->storage->PrecalculatedInfo[HERMES_MODE_QUAD][order_][index] = true;
-                      }
-                    }
-          }
-          else
-          {
-            // Correction of points for sub-element mappings.
-            if (this->sub_idx != 0)
-            {
-              for (short i = 0; i < np; i++)
-              {
-                ref_points[i][0] = ctm->m[0] * pt[i][0] + ctm->t[0];
-                ref_points[i][1] = ctm->m[1] * pt[i][1] + ctm->t[1];
-              }
-
-              for (k = 0; k < H2D_NUM_FUNCTION_VALUES; k++)
-                if (mask & idx2mask[k][0])
-                  for (short i = 0; i < np; i++)
-                    this->values[0][k][i] = shapeset->get_value(k, index, ref_points[i][0], ref_points[i][1], 0, mode);
-            }
-            else if (mode == HERMES_MODE_TRIANGLE)
-            {
-              if (mask & idx2mask[0][0])
-                for (short i = 0; i < np; i++)
-                  this->values[0][0][i] = shapeset->get_fn_value_0_tri(index, pt[i][0], pt[i][1]);
-              if (mask & idx2mask[1][0])
-                for (short i = 0; i < np; i++)
-                  this->values[0][1][i] = shapeset->get_dx_value_0_tri(index, pt[i][0], pt[i][1]);
-              if (mask & idx2mask[2][0])
-                for (short i = 0; i < np; i++)
-                  this->values[0][2][i] = shapeset->get_dy_value_0_tri(index, pt[i][0], pt[i][1]);
-            }
-            else
-            {
-              if (mask & idx2mask[0][0])
-                for (short i = 0; i < np; i++)
-                  this->values[0][0][i] = shapeset->get_fn_value_0_quad(index, pt[i][0], pt[i][1]);
-              if (mask & idx2mask[1][0])
-                for (short i = 0; i < np; i++)
-                  this->values[0][1][i] = shapeset->get_dx_value_0_quad(index, pt[i][0], pt[i][1]);
-              if (mask & idx2mask[2][0])
-                for (short i = 0; i < np; i++)
-                  this->values[0][2][i] = shapeset->get_dy_value_0_quad(index, pt[i][0], pt[i][1]);
-            }
-          }
+          ref_x[i] = ctm->m[0] * pt[i][0] + ctm->t[0];
+          ref_y[i] = ctm->m[1] * pt[i][1] + ctm->t[1];
         }
-        else
+      }
+      else
+      {
+        for (short i = 0; i < np; i++)
+        {
+          ref_x[i] = pt[i][0];
+          ref_y[i] = pt[i][1];
+        }
+      }
+
+      // Whole element - the shared tables.
+      if (this->reuse_possible())
+      {
+#pragma omp critical (precalculatingPSS)
         {
-          // Correction of points for sub-element mappings.
-          if (this->sub_idx != 0)
+          if (!this->storage->PrecalculatedInfo[mode][order_][index])
           {
-            for (short i = 0; i < np; i++)
-            {
-              ref_points[i][0] = ctm->m[0] * pt[i][0] + ctm->t[0];
-              ref_points[i][1] = ctm->m[1] * pt[i][1] + ctm->t[1];
-            }
+            for (unsigned short j = 0; j < this->num_components; j++)
+              for (unsigned short k = 0; k < H2D_PSS_STORED_VALUES; k++)
+                this->calculate_values(k, j, np, this->storage->PrecalculatedValues[mode][j][k][order_][index]);
 
-            for (j = 0; j < num_components; j++)
-              for (k = 0; k < H2D_NUM_FUNCTION_VALUES; k++)
-                if (mask & idx2mask[k][j])
-                  for (short i = 0; i < np; i++)
-                    this->values[j][k][i] = shapeset->get_value(k, index, ref_points[i][0], ref_points[i][1], j, mode);
+            this->storage->PrecalculatedInfo[mode][order_][index] = true;
           }
-          else
+        }
+        return;
+      }
+
+      // Sub-element - the cache of this thread.
+      if (this->sub_element_reuse_possible(mask))
+      {
+        PrecalcShapesetSubElementCache* cache = this->storage->get_sub_element_cache();
+        if (cache)
+        {
+          PrecalcShapesetSubElementCache::Key key(mode, order_, index, this->sub_idx);
+          double* cached_values = cache->get(key);
+          if (!cached_values)
           {
-            for (j = 0; j < num_components; j++)
-              for (k = 0; k < H2D_NUM_FUNCTION_VALUES; k++)
-                if (mask & idx2mask[k][j])
-                  for (short i = 0; i < np; i++)
-                    this->values[j][k][i] = shapeset->get_value(k, index, pt[i][0], pt[i][1], j, mode);
+            cached_values = cache->insert(key, this->num_components * H2D_PSS_STORED_VALUES * np);
+            for (unsigned short j = 0; j < this->num_components; j++)
+              for (unsigned short k = 0; k < H2D_PSS_STORED_VALUES; k++)
+                this->calculate_values(k, j, np, cached_values + (j * H2D_PSS_STORED_VALUES + k) * np);
           }
+          this->sub_element_values = cached_values;
+          this->sub_element_np = np;
+          return;
         }
       }
+
+      for (unsigned short j = 0; j < this->num_components; j++)
+        for (unsigned short k = 0; k < H2D_NUM_FUNCTION_VALUES; k++)
+          if (mask & idx2mask[k][j])
+            this->calculate_values(k, j, np, this->values[j][k]);
     }
 
-    PrecalcShapesetAssemblingStorage::PrecalcShapesetAssemblingStorage(Shapeset* shapeset) : shapeset_id(shapeset->get_id()), ref_count(0)
+    PrecalcShapesetAssemblingStorage::PrecalcShapesetAssemblingStorage(Shapeset* shapeset) : shapeset_id(shapeset->get_id()), ref_count(0), num_components(shapeset->get_num_components())
     {
       this->max_index[0] = shapeset->get_max_index(HERMES_MODE_TRIANGLE);
       this->max_index[1] = shapeset->get_max_index(HERMES_MODE_QUAD);
@@ -415,22 +350,27 @@ namespace Hermes
         unsigned short local_base_size = this->max_index[i] + 1;
 
         this->PrecalculatedInfo[i] = malloc_with_check<bool*>(g_max);
+        for (int k = 0; k < g_max; k++)
+          this->PrecalculatedInfo[i][k] = calloc_with_check<bool>(local_base_size);
 
-        for (int j = 0; j < H2D_NUM_FUNCTION_VALUES; j++)
+        for (int component = 0; component < this->num_components; component++)
         {
-          this->PrecalculatedValues[i][j] = malloc_with_check<double**>(g_max);
-
-          for (int k = 0; k < g_max; k++)
+          for (int j = 0; j < H2D_PSS_STORED_VALUES; j++)
           {
-            this->PrecalculatedValues[i][j][k] = malloc_with_check<double*>(local_base_size);
-            if (j == 0)
-              this->PrecalculatedInfo[i][k] = calloc_with_check<bool>(local_base_size);
+            this->PrecalculatedValues[i][component][j] = malloc_with_check<double**>(g_max);
 
-            for (int l = 0; l < local_base_size; l++)
-              this->PrecalculatedValues[i][j][k][l] = malloc_with_check<double>(np);
+            for (int k = 0; k < g_max; k++)
+            {
+              this->PrecalculatedValues[i][component][j][k] = malloc_with_check<double*>(local_base_size);
+              for (int l = 0; l < local_base_size; l++)
+                this->PrecalculatedValues[i][component][j][k][l] = malloc_with_check<double>(np);
+            }
           }
         }
       }
+
+      for (int i = 0; i < H2D_PSS_MAX_THREADS; i++)
+        this->sub_element_caches[i] = nullptr;
     }
 
     PrecalcShapesetAssemblingStorage::~PrecalcShapesetAssemblingStorage()
@@ -445,21 +385,106 @@ namespace Hermes
 
         unsigned short local_base_size = this->max_index[i] + 1;
 
-        for (int j = 0; j < H2D_NUM_FUNCTION_VALUES; j++)
+        for (int component = 0; component < this->num_components; component++)
         {
-          for (int k = 0; k < g_max; k++)
+          for (int j = 0; j < H2D_PSS_STORED_VALUES; j++)
           {
-            for (int l = 0; l < local_base_size; l++)
-              free_with_check(this->PrecalculatedValues[i][j][k][l]);
-            free_with_check(this->PrecalculatedValues[i][j][k]);
-            if (j == 0)
-              free_with_check(this->PrecalculatedInfo[i][k]);
+            for (int k = 0; k < g_max; k++)
+            {
+              for (int l = 0; l < local_base_size; l++)
+                free_with_check(this->PrecalculatedValues[i][component][j][k][l]);
+              free_with_check(this->PrecalculatedValues[i][component][j][k]);
+            }
+            free_with_check(this->PrecalculatedValues[i][component][j]);
           }
+        }
 
-          free_with_check(this->PrecalculatedValues[i][j]);
-          free_with_check(this->PrecalculatedInfo[i][j]);
+        for (int k = 0; k < g_max; k++)
+          free_with_check(this->PrecalculatedInfo[i][k]);
+        free_with_check(this->PrecalculatedInfo[i]);
+      }
+
+      for (int i = 0; i < H2D_PSS_MAX_THREADS; i++)
+        delete this->sub_element_caches[i];
+    }
+
+    PrecalcShapesetSubElementCache* PrecalcShapesetAssemblingStorage::get_sub_element_cache()
+    {
+      int thread_number = omp_get_thread_num();
+      if (thread_number >= H2D_PSS_MAX_THREADS)
+        return nullptr;
+
+      if (!this->sub_element_caches[thread_number])
+      {
+#pragma omp critical (pss_sub_element_cache_creation)
+        {
+          if (!this->sub_element_caches[thread_number])
+            this->sub_element_caches[thread_number] = new PrecalcShapesetSubElementCache(H2D_PSS_SUB_ELEMENT_CACHE_SIZE);
         }
       }
+
+      return this->sub_element_caches[thread_number];
+    }
+
+    PrecalcShapesetSubElementCache::Key::Key(unsigned char mode, unsigned short order, int index, uint64_t sub_idx) : mode(mode), order(order), index(index), sub_idx(sub_idx)
+    {
+    }
+
+    bool PrecalcShapesetSubElementCache::Key::operator<(const Key& other) const
+    {
+      if (this->sub_idx != other.sub_idx)
+        return this->sub_idx < other.sub_idx;
+      if (this->index != other.index)
+        return this->index < other.index;
+      if (this->order != other.order)
+        return this->order < other.order;
+      return this->mode < other.mode;
+    }
+
+    PrecalcShapesetSubElementCache::PrecalcShapesetSubElementCache(unsigned int capacity) : capacity(std::max(capacity, 2u))
+    {
+    }
+
+    PrecalcShapesetSubElementCache::~PrecalcShapesetSubElementCache()
+    {
+      for (std::list<Entry>::iterator it = this->entries.begin(); it != this->entries.end(); ++it)
+        free_with_check(it->values);
+    }
+
+    double* PrecalcShapesetSubElementCache::get(const Key& key)
+    {
+      std::map<Key, std::list<Entry>::iterator>::iterator found = this->lookup.find(key);
+      if (found == this->lookup.end())
+        return nullptr;
+
+      this->entries.splice(this->entries.begin(), this->entries, found->second);
+      return found->second->values;
+    }
+
+    double* PrecalcShapesetSubElementCache::insert(const Key& key, int size)
+    {
+      if (this->entries.size() < this->capacity)
+      {
+        Entry entry = { key, malloc_with_check<double>(size), size };
+        this->entries.push_front(entry);
+      }
+      else
+      {
+        // Reuse the least recently used entry.
+        this->entries.splice(this->entries.begin(), this->entries, --this->entries.end());
+        Entry& entry = this->entries.front();
+        this->lookup.erase(entry.key);
+        if (entry.size < size)
+        {
+          free_with_check(entry.values);
+          entry.values = malloc_with_check<double>(size);
+          entry.size = size;
+        }
+        entry.key = key;
+      }
+
+      this->lookup.insert(std::pair<Key, std::list<Entry>::iterator>(key, this->entries.begin()));
+      return this->entries.front().values;
     }
   }
 }
@@ -180,8 +180,58 @@ namespace Hermes
       return sum;
     }
 
+    void Shapeset::get_constrained_values(int n, int index, int np, const double* x, const double* y, unsigned short component, ElementMode2D mode, double* result)
+    {
+      index = -1 - index;
+
+      unsigned short part = (unsigned)index >> 7;
+      unsigned short order = (index >> 3) & 15;
+      unsigned short edge = (index >> 1) & 3;
+      unsigned short ori = index & 1;
+
+      unsigned short nc;
+      double* comb = get_constrained_edge_combination(order, part, ori, nc, mode);
+
+      memset(result, 0, np * sizeof(double));
+      shape_fn_t* table = shape_table[n][mode][component];
+      for (unsigned short i = 0; i < nc; i++)
+      {
+        shape_fn_t fn = table[get_edge_index(edge, ori, i + ebias, mode)];
+        double coeff = comb[i];
+        for (int j = 0; j < np; j++)
+          result[j] += coeff * fn(x[j], y[j]);
+      }
+    }
+
     Shapeset::~Shapeset() { free_constrained_edge_combinations(); }
 
+    Shapeset::MonomialTable::MonomialTable()
+    {
+      memset(coeffs, 0, sizeof(coeffs));
+      memset(size, 0, sizeof(size));
+    }
+
+    Shapeset::MonomialTable::MonomialTable(const MonomialTable& other)
+    {
+      memset(coeffs, 0, sizeof(coeffs));
+      memset(size, 0, sizeof(size));
+    }
+
+    Shapeset::MonomialTable::~MonomialTable()
+    {
+      for (int mode = 0; mode < H2D_NUM_MODES; mode++)
+      for (int component = 0; component < H2D_MAX_SOLUTION_COMPONENTS; component++)
+      for (int order = 0; order < num_orders; order++)
+      {
+        if (coeffs[mode][component][order])
+        {
+          for (int index = 0; index < size[mode][component][order]; index++)
+            free_with_check(coeffs[mode][component][order][index]);
+          free_with_check(coeffs[mode][component][order], true);
+        }
+      }
+    }
+
     unsigned short Shapeset::get_max_order() const
     {
       return max_order;
@@ -269,6 +319,19 @@ namespace Hermes
         return get_constrained_value(n, index, x, y, component, mode);
     }
 
+    void Shapeset::get_values(int n, int index, int np, const double* x, const double* y, unsigned short component, ElementMode2D mode, double* result)
+    {
+      if (index < 0)
+      {
+        get_constrained_values(n, index, np, x, y, component, mode, result);
+        return;
+      }
+
+      shape_fn_t fn = shape_table[n][mode][component][index];
+      for (int i = 0; i < np; i++)
+        result[i] = fn(x[i], y[i]);
+    }
+
     double Shapeset::get_fn_value(int index, double x, double y, unsigned short component, ElementMode2D mode)
     {
       if (index < 0)
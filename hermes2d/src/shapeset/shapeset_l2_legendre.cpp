@@ -8232,6 +8232,69 @@ namespace Hermes
       comb_table = nullptr;
     }
 
+    /// Number of points evaluated at once by the recurrence.
+    static const int leg_recurrence_block = 32;
+
+    /// Derivative orders in x, y of the values H2D_FEI_VALUE, ..., H2D_FEI_DXY.
+    static const unsigned char leg_x_derivative[6] = { 0, 1, 0, 2, 0, 1 };
+    static const unsigned char leg_y_derivative[6] = { 0, 0, 1, 0, 2, 1 };
+
+    /// Evaluates the given derivative of the Legendre polynomial of the given degree in np <= leg_recurrence_block points by
+    /// the recurrences (k+1) P_{k+1} = (2k+1) x P_k - k P_{k-1}, P'_{k+1} = P'_{k-1} + (2k+1) P_k, and the same for P''.
+    /// The inner loops over the points have no dependencies and vectorize.
+    static void leg_recurrence(unsigned short degree, unsigned char derivative, int np, const double* x, double* result)
+    {
+      double p_prev[leg_recurrence_block], p[leg_recurrence_block];
+      double d_prev[leg_recurrence_block], d[leg_recurrence_block];
+      double s_prev[leg_recurrence_block], s[leg_recurrence_block];
+
+      for (int i = 0; i < np; i++)
+      {
+        p_prev[i] = d_prev[i] = s_prev[i] = 0.;
+        p[i] = 1.;
+        d[i] = s[i] = 0.;
+      }
+
+      for (unsigned short k = 0; k < degree; k++)
+      {
+        double a = (2. * k + 1.) / (k + 1.), b = k / (k + 1.), c = 2. * k + 1.;
+        for (int i = 0; i < np; i++)
+        {
+          double p_next = a * x[i] * p[i] - b * p_prev[i];
+          double d_next = d_prev[i] + c * p[i];
+          double s_next = s_prev[i] + c * d[i];
+          p_prev[i] = p[i];
+          d_prev[i] = d[i];
+          s_prev[i] = s[i];
+          p[i] = p_next;
+          d[i] = d_next;
+          s[i] = s_next;
+        }
+      }
+
+      memcpy(result, derivative == 0 ? p : (derivative == 1 ? d : s), np * sizeof(double));
+    }
+
+    void L2ShapesetLegendre::get_values(int n, int index, int np, const double* x, const double* y, unsigned short component, ElementMode2D mode, double* result)
+    {
+      if (mode == HERMES_MODE_TRIANGLE || index < 0)
+      {
+        Shapeset::get_values(n, index, np, x, y, component, mode, result);
+        return;
+      }
+
+      unsigned short order = index_to_order[mode][index];
+      double y_values[leg_recurrence_block];
+      for (int start = 0; start < np; start += leg_recurrence_block)
+      {
+        int block_np = std::min(leg_recurrence_block, np - start);
+        leg_recurrence(H2D_GET_H_ORDER(order), leg_x_derivative[n], block_np, x + start, result + start);
+        leg_recurrence(H2D_GET_V_ORDER(order), leg_y_derivative[n], block_np, y + start, y_values);
+        for (int i = 0; i < block_np; i++)
+          result[start + i] *= y_values[i];
+      }
+    }
+
     const unsigned short L2ShapesetLegendre::max_index[2] = { 66, 120 };
   }
 }
\ No newline at end of file
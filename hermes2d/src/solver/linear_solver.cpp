@@ -129,7 +129,10 @@ namespace Hermes
       this->tick();
 
       // Solve, if the solver is iterative, give him the initial guess.
-      this->linear_matrix_solver->solve(coeff_vec);
+      {
+        HERMES_PROFILE_SCOPE("solve");
+        this->linear_matrix_solver->solve(coeff_vec);
+      }
 
       this->sln_vector = this->linear_matrix_solver->get_sln_vector();
 
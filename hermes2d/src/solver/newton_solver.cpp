@@ -85,9 +85,19 @@ namespace Hermes
       this->get_residual()->change_sign();
     }
 
+    template<typename Scalar>
+    void NewtonSolver<Scalar>::evaluate_residual(Scalar* coeff_vec, Vector<Scalar>* residual)
+    {
+      this->dp->assemble(coeff_vec, residual);
+    }
+
     template<typename Scalar>
     bool NewtonSolver<Scalar>::assemble_jacobian(bool store_previous_jacobian)
     {
+      /// The Jacobian-free mode without the preconditioning does not need the matrix at all.
+      if (this->jacobian_free && !this->jacobian_free_preconditioning)
+        return false;
+
       bool result = this->dp->assemble(this->sln_vector, this->get_jacobian());
       /// After the first time we assemble the matrix on the new reference space, we can no longer reuse the previous one.
       this->dp->set_reassembled_states_reuse_linear_system_fn(nullptr);
@@ -99,6 +109,12 @@ namespace Hermes
     template<typename Scalar>
     bool NewtonSolver<Scalar>::assemble(bool store_previous_jacobian, bool store_previous_residual)
     {
+      if (this->jacobian_free && !this->jacobian_free_preconditioning)
+      {
+        this->assemble_residual(store_previous_residual);
+        return false;
+      }
+
       bool result = this->dp->assemble(this->sln_vector, this->get_jacobian(), this->get_residual());
       /// After the first time we assemble the matrix on the new reference space, we can no longer reuse the previous one.
       this->dp->set_reassembled_states_reuse_linear_system_fn(nullptr);
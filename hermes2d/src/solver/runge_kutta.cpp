@@ -263,13 +263,7 @@ namespace Hermes
     void RungeKutta<Scalar>::multiply_as_diagonal_block_matrix(SparseMatrix<Scalar>* matrix, int num_blocks,
       Scalar* source_vec, Scalar* target_vec)
     {
-      int size = matrix->get_size();
-      for (int i = 0; i < num_blocks; i++)
-      {
-        Scalar* temp = target_vec + i * size;
-        Scalar** temp_for_pass = &temp;
-        matrix->multiply_with_vector(source_vec + i*size, *temp_for_pass, true);
-      }
+      matrix->multiply_with_vectors(source_vec, target_vec, num_blocks, true);
     }
 
     template<typename Scalar>
@@ -335,11 +329,12 @@ namespace Hermes
       // The corresponding part of the global residual vector is obtained
       // just by multiplication with the stage vector K.
       // FIXME: This should not be repeated if spaces have not changed.
-      Space<Scalar>::assign_dofs(spaces);
+      // The stage vectors are blocks of the size ndof, so the spaces are not renumbered jointly.
+      Space<Scalar>::assign_dofs(spaces, false);
       stage_dp_left->assemble(matrix_left);
 
       // The Newton's loop.
-      Space<Scalar>::assign_dofs(stage_spaces_vector);
+      Space<Scalar>::assign_dofs(stage_spaces_vector, false);
       double residual_norm;
       int it = 1;
       while (true)
@@ -463,8 +458,13 @@ namespace Hermes
       // will be stored in the vector coeff_vec.
       // FIXME - this projection is not needed when the
       //         spaces are the same (if spatial adaptivity is not used).
+      // Space by space, in the layout of the stage vectors.
       Scalar* coeff_vec = new Scalar[ndof];
-      OGProjection<Scalar>::project_global(spaces, slns_time_prev, coeff_vec);
+      for (unsigned int space_i = 0, start_index = 0; space_i < spaces.size(); space_i++)
+      {
+        OGProjection<Scalar>::project_global(spaces[space_i], slns_time_prev[space_i], coeff_vec + start_index);
+        start_index += spaces[space_i]->get_num_dofs();
+      }
 
       // Calculate new_ time level solution in the stage space (u_{n + 1} = u_n + h \sum_{j = 1}^s b_j k_j).
       for (int i = 0; i < ndof; i++)
@@ -90,6 +90,8 @@ namespace Hermes
       this->mesh_seq = -1;
       this->seq = g_space_seq++;
       this->seq_assigned = -1;
+      this->asm_table_valid = false;
+      this->dof_renumbering = HERMES_DOF_RENUMBERING_NONE;
       this->ndof = 0;
       this->proj_mat = nullptr;
       this->chol_p = nullptr;
@@ -109,6 +111,11 @@ namespace Hermes
     void Space<Scalar>::free()
     {
       free_bc_data();
+      this->asm_table_valid = false;
+      this->asm_table_offsets.clear();
+      this->asm_table_idx.clear();
+      this->asm_table_dof.clear();
+      this->asm_table_coef.clear();
       if (nsize)
       {
         free_with_check(ndata, true);
@@ -246,6 +253,7 @@ namespace Hermes
       this->vertex_functions_count = this->edge_functions_count = this->bubble_functions_count = 0;
 
       this->essential_bcs = space->essential_bcs;
+      this->dof_renumbering = space->dof_renumbering;
 
       if (new_mesh->get_seq() != space->get_mesh()->get_seq())
       {
@@ -376,7 +384,13 @@ namespace Hermes
     }
 
     template<typename Scalar>
-    int Space<Scalar>::assign_dofs(std::vector<SpaceSharedPtr<Scalar> > spaces)
+    int Space<Scalar>::get_system_dof(int dof) const
+    {
+      return this->system_dofs.empty() ? dof : this->system_dofs[dof - this->first_dof];
+    }
+
+    template<typename Scalar>
+    int Space<Scalar>::assign_dofs(std::vector<SpaceSharedPtr<Scalar> > spaces, bool renumber_jointly)
     {
       int n = spaces.size();
 
@@ -385,9 +399,48 @@ namespace Hermes
         ndof += spaces[i]->assign_dofs(ndof);
       }
 
+      if (renumber_jointly && is_renumbered_jointly(spaces))
+      {
+        std::vector<Space<Scalar>*> spaces_to_renumber;
+        for (int i = 0; i < n; i++)
+          spaces_to_renumber.push_back(spaces[i].get());
+        renumber_dofs(spaces_to_renumber, spaces[0]->dof_renumbering);
+      }
+
       return ndof;
     }
 
+    template<typename Scalar>
+    bool Space<Scalar>::is_renumbered_jointly(const std::vector<SpaceSharedPtr<Scalar> >& spaces)
+    {
+      if (spaces.size() < 2 || spaces[0]->dof_renumbering == HERMES_DOF_RENUMBERING_NONE)
+        return false;
+      for (unsigned int i = 1; i < spaces.size(); i++)
+      {
+        if (spaces[i]->dof_renumbering != spaces[0]->dof_renumbering)
+          return false;
+        for (unsigned int j = 0; j < i; j++)
+          if (spaces[i] == spaces[j])
+            return false;
+      }
+      return true;
+    }
+
+    template<typename Scalar>
+    void Space<Scalar>::reorder_to_system(std::vector<SpaceSharedPtr<Scalar> > spaces, Scalar* coeff_vec)
+    {
+      if (!is_renumbered_jointly(spaces))
+        return;
+
+      int ndof = assign_dofs(spaces);
+      Scalar* spaces_vec = malloc_with_check<Scalar>(ndof);
+      memcpy(spaces_vec, coeff_vec, ndof * sizeof(Scalar));
+      for (unsigned int i = 0; i < spaces.size(); i++)
+        for (int j = 0; j < spaces[i]->ndof; j++)
+          coeff_vec[spaces[i]->system_dofs[j]] = spaces_vec[spaces[i]->first_dof + j];
+      free_with_check(spaces_vec);
+    }
+
     template<typename Scalar>
     void Space<Scalar>::set_uniform_order(int order, std::string marker)
     {
@@ -729,6 +782,7 @@ namespace Hermes
     void Space<Scalar>::ReferenceSpaceCreator::finish_construction(SpaceSharedPtr<Scalar> ref_space)
     {
       ref_space->seq = g_space_seq++;
+      ref_space->dof_renumbering = this->coarse_space->dof_renumbering;
 
       Element *e;
       for_all_active_elements(e, coarse_space->get_mesh())
@@ -883,6 +937,9 @@ namespace Hermes
 
       resize_tables();
 
+      // The table of assembly lists is rebuilt at the end.
+      this->asm_table_valid = false;
+
       this->first_dof = next_dof = first_dof;
 
       reset_dof_assignment();
@@ -898,11 +955,478 @@ namespace Hermes
       this->mesh_seq = mesh->get_seq();
       seq_assigned = this->seq;
       this->ndof = next_dof - first_dof;
+      this->system_dofs.clear();
 
       this->check();
+
+      if (this->dof_renumbering != HERMES_DOF_RENUMBERING_NONE)
+        this->renumber_dofs();
+
+      this->build_assembly_list_table();
+
       return this->ndof;
     }
 
+    /// Leaf size of the nested dissection recursion.
+    static const int H2D_NESTED_DISSECTION_LEAF_SIZE = 64;
+
+    /// Blocks of DOFs that have to stay contiguous when renumbering (all DOFs of a node, bubble DOFs of an element).
+    class DofRenumberingBlocks
+    {
+    public:
+      DofRenumberingBlocks(int first_dof, int ndof) : first_dof(first_dof), ndof(ndof), covered(0), consistent(true), block_of_dof(ndof, -1) {}
+
+      /// Adds the block [dof, dof + n) with the position (x, y), blocks already present are skipped.
+      void add(int dof, int n, double x, double y)
+      {
+        if (dof < 0 || n <= 0)
+          return;
+        int local = dof - first_dof;
+        if (local < 0 || local + n > ndof)
+        {
+          consistent = false;
+          return;
+        }
+        if (block_of_dof[local] >= 0)
+        {
+          if (start[block_of_dof[local]] != dof || count[block_of_dof[local]] != n)
+            consistent = false;
+          return;
+        }
+        for (int i = 0; i < n; i++)
+        {
+          if (block_of_dof[local + i] >= 0)
+          {
+            consistent = false;
+            return;
+          }
+          block_of_dof[local + i] = start.size();
+        }
+        start.push_back(dof);
+        count.push_back(n);
+        this->x.push_back(x);
+        this->y.push_back(y);
+        covered += n;
+      }
+
+      /// Block containing the dof, -1 for negative (Dirichlet) dofs.
+      int get_block(int dof) const
+      {
+        return dof < 0 ? -1 : block_of_dof[dof - first_dof];
+      }
+
+      int size() const
+      {
+        return start.size();
+      }
+
+      /// All dofs are in exactly one block.
+      bool is_valid() const
+      {
+        return consistent && covered == ndof;
+      }
+
+      int first_dof, ndof, covered;
+      bool consistent;
+      std::vector<int> block_of_dof;
+      std::vector<int> start, count;
+      std::vector<double> x, y;
+    };
+
+    /// Breadth-first search from 'start' visiting only the vertices with mask[v] == 0.
+    /// Fills 'queue' with the visited vertices (ordered by levels) and 'levels' with the number of levels,
+    /// returns the position of the last level in 'queue'.
+    static int dof_renumbering_bfs(int start, const std::vector<int>& adj_offsets, const std::vector<int>& adj, const std::vector<char>& mask,
+      std::vector<int>& stamp, int stamp_value, std::vector<int>& queue, int& levels)
+    {
+      queue.clear();
+      queue.push_back(start);
+      stamp[start] = stamp_value;
+      int level_begin = 0;
+      levels = 1;
+      while (true)
+      {
+        int level_end = queue.size();
+        for (int i = level_begin; i < level_end; i++)
+        {
+          int v = queue[i];
+          for (int j = adj_offsets[v]; j < adj_offsets[v + 1]; j++)
+          {
+            int u = adj[j];
+            if (!mask[u] && stamp[u] != stamp_value)
+            {
+              stamp[u] = stamp_value;
+              queue.push_back(u);
+            }
+          }
+        }
+        if ((int)queue.size() == level_end)
+          return level_begin;
+        level_begin = level_end;
+        levels++;
+      }
+    }
+
+    /// Orders vertices by increasing degree, ties by index.
+    class DofRenumberingDegreeComparator
+    {
+    public:
+      DofRenumberingDegreeComparator(const std::vector<int>& adj_offsets) : adj_offsets(adj_offsets) {}
+      bool operator()(int a, int b) const
+      {
+        int degree_a = adj_offsets[a + 1] - adj_offsets[a];
+        int degree_b = adj_offsets[b + 1] - adj_offsets[b];
+        return degree_a < degree_b || (degree_a == degree_b && a < b);
+      }
+      const std::vector<int>& adj_offsets;
+    };
+
+    /// Reverse Cuthill-McKee ordering of the graph (adj_offsets, adj), component by component.
+    static void dof_renumbering_rcm(int n, const std::vector<int>& adj_offsets, const std::vector<int>& adj, std::vector<int>& order)
+    {
+      DofRenumberingDegreeComparator by_degree(adj_offsets);
+      std::vector<int> by_degree_order(n);
+      for (int i = 0; i < n; i++)
+        by_degree_order[i] = i;
+      std::sort(by_degree_order.begin(), by_degree_order.end(), by_degree);
+
+      std::vector<char> numbered(n, 0);
+      std::vector<int> stamp(n, -1);
+      std::vector<int> queue, neighbors;
+      int stamp_value = 0;
+      order.clear();
+      order.reserve(n);
+
+      for (int candidate = 0; candidate < n; candidate++)
+      {
+        int start = by_degree_order[candidate];
+        if (numbered[start])
+          continue;
+
+        // Pseudo-peripheral start vertex: repeat BFS from a minimum degree vertex of the last level while the eccentricity grows.
+        int eccentricity = -1;
+        for (int iteration = 0; iteration < 8; iteration++)
+        {
+          int levels;
+          int last_level = dof_renumbering_bfs(start, adj_offsets, adj, numbered, stamp, stamp_value++, queue, levels);
+          if (levels <= eccentricity)
+            break;
+          eccentricity = levels;
+          int next_start = queue[last_level];
+          for (int i = last_level + 1; i < (int)queue.size(); i++)
+          if (by_degree(queue[i], next_start))
+            next_start = queue[i];
+          if (next_start == start)
+            break;
+          start = next_start;
+        }
+
+        // Cuthill-McKee from the start vertex.
+        int component_begin = order.size();
+        order.push_back(start);
+        numbered[start] = 1;
+        for (int i = component_begin; i < (int)order.size(); i++)
+        {
+          int v = order[i];
+          neighbors.clear();
+          for (int j = adj_offsets[v]; j < adj_offsets[v + 1]; j++)
+          if (!numbered[adj[j]])
+          {
+            numbered[adj[j]] = 1;
+            neighbors.push_back(adj[j]);
+          }
+          std::sort(neighbors.begin(), neighbors.end(), by_degree);
+          order.insert(order.end(), neighbors.begin(), neighbors.end());
+        }
+      }
+
+      std::reverse(order.begin(), order.end());
+    }
+
+    /// Orders blocks by one of the coordinates.
+    class DofRenumberingCoordinateComparator
+    {
+    public:
+      DofRenumberingCoordinateComparator(const std::vector<double>& coordinate) : coordinate(coordinate) {}
+      bool operator()(int a, int b) const
+      {
+        return coordinate[a] < coordinate[b] || (coordinate[a] == coordinate[b] && a < b);
+      }
+      const std::vector<double>& coordinate;
+    };
+
+    /// Geometric nested dissection of 'subset': bisection at the median of the longer extent, the vertices of the
+    /// right half adjacent to the left half form the separator, which is numbered last.
+    static void dof_renumbering_nested_dissection(const DofRenumberingBlocks& blocks, const std::vector<int>& adj_offsets, const std::vector<int>& adj,
+      std::vector<int>& subset, std::vector<int>& left_mark, int& mark_value, std::vector<int>& order)
+    {
+      if (subset.empty())
+        return;
+
+      double x_min = blocks.x[subset[0]], x_max = x_min, y_min = blocks.y[subset[0]], y_max = y_min;
+      for (unsigned int i = 1; i < subset.size(); i++)
+      {
+        x_min = std::min(x_min, blocks.x[subset[i]]);
+        x_max = std::max(x_max, blocks.x[subset[i]]);
+        y_min = std::min(y_min, blocks.y[subset[i]]);
+        y_max = std::max(y_max, blocks.y[subset[i]]);
+      }
+      DofRenumberingCoordinateComparator comparator(x_max - x_min >= y_max - y_min ? blocks.x : blocks.y);
+
+      if ((int)subset.size() <= H2D_NESTED_DISSECTION_LEAF_SIZE)
+      {
+        std::sort(subset.begin(), subset.end(), comparator);
+        order.insert(order.end(), subset.begin(), subset.end());
+        return;
+      }
+
+      int half = subset.size() / 2;
+      std::nth_element(subset.begin(), subset.begin() + half, subset.end(), comparator);
+
+      int current_mark = mark_value++;
+      for (int i = 0; i < half; i++)
+        left_mark[subset[i]] = current_mark;
+
+      std::vector<int> left(subset.begin(), subset.begin() + half), right, separator;
+      for (unsigned int i = half; i < subset.size(); i++)
+      {
+        int v = subset[i];
+        bool on_separator = false;
+        for (int j = adj_offsets[v]; j < adj_offsets[v + 1] && !on_separator; j++)
+          on_separator = (left_mark[adj[j]] == current_mark);
+        if (on_separator)
+          separator.push_back(v);
+        else
+          right.push_back(v);
+      }
+      subset.clear();
+
+      dof_renumbering_nested_dissection(blocks, adj_offsets, adj, left, left_mark, mark_value, order);
+      dof_renumbering_nested_dissection(blocks, adj_offsets, adj, right, left_mark, mark_value, order);
+      std::sort(separator.begin(), separator.end(), comparator);
+      order.insert(order.end(), separator.begin(), separator.end());
+    }
+
+    template<typename Scalar>
+    void Space<Scalar>::set_dof_renumbering(DofRenumberingType dof_renumbering)
+    {
+      if (this->dof_renumbering == dof_renumbering)
+        return;
+
+      bool assigned = (this->mesh != nullptr) && this->is_up_to_date();
+      this->dof_renumbering = dof_renumbering;
+      this->seq = g_space_seq++;
+      if (assigned)
+        this->assign_dofs(this->first_dof);
+    }
+
+    template<typename Scalar>
+    DofRenumberingType Space<Scalar>::get_dof_renumbering() const
+    {
+      return this->dof_renumbering;
+    }
+
+    template<typename Scalar>
+    void Space<Scalar>::renumber_dofs()
+    {
+      renumber_dofs(std::vector<Space<Scalar>*>(1, this), this->dof_renumbering);
+    }
+
+    template<typename Scalar>
+    void Space<Scalar>::renumber_dofs(const std::vector<Space<Scalar>*>& spaces, DofRenumberingType dof_renumbering)
+    {
+      int first_dof = spaces[0]->first_dof, ndof = 0;
+      for (unsigned int space_i = 0; space_i < spaces.size(); space_i++)
+        ndof += spaces[space_i]->ndof;
+      if (ndof < 2)
+        return;
+
+      // Blocks - the DOFs of nodes and element bubbles, positioned at their midpoints.
+      DofRenumberingBlocks blocks(first_dof, ndof);
+      Element* e;
+      for (unsigned int space_i = 0; space_i < spaces.size(); space_i++)
+      {
+        Space<Scalar>* space = spaces[space_i];
+        for_all_active_elements(e, space->mesh)
+        {
+          double x = 0., y = 0.;
+          for (unsigned char i = 0; i < e->get_nvert(); i++)
+          {
+            Node* vn = e->vn[i];
+            Node* vn_next = e->vn[e->next_vert(i)];
+            if (!vn->is_constrained_vertex())
+              blocks.add(space->ndata[vn->id].dof, 1, vn->x, vn->y);
+            NodeData* nd = space->ndata + e->en[i]->id;
+            if (nd->n > 0)
+              blocks.add(nd->dof, nd->n, (vn->x + vn_next->x) / 2., (vn->y + vn_next->y) / 2.);
+            x += vn->x;
+            y += vn->y;
+          }
+          blocks.add(space->edata[e->id].bdof, space->edata[e->id].n, x / e->get_nvert(), y / e->get_nvert());
+        }
+      }
+
+      if (!blocks.is_valid())
+      {
+        spaces[0]->warn("Space<Scalar>::renumber_dofs: DOFs not forming node / element blocks, the renumbering was skipped.");
+        return;
+      }
+
+      // Elements coupling the blocks - the active elements if all spaces are on one mesh, the states of the union mesh otherwise.
+      MeshSharedPtr mesh = spaces[0]->mesh;
+      std::vector<MeshSharedPtr> meshes;
+      for (unsigned int space_i = 0; space_i < spaces.size(); space_i++)
+      {
+        meshes.push_back(spaces[space_i]->mesh);
+        if (spaces[space_i]->mesh != mesh)
+          mesh.reset();
+      }
+      TraversalPlanSharedPtr traversal_plan;
+      unsigned int num_states;
+      if (mesh)
+        num_states = mesh->get_max_element_id();
+      else
+      {
+        traversal_plan = Traverse::get_plan(meshes, meshes.size());
+        num_states = traversal_plan->get_num_states();
+      }
+
+      // Block adjacency - blocks sharing an element, for L2 spaces also blocks of neighboring elements (DG coupling).
+      int num_blocks = blocks.size();
+      std::vector<std::pair<int, int> > edges;
+      std::vector<int> element_blocks;
+      AsmList<Scalar> al;
+      for (unsigned int state_i = 0; state_i < num_states; state_i++)
+      {
+        element_blocks.clear();
+        for (unsigned int space_i = 0; space_i < spaces.size(); space_i++)
+        {
+          Space<Scalar>* space = spaces[space_i];
+          e = mesh ? mesh->get_element_fast(state_i) : traversal_plan->get_states()[state_i]->e[space_i];
+          if (e == nullptr || !e->used || !e->active)
+            continue;
+
+          space->get_element_assembly_list(e, &al);
+          for (unsigned int i = 0; i < al.cnt; i++)
+          if (al.dof[i] >= 0)
+            element_blocks.push_back(blocks.get_block(al.dof[i]));
+          if (space->get_type() == HERMES_L2_SPACE)
+          {
+            for (unsigned char i = 0; i < e->get_nvert(); i++)
+            {
+              Element* neighbor = e->en[i]->bnd ? nullptr : e->get_neighbor(i);
+              if (neighbor != nullptr && neighbor->active)
+                element_blocks.push_back(blocks.get_block(space->edata[neighbor->id].n > 0 ? space->edata[neighbor->id].bdof : -1));
+            }
+          }
+        }
+        std::sort(element_blocks.begin(), element_blocks.end());
+        element_blocks.erase(std::unique(element_blocks.begin(), element_blocks.end()), element_blocks.end());
+        for (unsigned int i = 0; i < element_blocks.size(); i++)
+        for (unsigned int j = 0; j < element_blocks.size(); j++)
+        if (i != j && element_blocks[i] >= 0 && element_blocks[j] >= 0)
+          edges.push_back(std::pair<int, int>(element_blocks[i], element_blocks[j]));
+      }
+      std::sort(edges.begin(), edges.end());
+      edges.erase(std::unique(edges.begin(), edges.end()), edges.end());
+
+      std::vector<int> adj_offsets(num_blocks + 1, 0);
+      std::vector<int> adj(edges.size());
+      for (unsigned int i = 0; i < edges.size(); i++)
+      {
+        adj_offsets[edges[i].first + 1]++;
+        adj[i] = edges[i].second;
+      }
+      for (int i = 0; i < num_blocks; i++)
+        adj_offsets[i + 1] += adj_offsets[i];
+
+      // New order of the blocks.
+      std::vector<int> order;
+      if (dof_renumbering == HERMES_DOF_RENUMBERING_RCM)
+        dof_renumbering_rcm(num_blocks, adj_offsets, adj, order);
+      else
+      {
+        std::vector<int> subset(num_blocks), left_mark(num_blocks, -1);
+        for (int i = 0; i < num_blocks; i++)
+          subset[i] = i;
+        int mark_value = 0;
+        order.reserve(num_blocks);
+        dof_renumbering_nested_dissection(blocks, adj_offsets, adj, subset, left_mark, mark_value, order);
+      }
+
+      // Old DOF -> new DOF.
+      std::vector<int> dof_map(ndof);
+      for (int i = 0, new_dof = first_dof; i < num_blocks; i++)
+      {
+        int block = order[i];
+        for (int j = 0; j < blocks.count[block]; j++)
+          dof_map[blocks.start[block] - first_dof + j] = new_dof++;
+      }
+
+      // Rewrite the DOFs stored in the nodes and elements, every node once.
+      for (unsigned int space_i = 0; space_i < spaces.size(); space_i++)
+      {
+        Space<Scalar>* space = spaces[space_i];
+        std::vector<char> node_done(space->mesh->get_max_node_id(), 0);
+        for_all_active_elements(e, space->mesh)
+        {
+          for (unsigned char i = 0; i < e->get_nvert(); i++)
+          {
+            Node* vn = e->vn[i];
+            if (!node_done[vn->id])
+            {
+              node_done[vn->id] = 1;
+              NodeData* nd = space->ndata + vn->id;
+              if (!vn->is_constrained_vertex())
+              {
+                if (nd->dof >= 0)
+                  nd->dof = dof_map[nd->dof - first_dof];
+              }
+              // Baselists are only used by H1 spaces, they are kept sorted by DOF.
+              else if (space->get_type() == HERMES_H1_SPACE && nd->baselist != nullptr)
+              {
+                for (int j = 0; j < nd->ncomponents; j++)
+                if (nd->baselist[j].dof >= 0)
+                  nd->baselist[j].dof = dof_map[nd->baselist[j].dof - first_dof];
+                for (int j = 1; j < nd->ncomponents; j++)
+                {
+                  BaseComponent component = nd->baselist[j];
+                  int k = j - 1;
+                  for (; k >= 0 && nd->baselist[k].dof > component.dof; k--)
+                    nd->baselist[k + 1] = nd->baselist[k];
+                  nd->baselist[k + 1] = component;
+                }
+              }
+            }
+
+            Node* en = e->en[i];
+            if (!node_done[en->id])
+            {
+              node_done[en->id] = 1;
+              NodeData* nd = space->ndata + en->id;
+              if (nd->n > 0 && nd->dof >= 0)
+                nd->dof = dof_map[nd->dof - first_dof];
+            }
+          }
+
+          ElementData* ed = space->edata + e->id;
+          if (ed->n > 0 && ed->bdof >= 0)
+            ed->bdof = dof_map[ed->bdof - first_dof];
+        }
+      }
+
+      // A system - the permutation is kept for reordering vectors of the spaces, the assembly lists are built anew.
+      if (spaces.size() > 1)
+      {
+        for (unsigned int space_i = 0; space_i < spaces.size(); space_i++)
+        {
+          Space<Scalar>* space = spaces[space_i];
+          space->system_dofs.assign(dof_map.begin() + (space->first_dof - first_dof), dof_map.begin() + (space->first_dof - first_dof + space->ndof));
+          space->build_assembly_list_table();
+        }
+      }
+    }
+
     template<typename Scalar>
     void Space<Scalar>::reset_dof_assignment()
     {
@@ -965,6 +1489,9 @@ namespace Hermes
         throw Hermes::Exceptions::Exception("The space in get_element_assembly_list() is out of date. You need to update it with assign_dofs()"
         " any time the mesh changes.");
 
+      if (this->get_element_assembly_list_from_table(e, al))
+        return;
+
       // add vertex, edge and bubble functions to the assembly list
       al->cnt = 0;
       for (unsigned char i = 0; i < e->get_nvert(); i++)
@@ -974,6 +1501,58 @@ namespace Hermes
       get_bubble_assembly_list(e, al);
     }
 
+    template<typename Scalar>
+    void Space<Scalar>::build_assembly_list_table()
+    {
+      this->asm_table_valid = false;
+
+      int max_element_id = this->mesh->get_max_element_id();
+      this->asm_table_offsets.resize(max_element_id + 1);
+      this->asm_table_idx.clear();
+      this->asm_table_dof.clear();
+      this->asm_table_coef.clear();
+
+      AsmList<Scalar> al;
+      for (int id = 0; id < max_element_id; id++)
+      {
+        this->asm_table_offsets[id] = this->asm_table_idx.size();
+
+        Element* e = this->mesh->get_element_fast(id);
+        if (!e->used || !e->active || id >= this->esize || this->edata[id].order < 0)
+          continue;
+
+        this->get_element_assembly_list(e, &al);
+        this->asm_table_idx.insert(this->asm_table_idx.end(), al.idx, al.idx + al.cnt);
+        this->asm_table_dof.insert(this->asm_table_dof.end(), al.dof, al.dof + al.cnt);
+        this->asm_table_coef.insert(this->asm_table_coef.end(), al.coef, al.coef + al.cnt);
+      }
+      this->asm_table_offsets[max_element_id] = this->asm_table_idx.size();
+
+      this->asm_table_seq = this->seq;
+      this->asm_table_mesh_seq = this->mesh->get_seq();
+      this->asm_table_valid = true;
+    }
+
+    template<typename Scalar>
+    bool Space<Scalar>::get_element_assembly_list_from_table(Element* e, AsmList<Scalar>* al) const
+    {
+      if (!this->asm_table_valid || this->asm_table_seq != this->seq || this->asm_table_mesh_seq != this->mesh->get_seq())
+        return false;
+      if (e->id + 1 >= (int)this->asm_table_offsets.size())
+        return false;
+
+      int start = this->asm_table_offsets[e->id];
+      int cnt = this->asm_table_offsets[e->id + 1] - start;
+      if (cnt == 0)
+        return false;
+
+      memcpy(al->idx, &this->asm_table_idx[start], cnt * sizeof(int));
+      memcpy(al->dof, &this->asm_table_dof[start], cnt * sizeof(int));
+      memcpy(al->coef, &this->asm_table_coef[start], cnt * sizeof(Scalar));
+      al->cnt = cnt;
+      return true;
+    }
+
     template<typename Scalar>
     void Space<Scalar>::get_boundary_assembly_list(Element* e, int surf_num, AsmList<Scalar>* al) const
     {
@@ -1080,6 +1659,9 @@ namespace Hermes
           }
         }
       }
+      // The Dirichlet lift coefficients are part of the assembly lists.
+      if (this->asm_table_valid)
+        this->build_assembly_list_table();
     }
 
     template<typename Scalar>
@@ -1528,6 +2110,135 @@ namespace Hermes
     }
 #endif
 
+    template<typename Scalar>
+    void Space<Scalar>::save_binary(BinaryIO::BinaryContainerWriter& writer, const char* prefix) const
+    {
+      // Check.
+      this->check();
+
+      int element_data_count = this->mesh->get_max_element_id();
+
+      // Space type, count, number of DOFs, first DOF, renumbering, renumbered jointly with other spaces.
+      int* info = writer.allocate_array<int>((std::string(prefix) + "info").c_str(), 6);
+      info[0] = this->get_type();
+      info[1] = element_data_count;
+      info[2] = this->ndof;
+      info[3] = this->first_dof;
+      info[4] = this->dof_renumbering;
+      info[5] = !this->system_dofs.empty();
+
+      // Element data (order, bdof, n, changed).
+      int* element_data = writer.allocate_array<int>((std::string(prefix) + "element_data").c_str(), 4 * element_data_count);
+      for (int _id = 0; _id < element_data_count; _id++)
+      {
+        element_data[4 * _id] = this->edata[_id].order;
+        element_data[4 * _id + 1] = this->edata[_id].bdof;
+        element_data[4 * _id + 2] = this->edata[_id].n;
+        element_data[4 * _id + 3] = this->edata[_id].changed_in_last_adaptation;
+      }
+
+      // DOF map - the assembly lists of the active elements.
+      int* dof_map_offsets = writer.allocate_array<int>((std::string(prefix) + "dof_map_offsets").c_str(), element_data_count + 1);
+      std::vector<int> dof_map;
+      AsmList<Scalar> al;
+      dof_map_offsets[0] = 0;
+      for (int _id = 0; _id < element_data_count; _id++)
+      {
+        Element* e = this->mesh->get_element_fast(_id);
+        if (e->used && e->active)
+        {
+          this->get_element_assembly_list(e, &al);
+          dof_map.insert(dof_map.end(), al.dof, al.dof + al.cnt);
+        }
+        dof_map_offsets[_id + 1] = dof_map.size();
+      }
+      int* dof_map_data = writer.allocate_array<int>((std::string(prefix) + "dof_map").c_str(), dof_map.size());
+      if (!dof_map.empty())
+        memcpy(dof_map_data, &dof_map[0], dof_map.size() * sizeof(int));
+    }
+
+    template<typename Scalar>
+    SpaceSharedPtr<Scalar> Space<Scalar>::load_binary(const BinaryIO::BinaryContainer& container, const char* prefix, MeshSharedPtr mesh, EssentialBCs<Scalar>* essential_bcs, Shapeset* shapeset)
+    {
+      int* info = container.get_array_of_size<int>((std::string(prefix) + "info").c_str(), 6);
+      if (info[5])
+        throw Exceptions::Exception("The space was renumbered jointly with other spaces, it has to be loaded with them (Checkpoint::load_spaces()) in Space<Scalar>::load_binary.");
+
+      SpaceSharedPtr<Scalar> space = Space<Scalar>::load_binary_data(container, prefix, mesh, essential_bcs, shapeset);
+      space->assign_dofs(info[3]);
+      space->check_binary_dof_map(container, prefix);
+
+      return space;
+    }
+
+    template<typename Scalar>
+    SpaceSharedPtr<Scalar> Space<Scalar>::load_binary_data(const BinaryIO::BinaryContainer& container, const char* prefix, MeshSharedPtr mesh, EssentialBCs<Scalar>* essential_bcs, Shapeset* shapeset)
+    {
+      int* info = container.get_array_of_size<int>((std::string(prefix) + "info").c_str(), 6);
+
+      SpaceSharedPtr<Scalar> space = Space<Scalar>::init_empty_space((SpaceType)info[0], mesh, shapeset);
+      space->mesh_seq = space->mesh->get_seq();
+      space->resize_tables();
+
+      // L2 space does not have any (strong) essential BCs.
+      if (essential_bcs != nullptr && space->get_type() != HERMES_L2_SPACE && space->get_type() != HERMES_L2_MARKERWISE_CONST_SPACE)
+      {
+        space->essential_bcs = essential_bcs;
+        for (typename std::vector<EssentialBoundaryCondition<Scalar>*>::const_iterator it = essential_bcs->begin(); it != essential_bcs->end(); it++)
+          for (unsigned int i = 0; i < (*it)->markers.size(); i++)
+            if (space->get_mesh()->boundary_markers_conversion.conversion_table_inverse.find((*it)->markers.at(i)) == space->get_mesh()->boundary_markers_conversion.conversion_table_inverse.end())
+              throw Hermes::Exceptions::Exception("A boundary condition defined on a non-existent marker.");
+      }
+
+      // Element count.
+      if (info[1] != mesh->get_max_element_id())
+        throw Exceptions::Exception("Mesh and saved space mixed in Space<Scalar>::load_binary.");
+
+      int* element_data = container.get_array_of_size<int>((std::string(prefix) + "element_data").c_str(), 4 * info[1]);
+      for (int _id = 0; _id < info[1]; _id++)
+      {
+        space->edata[_id].order = element_data[4 * _id];
+        space->edata[_id].bdof = element_data[4 * _id + 1];
+        space->edata[_id].n = element_data[4 * _id + 2];
+        space->edata[_id].changed_in_last_adaptation = element_data[4 * _id + 3] != 0;
+      }
+
+      space->seq = g_space_seq++;
+
+      space->dof_renumbering = (DofRenumberingType)info[4];
+
+      return space;
+    }
+
+    template<typename Scalar>
+    void Space<Scalar>::check_binary_dof_map(const BinaryIO::BinaryContainer& container, const char* prefix) const
+    {
+      int* info = container.get_array_of_size<int>((std::string(prefix) + "info").c_str(), 6);
+
+      // The DOF map is deterministic given the element data, first DOF and renumbering - checked, so that the coefficient
+      // vectors saved with the space are never scattered onto different DOFs.
+      if (this->ndof != info[2])
+        throw Exceptions::Exception("The number of DOFs of the loaded space (%i) differs from the saved one (%i) in Space<Scalar>::load_binary.", this->ndof, info[2]);
+
+      int* dof_map_offsets = container.get_array_of_size<int>((std::string(prefix) + "dof_map_offsets").c_str(), info[1] + 1);
+      int* dof_map = container.get_array_of_size<int>((std::string(prefix) + "dof_map").c_str(), dof_map_offsets[info[1]]);
+      AsmList<Scalar> al;
+      for (int _id = 0; _id < info[1]; _id++)
+      {
+        Element* e = this->mesh->get_element_fast(_id);
+        if (!e->used || !e->active)
+        {
+          if (dof_map_offsets[_id + 1] != dof_map_offsets[_id])
+            throw Exceptions::Exception("Mesh and saved space mixed in Space<Scalar>::load_binary.");
+          continue;
+        }
+
+        this->get_element_assembly_list(e, &al);
+        if (al.cnt != dof_map_offsets[_id + 1] - dof_map_offsets[_id] || memcmp(al.dof, dof_map + dof_map_offsets[_id], al.cnt * sizeof(int)))
+          throw Exceptions::Exception("The DOF map of the loaded space differs from the saved one (element %i) in Space<Scalar>::load_binary.", _id);
+      }
+    }
+
     namespace Mixins
     {
       template<typename Scalar>
@@ -114,6 +114,9 @@ namespace Hermes
     template<typename Scalar>
     void L2Space<Scalar>::get_element_assembly_list(Element* e, AsmList<Scalar>* al) const
     {
+      if (this->get_element_assembly_list_from_table(e, al))
+        return;
+
       // add bubble functions to the assembly list
       al->cnt = 0;
       get_bubble_assembly_list(e, al);
@@ -14,10 +14,14 @@
 // along with Hermes2D.  If not, see <http://www.gnu.org/licenses/>.
 
 #include "thread_linearizer.h"
+#include "vtu_output.h"
 #include "refmap.h"
 #include "traverse.h"
 #include "exact_solution.h"
 #include "api2d.h"
+#ifdef _MSC_VER
+#include <intrin.h>
+#endif
 
 namespace Hermes
 {
@@ -25,6 +29,16 @@ namespace Hermes
   {
     namespace Views
     {
+      /// Atomic compare-and-swap of a slot in the vertex table, returns the previous value.
+      static int compare_and_swap(volatile int* slot, int expected, int desired)
+      {
+#ifdef _MSC_VER
+        return _InterlockedCompareExchange((volatile long*)slot, desired, expected);
+#else
+        return __sync_val_compare_and_swap(slot, expected, desired);
+#endif
+      }
+
       LinearizerCriterion::LinearizerCriterion(bool adaptive) : adaptive(adaptive)
       {
       }
@@ -269,32 +283,153 @@ namespace Hermes
         // regularize the linear mesh
         if (this->exceptionMessageCaughtInParallelBlock.empty())
         {
-          find_min_max();
-          // Polish triangle vertex indices for FileExport case.
+          // Merge vertices & polish triangle vertex indices for FileExport case.
           if (this->linearizerOutputType == FileExport)
+            this->merge_vertices();
+          find_min_max();
+        }
+
+        // select old quadratrues
+        for (int k = 0; k < LinearizerDataDimensions::dimension; k++)
+          sln[k]->set_quad_2d(old_quad[k]);
+
+        // Unlock data.
+        this->unlock_data();
+      }
+
+      template<typename LinearizerDataDimensions>
+      void LinearizerMultidimensional<LinearizerDataDimensions>::merge_vertices()
+      {
+        // Offsets of the threads' vertices in the global numbering (exclusive prefix sum).
+        int* offsets = malloc_with_check<LinearizerMultidimensional<LinearizerDataDimensions>, int>(this->num_threads_used + 1, this);
+        offsets[0] = 0;
+        for (int i = 0; i < this->num_threads_used; i++)
+          offsets[i + 1] = offsets[i] + this->threadLinearizerMultidimensional[i]->vertex_count;
+        int total_count = offsets[this->num_threads_used];
+        if (total_count == 0)
+        {
+          free_with_check(offsets);
+          return;
+        }
+
+        unsigned long long* keys = malloc_with_check<LinearizerMultidimensional<LinearizerDataDimensions>, unsigned long long>(total_count, this);
+        typename LinearizerDataDimensions::vertex_t** vertices = malloc_with_check<LinearizerMultidimensional<LinearizerDataDimensions>, typename LinearizerDataDimensions::vertex_t*>(total_count, this);
+        // Slot in the table, later representative (the lowest global index of the same vertex) of each vertex.
+        int* representatives = malloc_with_check<LinearizerMultidimensional<LinearizerDataDimensions>, int>(total_count, this);
+        int* new_indices = malloc_with_check<LinearizerMultidimensional<LinearizerDataDimensions>, int>(total_count, this);
+        int* new_offsets = malloc_with_check<LinearizerMultidimensional<LinearizerDataDimensions>, int>(this->num_threads_used + 1, this);
+
+        // Open addressing table of global vertex indices, at most half full.
+        int table_size = 1;
+        while (table_size < 2 * total_count)
+          table_size <<= 1;
+        int* table = malloc_with_check<LinearizerMultidimensional<LinearizerDataDimensions>, int>(table_size, this);
+        memset(table, 0xff, sizeof(int)* table_size);
+
+        // 1 - keys.
+#pragma omp parallel for num_threads(num_threads_used) schedule(static, 1)
+        for (int i = 0; i < this->num_threads_used; i++)
+        {
+          ThreadLinearizerMultidimensional<LinearizerDataDimensions>* thread_linearizer = this->threadLinearizerMultidimensional[i];
+          thread_linearizer->calculate_vertex_keys(keys + offsets[i]);
+          for (int j = 0; j < thread_linearizer->vertex_count; j++)
+            vertices[offsets[i] + j] = &thread_linearizer->vertices[j];
+        }
+
+        // 2 - insertion into the table, the slot of a vertex keeps the lowest global index of its duplicates.
+        // Slots are only ever claimed (never emptied) and only replaced by a matching vertex,
+        // so that all duplicates of a vertex end in the first matching slot of their (common) probing sequence.
+#pragma omp parallel for num_threads(num_threads_used) schedule(static, 1)
+        for (int i = 0; i < this->num_threads_used; i++)
+        {
+          for (int global_index = offsets[i]; global_index < offsets[i + 1]; global_index++)
           {
-            int running_count = 0;
-            for (int i = 0; i < this->num_threads_used; i++)
+            int slot = (int)(keys[global_index] & (table_size - 1));
+            while (true)
             {
-              if (i > 0)
+              int current = ((volatile int*)table)[slot];
+              if (current == -1)
+              {
+                current = compare_and_swap(table + slot, -1, global_index);
+                if (current == -1)
+                {
+                  representatives[global_index] = slot;
+                  break;
+                }
+              }
+              if (keys[current] == keys[global_index] && ThreadLinearizerMultidimensional<LinearizerDataDimensions>::vertices_match(*vertices[current], *vertices[global_index]))
               {
-                for (int j = 0; j < this->threadLinearizerMultidimensional[i]->triangle_count; j++)
+                while (current > global_index)
                 {
-                  for (int k = 0; k < 3; k++)
-                    this->threadLinearizerMultidimensional[i]->triangle_indices[j][k] += running_count;
+                  int previous = compare_and_swap(table + slot, current, global_index);
+                  if (previous == current)
+                    break;
+                  current = previous;
                 }
+                representatives[global_index] = slot;
+                break;
               }
-              running_count += this->threadLinearizerMultidimensional[i]->vertex_count;
+              slot = (slot + 1) & (table_size - 1);
             }
           }
         }
 
-        // select old quadratrues
-        for (int k = 0; k < LinearizerDataDimensions::dimension; k++)
-          sln[k]->set_quad_2d(old_quad[k]);
+        // 3 - representatives, counts of the unique vertices per thread.
+#pragma omp parallel for num_threads(num_threads_used) schedule(static, 1)
+        for (int i = 0; i < this->num_threads_used; i++)
+        {
+          int unique_count = 0;
+          for (int global_index = offsets[i]; global_index < offsets[i + 1]; global_index++)
+          {
+            representatives[global_index] = table[representatives[global_index]];
+            if (representatives[global_index] == global_index)
+              unique_count++;
+          }
+          new_offsets[i + 1] = unique_count;
+        }
 
-        // Unlock data.
-        this->unlock_data();
+        new_offsets[0] = 0;
+        for (int i = 0; i < this->num_threads_used; i++)
+          new_offsets[i + 1] += new_offsets[i];
+
+        // 4 - compaction of the vertices (in place, each thread's part keeps its order).
+#pragma omp parallel for num_threads(num_threads_used) schedule(static, 1)
+        for (int i = 0; i < this->num_threads_used; i++)
+        {
+          ThreadLinearizerMultidimensional<LinearizerDataDimensions>* thread_linearizer = this->threadLinearizerMultidimensional[i];
+          int local_index = 0;
+          for (int j = 0; j < thread_linearizer->vertex_count; j++)
+          {
+            int global_index = offsets[i] + j;
+            if (representatives[global_index] != global_index)
+              continue;
+            new_indices[global_index] = new_offsets[i] + local_index;
+            if (local_index != j)
+              memcpy(&thread_linearizer->vertices[local_index], &thread_linearizer->vertices[j], sizeof(typename LinearizerDataDimensions::vertex_t));
+            local_index++;
+          }
+        }
+
+        // 5 - triangle indices.
+#pragma omp parallel for num_threads(num_threads_used) schedule(static, 1)
+        for (int i = 0; i < this->num_threads_used; i++)
+        {
+          ThreadLinearizerMultidimensional<LinearizerDataDimensions>* thread_linearizer = this->threadLinearizerMultidimensional[i];
+          for (int j = 0; j < thread_linearizer->triangle_count; j++)
+          {
+            for (int k = 0; k < 3; k++)
+              thread_linearizer->triangle_indices[j][k] = new_indices[representatives[offsets[i] + thread_linearizer->triangle_indices[j][k]]];
+          }
+          thread_linearizer->vertex_count = new_offsets[i + 1] - new_offsets[i];
+        }
+
+        free_with_check(table);
+        free_with_check(new_offsets);
+        free_with_check(new_indices);
+        free_with_check(representatives);
+        free_with_check(vertices);
+        free_with_check(keys);
+        free_with_check(offsets);
       }
 
       template<typename LinearizerDataDimensions>
@@ -453,6 +588,128 @@ namespace Hermes
         LinearizerMultidimensional<LinearizerDataDimensions>::save_solution_vtk(slns, items, filename, quantity_name, mode_3D);
       }
 
+      template<typename LinearizerDataDimensions>
+      void LinearizerMultidimensional<LinearizerDataDimensions>::save_solution_vtu(std::vector<MeshFunctionSharedPtr<double> > slns, std::vector<int> items, const char* filename, const char *quantity_name,
+        bool mode_3D, bool compress)
+      {
+        if (this->linearizerOutputType != FileExport)
+          throw Exceptions::Exception("This LinearizerMultidimensional is not meant to be used for file export, create a new one with appropriate linearizerOutputType.");
+
+        if (compress && !VTUAppendedDataWriter::compression_available())
+          throw Exceptions::Exception("Compressed VTU output requires Hermes built with WITH_ZLIB.");
+
+        process_solution(&slns[0], &items[0]);
+
+        FILE* f = fopen(filename, "wb");
+        if (f == nullptr) throw Hermes::Exceptions::Exception("Could not open %s for writing.", filename);
+        setvbuf(f, nullptr, _IOFBF, 1 << 20);
+
+        const int dimension = LinearizerDataDimensions::dimension;
+        const char* data_type = sizeof(LINEARIZER_DATA_TYPE) == sizeof(float) ? "Float32" : "Float64";
+        int vertex_count = this->get_vertex_count();
+        int triangle_count = this->get_triangle_count();
+
+        // Header, the offsets of the arrays in the appended data are filled in at the end.
+        // Order of the arrays: values, points, connectivity, offsets, types.
+        long long offset_positions[5];
+        fprintf(f, "<?xml version=\"1.0\"?>\n");
+        fprintf(f, "<VTKFile type=\"UnstructuredGrid\" version=\"1.0\" byte_order=\"LittleEndian\" header_type=\"UInt64\"%s>\n", compress ? " compressor=\"vtkZLibDataCompressor\"" : "");
+        fprintf(f, "  <UnstructuredGrid>\n");
+        fprintf(f, "    <Piece NumberOfPoints=\"%d\" NumberOfCells=\"%d\">\n", vertex_count, triangle_count);
+        fprintf(f, "      <PointData%s%s%s>\n", dimension == 1 ? " Scalars=\"" : "", dimension == 1 ? quantity_name : "", dimension == 1 ? "\"" : "");
+        fprintf(f, "        <DataArray type=\"%s\" Name=\"%s\" NumberOfComponents=\"%d\" format=\"appended\" offset=\"", data_type, quantity_name, dimension);
+        offset_positions[0] = VTUAppendedDataWriter::tell(f);
+        fprintf(f, "%020llu\"/>\n", 0ULL);
+        fprintf(f, "      </PointData>\n");
+        fprintf(f, "      <Points>\n");
+        fprintf(f, "        <DataArray type=\"%s\" NumberOfComponents=\"3\" format=\"appended\" offset=\"", data_type);
+        offset_positions[1] = VTUAppendedDataWriter::tell(f);
+        fprintf(f, "%020llu\"/>\n", 0ULL);
+        fprintf(f, "      </Points>\n");
+        fprintf(f, "      <Cells>\n");
+        fprintf(f, "        <DataArray type=\"Int32\" Name=\"connectivity\" format=\"appended\" offset=\"");
+        offset_positions[2] = VTUAppendedDataWriter::tell(f);
+        fprintf(f, "%020llu\"/>\n", 0ULL);
+        fprintf(f, "        <DataArray type=\"Int32\" Name=\"offsets\" format=\"appended\" offset=\"");
+        offset_positions[3] = VTUAppendedDataWriter::tell(f);
+        fprintf(f, "%020llu\"/>\n", 0ULL);
+        fprintf(f, "        <DataArray type=\"UInt8\" Name=\"types\" format=\"appended\" offset=\"");
+        offset_positions[4] = VTUAppendedDataWriter::tell(f);
+        fprintf(f, "%020llu\"/>\n", 0ULL);
+        fprintf(f, "      </Cells>\n");
+        fprintf(f, "    </Piece>\n");
+        fprintf(f, "  </UnstructuredGrid>\n");
+        fprintf(f, "  <AppendedData encoding=\"raw\">\n_");
+
+        unsigned long long offsets[5];
+        {
+          VTUAppendedDataWriter writer(f, compress);
+
+          // Values.
+          writer.begin_array((unsigned long long)vertex_count * dimension * sizeof(LINEARIZER_DATA_TYPE));
+          for (int i = 0; i < this->num_threads_used; i++)
+            for (int j = 0; j < this->threadLinearizerMultidimensional[i]->vertex_count; j++)
+              writer.write(&this->threadLinearizerMultidimensional[i]->vertices[j][2], dimension * sizeof(LINEARIZER_DATA_TYPE));
+          offsets[0] = writer.end_array();
+
+          // Points.
+          writer.begin_array((unsigned long long)vertex_count * 3 * sizeof(LINEARIZER_DATA_TYPE));
+          for (int i = 0; i < this->num_threads_used; i++)
+          {
+            for (int j = 0; j < this->threadLinearizerMultidimensional[i]->vertex_count; j++)
+            {
+              typename LinearizerDataDimensions::vertex_t& vertex = this->threadLinearizerMultidimensional[i]->vertices[j];
+              LINEARIZER_DATA_TYPE point[3] = { vertex[0], vertex[1], (mode_3D && dimension == 1) ? vertex[2] : (LINEARIZER_DATA_TYPE)0 };
+              writer.write(point, 3 * sizeof(LINEARIZER_DATA_TYPE));
+            }
+          }
+          offsets[1] = writer.end_array();
+
+          // Connectivity, the indices are already global (see finish()).
+          writer.begin_array((unsigned long long)triangle_count * sizeof(triangle_indices_t));
+          for (int i = 0; i < this->num_threads_used; i++)
+            writer.write(this->threadLinearizerMultidimensional[i]->triangle_indices, (unsigned long long)this->threadLinearizerMultidimensional[i]->triangle_count * sizeof(triangle_indices_t));
+          offsets[2] = writer.end_array();
+
+          // Offsets.
+          writer.begin_array((unsigned long long)triangle_count * sizeof(int));
+          for (int i = 1; i <= triangle_count; i++)
+          {
+            int offset = 3 * i;
+            writer.write(&offset, sizeof(int));
+          }
+          offsets[3] = writer.end_array();
+
+          // Cell types, the "5" means triangle in VTK.
+          writer.begin_array((unsigned long long)triangle_count);
+          unsigned char type = 5;
+          for (int i = 0; i < triangle_count; i++)
+            writer.write(&type, 1);
+          offsets[4] = writer.end_array();
+        }
+
+        fprintf(f, "\n  </AppendedData>\n");
+        fprintf(f, "</VTKFile>\n");
+
+        for (int i = 0; i < 5; i++)
+        {
+          VTUAppendedDataWriter::seek(f, offset_positions[i]);
+          fprintf(f, "%020llu", offsets[i]);
+        }
+
+        fclose(f);
+      }
+
+      template<typename LinearizerDataDimensions>
+      void LinearizerMultidimensional<LinearizerDataDimensions>::save_solution_vtu(MeshFunctionSharedPtr<double> sln, const char* filename, const char* quantity_name, bool mode_3D, int item, bool compress)
+      {
+        std::vector<MeshFunctionSharedPtr<double> > slns;
+        std::vector<int> items;
+        slns.push_back(sln);
+        items.push_back(item);
+        LinearizerMultidimensional<LinearizerDataDimensions>::save_solution_vtu(slns, items, filename, quantity_name, mode_3D, compress);
+      }
+
       template<typename LinearizerDataDimensions>
       void LinearizerMultidimensional<LinearizerDataDimensions>::save_solution_tecplot(std::vector<MeshFunctionSharedPtr<double> > slns, std::vector<int> items, const char* filename, std::vector<std::string> quantity_names)
       {
@@ -181,7 +181,7 @@ namespace Hermes
         this->hash_table = malloc_with_check<ThreadLinearizerMultidimensional<LinearizerDataDimensions>, int>(this->vertex_size, this, true);
         memset(this->hash_table, 0xff, sizeof(int)* this->vertex_size);
 
-        this->info = malloc_with_check<ThreadLinearizerMultidimensional<LinearizerDataDimensions>, internal_vertex_info_t>(this->vertex_size, this, true);
+        this->info = realloc_with_check<ThreadLinearizerMultidimensional, internal_vertex_info_t>(this->info, this->vertex_size, this);
       }
 
       template<typename LinearizerDataDimensions>
@@ -190,8 +190,8 @@ namespace Hermes
         for (unsigned int j = 0; j < (LinearizerDataDimensions::dimension + (this->user_xdisp ? 1 : 0) + (this->user_ydisp ? 1 : 0)); j++)
           delete fns[j];
 
+        // info is kept for LinearizerMultidimensional::merge_vertices().
         free_with_check(this->hash_table, true);
-        free_with_check(this->info, true);
       }
 
       template<typename LinearizerDataDimensions>
@@ -743,6 +743,50 @@ namespace Hermes
         return i;
       }
 
+      template<typename LinearizerDataDimensions>
+      void ThreadLinearizerMultidimensional<LinearizerDataDimensions>::calculate_vertex_keys(unsigned long long* keys) const
+      {
+        // Parents are always created before their children.
+        for (int i = 0; i < this->vertex_count; i++)
+        {
+          // Mesh vertex, see process_state().
+          if (this->info[i][0] == this->info[i][1])
+          {
+            keys[i] = (unsigned long long)(-this->info[i][0]);
+            continue;
+          }
+
+          unsigned long long key_1 = keys[this->info[i][0]];
+          unsigned long long key_2 = keys[this->info[i][1]];
+          if (key_1 > key_2)
+            std::swap(key_1, key_2);
+
+          // 64-bit mixing of the (ordered) couple of parent keys.
+          unsigned long long key = key_1 * 0x9E3779B97F4A7C15ULL + key_2;
+          key ^= key >> 33;
+          key *= 0xFF51AFD7ED558CCDULL;
+          key ^= key >> 33;
+          key *= 0xC4CEB9FE1A85EC53ULL;
+          key ^= key >> 33;
+          keys[i] = key;
+        }
+      }
+
+      template<typename LinearizerDataDimensions>
+      bool ThreadLinearizerMultidimensional<LinearizerDataDimensions>::vertices_match(const typename LinearizerDataDimensions::vertex_t& a, const typename LinearizerDataDimensions::vertex_t& b)
+      {
+        if (fabs(a[0] - b[0]) >= Hermes::HermesEpsilon || fabs(a[1] - b[1]) >= Hermes::HermesEpsilon)
+          return false;
+        // Different values on the same place - discontinuity, see get_vertex().
+        for (int k = 0; k < LinearizerDataDimensions::dimension; k++)
+        {
+          double difference = fabs(a[2 + k] - b[2 + k]);
+          if (difference >= Hermes::HermesEpsilon && difference > vertex_relative_tolerance * std::max(fabs(a[2 + k]), fabs(b[2 + k])))
+            return false;
+        }
+        return true;
+      }
+
       template<typename LinearizerDataDimensions>
       int ThreadLinearizerMultidimensional<LinearizerDataDimensions>::add_vertex()
       {
@@ -0,0 +1,204 @@
+// This file is part of Hermes2D.
+//
+// Hermes2D is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 2 of the License, or
+// (at your option) any later version.
+//
+// Hermes2D is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with Hermes2D.  If not, see <http://www.gnu.org/licenses/>.
+
+#include "vtu_output.h"
+#ifdef WITH_ZLIB
+#include <zlib.h>
+#endif
+
+namespace Hermes
+{
+  namespace Hermes2D
+  {
+    namespace Views
+    {
+      VTUAppendedDataWriter::VTUAppendedDataWriter(FILE* file, bool compress) : file(file), compress(compress), array_byte_count(0), array_bytes_written(0), block_fill(0), compressed_block(nullptr), compressed_block_size(0)
+      {
+        if (compress && !compression_available())
+          throw Exceptions::Exception("Compressed VTU output requires Hermes built with WITH_ZLIB.");
+
+        this->appended_start = tell(file);
+        this->array_start = this->appended_start;
+        this->block = malloc_with_check<char>(H2D_VTU_BLOCK_SIZE);
+#ifdef WITH_ZLIB
+        if (compress)
+        {
+          this->compressed_block_size = compressBound(H2D_VTU_BLOCK_SIZE);
+          this->compressed_block = malloc_with_check<char>(this->compressed_block_size);
+        }
+#endif
+      }
+
+      VTUAppendedDataWriter::~VTUAppendedDataWriter()
+      {
+        free_with_check(this->block);
+        free_with_check(this->compressed_block);
+      }
+
+      bool VTUAppendedDataWriter::compression_available()
+      {
+#ifdef WITH_ZLIB
+        return true;
+#else
+        return false;
+#endif
+      }
+
+      long long VTUAppendedDataWriter::tell(FILE* file)
+      {
+#if defined(WIN32) || defined(_WINDOWS)
+        return _ftelli64(file);
+#else
+        return ftello(file);
+#endif
+      }
+
+      void VTUAppendedDataWriter::seek(FILE* file, long long position)
+      {
+#if defined(WIN32) || defined(_WINDOWS)
+        _fseeki64(file, position, SEEK_SET);
+#else
+        fseeko(file, position, SEEK_SET);
+#endif
+      }
+
+      void VTUAppendedDataWriter::begin_array(unsigned long long byte_count)
+      {
+        this->array_start = tell(this->file);
+        this->array_byte_count = byte_count;
+        this->array_bytes_written = 0;
+        this->block_fill = 0;
+
+        if (this->compress)
+        {
+          // Header: number of blocks, block size, size of the last block, compressed sizes of the blocks.
+          // Written with zero compressed sizes now, rewritten in end_array().
+          unsigned long long block_count = (byte_count + H2D_VTU_BLOCK_SIZE - 1) / H2D_VTU_BLOCK_SIZE;
+          this->compressed_sizes.clear();
+          this->compressed_sizes.reserve(block_count);
+          std::vector<unsigned long long> header(3 + block_count, 0);
+          fwrite(&header[0], sizeof(unsigned long long), header.size(), this->file);
+        }
+        else
+          fwrite(&byte_count, sizeof(unsigned long long), 1, this->file);
+      }
+
+      void VTUAppendedDataWriter::write(const void* data, unsigned long long byte_count)
+      {
+        this->array_bytes_written += byte_count;
+        if (this->array_bytes_written > this->array_byte_count)
+          throw Exceptions::Exception("More data written to a VTU data array than announced.");
+
+        // Large uncompressed writes go directly to the file.
+        if (!this->compress && this->block_fill == 0 && byte_count >= H2D_VTU_BLOCK_SIZE)
+        {
+          fwrite(data, 1, byte_count, this->file);
+          return;
+        }
+
+        const char* data_char = (const char*)data;
+        while (byte_count > 0)
+        {
+          unsigned int to_copy = (unsigned int)std::min<unsigned long long>(byte_count, H2D_VTU_BLOCK_SIZE - this->block_fill);
+          memcpy(this->block + this->block_fill, data_char, to_copy);
+          this->block_fill += to_copy;
+          data_char += to_copy;
+          byte_count -= to_copy;
+          if (this->block_fill == H2D_VTU_BLOCK_SIZE)
+            this->flush_block();
+        }
+      }
+
+      void VTUAppendedDataWriter::flush_block()
+      {
+        if (this->block_fill == 0)
+          return;
+
+#ifdef WITH_ZLIB
+        if (this->compress)
+        {
+          uLongf compressed_size = this->compressed_block_size;
+          if (compress2((Bytef*)this->compressed_block, &compressed_size, (const Bytef*)this->block, this->block_fill, Z_DEFAULT_COMPRESSION) != Z_OK)
+            throw Exceptions::Exception("zlib compression of VTU data failed.");
+          fwrite(this->compressed_block, 1, compressed_size, this->file);
+          this->compressed_sizes.push_back(compressed_size);
+        }
+        else
+#endif
+          fwrite(this->block, 1, this->block_fill, this->file);
+
+        this->block_fill = 0;
+      }
+
+      unsigned long long VTUAppendedDataWriter::end_array()
+      {
+        if (this->array_bytes_written != this->array_byte_count)
+          throw Exceptions::Exception("Less data written to a VTU data array than announced.");
+
+        this->flush_block();
+
+        if (this->compress)
+        {
+          long long array_end = tell(this->file);
+
+          std::vector<unsigned long long> header;
+          header.push_back(this->compressed_sizes.size());
+          header.push_back(H2D_VTU_BLOCK_SIZE);
+          unsigned long long last_block_size = this->array_byte_count % H2D_VTU_BLOCK_SIZE;
+          header.push_back((last_block_size == 0 && this->array_byte_count > 0) ? H2D_VTU_BLOCK_SIZE : last_block_size);
+          header.insert(header.end(), this->compressed_sizes.begin(), this->compressed_sizes.end());
+
+          seek(this->file, this->array_start);
+          fwrite(&header[0], sizeof(unsigned long long), header.size(), this->file);
+          seek(this->file, array_end);
+        }
+
+        return this->array_start - this->appended_start;
+      }
+
+      PVDCollection::PVDCollection(const char* filename) : filename(filename)
+      {
+      }
+
+      void PVDCollection::add_dataset(double time, const char* vtu_filename, int part)
+      {
+        DataSet dataset;
+        dataset.time = time;
+        dataset.part = part;
+        dataset.filename = vtu_filename;
+        this->datasets.push_back(dataset);
+
+        this->save();
+      }
+
+      void PVDCollection::save() const
+      {
+        FILE* f = fopen(this->filename.c_str(), "wb");
+        if (f == nullptr)
+          throw Hermes::Exceptions::Exception("Could not open %s for writing.", this->filename.c_str());
+
+        fprintf(f, "<?xml version=\"1.0\"?>\n");
+        fprintf(f, "<VTKFile type=\"Collection\" version=\"0.1\" byte_order=\"LittleEndian\">\n");
+        fprintf(f, "  <Collection>\n");
+        for (unsigned int i = 0; i < this->datasets.size(); i++)
+          fprintf(f, "    <DataSet timestep=\"%.15g\" group=\"\" part=\"%d\" file=\"%s\"/>\n", this->datasets[i].time, this->datasets[i].part, this->datasets[i].filename.c_str());
+        fprintf(f, "  </Collection>\n");
+        fprintf(f, "</VTKFile>\n");
+
+        fclose(f);
+      }
+    }
+  }
+}
@@ -59,6 +59,7 @@ namespace Hermes
       this->neq = neq;
       this->original_neq = neq;
       this->is_matfree = mat_free;
+      this->invalidate_integration_order_cache();
     }
 
     template<typename Scalar>
@@ -178,6 +179,9 @@ namespace Hermes
       }
       this->cloneMemberExtFunctions(other_wf->ext, this->ext);
       this->u_ext_fn = other_wf->u_ext_fn;
+
+      // The forms and external functions are the same, so are the cached integration orders.
+      this->integration_order_seq = other_wf->integration_order_seq;
     }
 
     template<typename Scalar>
@@ -216,19 +220,33 @@ namespace Hermes
       vfsurf.clear();
       vfDG.clear();
       forms.clear();
+      this->invalidate_integration_order_cache();
     };
 
+    /// Source of WeakForm::integration_order_seq, 0 is never assigned.
+    static unsigned int g_integration_order_seq = 0;
+
+    template<typename Scalar>
+    void WeakForm<Scalar>::invalidate_integration_order_cache()
+    {
+      // Weak forms are also cloned by the assembling threads.
+#pragma omp critical (IntegrationOrderSeq)
+      this->integration_order_seq = ++g_integration_order_seq;
+    }
+
     template<typename Scalar>
     void WeakForm<Scalar>::set_ext(MeshFunctionSharedPtr<Scalar> ext)
     {
       this->ext.clear();
       this->ext.push_back(ext);
+      this->invalidate_integration_order_cache();
     }
 
     template<typename Scalar>
     void WeakForm<Scalar>::set_ext(std::vector<MeshFunctionSharedPtr<Scalar> > ext)
     {
       this->ext = ext;
+      this->invalidate_integration_order_cache();
     }
 
     template<typename Scalar>
@@ -236,12 +254,14 @@ namespace Hermes
     {
       this->u_ext_fn.clear();
       this->u_ext_fn.push_back(ext);
+      this->invalidate_integration_order_cache();
     }
 
     template<typename Scalar>
     void WeakForm<Scalar>::set_u_ext_fn(std::vector<UExtFunctionSharedPtr<Scalar> > ext)
     {
       this->u_ext_fn = ext;
+      this->invalidate_integration_order_cache();
     }
 
     template<typename Scalar>
@@ -438,6 +458,13 @@ namespace Hermes
       return Hermes::Ord();
     }
 
+    template<typename Scalar>
+    bool MatrixFormVol<Scalar>::value_block(int n, double *wt, Func<Scalar> **u_ext, Func<double> **u, unsigned short u_count, Func<double> **v, unsigned short v_count,
+      GeomVol<double> *e, Func<Scalar> **ext, Scalar* result, unsigned short result_stride) const
+    {
+      return false;
+    }
+
     template<typename Scalar>
     MatrixFormVol<Scalar>* MatrixFormVol<Scalar>::clone() const
     {
@@ -655,6 +682,7 @@ namespace Hermes
       form->set_weakform(this);
       mfvol.push_back(form);
       forms.push_back(form);
+      this->invalidate_integration_order_cache();
     }
 
     template<typename Scalar>
@@ -666,6 +694,7 @@ namespace Hermes
       form->set_weakform(this);
       mfsurf.push_back(form);
       forms.push_back(form);
+      this->invalidate_integration_order_cache();
     }
 
     template<typename Scalar>
@@ -677,6 +706,7 @@ namespace Hermes
       form->set_weakform(this);
       mfDG.push_back(form);
       forms.push_back(form);
+      this->invalidate_integration_order_cache();
     }
 
     template<typename Scalar>
@@ -687,6 +717,7 @@ namespace Hermes
       form->set_weakform(this);
       vfvol.push_back(form);
       forms.push_back(form);
+      this->invalidate_integration_order_cache();
     }
 
     template<typename Scalar>
@@ -698,6 +729,7 @@ namespace Hermes
       form->set_weakform(this);
       vfsurf.push_back(form);
       forms.push_back(form);
+      this->invalidate_integration_order_cache();
     }
 
     template<typename Scalar>
@@ -709,6 +741,7 @@ namespace Hermes
       form->set_weakform(this);
       vfDG.push_back(form);
       forms.push_back(form);
+      this->invalidate_integration_order_cache();
     }
 
     template<typename Scalar>
@@ -15,6 +15,7 @@
 
 #include "weakform_library/weakforms_h1.h"
 #include "weakform_library/integrals_h1.h"
+#include <typeinfo>
 
 namespace Hermes
 {
@@ -22,6 +23,57 @@ namespace Hermes
   {
     namespace WeakFormsH1
     {
+      /// Dense kernel shared by the value_block() implementations of the symmetric forms below.
+      /// result[i * result_stride + j] = \sum_k w[k] * (u[j]->val[k] * v[i]->val[k]) for mass-type forms,
+      /// result[i * result_stride + j] = \sum_k w[k] * (u[j]->dx[k] * v[i]->dx[k] + u[j]->dy[k] * v[i]->dy[k]) for diffusion-type forms.
+      /// If u and v are the same set of functions, only the upper triangle is calculated and mirrored.
+      template<typename Scalar, bool gradients>
+      static void value_block_symmetric_kernel(int n, Scalar* w, Func<double> **u, unsigned short u_count, Func<double> **v, unsigned short v_count,
+        Scalar* result, unsigned short result_stride)
+      {
+        bool same_functions = (u == v) && (u_count == v_count);
+        Scalar w_v[H2D_MAX_INTEGRATION_POINTS_COUNT];
+        Scalar w_v_dy[H2D_MAX_INTEGRATION_POINTS_COUNT];
+
+        for (unsigned short i = 0; i < v_count; i++)
+        {
+          Scalar* result_row = result + i * result_stride;
+          if (gradients)
+          {
+            for (int k = 0; k < n; k++)
+            {
+              w_v[k] = w[k] * v[i]->dx[k];
+              w_v_dy[k] = w[k] * v[i]->dy[k];
+            }
+          }
+          else
+          {
+            for (int k = 0; k < n; k++)
+              w_v[k] = w[k] * v[i]->val[k];
+          }
+
+          for (unsigned short j = (same_functions ? i : 0); j < u_count; j++)
+          {
+            Scalar result_ij = 0;
+            if (gradients)
+            {
+              double* u_dx = u[j]->dx;
+              double* u_dy = u[j]->dy;
+              for (int k = 0; k < n; k++)
+                result_ij += w_v[k] * u_dx[k] + w_v_dy[k] * u_dy[k];
+            }
+            else
+            {
+              double* u_val = u[j]->val;
+              for (int k = 0; k < n; k++)
+                result_ij += w_v[k] * u_val[k];
+            }
+            result_row[j] = result_ij;
+            if (same_functions)
+              result[j * result_stride + i] = result_ij;
+          }
+        }
+      }
       template<>
       DefaultMatrixFormVol<double>::DefaultMatrixFormVol(int i, int j, std::string area, Hermes2DFunction<double>* coeff, SymFlag sym, GeomType gt)
         : MatrixFormVol<double>(i, j), coeff(coeff), gt(gt)
@@ -155,6 +207,45 @@ namespace Hermes
         return result;
       }
 
+      template<typename Scalar>
+      bool DefaultMatrixFormVol<Scalar>::value_block(int n, double *wt, Func<Scalar> *u_ext[], Func<double> **u, unsigned short u_count, Func<double> **v, unsigned short v_count,
+        GeomVol<double> *e, Func<Scalar> **ext, Scalar* result, unsigned short result_stride) const
+      {
+        // A subclass overriding value() has to be evaluated by it.
+        if (typeid(*this) != typeid(DefaultMatrixFormVol<Scalar>))
+          return false;
+
+        // Weights including the coefficient and the geometry type.
+        Scalar w[H2D_MAX_INTEGRATION_POINTS_COUNT];
+        if (gt == HERMES_PLANAR)
+        {
+          if (coeff->is_constant())
+          {
+            Scalar const_coeff = coeff->value(e->x[0], e->y[0]);
+            for (int i = 0; i < n; i++)
+              w[i] = wt[i] * const_coeff;
+          }
+          else
+          {
+            for (int i = 0; i < n; i++)
+              w[i] = wt[i] * coeff->value(e->x[i], e->y[i]);
+          }
+        }
+        else {
+          if (gt == HERMES_AXISYM_X) {
+            for (int i = 0; i < n; i++)
+              w[i] = wt[i] * e->y[i] * coeff->value(e->x[i], e->y[i]);
+          }
+          else {
+            for (int i = 0; i < n; i++)
+              w[i] = wt[i] * e->x[i] * coeff->value(e->x[i], e->y[i]);
+          }
+        }
+
+        value_block_symmetric_kernel<Scalar, false>(n, w, u, u_count, v, v_count, result, result_stride);
+        return true;
+      }
+
       template<typename Scalar>
       MatrixFormVol<Scalar>* DefaultMatrixFormVol<Scalar>::clone() const
       {
@@ -288,6 +379,65 @@ namespace Hermes
         return result;
       }
 
+      template<typename Scalar>
+      bool DefaultJacobianDiffusion<Scalar>::value_block(int n, double *wt, Func<Scalar> *u_ext[], Func<double> **u, unsigned short u_count, Func<double> **v, unsigned short v_count,
+        GeomVol<double> *e, Func<Scalar> **ext, Scalar* result, unsigned short result_stride) const
+      {
+        // A subclass overriding value() has to be evaluated by it.
+        if (typeid(*this) != typeid(DefaultJacobianDiffusion<Scalar>))
+          return false;
+
+        Func<Scalar>* u_prev = u_ext[this->previous_iteration_space_index];
+
+        // Point-wise coefficients: coeff'(u_prev) and coeff(u_prev), including weights and the geometry type.
+        Scalar w_der[H2D_MAX_INTEGRATION_POINTS_COUNT];
+        Scalar w_val[H2D_MAX_INTEGRATION_POINTS_COUNT];
+        for (int i = 0; i < n; i++)
+        {
+          double w = wt[i];
+          if (gt == HERMES_AXISYM_X)
+            w *= e->y[i];
+          else if (gt == HERMES_AXISYM_Y)
+            w *= e->x[i];
+
+          if (gt == HERMES_PLANAR && coeff->is_constant())
+          {
+            w_der[i] = w * coeff->derivative(u_prev->val[0]);
+            w_val[i] = w * coeff->value(u_prev->val[0]);
+          }
+          else
+          {
+            w_der[i] = w * coeff->derivative(u_prev->val[i]);
+            w_val[i] = w * coeff->value(u_prev->val[i]);
+          }
+        }
+
+        // Test-function dependent parts, so that the inner loop over basis functions is a plain dot product.
+        Scalar test_val[H2D_MAX_INTEGRATION_POINTS_COUNT];
+        Scalar test_dx[H2D_MAX_INTEGRATION_POINTS_COUNT];
+        Scalar test_dy[H2D_MAX_INTEGRATION_POINTS_COUNT];
+        for (unsigned short i = 0; i < v_count; i++)
+        {
+          for (int k = 0; k < n; k++)
+          {
+            test_val[k] = w_der[k] * (u_prev->dx[k] * v[i]->dx[k] + u_prev->dy[k] * v[i]->dy[k]);
+            test_dx[k] = w_val[k] * v[i]->dx[k];
+            test_dy[k] = w_val[k] * v[i]->dy[k];
+          }
+
+          Scalar* result_row = result + i * result_stride;
+          for (unsigned short j = 0; j < u_count; j++)
+          {
+            Scalar result_ij = 0;
+            for (int k = 0; k < n; k++)
+              result_ij += test_val[k] * u[j]->val[k] + test_dx[k] * u[j]->dx[k] + test_dy[k] * u[j]->dy[k];
+            result_row[j] = result_ij;
+          }
+        }
+
+        return true;
+      }
+
       template<typename Scalar>
       MatrixFormVol<Scalar>* DefaultJacobianDiffusion<Scalar>::clone() const
       {
@@ -386,6 +536,36 @@ namespace Hermes
         return result;
       }
 
+      template<typename Scalar>
+      bool DefaultMatrixFormDiffusion<Scalar>::value_block(int n, double *wt, Func<Scalar> *u_ext[], Func<double> **u, unsigned short u_count, Func<double> **v, unsigned short v_count,
+        GeomVol<double> *e, Func<Scalar> **ext, Scalar* result, unsigned short result_stride) const
+      {
+        // A subclass overriding value() has to be evaluated by it.
+        if (typeid(*this) != typeid(DefaultMatrixFormDiffusion<Scalar>))
+          return false;
+
+        // Weights including the coefficient and the geometry type.
+        Scalar const_coeff = this->coeff->value(0.);
+        Scalar w[H2D_MAX_INTEGRATION_POINTS_COUNT];
+        if (gt == HERMES_PLANAR) {
+          for (int i = 0; i < n; i++)
+            w[i] = wt[i] * const_coeff;
+        }
+        else {
+          if (gt == HERMES_AXISYM_X) {
+            for (int i = 0; i < n; i++)
+              w[i] = wt[i] * e->y[i] * const_coeff;
+          }
+          else {
+            for (int i = 0; i < n; i++)
+              w[i] = wt[i] * e->x[i] * const_coeff;
+          }
+        }
+
+        value_block_symmetric_kernel<Scalar, true>(n, w, u, u_count, v, v_count, result, result_stride);
+        return true;
+      }
+
       template<typename Scalar>
       MatrixFormVol<Scalar>* DefaultMatrixFormDiffusion<Scalar>::clone() const
       {
@@ -485,6 +665,52 @@ namespace Hermes
         return result;
       }
 
+      template<typename Scalar>
+      bool DefaultJacobianAdvection<Scalar>::value_block(int n, double *wt, Func<Scalar> *u_ext[], Func<double> **u, unsigned short u_count, Func<double> **v, unsigned short v_count,
+        GeomVol<double> *e, Func<Scalar> **ext, Scalar* result, unsigned short result_stride) const
+      {
+        // A subclass overriding value() has to be evaluated by it.
+        if (typeid(*this) != typeid(DefaultJacobianAdvection<Scalar>))
+          return false;
+
+        Func<Scalar>* u_prev = u_ext[this->previous_iteration_space_index];
+
+        // Point-wise coefficients of u, u->dx, u->dy, including weights.
+        Scalar w_val[H2D_MAX_INTEGRATION_POINTS_COUNT];
+        Scalar w_dx[H2D_MAX_INTEGRATION_POINTS_COUNT];
+        Scalar w_dy[H2D_MAX_INTEGRATION_POINTS_COUNT];
+        for (int i = 0; i < n; i++)
+        {
+          w_val[i] = wt[i] * (coeff1->derivative(u_prev->val[i]) * u_prev->dx[i] + coeff2->derivative(u_prev->val[i]) * u_prev->dy[i]);
+          w_dx[i] = wt[i] * coeff1->value(u_prev->val[i]);
+          w_dy[i] = wt[i] * coeff2->value(u_prev->val[i]);
+        }
+
+        Scalar test_val[H2D_MAX_INTEGRATION_POINTS_COUNT];
+        Scalar test_dx[H2D_MAX_INTEGRATION_POINTS_COUNT];
+        Scalar test_dy[H2D_MAX_INTEGRATION_POINTS_COUNT];
+        for (unsigned short i = 0; i < v_count; i++)
+        {
+          for (int k = 0; k < n; k++)
+          {
+            test_val[k] = w_val[k] * v[i]->val[k];
+            test_dx[k] = w_dx[k] * v[i]->val[k];
+            test_dy[k] = w_dy[k] * v[i]->val[k];
+          }
+
+          Scalar* result_row = result + i * result_stride;
+          for (unsigned short j = 0; j < u_count; j++)
+          {
+            Scalar result_ij = 0;
+            for (int k = 0; k < n; k++)
+              result_ij += test_val[k] * u[j]->val[k] + test_dx[k] * u[j]->dx[k] + test_dy[k] * u[j]->dy[k];
+            result_row[j] = result_ij;
+          }
+        }
+
+        return true;
+      }
+
       // This is to make the form usable in rk_time_step_newton().
       template<typename Scalar>
       MatrixFormVol<Scalar>* DefaultJacobianAdvection<Scalar>::clone() const
@@ -0,0 +1,191 @@
+#include "hermes2d.h"
+
+using namespace Hermes;
+using namespace Hermes::Hermes2D;
+using namespace Hermes::Hermes2D::WeakFormsH1;
+
+// This test assembles the matrix of the form 2 * (u, v) + 3 * (grad u, grad v) three times:
+// - by plain MatrixFormVol subclasses, which are always evaluated for each (basis, test) function pair,
+// - by subclasses of DefaultMatrixFormVol and DefaultMatrixFormDiffusion that override value() (as
+//   CustomMatrixFormVol of the example 00-quickShow does), and inherit value_block(),
+// - by DefaultMatrixFormVol and DefaultMatrixFormDiffusion with the coefficients, evaluated by value_block().
+//
+// All three matrices have to be the same - in particular, the overridden value() must not be bypassed by the
+// inherited value_block().
+
+// Polynomial degree.
+const int P_INIT = 3;
+// Number of initial uniform mesh refinements.
+const int INIT_REF_NUM = 3;
+// Tolerance of the comparison of the matrices (relative to the largest entry).
+const double TOLERANCE = 1e-12;
+
+const double MASS_COEFF = 2.;
+const double DIFFUSION_COEFF = 3.;
+
+// Plain forms.
+class ReferenceMassForm : public MatrixFormVol<double>
+{
+public:
+  ReferenceMassForm() : MatrixFormVol<double>(0, 0) {}
+
+  double value(int n, double *wt, Func<double> *u_ext[], Func<double> *u, Func<double> *v, GeomVol<double> *e, Func<double> **ext) const
+  {
+    double result = 0.;
+    for (int i = 0; i < n; i++)
+      result += wt[i] * u->val[i] * v->val[i];
+    return MASS_COEFF * result;
+  }
+
+  Ord ord(int n, double *wt, Func<Ord> *u_ext[], Func<Ord> *u, Func<Ord> *v, GeomVol<Ord> *e, Func<Ord> **ext) const
+  {
+    return u->val[0] * v->val[0];
+  }
+
+  MatrixFormVol<double>* clone() const
+  {
+    return new ReferenceMassForm();
+  }
+};
+
+class ReferenceDiffusionForm : public MatrixFormVol<double>
+{
+public:
+  ReferenceDiffusionForm() : MatrixFormVol<double>(0, 0) {}
+
+  double value(int n, double *wt, Func<double> *u_ext[], Func<double> *u, Func<double> *v, GeomVol<double> *e, Func<double> **ext) const
+  {
+    double result = 0.;
+    for (int i = 0; i < n; i++)
+      result += wt[i] * (u->dx[i] * v->dx[i] + u->dy[i] * v->dy[i]);
+    return DIFFUSION_COEFF * result;
+  }
+
+  Ord ord(int n, double *wt, Func<Ord> *u_ext[], Func<Ord> *u, Func<Ord> *v, GeomVol<Ord> *e, Func<Ord> **ext) const
+  {
+    return u->dx[0] * v->dx[0] + u->dy[0] * v->dy[0];
+  }
+
+  MatrixFormVol<double>* clone() const
+  {
+    return new ReferenceDiffusionForm();
+  }
+};
+
+// Subclasses of the default forms overriding value().
+class ScaledMassForm : public DefaultMatrixFormVol<double>
+{
+public:
+  ScaledMassForm() : DefaultMatrixFormVol<double>(0, 0) {}
+
+  double value(int n, double *wt, Func<double> *u_ext[], Func<double> *u, Func<double> *v, GeomVol<double> *e, Func<double> **ext) const
+  {
+    return MASS_COEFF * DefaultMatrixFormVol<double>::value(n, wt, u_ext, u, v, e, ext);
+  }
+
+  MatrixFormVol<double>* clone() const
+  {
+    return new ScaledMassForm();
+  }
+};
+
+class ScaledDiffusionForm : public DefaultMatrixFormDiffusion<double>
+{
+public:
+  ScaledDiffusionForm() : DefaultMatrixFormDiffusion<double>(0, 0) {}
+
+  double value(int n, double *wt, Func<double> *u_ext[], Func<double> *u, Func<double> *v, GeomVol<double> *e, Func<double> **ext) const
+  {
+    return DIFFUSION_COEFF * DefaultMatrixFormDiffusion<double>::value(n, wt, u_ext, u, v, e, ext);
+  }
+
+  MatrixFormVol<double>* clone() const
+  {
+    return new ScaledDiffusionForm();
+  }
+};
+
+class ReferenceWeakForm : public WeakForm<double>
+{
+public:
+  ReferenceWeakForm() : WeakForm<double>(1)
+  {
+    add_matrix_form(new ReferenceMassForm());
+    add_matrix_form(new ReferenceDiffusionForm());
+  }
+};
+
+class ScaledWeakForm : public WeakForm<double>
+{
+public:
+  ScaledWeakForm() : WeakForm<double>(1)
+  {
+    add_matrix_form(new ScaledMassForm());
+    add_matrix_form(new ScaledDiffusionForm());
+  }
+};
+
+class DefaultWeakForm : public WeakForm<double>
+{
+public:
+  DefaultWeakForm() : WeakForm<double>(1)
+  {
+    add_matrix_form(new DefaultMatrixFormVol<double>(0, 0, HERMES_ANY, new Hermes2DFunction<double>(MASS_COEFF)));
+    add_matrix_form(new DefaultMatrixFormDiffusion<double>(0, 0, HERMES_ANY, new Hermes1DFunction<double>(DIFFUSION_COEFF)));
+  }
+};
+
+// Largest difference of the entries relative to the largest entry of 'reference'.
+double relative_difference(CSCMatrix<double>* reference, CSCMatrix<double>* matrix, int ndof)
+{
+  double max_reference = 0., max_difference = 0.;
+  for (int i = 0; i < ndof; i++)
+  {
+    for (int j = 0; j < ndof; j++)
+    {
+      max_reference = std::max(max_reference, std::abs(reference->get(i, j)));
+      max_difference = std::max(max_difference, std::abs(reference->get(i, j) - matrix->get(i, j)));
+    }
+  }
+  return max_difference / max_reference;
+}
+
+int main(int argc, char* argv[])
+{
+  // Load and refine the mesh.
+  MeshSharedPtr mesh(new Mesh);
+  MeshReaderH2D mloader;
+  mloader.load("square.mesh", mesh);
+  for (int i = 0; i < INIT_REF_NUM; i++)
+    mesh->refine_all_elements();
+
+  SpaceSharedPtr<double> space(new H1Space<double>(mesh, P_INIT));
+  int ndof = space->get_num_dofs();
+
+  WeakFormSharedPtr<double> reference_wf(new ReferenceWeakForm);
+  WeakFormSharedPtr<double> scaled_wf(new ScaledWeakForm);
+  WeakFormSharedPtr<double> default_wf(new DefaultWeakForm);
+
+  CSCMatrix<double> reference_matrix, scaled_matrix, default_matrix;
+  DiscreteProblem<double> reference_dp(reference_wf, space, true);
+  reference_dp.assemble(&reference_matrix);
+  DiscreteProblem<double> scaled_dp(scaled_wf, space, true);
+  scaled_dp.assemble(&scaled_matrix);
+  DiscreteProblem<double> default_dp(default_wf, space, true);
+  default_dp.assemble(&default_matrix);
+
+  double scaled_difference = relative_difference(&reference_matrix, &scaled_matrix, ndof);
+  double default_difference = relative_difference(&reference_matrix, &default_matrix, ndof);
+  printf("Relative difference from the per-pair assembly: subclasses overriding value(): %g, default forms: %g.\n", scaled_difference, default_difference);
+
+  if (scaled_difference < TOLERANCE && default_difference < TOLERANCE)
+  {
+    printf("Success!\n");
+    return 0;
+  }
+  else
+  {
+    printf("Failure!\n");
+    return -1;
+  }
+}
@@ -0,0 +1,135 @@
+#include "hermes2d.h"
+
+using namespace Hermes;
+using namespace Hermes::Hermes2D;
+
+// This test projects two functions onto the same H1 space by OGProjection without the factorization caching, with it
+// (one function after another), and by the multiple-source projection.
+//
+// The results have to be the same, the second and the multiple-source projections have to reuse the cached factorization.
+
+// Polynomial degree.
+const int P_INIT = 3;
+// Number of initial uniform mesh refinements.
+const int INIT_REF_NUM = 3;
+// Tolerance of the comparison of the coefficient vectors (relative to the largest coefficient).
+const double TOLERANCE = 1e-10;
+
+class WaveFunction : public ExactSolutionScalar<double>
+{
+public:
+  WaveFunction(MeshSharedPtr mesh, double k) : ExactSolutionScalar<double>(mesh), k(k) {}
+
+  double value(double x, double y) const
+  {
+    return std::sin(k * x) * std::cos(k * y);
+  }
+
+  void derivatives(double x, double y, double& dx, double& dy) const
+  {
+    dx = k * std::cos(k * x) * std::cos(k * y);
+    dy = -k * std::sin(k * x) * std::sin(k * y);
+  }
+
+  Ord ord(double x, double y) const
+  {
+    return Ord(10);
+  }
+
+  MeshFunction<double>* clone() const
+  {
+    return new WaveFunction(this->mesh, this->k);
+  }
+
+private:
+  double k;
+};
+
+// Largest difference of the coefficients relative to the largest coefficient of 'reference'.
+double relative_difference(double* reference, double* coeff_vec, int ndof)
+{
+  double max_reference = 0., max_difference = 0.;
+  for (int i = 0; i < ndof; i++)
+  {
+    max_reference = std::max(max_reference, std::abs(reference[i]));
+    max_difference = std::max(max_difference, std::abs(reference[i] - coeff_vec[i]));
+  }
+  return max_difference / max_reference;
+}
+
+int main(int argc, char* argv[])
+{
+  // Load and refine the mesh.
+  MeshSharedPtr mesh(new Mesh);
+  MeshReaderH2D mloader;
+  mloader.load("square.mesh", mesh);
+  for (int i = 0; i < INIT_REF_NUM; i++)
+    mesh->refine_all_elements();
+
+  // The Dirichlet lift has to be assembled also with the cached factorization.
+  DefaultEssentialBCConst<double> bc("Bdy", 0.5);
+  EssentialBCs<double> bcs(&bc);
+  SpaceSharedPtr<double> space(new H1Space<double>(mesh, &bcs, P_INIT));
+  int ndof = space->get_num_dofs();
+
+  std::vector<MeshFunctionSharedPtr<double> > sources({ MeshFunctionSharedPtr<double>(new WaveFunction(mesh, 0.1)), MeshFunctionSharedPtr<double>(new WaveFunction(mesh, 0.3)) });
+  std::vector<double*> reference_vecs, cached_vecs, multiple_vecs;
+  for (unsigned int i = 0; i < sources.size(); i++)
+  {
+    reference_vecs.push_back(new double[ndof]);
+    cached_vecs.push_back(new double[ndof]);
+    multiple_vecs.push_back(new double[ndof]);
+  }
+
+  bool success = true;
+
+  // Without caching.
+  OGProjection<double>::set_factorization_caching(false);
+  for (unsigned int i = 0; i < sources.size(); i++)
+    OGProjection<double>::project_global(space, sources[i], reference_vecs[i], HERMES_H1_NORM);
+
+  // With caching, one function after another - the first projection factorizes the matrix, the second one reuses it.
+  OGProjection<double>::set_factorization_caching(true);
+  unsigned int hits = OGProjection<double>::get_factorization_cache_hits();
+  for (unsigned int i = 0; i < sources.size(); i++)
+    OGProjection<double>::project_global(space, sources[i], cached_vecs[i], HERMES_H1_NORM);
+  if (OGProjection<double>::get_factorization_cache_hits() != hits + 1)
+  {
+    printf("The second projection did not reuse the cached factorization.\n");
+    success = false;
+  }
+
+  // Both functions at once, reusing the cached factorization again.
+  hits = OGProjection<double>::get_factorization_cache_hits();
+  OGProjection<double>::project_global(space, sources, multiple_vecs, HERMES_H1_NORM);
+  if (OGProjection<double>::get_factorization_cache_hits() != hits + 1)
+  {
+    printf("The multiple-source projection did not reuse the cached factorization.\n");
+    success = false;
+  }
+  OGProjection<double>::set_factorization_caching(false);
+
+  for (unsigned int i = 0; i < sources.size(); i++)
+  {
+    double cached_difference = relative_difference(reference_vecs[i], cached_vecs[i], ndof);
+    double multiple_difference = relative_difference(reference_vecs[i], multiple_vecs[i], ndof);
+    printf("Function %i, relative difference from the uncached projection: cached: %g, multiple-source: %g.\n", i, cached_difference, multiple_difference);
+    if (cached_difference > TOLERANCE || multiple_difference > TOLERANCE)
+      success = false;
+
+    delete[] reference_vecs[i];
+    delete[] cached_vecs[i];
+    delete[] multiple_vecs[i];
+  }
+
+  if (success)
+  {
+    printf("Success!\n");
+    return 0;
+  }
+  else
+  {
+    printf("Failure!\n");
+    return -1;
+  }
+}
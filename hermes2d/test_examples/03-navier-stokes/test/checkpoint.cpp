@@ -0,0 +1,194 @@
+#include "hermes2d.h"
+
+using namespace Hermes;
+using namespace Hermes::Hermes2D;
+using namespace Hermes::Hermes2D::WeakFormsH1;
+
+// This test saves a refined mesh with curved elements (the obstacle of the example 03-navier-stokes), a system
+// of two spaces renumbered jointly by the reverse Cuthill-McKee ordering (Space::set_dof_renumbering()) and the
+// solution of a coupled problem on them by Checkpoint, and loads it back.
+//
+// The loaded mesh has to have the same (curved) elements, the loaded spaces the same DOF map - the assembly list
+// of every active element - and the loaded solutions the same values at sample points as the original ones.
+
+// Polynomial degrees of the two spaces.
+const int P_INIT_U = 3;
+const int P_INIT_V = 2;
+// Tolerance of the comparison of the solutions.
+const double TOLERANCE = 1e-12;
+
+// Boundary markers.
+const std::string BDY_LEFT = "4";
+const std::string BDY_OBSTACLE = "5";
+
+// Two reaction-diffusion equations coupled by the reaction terms:
+// -\Delta u + u - v / 2 = 1,
+// -\Delta v + v - u / 2 = 2.
+class CoupledWeakForm : public WeakForm<double>
+{
+public:
+  CoupledWeakForm() : WeakForm<double>(2)
+  {
+    for (int i = 0; i < 2; i++)
+    {
+      add_matrix_form(new DefaultMatrixFormDiffusion<double>(i, i));
+      add_matrix_form(new DefaultMatrixFormVol<double>(i, i));
+      add_matrix_form(new DefaultMatrixFormVol<double>(i, 1 - i, HERMES_ANY, new Hermes2DFunction<double>(-0.5)));
+      add_vector_form(new DefaultVectorFormVol<double>(i, HERMES_ANY, new Hermes2DFunction<double>(i + 1.)));
+    }
+  }
+};
+
+// Compares the elements of the meshes and the assembly lists of the spaces on them.
+bool compare(MeshSharedPtr mesh, std::vector<SpaceSharedPtr<double> > spaces, MeshSharedPtr loaded_mesh, std::vector<SpaceSharedPtr<double> > loaded_spaces)
+{
+  if (mesh->get_max_element_id() != loaded_mesh->get_max_element_id() || mesh->get_num_active_elements() != loaded_mesh->get_num_active_elements())
+  {
+    printf("Mesh: %i elements (%i active), loaded: %i (%i active).\n", mesh->get_max_element_id(), mesh->get_num_active_elements(),
+      loaded_mesh->get_max_element_id(), loaded_mesh->get_num_active_elements());
+    return false;
+  }
+
+  if (Space<double>::get_num_dofs(spaces) != Space<double>::get_num_dofs(loaded_spaces))
+  {
+    printf("DOFs: %i, loaded: %i.\n", Space<double>::get_num_dofs(spaces), Space<double>::get_num_dofs(loaded_spaces));
+    return false;
+  }
+
+  int curved_count = 0;
+  AsmList<double> al, loaded_al;
+  for (int id = 0; id < mesh->get_max_element_id(); id++)
+  {
+    Element* e = mesh->get_element_fast(id);
+    Element* loaded_e = loaded_mesh->get_element_fast(id);
+    if (e->used != loaded_e->used || e->active != loaded_e->active || e->is_curved() != loaded_e->is_curved())
+    {
+      printf("Element %i differs from the loaded one.\n", id);
+      return false;
+    }
+    if (!e->used || !e->active)
+      continue;
+    if (e->is_curved())
+      curved_count++;
+
+    for (unsigned int space_i = 0; space_i < spaces.size(); space_i++)
+    {
+      spaces[space_i]->get_element_assembly_list(e, &al);
+      loaded_spaces[space_i]->get_element_assembly_list(loaded_e, &loaded_al);
+      bool same = al.cnt == loaded_al.cnt;
+      for (unsigned int i = 0; i < al.cnt && same; i++)
+        same = al.idx[i] == loaded_al.idx[i] && al.dof[i] == loaded_al.dof[i] && al.coef[i] == loaded_al.coef[i];
+      if (!same)
+      {
+        printf("Assembly list of the space %i on the element %i differs from the loaded one.\n", space_i, id);
+        return false;
+      }
+    }
+  }
+
+  if (curved_count == 0)
+  {
+    printf("No curved active elements.\n");
+    return false;
+  }
+
+  return true;
+}
+
+int main(int argc, char* argv[])
+{
+  // Load and refine the mesh, the refinements towards the obstacle are curved.
+  MeshSharedPtr mesh(new Mesh);
+  MeshReaderH2D mloader;
+  mloader.load("domain.mesh", mesh);
+  mesh->refine_towards_boundary(BDY_OBSTACLE, 2, false);
+  mesh->refine_all_elements();
+
+  // Spaces renumbered jointly.
+  DefaultEssentialBCConst<double> bc_u(BDY_OBSTACLE, 0.0);
+  EssentialBCs<double> bcs_u(&bc_u);
+  DefaultEssentialBCConst<double> bc_v(BDY_LEFT, 0.0);
+  EssentialBCs<double> bcs_v(&bc_v);
+  SpaceSharedPtr<double> u_space(new H1Space<double>(mesh, &bcs_u, P_INIT_U));
+  SpaceSharedPtr<double> v_space(new H1Space<double>(mesh, &bcs_v, P_INIT_V));
+  std::vector<SpaceSharedPtr<double> > spaces({ u_space, v_space });
+  for (unsigned int space_i = 0; space_i < spaces.size(); space_i++)
+    spaces[space_i]->set_dof_renumbering(HERMES_DOF_RENUMBERING_RCM);
+
+  // Solve.
+  WeakFormSharedPtr<double> wf(new CoupledWeakForm);
+  LinearSolver<double> linear_solver(wf, spaces);
+  linear_solver.set_verbose_output(false);
+  linear_solver.solve();
+  MeshFunctionSharedPtr<double> u_sln(new Solution<double>), v_sln(new Solution<double>);
+  std::vector<MeshFunctionSharedPtr<double> > slns({ u_sln, v_sln });
+  Solution<double>::vector_to_solutions(linear_solver.get_sln_vector(), spaces, slns);
+
+  bool success = true;
+
+  // The system has to be numbered jointly - the DOFs of the first space are not one block before the second one.
+  int max_u_dof = -1;
+  AsmList<double> al;
+  Element* e;
+  for_all_active_elements(e, mesh)
+  {
+    u_space->get_element_assembly_list(e, &al);
+    for (unsigned int i = 0; i < al.cnt; i++)
+      max_u_dof = std::max(max_u_dof, al.dof[i]);
+  }
+  if (max_u_dof < u_space->get_num_dofs())
+  {
+    printf("The spaces were not renumbered jointly.\n");
+    success = false;
+  }
+
+  // Save, load.
+  Checkpoint<double>::save("checkpoint.h2dc", mesh, spaces, slns);
+
+  // The checkpoint and the loaded solutions keep the file mapped, they are released before it is removed.
+  {
+    Checkpoint<double> checkpoint("checkpoint.h2dc");
+    MeshSharedPtr loaded_mesh(new Mesh);
+    checkpoint.load_mesh(loaded_mesh);
+    std::vector<SpaceSharedPtr<double> > loaded_spaces = checkpoint.load_spaces(loaded_mesh, { &bcs_u, &bcs_v });
+    std::vector<MeshFunctionSharedPtr<double> > loaded_slns;
+    for (unsigned int sln_i = 0; sln_i < slns.size(); sln_i++)
+    {
+      loaded_slns.push_back(MeshFunctionSharedPtr<double>(new Solution<double>));
+      checkpoint.load_solution(sln_i, loaded_spaces[sln_i], loaded_slns[sln_i]);
+    }
+
+    if (!compare(mesh, spaces, loaded_mesh, loaded_spaces))
+      success = false;
+
+    // Sample points - at the obstacle (curved elements) and in the rest of the channel.
+    double points[6][2] = { { 2.5, 3.65 }, { 1.45, 2.6 }, { 3.55, 2.6 }, { 2.5, 1.55 }, { 8., 4. }, { 12., 1. } };
+    for (int point_i = 0; point_i < 6; point_i++)
+    {
+      for (unsigned int sln_i = 0; sln_i < slns.size(); sln_i++)
+      {
+        Func<double>* value = slns[sln_i]->get_pt_value(points[point_i][0], points[point_i][1]);
+        Func<double>* loaded_value = loaded_slns[sln_i]->get_pt_value(points[point_i][0], points[point_i][1]);
+        if (std::abs(value->val[0] - loaded_value->val[0]) > TOLERANCE)
+        {
+          printf("Solution %i at [%g, %g]: %g, loaded: %g.\n", sln_i, points[point_i][0], points[point_i][1], value->val[0], loaded_value->val[0]);
+          success = false;
+        }
+        delete value;
+        delete loaded_value;
+      }
+    }
+  }
+  remove("checkpoint.h2dc");
+
+  if (success)
+  {
+    printf("Success!\n");
+    return 0;
+  }
+  else
+  {
+    printf("Failure!\n");
+    return -1;
+  }
+}
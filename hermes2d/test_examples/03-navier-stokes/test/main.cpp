@@ -0,0 +1,189 @@
+#include "hermes2d.h"
+
+using namespace Hermes;
+using namespace Hermes::Hermes2D;
+
+// This test solves the first time steps of the example 03-navier-stokes three times - with the DOFs
+// of the velocity and pressure spaces numbered one after another, and with the whole system renumbered
+// jointly by the reverse Cuthill-McKee and the nested dissection orderings (Space::set_dof_renumbering()).
+//
+// The initial coefficient vector comes from OGProjection of all spaces and the results are obtained by
+// Solution::vector_to_solutions(), so the renumbering has to be transparent to both. The solutions are
+// compared at sample points, and the bandwidth of the system (the largest difference of two DOFs coupled
+// by an element) has to be reduced by the RCM ordering.
+
+// Initial polynomial degree for velocity components.
+const int P_INIT_VEL = 2;
+// Initial polynomial degree for pressure.
+const int P_INIT_PRESSURE = 1;
+// Reynolds number.
+const double RE = 200.0;
+// Inlet velocity (reached after STARTUP_TIME).
+const double VEL_INLET = 1.0;
+// Current time (used in weak forms).
+double current_time = 0;
+// During this time, inlet velocity increases gradually
+// from 0 to VEL_INLET, then it stays constant.
+const double STARTUP_TIME = 1.0;
+// Time step.
+const double TAU = 0.1;
+// Number of time steps.
+const int NUM_TIME_STEPS = 4;
+// Domain height (necessary to define the parabolic velocity profile at inlet).
+const double H = 5;
+// Tolerance of the comparison of the solutions.
+const double TOLERANCE = 1e-6;
+
+// Boundary markers.
+const std::string BDY_BOTTOM = "1";
+const std::string BDY_RIGHT = "2";
+const std::string BDY_TOP = "3";
+const std::string BDY_LEFT = "4";
+const std::string BDY_OBSTACLE = "5";
+
+// Weak forms.
+#include "../definitions.cpp"
+
+// The largest difference of two DOFs coupled by an element.
+int get_bandwidth(MeshSharedPtr mesh, std::vector<SpaceSharedPtr<double> > spaces)
+{
+  int bandwidth = 0;
+  AsmList<double> al;
+  Element* e;
+  for_all_active_elements(e, mesh)
+  {
+    int min_dof = std::numeric_limits<int>::max(), max_dof = -1;
+    for (unsigned int space_i = 0; space_i < spaces.size(); space_i++)
+    {
+      spaces[space_i]->get_element_assembly_list(e, &al);
+      for (unsigned int i = 0; i < al.cnt; i++)
+      {
+        if (al.dof[i] >= 0)
+        {
+          min_dof = std::min(min_dof, al.dof[i]);
+          max_dof = std::max(max_dof, al.dof[i]);
+        }
+      }
+    }
+    if (max_dof >= 0)
+      bandwidth = std::max(bandwidth, max_dof - min_dof);
+  }
+  return bandwidth;
+}
+
+// Solves NUM_TIME_STEPS time steps with the spaces renumbered by 'dof_renumbering', returns the solutions
+// of the last step and the bandwidth of the system.
+int solve(MeshSharedPtr mesh, DofRenumberingType dof_renumbering, std::vector<MeshFunctionSharedPtr<double> >& slns)
+{
+  current_time = 0;
+
+  // Initialize boundary conditions.
+  EssentialBCNonConst bc_left_vel_x(BDY_LEFT, VEL_INLET, H, STARTUP_TIME);
+  DefaultEssentialBCConst<double> bc_other_vel_x({ BDY_BOTTOM, BDY_TOP, BDY_OBSTACLE }, 0.0);
+  EssentialBCs<double> bcs_vel_x({ &bc_left_vel_x, &bc_other_vel_x });
+  DefaultEssentialBCConst<double> bc_vel_y({ BDY_LEFT, BDY_BOTTOM, BDY_TOP, BDY_OBSTACLE }, 0.0);
+  EssentialBCs<double> bcs_vel_y(&bc_vel_y);
+
+  // Spaces for velocity components and pressure.
+  SpaceSharedPtr<double> xvel_space(new H1Space<double>(mesh, &bcs_vel_x, P_INIT_VEL));
+  SpaceSharedPtr<double> yvel_space(new H1Space<double>(mesh, &bcs_vel_y, P_INIT_VEL));
+  SpaceSharedPtr<double> p_space(new L2Space<double>(mesh, P_INIT_PRESSURE));
+  std::vector<SpaceSharedPtr<double> > spaces({ xvel_space, yvel_space, p_space });
+  for (unsigned int space_i = 0; space_i < spaces.size(); space_i++)
+    spaces[space_i]->set_dof_renumbering(dof_renumbering);
+
+  // Solutions for the Newton's iteration and time stepping.
+  MeshFunctionSharedPtr<double> xvel_prev_time(new ConstantSolution<double>(mesh, 0.0));
+  MeshFunctionSharedPtr<double> yvel_prev_time(new ConstantSolution<double>(mesh, 0.0));
+  MeshFunctionSharedPtr<double> p_prev_time(new ConstantSolution<double>(mesh, 0.0));
+  slns = { xvel_prev_time, yvel_prev_time, p_prev_time };
+
+  // Project the initial condition on the FE space to obtain initial coefficient vector for the Newton's method.
+  double* coeff_vec = new double[Space<double>::get_num_dofs(spaces)];
+  OGProjection<double>::project_global(spaces, slns, coeff_vec, { HERMES_H1_NORM, HERMES_H1_NORM, HERMES_L2_NORM });
+
+  // Initialize weak formulation.
+  WeakFormSharedPtr<double> wf(new WeakFormNSNewton(false, RE, TAU, xvel_prev_time, yvel_prev_time));
+  UExtFunctionSharedPtr<double> fn_0(new CustomUExtFunction(0));
+  UExtFunctionSharedPtr<double> fn_1(new CustomUExtFunction(1));
+  wf->set_ext({ xvel_prev_time, yvel_prev_time });
+  wf->set_u_ext_fn({ fn_0, fn_1 });
+
+  // Initialize the Newton solver.
+  NewtonSolver<double> newton(wf, spaces);
+  newton.set_verbose_output(false);
+  newton.set_max_allowed_iterations(10);
+  newton.set_manual_damping_coeff(true, 1.0);
+  newton.set_tolerance(1e-3, Hermes::Solvers::ResidualNormAbsolute);
+
+  // Time-stepping loop.
+  for (int time_step = 1; time_step <= NUM_TIME_STEPS; time_step++, current_time += TAU)
+  {
+    newton.set_time(current_time);
+    newton.solve(coeff_vec);
+    memcpy(coeff_vec, newton.get_sln_vector(), Space<double>::get_num_dofs(spaces) * sizeof(double));
+    Solution<double>::vector_to_solutions(newton.get_sln_vector(), spaces, slns);
+  }
+
+  delete[] coeff_vec;
+
+  // The spaces as assigned by the solver.
+  return get_bandwidth(mesh, spaces);
+}
+
+int main(int argc, char* argv[])
+{
+  // Load the mesh.
+  MeshSharedPtr mesh(new Mesh);
+  MeshReaderH2D mloader;
+  mloader.load("domain.mesh", mesh);
+
+  // Initial mesh refinements.
+  mesh->refine_towards_boundary(BDY_OBSTACLE, 2, false);
+  mesh->refine_towards_boundary(BDY_TOP, 2, true);
+  mesh->refine_towards_boundary(BDY_BOTTOM, 2, true);
+  mesh->refine_all_elements();
+
+  std::vector<MeshFunctionSharedPtr<double> > slns, slns_rcm, slns_nd;
+  int bandwidth = solve(mesh, HERMES_DOF_RENUMBERING_NONE, slns);
+  int bandwidth_rcm = solve(mesh, HERMES_DOF_RENUMBERING_RCM, slns_rcm);
+  solve(mesh, HERMES_DOF_RENUMBERING_NESTED_DISSECTION, slns_nd);
+
+  bool success = true;
+
+  printf("Bandwidth: %i, RCM: %i.\n", bandwidth, bandwidth_rcm);
+  if (2 * bandwidth_rcm > bandwidth)
+    success = false;
+
+  // Sample points - in the channel, away from the obstacle.
+  double points[7][2] = { { 1., 1. }, { 1., 4. }, { 4., 0.5 }, { 6., 2.5 }, { 8., 4. }, { 12., 1. }, { 14., 3. } };
+  for (int point_i = 0; point_i < 7; point_i++)
+  {
+    for (unsigned int sln_i = 0; sln_i < slns.size(); sln_i++)
+    {
+      Func<double>* value = slns[sln_i]->get_pt_value(points[point_i][0], points[point_i][1]);
+      Func<double>* value_rcm = slns_rcm[sln_i]->get_pt_value(points[point_i][0], points[point_i][1]);
+      Func<double>* value_nd = slns_nd[sln_i]->get_pt_value(points[point_i][0], points[point_i][1]);
+      if (std::abs(value->val[0] - value_rcm->val[0]) > TOLERANCE || std::abs(value->val[0] - value_nd->val[0]) > TOLERANCE)
+      {
+        printf("Solution %i at [%g, %g]: %g, RCM: %g, nested dissection: %g.\n", sln_i, points[point_i][0], points[point_i][1],
+          value->val[0], value_rcm->val[0], value_nd->val[0]);
+        success = false;
+      }
+      delete value;
+      delete value_rcm;
+      delete value_nd;
+    }
+  }
+
+  if (success)
+  {
+    printf("Success!\n");
+    return 0;
+  }
+  else
+  {
+    printf("Failure!\n");
+    return -1;
+  }
+}
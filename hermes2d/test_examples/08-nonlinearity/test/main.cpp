@@ -0,0 +1,136 @@
+#include "../definitions.h"
+
+// This test solves the problem of the example 08-nonlinearity three times - by the Newton's method with the
+// assembled Jacobian, and in the Jacobian-free Newton-Krylov mode (NewtonMatrixSolver::set_jacobian_free())
+// without and with the assembled Jacobian as the preconditioner.
+//
+// The converged coefficient vectors of the Jacobian-free runs have to match the one of the assembled-Jacobian run.
+
+// Initial polynomial degree.
+const int P_INIT = 2;
+// Stopping criterion for the Newton's method.
+const double NEWTON_TOL = 1e-8;
+// Maximum allowed number of Newton iterations.
+const int NEWTON_MAX_ITER = 100;
+// Number of initial uniform mesh refinements.
+const int INIT_GLOB_REF_NUM = 2;
+// Number of initial refinements towards boundary.
+const int INIT_BDY_REF_NUM = 2;
+// Tolerance of the comparison of the solutions (relative to the largest coefficient).
+const double TOLERANCE = 1e-6;
+
+// Problem parameters.
+double heat_src = 1.0;
+double alpha = 7.0;
+
+// Solves the problem from the projection of the initial condition, returns the converged coefficient vector
+// (nullptr if the solver failed).
+double* solve(WeakFormSharedPtr<double> wf, SpaceSharedPtr<double> space, bool jacobian_free, bool precondition_by_jacobian)
+{
+  int ndof = space->get_num_dofs();
+  double* coeff_vec = new double[ndof];
+  MeshFunctionSharedPtr<double> init_sln(new CustomInitialCondition(space->get_mesh()));
+  OGProjection<double> ogProjection; ogProjection.project_global(space, init_sln, coeff_vec);
+
+  NewtonSolver<double> newton(wf, space);
+  newton.set_verbose_output(false);
+  newton.set_tolerance(NEWTON_TOL, Hermes::Solvers::ResidualNormAbsolute);
+  newton.set_max_allowed_residual_norm(1e99);
+  newton.set_max_allowed_iterations(NEWTON_MAX_ITER);
+  newton.set_sufficient_improvement_factor_jacobian(0.5);
+  newton.set_max_steps_with_reused_jacobian(5);
+  newton.set_initial_auto_damping_coeff(0.95);
+  newton.set_sufficient_improvement_factor(1.1);
+  newton.set_min_allowed_damping_coeff(1e-10);
+  if (jacobian_free)
+  {
+    newton.set_jacobian_free(true, precondition_by_jacobian);
+    newton.set_jacobian_free_krylov_parameters(50, 2000);
+  }
+
+  try
+  {
+    newton.solve(coeff_vec);
+  }
+  catch (Exceptions::Exception& e)
+  {
+    std::cout << e.info();
+    delete[] coeff_vec;
+    return nullptr;
+  }
+  catch (std::exception& e)
+  {
+    std::cout << e.what();
+    delete[] coeff_vec;
+    return nullptr;
+  }
+
+  memcpy(coeff_vec, newton.get_sln_vector(), ndof * sizeof(double));
+  return coeff_vec;
+}
+
+// Largest difference of the coefficients relative to the largest coefficient of 'reference'.
+double relative_difference(double* reference, double* coeff_vec, int ndof)
+{
+  double max_reference = 0., max_difference = 0.;
+  for (int i = 0; i < ndof; i++)
+  {
+    max_reference = std::max(max_reference, std::abs(reference[i]));
+    max_difference = std::max(max_difference, std::abs(reference[i] - coeff_vec[i]));
+  }
+  return max_difference / max_reference;
+}
+
+int main(int argc, char* argv[])
+{
+  // Load the mesh.
+  MeshSharedPtr mesh(new Mesh);
+  MeshReaderH2D mloader;
+  mloader.load("square.mesh", mesh);
+
+  // Perform initial mesh refinements.
+  for (int i = 0; i < INIT_GLOB_REF_NUM; i++) mesh->refine_all_elements();
+  mesh->refine_towards_boundary("Bdy", INIT_BDY_REF_NUM);
+
+  // Initialize boundary conditions.
+  CustomEssentialBCNonConst bc_essential("Bdy");
+  EssentialBCs<double> bcs(&bc_essential);
+
+  // Create an H1 space with default shapeset.
+  SpaceSharedPtr<double> space(new H1Space<double>(mesh, &bcs, P_INIT));
+  int ndof = space->get_num_dofs();
+
+  // Initialize the weak formulation
+  CustomNonlinearity lambda(alpha);
+  Hermes2DFunction<double> src(-heat_src);
+  WeakFormSharedPtr<double> wf(new DefaultWeakFormPoisson<double>(HERMES_ANY, &lambda, &src));
+
+  double* coeff_vec = solve(wf, space, false, false);
+  double* coeff_vec_jfnk = solve(wf, space, true, false);
+  double* coeff_vec_jfnk_preconditioned = solve(wf, space, true, true);
+
+  bool success = coeff_vec && coeff_vec_jfnk && coeff_vec_jfnk_preconditioned;
+  if (success)
+  {
+    double difference = relative_difference(coeff_vec, coeff_vec_jfnk, ndof);
+    double difference_preconditioned = relative_difference(coeff_vec, coeff_vec_jfnk_preconditioned, ndof);
+    printf("Relative difference from the assembled-Jacobian Newton: JFNK: %g, preconditioned JFNK: %g.\n", difference, difference_preconditioned);
+    if (difference > TOLERANCE || difference_preconditioned > TOLERANCE)
+      success = false;
+  }
+
+  delete[] coeff_vec;
+  delete[] coeff_vec_jfnk;
+  delete[] coeff_vec_jfnk_preconditioned;
+
+  if (success)
+  {
+    printf("Success!\n");
+    return 0;
+  }
+  else
+  {
+    printf("Failure!\n");
+    return -1;
+  }
+}
@@ -0,0 +1,143 @@
+#include "hermes2d.h"
+
+using namespace Hermes;
+using namespace Hermes::Hermes2D;
+
+// This test projects functions onto L2 spaces (L2Space with varying element orders, L2MarkerWiseConstSpace) on the
+// meshes of the example 10-linear-advection-dg-adapt in the L2 norm - by the element-local projection, which solves
+// the diagonal blocks of the projection matrix one element at a time, and by the global OGProjection, which assembles
+// and solves the whole matrix.
+//
+// The sources are defined on the space mesh and on its refinement (then the element blocks are integrated over
+// sub-elements). The coefficient vectors of both projections have to be the same.
+
+// Polynomial degree.
+const int P_INIT = 2;
+// Number of initial uniform mesh refinements.
+const int INIT_REF_NUM = 2;
+// Tolerance of the comparison of the coefficient vectors (relative to the largest coefficient).
+const double TOLERANCE = 1e-10;
+
+class WaveFunction : public ExactSolutionScalar<double>
+{
+public:
+  WaveFunction(MeshSharedPtr mesh, double k) : ExactSolutionScalar<double>(mesh), k(k) {}
+
+  double value(double x, double y) const
+  {
+    return std::sin(k * x) * std::cos(k * y) + x * y;
+  }
+
+  void derivatives(double x, double y, double& dx, double& dy) const
+  {
+    dx = k * std::cos(k * x) * std::cos(k * y) + y;
+    dy = -k * std::sin(k * x) * std::sin(k * y) + x;
+  }
+
+  Ord ord(double x, double y) const
+  {
+    return Ord(10);
+  }
+
+  MeshFunction<double>* clone() const
+  {
+    return new WaveFunction(this->mesh, this->k);
+  }
+
+private:
+  double k;
+};
+
+// Exposes the projections OGProjection::project_global() chooses from.
+class TestProjection : public OGProjection<double>
+{
+public:
+  using OGProjection<double>::project_element_local;
+  using OGProjection<double>::project_internal;
+};
+
+// Largest difference of the coefficients relative to the largest coefficient of 'reference'.
+double relative_difference(double* reference, double* coeff_vec, int ndof)
+{
+  double max_reference = 0., max_difference = 0.;
+  for (int i = 0; i < ndof; i++)
+  {
+    max_reference = std::max(max_reference, std::abs(reference[i]));
+    max_difference = std::max(max_difference, std::abs(reference[i] - coeff_vec[i]));
+  }
+  return max_difference / max_reference;
+}
+
+// Projects the source onto the space both ways, returns false if the projections differ.
+bool compare(SpaceSharedPtr<double> space, MeshFunctionSharedPtr<double> source, const char* name)
+{
+  Space<double>::assign_dofs(std::vector<SpaceSharedPtr<double> >(1, space));
+  int ndof = space->get_num_dofs();
+  double* local_vec = new double[ndof];
+  double* global_vec = new double[ndof];
+
+  bool success = TestProjection::project_element_local(space, source, local_vec, HERMES_L2_NORM);
+  if (!success)
+    printf("%s: the element-local projection was not used.\n", name);
+  else
+  {
+    WeakFormSharedPtr<double> wf(new WeakForm<double>(1));
+    wf->add_matrix_form(new MatrixDefaultNormFormVol<double>(0, 0, HERMES_L2_NORM));
+    wf->add_vector_form(new VectorDefaultNormFormVol<double>(0, HERMES_L2_NORM));
+    wf->set_ext(source);
+    TestProjection::project_internal(space, wf, global_vec);
+
+    double difference = relative_difference(global_vec, local_vec, ndof);
+    printf("%s: %i DOFs, relative difference from the global projection: %g.\n", name, ndof, difference);
+    success = difference < TOLERANCE;
+  }
+
+  delete[] local_vec;
+  delete[] global_vec;
+  return success;
+}
+
+int main(int argc, char* argv[])
+{
+  bool success = true;
+
+  const char* mesh_files[2] = { "square.mesh", "square-triangular.mesh" };
+  for (int mesh_i = 0; mesh_i < 2; mesh_i++)
+  {
+    // Load and refine the mesh, the source mesh is refined once more.
+    MeshSharedPtr mesh(new Mesh), source_mesh(new Mesh);
+    MeshReaderH2D mloader;
+    mloader.load(mesh_files[mesh_i], mesh);
+    for (int i = 0; i < INIT_REF_NUM; i++)
+      mesh->refine_all_elements();
+    source_mesh->copy(mesh);
+    source_mesh->refine_all_elements();
+
+    // Element orders from P_INIT to P_INIT + 2 - blocks of different sizes.
+    SpaceSharedPtr<double> space(new L2Space<double>(mesh, P_INIT));
+    Element* e;
+    for_all_active_elements(e, mesh)
+      space->set_element_order(e->id, P_INIT + e->id % 3);
+    SpaceSharedPtr<double> const_space(new L2MarkerWiseConstSpace<double>(mesh));
+
+    MeshFunctionSharedPtr<double> source(new WaveFunction(mesh, 2.));
+    MeshFunctionSharedPtr<double> refined_source(new WaveFunction(source_mesh, 2.));
+
+    printf("%s\n", mesh_files[mesh_i]);
+    success = compare(space, source, "L2Space") && success;
+    success = compare(space, refined_source, "L2Space, refined source") && success;
+    success = compare(const_space, source, "L2MarkerWiseConstSpace") && success;
+    success = compare(const_space, refined_source, "L2MarkerWiseConstSpace, refined source") && success;
+  }
+
+  if (success)
+  {
+    printf("Success!\n");
+    return 0;
+  }
+  else
+  {
+    printf("Failure!\n");
+    return -1;
+  }
+}
@@ -0,0 +1,177 @@
+#include "hermes2d.h"
+
+using namespace Hermes;
+using namespace Hermes::Hermes2D;
+using namespace Hermes::Hermes2D::WeakFormsH1;
+
+// This example measures how the assembling of the matrix and the right-hand side
+// scales with the number of OpenMP threads. The same problem (Helmholtz-type operator
+// -Laplace u + c u = f on a square) is assembled once with real and once with complex
+// scalars, so that the two accumulation paths into the sparse structures can be compared.
+//
+// For each number of threads from 1 to the maximum available, the time of one assembling
+// (the best of NUM_ASSEMBLIES runs) is printed for both scalar types, together with the
+// speedup w.r.t. one thread.
+//
+// The assembled (real) matrix is then used to measure the sparse matrix-vector product
+// (the best of NUM_MULTIPLICATIONS runs), both in the CSC format (as assembled) and in the CSR format.
+//
+// The following parameters can be changed:
+
+// Uniform polynomial degree of mesh elements.
+const int P_INIT = 6;
+// Number of initial uniform mesh refinements.
+const int INIT_REF_NUM = 5;
+// Number of assemblings per measurement.
+const int NUM_ASSEMBLIES = 3;
+// Number of matrix-vector products per measurement.
+const int NUM_MULTIPLICATIONS = 20;
+
+template<typename Scalar>
+class ScalingWeakForm : public WeakForm<Scalar>
+{
+public:
+  ScalingWeakForm() : WeakForm<Scalar>(1)
+  {
+    this->add_matrix_form(new DefaultMatrixFormDiffusion<Scalar>(0, 0));
+    this->add_matrix_form(new DefaultMatrixFormVol<Scalar>(0, 0));
+    this->add_vector_form(new DefaultVectorFormVol<Scalar>(0));
+  }
+};
+
+// Returns the best time of one matrix-vector product using the given number of threads.
+template<typename Scalar>
+double measure_multiplication(CSMatrix<Scalar>* matrix, int num_threads)
+{
+  HermesCommonApi.set_integral_param_value(numThreads, num_threads);
+
+  int size = matrix->get_size();
+  Scalar* vector_in = malloc_with_check<Scalar>(size);
+  for (int i = 0; i < size; i++)
+    vector_in[i] = Scalar(1.0 + i % 10);
+  Scalar* vector_out = malloc_with_check<Scalar>(size);
+
+  double best_time = std::numeric_limits<double>::max();
+  for (int i = 0; i < NUM_MULTIPLICATIONS; i++)
+  {
+    Hermes::Mixins::TimeMeasurable timer;
+    timer.tick();
+    matrix->multiply_with_vector(vector_in, vector_out, true);
+    timer.tick();
+    best_time = std::min(best_time, timer.last());
+  }
+
+  free_with_check(vector_in);
+  free_with_check(vector_out);
+
+  return best_time;
+}
+
+// Assembles the (real) matrix of the problem in the CSC format.
+CSCMatrix<double>* assemble_matrix(MeshSharedPtr mesh)
+{
+  DefaultEssentialBCConst<double> bc_essential("Bdy", 0.0);
+  EssentialBCs<double> bcs(&bc_essential);
+  SpaceSharedPtr<double> space(new H1Space<double>(mesh, &bcs, P_INIT));
+  WeakFormSharedPtr<double> wf(new ScalingWeakForm<double>());
+
+  DiscreteProblem<double> dp(wf, space);
+  CSCMatrix<double>* matrix = new CSCMatrix<double>();
+  dp.assemble(matrix);
+  return matrix;
+}
+
+// Returns the best time of one assembling using the given number of threads.
+template<typename Scalar>
+double measure_assembling(MeshSharedPtr mesh, int num_threads)
+{
+  HermesCommonApi.set_integral_param_value(numThreads, num_threads);
+
+  DefaultEssentialBCConst<Scalar> bc_essential("Bdy", Scalar(0.0));
+  EssentialBCs<Scalar> bcs(&bc_essential);
+  SpaceSharedPtr<Scalar> space(new H1Space<Scalar>(mesh, &bcs, P_INIT));
+  WeakFormSharedPtr<Scalar> wf(new ScalingWeakForm<Scalar>());
+
+  DiscreteProblem<Scalar> dp(wf, space);
+  SparseMatrix<Scalar>* matrix = create_matrix<Scalar>();
+  Vector<Scalar>* rhs = create_vector<Scalar>();
+
+  // The first assembling also creates the sparse structure.
+  dp.assemble(matrix, rhs);
+
+  double best_time = std::numeric_limits<double>::max();
+  for (int i = 0; i < NUM_ASSEMBLIES; i++)
+  {
+    matrix->zero();
+    rhs->zero();
+
+    Hermes::Mixins::TimeMeasurable timer;
+    timer.tick();
+    dp.assemble(matrix, rhs);
+    timer.tick();
+    best_time = std::min(best_time, timer.last());
+  }
+
+  delete matrix;
+  delete rhs;
+
+  return best_time;
+}
+
+int main(int argc, char* argv[])
+{
+  // Load the mesh.
+  MeshSharedPtr mesh(new Mesh);
+  MeshReaderH2D mloader;
+  mloader.load("domain.mesh", mesh);
+
+  // Perform initial mesh refinements.
+  for (int i = 0; i < INIT_REF_NUM; i++)
+    mesh->refine_all_elements();
+
+  int max_threads = omp_get_max_threads();
+  int original_threads = HermesCommonApi.get_integral_param_value(numThreads);
+
+  double time_real_single = 0., time_complex_single = 0.;
+  std::cout << "threads\treal [s]\tspeedup\tcomplex [s]\tspeedup\tcomplex / real" << std::endl;
+  for (int num_threads = 1; num_threads <= max_threads; num_threads++)
+  {
+    double time_real = measure_assembling<double>(mesh, num_threads);
+    double time_complex = measure_assembling<std::complex<double> >(mesh, num_threads);
+    if (num_threads == 1)
+    {
+      time_real_single = time_real;
+      time_complex_single = time_complex;
+    }
+
+    std::cout << num_threads << '\t' << time_real << '\t' << time_real_single / time_real << '\t'
+      << time_complex << '\t' << time_complex_single / time_complex << '\t' << time_complex / time_real << std::endl;
+  }
+
+  // Matrix-vector products.
+  CSCMatrix<double>* csc_matrix = assemble_matrix(mesh);
+  CSRMatrix<double> csr_matrix;
+  csr_matrix.create(csc_matrix->get_size(), csc_matrix->get_nnz(), csc_matrix->get_Ap(), csc_matrix->get_Ai(), csc_matrix->get_Ax());
+  csr_matrix.switch_orientation();
+
+  double time_csc_single = 0., time_csr_single = 0.;
+  std::cout << std::endl << "SpMV, size: " << csc_matrix->get_size() << ", nnz: " << csc_matrix->get_nnz() << std::endl;
+  std::cout << "threads\tCSC [s]\tspeedup\tCSR [s]\tspeedup" << std::endl;
+  for (int num_threads = 1; num_threads <= max_threads; num_threads++)
+  {
+    double time_csc = measure_multiplication<double>(csc_matrix, num_threads);
+    double time_csr = measure_multiplication<double>(&csr_matrix, num_threads);
+    if (num_threads == 1)
+    {
+      time_csc_single = time_csc;
+      time_csr_single = time_csr;
+    }
+
+    std::cout << num_threads << '\t' << time_csc << '\t' << time_csc_single / time_csc << '\t'
+      << time_csr << '\t' << time_csr_single / time_csr << std::endl;
+  }
+  delete csc_matrix;
+
+  HermesCommonApi.set_integral_param_value(numThreads, original_threads);
+  return 0;
+}
@@ -22,7 +22,9 @@
 
 #cmakedefine WITH_TC_MALLOC
 #cmakedefine WITH_PJLIB
+#cmakedefine WITH_PROFILING
 #cmakedefine WITH_BSON
+#cmakedefine WITH_ZLIB
 #cmakedefine WITH_MATIO
 #cmakedefine MONGO_STATIC_BUILD
 #cmakedefine UMFPACK_LONG_INT
@@ -37,6 +37,7 @@ namespace Hermes
     SOLVER_AMESOS = 6,
     SOLVER_AZTECOO = 7,
     SOLVER_EXTERNAL = 8,
+    SOLVER_NATIVE_ITERATIVE = 9,
     SOLVER_EMPTY = 100
   };
 
@@ -54,7 +55,8 @@ namespace Hermes
   {
     ITERATIVE_SOLVER_PARALUTION = 1,
     ITERATIVE_SOLVER_PETSC = 3,
-    ITERATIVE_SOLVER_AZTECOO = 7
+    ITERATIVE_SOLVER_AZTECOO = 7,
+    ITERATIVE_SOLVER_NATIVE = 9
   };
 
   enum AMGMatrixSolverType
@@ -65,6 +65,25 @@ namespace Hermes
       /// Virtual - the method body is 1:1 for CSCMatrix, inverted for CSR.
       virtual Scalar get(unsigned int Ai_data_index, unsigned int Ai_index) const;
 
+      /// Add a local (element) matrix.
+      /// The indices into Ai (rows for CSC, columns for CSR) are sorted once per call and the positions in Ax
+      /// are then found by a single merge-walk per column (row), instead of a binary search per entry.
+      /// \See Matrix<Scalar>::add().
+      virtual void add(unsigned int m, unsigned int n, Scalar *mat, int *rows, int *cols, const int size);
+
+      /// Thread-private accumulation for multi-threaded assembling.
+      /// Everything added from thread number i (omp_get_thread_num()) is accumulated without any atomic
+      /// operations into the i-th private copy of Ax, threads numbered num_threads and above add atomically into Ax.
+      /// The copies are summed into Ax in finish(), which also switches the accumulation off, i.e. this has to be called
+      /// before every assembling. The copies are kept (zeroed) for the next assembling, they are only allocated again
+      /// if the number of threads or nnz changes.
+      /// Costs num_threads * nnz Scalars of memory. num_threads < 2, or the cost above memory_limit (in MB), switches
+      /// the accumulation off (and frees the copies) - the threads then add atomically into Ax.
+      void set_thread_private_accumulation(int num_threads, int memory_limit);
+
+      /// Sums the thread-private accumulation copies into Ax.
+      virtual void finish();
+
       /// Allocate utility storage (row, column indices, etc.).
       virtual void alloc();
       // Allocate data storage.
@@ -104,6 +123,12 @@ namespace Hermes
       /// @return pointer to #Ax
       Scalar *get_Ax() const;
 
+      /// Row-wise index of the entries (e.g. for row-wise preconditioners), valid until the sparsity structure changes.
+      /// @param[out] row_Ap Index to row_Ai, where each row starts.
+      /// @param[out] row_Ai Column indices, sorted in each row.
+      /// @param[out] row_Ax_positions Positions of the entries in Ax, nullptr if identical to the positions in row_Ai.
+      virtual void get_row_index(const int*& row_Ap, const int*& row_Ai, const int*& row_Ax_positions) const = 0;
+
       /// Add matrix to specific position.
       /// @param[in] i row in target matrix coresponding with top row of added matrix
       /// @param[in] j column in target matrix coresponding with lef column of added matrix
@@ -112,6 +137,28 @@ namespace Hermes
       virtual void add_as_block(unsigned int i, unsigned int j, SparseMatrix<Scalar>* mat);
 
     protected:
+      /// Add a local matrix, outer indices are indices into Ap, inner ones into Ai.
+      /// @param[in] transposed If true, the value for (outer[o], inner[i]) is mat[o * size + i], mat[i * size + o] otherwise.
+      void add_block(unsigned int outer_count, unsigned int inner_count, Scalar *mat, int *outer, int *inner, const int size, bool transposed);
+
+      /// (De)allocation of the thread-private accumulation copies of Ax (thread_private_count copies of size nnz).
+      void alloc_thread_private_data();
+      void free_thread_private_data();
+      /// The array the calling thread adds into - its thread-private copy of Ax, or Ax itself (atomic == true).
+      Scalar* get_accumulation_target(bool& atomic);
+
+      /// Row-wise matrix product used by the SpMV of both orientations.
+      /// Rows are split among threads into contiguous blocks with (roughly) the same number of nonzeros,
+      /// every output entry is written by exactly one thread.
+      /// @param[in] row_Ap Index to row_Ai, where each row starts.
+      /// @param[in] row_Ai Column indices.
+      /// @param[in] row_Ax_positions Positions of the entries in Ax, nullptr if identical to the positions in row_Ai.
+      void multiply_rows(const int* row_Ap, const int* row_Ai, const int* row_Ax_positions, Scalar* vectors_in, Scalar* vectors_out, unsigned int num_vectors) const;
+
+      /// Builds the row-wise index of the column-wise storage (see transposed_Ap), if not built yet.
+      void build_transposed_index() const;
+      void free_transposed_index();
+
       /// UMFPack specific data structures for storing the system matrix (CSC format).
       /// Matrix entries (column-wise).
       Scalar *Ax;
@@ -121,6 +168,24 @@ namespace Hermes
       int *Ap;
       /// Number of non-zero entries ( =  Ap[size]).
       unsigned int nnz;
+
+      /// Number of the thread-private copies of Ax (0 - not allocated).
+      int thread_private_count;
+      /// Thread-private copies of Ax, all zero unless the accumulation is on.
+      Scalar** thread_private_Ax;
+      /// Size of the thread-private copies (nnz they were allocated for).
+      unsigned int thread_private_nnz;
+      /// Additions go to the thread-private copies (between set_thread_private_accumulation() and finish()).
+      bool thread_private_active;
+
+      /// Index of the entries by the other orientation (rows for CSC), so that CSC SpMV can be done row-wise without write conflicts.
+      /// Built on demand, freed whenever the sparsity structure changes.
+      /// Index to transposed_Ai / transposed_Ax_positions, where each row starts.
+      mutable int* transposed_Ap;
+      /// Column indices.
+      mutable int* transposed_Ai;
+      /// Positions of the entries in Ax.
+      mutable int* transposed_Ax_positions;
       template<typename T> friend SparseMatrix<T>*  create_matrix();
     };
 
@@ -145,7 +210,15 @@ namespace Hermes
 
       virtual void add(unsigned int m, unsigned int n, Scalar v);
 
-      void multiply_with_vector(Scalar* vector_in, Scalar*& vector_out, bool vector_out_initialized) const;
+      /// Parallel SpMV, done row-wise using the transposed index.
+      void multiply_with_vector(Scalar* vector_in, Scalar*& vector_out, bool vector_out_initialized = false) const;
+
+      /// Each matrix entry is loaded once for (a block of) all vectors.
+      /// \See Matrix<Scalar>::multiply_with_vectors().
+      virtual void multiply_with_vectors(Scalar* vectors_in, Scalar*& vectors_out, unsigned int num_vectors, bool vectors_out_initialized = false) const;
+
+      /// The transposed index (built if not yet).
+      virtual void get_row_index(const int*& row_Ap, const int*& row_Ai, const int*& row_Ax_positions) const;
 
       virtual void export_to_file(const char *filename, const char *var_name, MatrixExportFormat fmt, char* number_format = "%lf");
       virtual void import_from_file(const char *filename, const char *var_name, MatrixExportFormat fmt);
@@ -175,6 +248,19 @@ namespace Hermes
 
       virtual void add(unsigned int m, unsigned int n, Scalar v);
 
+      /// Add a local (element) matrix - inverted storage w.r.t. CSMatrix<Scalar>::add().
+      virtual void add(unsigned int m, unsigned int n, Scalar *mat, int *rows, int *cols, const int size);
+
+      /// Parallel SpMV, row-parallel.
+      void multiply_with_vector(Scalar* vector_in, Scalar*& vector_out, bool vector_out_initialized = false) const;
+
+      /// Each matrix entry is loaded once for (a block of) all vectors.
+      /// \See Matrix<Scalar>::multiply_with_vectors().
+      virtual void multiply_with_vectors(Scalar* vectors_in, Scalar*& vectors_out, unsigned int num_vectors, bool vectors_out_initialized = false) const;
+
+      /// The storage itself.
+      virtual void get_row_index(const int*& row_Ap, const int*& row_Ai, const int*& row_Ax_positions) const;
+
       void export_to_file(const char *filename, const char *var_name, MatrixExportFormat fmt, char* number_format = "%lf");
       void import_from_file(const char *filename, const char *var_name, MatrixExportFormat fmt);
 
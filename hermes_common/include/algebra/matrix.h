@@ -85,6 +85,10 @@ namespace Hermes
       /// Multiply with a vector.
       virtual void multiply_with_vector(Scalar* vector_in, Scalar*& vector_out, bool vector_out_initialized = false) const;
 
+      /// Multiply with several vectors stored one after another (the k-th vector starts at vectors_in + k * size),
+      /// the results are stored in the same way.
+      virtual void multiply_with_vectors(Scalar* vectors_in, Scalar*& vectors_out, unsigned int num_vectors, bool vectors_out_initialized = false) const;
+
       /// Multiply with a Scalar.
       virtual void multiply_with_Scalar(Scalar value);
 
@@ -37,7 +37,10 @@ namespace Hermes
     directMatrixSolverType,
     showInternalWarnings,
     checkMeshesOnLoad,
-    useAccelerators
+    useAccelerators,
+    useThreadPrivateAccumulation,
+    /// Memory (in MB) the thread-private accumulation copies of a matrix may take, see CSMatrix::set_thread_private_accumulation().
+    threadPrivateAccumulationMemoryLimit
   };
 
   /// API Class containing settings for the whole HermesCommon.
@@ -82,6 +82,7 @@
 inline int omp_get_max_threads() { return 1; }
 inline int omp_get_num_threads() { return 1; }
 inline int omp_get_thread_num() { return 0; }
+inline double omp_get_wtime() { return (double)clock() / CLOCKS_PER_SEC; }
 #endif
 
 #ifdef WITH_PJLIB
@@ -36,6 +36,7 @@
 #include "solvers/interfaces/umfpack_solver.h"
 #include "solvers/interfaces/superlu_solver.h"
 #include "solvers/interfaces/paralution_solver.h"
+#include "solvers/native_iterative_solver.h"
 #include "solvers/precond.h"
 #include "solvers/interfaces/precond_ifpack.h"
 #include "solvers/interfaces/precond_ml.h"
@@ -47,6 +48,8 @@
 #include "data_structures/range.h"
 #include "util/qsort.h"
 #include "util/memory_handling.h"
+#include "util/profiler.h"
+#include "util/binary_container.h"
 #include "ord.h"
 #include "mixins.h"
 #include "api.h"
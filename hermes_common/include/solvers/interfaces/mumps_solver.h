@@ -87,6 +87,9 @@ namespace Hermes
 
       void add(unsigned int m, unsigned int n, Scalar v);
 
+      /// Add a local (element) matrix entry by entry, the entries are stored in MUMPS-specific arrays.
+      void add(unsigned int m, unsigned int n, Scalar *mat, int *rows, int *cols, const int size);
+
       /// Matrix export method.
       /// Utility version
       /// \See MatrixRhsImportExport<Scalar>::export_to_file.
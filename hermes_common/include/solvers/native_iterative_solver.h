@@ -0,0 +1,179 @@
+// This file is part of HermesCommon
+//
+// Copyright (c) 2009 hp-FEM group at the University of Nevada, Reno (UNR).
+// Email: hpfem-group@unr.edu, home page: http://www.hpfem.org/.
+//
+// Hermes2D is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published
+// by the Free Software Foundation; either version 2 of the License,
+// or (at your option) any later version.
+//
+// Hermes2D is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with Hermes2D; if not, write to the Free Software
+// Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+/*! \file native_iterative_solver.h
+\brief Built-in (OpenMP-parallel) Krylov solvers working directly on CS matrices.
+*/
+#ifndef __HERMES_COMMON_NATIVE_ITERATIVE_SOLVER_H_
+#define __HERMES_COMMON_NATIVE_ITERATIVE_SOLVER_H_
+#include "solvers/linear_matrix_solver.h"
+#include "algebra/cs_matrix.h"
+#include "solvers/precond.h"
+
+using namespace Hermes::Algebra;
+
+namespace Hermes
+{
+  namespace Preconditioners
+  {
+    /// \brief A built-in preconditioner for NativeIterativeLinearMatrixSolver.
+    /// Supported types: Jacobi, ILU (= ILU(0)), SSOR.
+    /// The triangular solves of ILU and SSOR are parallelized by level scheduling - the rows of each triangle are grouped
+    /// into levels depending only on the previous ones, the rows of one level are processed in parallel. The results do not
+    /// depend on the number of threads. The ILU(0) factorization itself is computed serially.
+    /// If ILU / SSOR can not be computed (zero or missing diagonal entries, e.g. saddle-point systems,
+    /// or a zero pivot of ILU(0)), Jacobi is used instead with a warning, rows with a zero diagonal are not scaled.
+    template <typename Scalar>
+    class HERMES_API NativePrecond : public Precond < Scalar >, public Hermes::Mixins::Loggable
+    {
+    public:
+      /// Constructor.
+      /// \param[in] preconditionerType The preconditioner type to create.
+      /// \param[in] omega Relaxation parameter (SSOR only).
+      NativePrecond(PreconditionerType preconditionerType, double omega = 1.0);
+      virtual ~NativePrecond();
+
+      /// Computes the preconditioner for the matrix given by its row-wise index (see CSMatrix::get_row_index()) and values.
+      /// The index is referenced, not copied.
+      void setup(int size, const int* Ap, const int* Ai, const int* Ax_positions, const Scalar* Ax);
+
+      /// Applies the preconditioner: z = M^{-1} r.
+      void apply(Scalar* r, Scalar* z) const;
+
+      /// Frees the computed data.
+      void free();
+
+      /// setup() has been called (and free() has not been called since).
+      bool is_computed() const;
+
+      PreconditionerType get_type() const;
+
+      /// The type applied after the last setup() - Jacobi if the requested type could not be computed.
+      PreconditionerType get_applied_type() const;
+
+    private:
+      PreconditionerType preconditionerType;
+      PreconditionerType applied_type;
+      double omega;
+
+      /// Groups the rows of the lower (upper) triangle into levels, a row only depends on the rows of lower levels.
+      /// @param[out] level_Ap Index to level_rows, where each level starts.
+      /// @param[out] level_rows The rows by levels (ascending within a level).
+      void compute_levels(bool upper, std::vector<int>& level_Ap, std::vector<int>& level_rows) const;
+
+      /// The row-wise index of the matrix (not owned).
+      int size;
+      const int* Ap;
+      const int* Ai;
+
+      /// Position of the diagonal entry in each row.
+      int* diag_position;
+      /// Inverted diagonal (Jacobi, SSOR).
+      Scalar* inv_diag;
+      /// The matrix values in the order of Ai (ILU, SSOR); for ILU overwritten by the ILU(0) factors (unit lower triangle is implicit).
+      Scalar* values;
+
+      /// Levels of the lower and upper triangle (ILU, SSOR), see compute_levels().
+      std::vector<int> lower_level_Ap;
+      std::vector<int> lower_level_rows;
+      std::vector<int> upper_level_Ap;
+      std::vector<int> upper_level_rows;
+    };
+  }
+
+  namespace Solvers
+  {
+    /// \brief Built-in iterative solver (CG, GMRES, BiCGStab) working directly on CSCMatrix / CSRMatrix.
+    /// Matrix-vector products and vector operations are parallelized with OpenMP using HermesCommonApi's numThreads.
+    /// Selected by HermesCommonApi.set_integral_param_value(matrixSolverType, SOLVER_NATIVE_ITERATIVE).
+    template <typename Scalar>
+    class HERMES_API NativeIterativeLinearMatrixSolver : public virtual IterSolver < Scalar >
+    {
+    public:
+      /// Constructor.
+      /// @param[in] m pointer to matrix
+      /// @param[in] rhs pointer to right hand side vector
+      NativeIterativeLinearMatrixSolver(CSMatrix<Scalar> *m, SimpleVector<Scalar> *rhs);
+      virtual ~NativeIterativeLinearMatrixSolver();
+
+      virtual void solve();
+      virtual void solve(Scalar* initial_guess);
+
+      /// Get number of iterations.
+      virtual int get_num_iters();
+
+      /// Get the residual value.
+      virtual double get_residual_norm();
+
+      /// Utility.
+      virtual int get_matrix_size();
+
+      /// Free this instance.
+      virtual void free();
+
+      /// Set preconditioner, has to be a NativePrecond instance, nullptr switches preconditioning off.
+      /// The instance is owned (deleted) by this solver.
+      virtual void set_precond(Precond<Scalar> *pc);
+
+      /// Set the Krylov subspace dimension after which GMRES restarts.
+      void set_gmres_restart(int restart);
+
+    protected:
+      /// (Re-)computes the preconditioner.
+      void setup();
+
+      /// y = A x, by CSMatrix::multiply_with_vector().
+      void spmv(Scalar* x, Scalar* y) const;
+
+      /// z = M^{-1} r (copy if not preconditioned).
+      void precondition(Scalar* r, Scalar* z) const;
+
+      /// The methods, return true on convergence.
+      bool solve_cg(Scalar* x, double b_norm);
+      bool solve_gmres(Scalar* x, double b_norm);
+      bool solve_bicgstab(Scalar* x, double b_norm);
+
+      /// Convergence check according to the tolerance type.
+      bool converged(double residual_norm, double b_norm, double initial_residual_norm) const;
+
+      /// Matrix to solve.
+      CSMatrix<Scalar> *matrix;
+
+      /// Right hand side vector.
+      SimpleVector<Scalar> *rhs;
+
+      /// Preconditioner.
+      Preconditioners::NativePrecond<Scalar>* preconditioner;
+
+      /// GMRES restart.
+      int gmres_restart;
+
+      /// Store num_iters.
+      int num_iters;
+
+      /// Store final_residual.
+      double final_residual;
+
+      /// Number of threads used.
+      int num_threads;
+
+      template<typename T> friend LinearMatrixSolver<T>* create_linear_solver(Matrix<T>* matrix, Vector<T>* rhs, bool use_direct_solver);
+    };
+  }
+}
+#endif
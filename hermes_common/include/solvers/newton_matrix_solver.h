@@ -35,9 +35,78 @@ namespace Hermes
       NewtonMatrixSolver();
       virtual ~NewtonMatrixSolver() {};
 
+#pragma region jacobian_free-public
+      /// Switches the Jacobian-free Newton-Krylov (JFNK) mode on / off.
+      /// The Newton step is then computed by restarted GMRES, where the products of the Jacobian with vectors are
+      /// approximated by finite differences of residuals, so that the Jacobian does not have to be assembled and factorized.
+      /// Default: off.
+      /// \param[in] precondition_by_jacobian Use the assembled Jacobian, solved by the linear matrix solver, as a (right) preconditioner.
+      /// The Jacobian is lagged (reused) as set by set_max_steps_with_reused_jacobian(), an iterative linear matrix solver
+      /// with its own preconditioner makes it an approximate one.
+      void set_jacobian_free(bool to_set = true, bool precondition_by_jacobian = false);
+
+      /// Sets the Eisenstat-Walker forcing terms (choice 2): GMRES stops when |F + J dx| <= eta |F|, where
+      /// eta = gamma * (|F_k| / |F_{k-1}|)^alpha, safeguarded and limited by eta_max.
+      /// Default: eta_max = 0.9, gamma = 0.9, alpha = 2.0.
+      void set_forcing_term_parameters(double eta_max, double gamma, double alpha);
+
+      /// Sets the Krylov subspace dimension after which GMRES restarts, and the maximum number of GMRES iterations per Newton step.
+      /// Default: 30, 300.
+      void set_jacobian_free_krylov_parameters(int restart, int max_iters);
+#pragma endregion
+
     protected:
       virtual double update_solution_return_change_norm(Scalar* linear_system_solution);
 
+#pragma region jacobian_free-private
+      /// Assembles the residual F(coeff_vec) (not sign-changed), used by the Jacobian-free mode.
+      virtual void evaluate_residual(Scalar* coeff_vec, Vector<Scalar>* residual);
+
+      /// In the Jacobian-free mode, computes the step by solve_jacobian_free().
+      virtual void solve_linear_system();
+
+      /// GMRES for J step = -F, with the right hand side stored in jfnk_residual.
+      /// \return Number of GMRES iterations.
+      int solve_jacobian_free(Scalar* step);
+
+      /// y ~ J v by a finite difference of residuals.
+      void jacobian_vector_product(Scalar* v, Scalar* y);
+
+      /// z = M^{-1} r with the assembled Jacobian, copy if not preconditioned.
+      void apply_preconditioner(Scalar* r, Scalar* z);
+
+      /// The Eisenstat-Walker forcing term of the current step.
+      double calculate_forcing_term();
+
+      /// Nothing to reuse without the preconditioning.
+      virtual bool force_reuse_jacobian_values(unsigned int& successful_steps_with_reused_jacobian);
+      /// In the Jacobian-free mode, the lagged Jacobian is only the preconditioner, the step is a Newton one.
+      virtual bool jacobian_reused_okay(unsigned int& successful_steps_with_reused_jacobian);
+
+      virtual void init_solving(Scalar* coeff_vec);
+      virtual void deinit_solving();
+
+      bool jacobian_free;
+      bool jacobian_free_preconditioning;
+      double forcing_term_max;
+      double forcing_term_gamma;
+      double forcing_term_alpha;
+      int jacobian_free_restart;
+      int jacobian_free_max_iters;
+
+      /// The forcing term of the previous step (negative before the first one).
+      double forcing_term;
+      /// Norm of sln_vector for the finite difference step size.
+      double jfnk_sln_norm;
+      /// -F(sln_vector).
+      Scalar* jfnk_residual;
+      /// sln_vector + eps v, and F of it.
+      Scalar* jfnk_perturbed_sln;
+      Vector<Scalar>* jfnk_perturbed_residual;
+      /// The computed step.
+      Scalar* jfnk_step;
+#pragma endregion
+
       /// Find out the convergence state.
       virtual NonlinearConvergenceState get_convergence_state();
 
@@ -48,7 +48,8 @@ namespace Hermes
       IC = 4,
       AIChebyshev = 5,
       MultiElimination = 6,
-      SaddlePoint = 7
+      SaddlePoint = 7,
+      SSOR = 8
     };
 
     /// \brief Abstract class to define interface for preconditioners.
@@ -0,0 +1,168 @@
+// This file is part of HermesCommon
+//
+// Copyright (c) 2009 hp-FEM group at the University of Nevada, Reno (UNR).
+// Email: hpfem-group@unr.edu, home page: http://www.hpfem.org/.
+//
+// Hermes2D is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published
+// by the Free Software Foundation; either version 2 of the License,
+// or (at your option) any later version.
+//
+// Hermes2D is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with Hermes2D; if not, write to the Free Software
+// Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+/*! \file binary_container.h
+    \brief Versioned little-endian binary container of named flat arrays, read through a memory mapping.
+    */
+#ifndef __HERMES_COMMON_BINARY_CONTAINER_H_
+#define __HERMES_COMMON_BINARY_CONTAINER_H_
+
+#include "util/compat.h"
+#include "common.h"
+#include "exceptions.h"
+#include "util/memory_handling.h"
+
+namespace Hermes
+{
+  namespace BinaryIO
+  {
+    /// Version of the container layout.
+    const unsigned int HERMES_BINARY_CONTAINER_VERSION = 1;
+    /// Maximum length of an array name (including the terminating zero).
+    const int HERMES_BINARY_CONTAINER_NAME_LENGTH = 40;
+    /// Alignment of the arrays in the file (and so in the mapping).
+    const int HERMES_BINARY_CONTAINER_ALIGNMENT = 64;
+
+    /// Types of the stored arrays.
+    enum BinaryArrayType
+    {
+      BinaryArrayChar = 0,
+      BinaryArrayInt = 1,
+      BinaryArrayDouble = 2,
+      BinaryArrayComplex = 3
+    };
+
+    /// Array type of a C++ type.
+    template<typename T> BinaryArrayType binary_array_type();
+
+    /// \brief Layout of the file:
+    /// header (magic "HERMESBC", version, byte order mark, number of arrays),
+    /// table of contents (name, type, element size, count, offset for each array),
+    /// arrays aligned to HERMES_BINARY_CONTAINER_ALIGNMENT bytes.
+    /// All values are little-endian, the container is only written and read on little-endian platforms.
+    struct BinaryContainerHeader
+    {
+      char magic[8];
+      unsigned int version;
+      unsigned int byte_order_mark;
+      unsigned long long array_count;
+    };
+
+    struct BinaryContainerEntry
+    {
+      char name[HERMES_BINARY_CONTAINER_NAME_LENGTH];
+      unsigned int type;
+      unsigned int element_size;
+      unsigned long long count;
+      unsigned long long offset;
+    };
+
+    /// \brief Collects the arrays and writes them by large sequential writes.
+    /// Usage:
+    ///  BinaryContainerWriter writer;
+    ///  writer.add_array("coeffs", coeffs, num_coeffs); // not copied, has to live until write()
+    ///  int* orders = writer.allocate_array<int>("orders", num_elems); // owned by the writer
+    ///  ... fill orders ...
+    ///  writer.write("checkpoint.h2db");
+    class HERMES_API BinaryContainerWriter
+    {
+    public:
+      BinaryContainerWriter();
+      ~BinaryContainerWriter();
+
+      /// Adds an array, the data is not copied.
+      template<typename T>
+      void add_array(const char* name, const T* data, unsigned long long count)
+      {
+        this->add_entry(name, binary_array_type<T>(), sizeof(T), count, data, false);
+      }
+
+      /// Adds an array with storage owned by the writer, to be filled by the caller.
+      template<typename T>
+      T* allocate_array(const char* name, unsigned long long count)
+      {
+        // Freed in add_entry() / the destructor by free_with_check(.., true).
+        T* data = malloc_with_check<T>((int)std::max<unsigned long long>(count, 1), true);
+        this->add_entry(name, binary_array_type<T>(), sizeof(T), count, data, true);
+        return data;
+      }
+
+      /// Writes all the arrays.
+      void write(const char* filename) const;
+
+    private:
+      struct Item
+      {
+        BinaryContainerEntry entry;
+        const void* data;
+        bool owned;
+      };
+
+      void add_entry(const char* name, BinaryArrayType type, unsigned int element_size, unsigned long long count, const void* data, bool owned);
+
+      std::vector<Item> items;
+    };
+
+    /// \brief Read-only access to a container file mapped to the memory.
+    /// The arrays are views into the (copy-on-write) mapping, so that they may be modified
+    /// in place without changing the file, and they are valid as long as the container exists.
+    class HERMES_API BinaryContainer
+    {
+    public:
+      /// Maps the file and checks the header and the table of contents.
+      BinaryContainer(const char* filename);
+      ~BinaryContainer();
+
+      /// Whether the array is present.
+      bool has_array(const char* name) const;
+
+      /// A view of the array, throws if not present or of a different type.
+      template<typename T>
+      T* get_array(const char* name, unsigned long long& count) const
+      {
+        return (T*)this->get_entry_data(name, binary_array_type<T>(), sizeof(T), count);
+      }
+
+      /// A view of the array, throws if its length is not the expected one.
+      template<typename T>
+      T* get_array_of_size(const char* name, unsigned long long expected_count) const
+      {
+        unsigned long long count;
+        T* data = this->get_array<T>(name, count);
+        if (count != expected_count)
+          throw Exceptions::Exception("Array %s in %s has %llu entries instead of %llu.", name, this->filename.c_str(), count, expected_count);
+        return data;
+      }
+
+    private:
+      void* get_entry_data(const char* name, BinaryArrayType type, unsigned int element_size, unsigned long long& count) const;
+
+      std::string filename;
+      char* data;
+      unsigned long long size;
+#if defined(WIN32) || defined(_WINDOWS)
+      void* file_handle;
+      void* mapping_handle;
+#endif
+      std::map<std::string, const BinaryContainerEntry*> entries;
+    };
+  }
+
+  typedef std::tr1::shared_ptr<Hermes::BinaryIO::BinaryContainer> BinaryContainerSharedPtr;
+}
+#endif
@@ -26,6 +26,7 @@
 #include "exceptions.h"
 #include "api.h"
 #include <cstddef>
+#include <vector>
 
 // If C++ 11 is not supported
 namespace std
@@ -290,5 +291,48 @@ namespace Hermes
       }
     }
   }
+
+  /// \brief Bump allocator for short-lived scratch data (e.g. the data of one element in assembling).
+  /// The memory is taken from blocks (allocated on the first use) kept until the arena is destroyed, reset() makes all of it available again,
+  /// so once the blocks are large enough, no memory is allocated from the system.
+  /// No destructors of the objects placed in the arena are called.
+  class HERMES_API MemoryArena
+  {
+  public:
+    /// \param[in] block_size Size of the first block, the following ones are at least twice as large as the previous one.
+    MemoryArena(size_t block_size = 1024 * 1024);
+    ~MemoryArena();
+
+    /// Uninitialized array of count items (aligned for any type), nullptr for count == 0.
+    template<typename ArrayItem>
+    ArrayItem* allocate(int count)
+    {
+      return (ArrayItem*)this->allocate_bytes(count * sizeof(ArrayItem));
+    }
+
+    /// Uninitialized memory (aligned for any type), nullptr for size == 0.
+    void* allocate_bytes(size_t size);
+
+    /// Makes all memory available again (the blocks are kept).
+    void reset();
+
+    /// The size of all blocks.
+    size_t get_capacity() const;
+
+  private:
+    struct Block
+    {
+      char* data;
+      size_t size;
+    };
+    std::vector<Block> blocks;
+
+    /// The block the memory is taken from, and the offset of the free part in it.
+    unsigned int current_block;
+    size_t current_offset;
+
+    /// Size of the first block.
+    size_t block_size;
+  };
 }
 #endif
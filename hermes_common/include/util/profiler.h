@@ -0,0 +1,213 @@
+// This file is part of HermesCommon
+//
+// Copyright (c) 2009 hp-FEM group at the University of Nevada, Reno (UNR).
+// Email: hpfem-group@unr.edu, home page: http://www.hpfem.org/.
+//
+// Hermes2D is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published
+// by the Free Software Foundation; either version 2 of the License,
+// or (at your option) any later version.
+//
+// Hermes2D is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with Hermes2D; if not, write to the Free Software
+// Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+/*! \file profiler.h
+    \brief Hierarchical profiling of the phases of a computation (assembling, solving, adaptivity).
+    */
+#ifndef __HERMES_COMMON_PROFILER_H_
+#define __HERMES_COMMON_PROFILER_H_
+
+#include "util/compat.h"
+#include "common.h"
+
+namespace Hermes
+{
+  namespace Profiling
+  {
+    /// Maximum number of threads the profiler keeps separate records for.
+    const int HERMES_PROFILER_MAX_THREADS = 256;
+
+    /// \brief Records nested phases with per-thread timers, and counters.
+    /// Not used directly, but through the macros HERMES_PROFILE_SCOPE, HERMES_PROFILE_COUNT, HERMES_PROFILE_PARENT_PHASE,
+    /// HERMES_PROFILE_PARALLEL_REGION, which are empty (and the profiling has no overhead) if Hermes is built without WITH_PROFILING.
+    /// The phases are identified by their name (the string, not its address) and by their parent phase, and the tree of them
+    /// is common to all threads - the phases of the threads of a parallel region are nested in the phase which was open
+    /// when the region started (see enter_parallel_region()).
+    /// Usage:
+    ///  Hermes::HermesProfiler.reset();
+    ///  ... computation ...
+    ///  Hermes::HermesProfiler.export_json("profile.json");
+    ///  Hermes::HermesProfiler.export_chrome_trace("trace.json");
+    class HERMES_API Profiler
+    {
+    public:
+      Profiler();
+      ~Profiler();
+
+      /// Switches the recording on / off at runtime (default: on).
+      /// Should not be called while some phases are open.
+      void set_enabled(bool to_set);
+      bool is_enabled() const;
+
+      /// Maximum number of recorded (trace) events per thread, the phase tree is aggregated also beyond that.
+      void set_max_trace_events(unsigned int max_trace_events);
+
+      /// Starts a phase, nested in the currently open phase of the calling thread.
+      void begin(const char* name);
+      /// Ends the innermost open phase of the calling thread.
+      void end();
+
+      /// The innermost open phase of the calling thread (0 - the root, if none is open).
+      /// To be called before a parallel region, and passed to enter_parallel_region() in its threads.
+      int get_current_phase();
+      /// Nests the phases started by the calling thread in the phase 'parent' until leave_parallel_region().
+      /// The other threads of a parallel region do not have the phases of the thread which started it open,
+      /// so without this their phases would end up in the root.
+      void enter_parallel_region(int parent);
+      void leave_parallel_region();
+
+      /// Adds to a counter.
+      void count(const char* name, unsigned long long amount = 1);
+
+      /// Clears all records.
+      /// Should not be called while some phases are open.
+      void reset();
+
+      /// Exports the phase tree (calls, total and self times, merged over threads) and the counters as JSON.
+      void export_json(const char* filename) const;
+      /// Exports the recorded phases in the Chrome trace-event format (chrome://tracing, Perfetto).
+      void export_chrome_trace(const char* filename) const;
+
+    private:
+      /// A node of the phase tree, common to all threads.
+      struct Phase
+      {
+        Phase(int name, int parent);
+        /// Index to names.
+        int name;
+        int parent;
+        /// Indices of the children by the index of their name.
+        std::map<int, int> children;
+      };
+
+      /// Calls of one phase by one thread.
+      struct PhaseTime
+      {
+        PhaseTime();
+        unsigned long long calls;
+        double total_time;
+      };
+
+      /// One recorded interval.
+      struct Event
+      {
+        /// Index to names.
+        int name;
+        double start;
+        double duration;
+      };
+
+      /// Everything recorded by one thread.
+      struct ThreadRecord
+      {
+        ThreadRecord();
+        /// Indexed by the phases.
+        std::vector<PhaseTime> phase_times;
+        /// Open phases, the first one is the root.
+        /// Parents of parallel regions are here as well, but not in start_stack, event_stack.
+        std::vector<int> phase_stack;
+        std::vector<double> start_stack;
+        /// Indices of the events of the open phases (-1 if not recorded).
+        std::vector<int> event_stack;
+        std::vector<Event> events;
+        /// Indexed by names.
+        std::map<int, unsigned long long> counters;
+        /// Lookup of name indices (and the names) by the address of the string - equal strings at different addresses get the same index.
+        std::map<const char*, std::pair<int, std::string> > name_cache;
+        /// Lookup of phases by the parent and the name index.
+        std::map<std::pair<int, int>, int> phase_cache;
+      };
+
+      /// A node of the phase tree merged over threads.
+      struct MergedPhase
+      {
+        MergedPhase();
+        unsigned long long calls;
+        double total_time;
+        std::map<std::string, MergedPhase> children;
+      };
+
+      /// Record of the calling thread (created on the first use).
+      ThreadRecord* get_thread_record();
+
+      /// Index of the name (interned on the first use).
+      int get_name(ThreadRecord* record, const char* name);
+
+      /// Index of the child phase (created on the first use).
+      int get_phase(ThreadRecord* record, int parent, int name);
+
+      /// Adds the times of all threads in the subtree of the phase into the merged one.
+      void merge_phase(int phase, MergedPhase& merged) const;
+
+      /// Writes the merged phase children as a JSON array.
+      static void write_phases_json(FILE* file, const MergedPhase& merged, int indent);
+
+      /// Current time relative to the time of the last reset.
+      double get_time() const;
+
+      ThreadRecord* thread_records[HERMES_PROFILER_MAX_THREADS];
+      /// Names of the phases and counters, their indices.
+      std::vector<std::string> names;
+      std::map<std::string, int> name_indices;
+      /// The phase tree, the first one is the root.
+      std::vector<Phase> phases;
+      bool enabled;
+      unsigned int max_trace_events;
+      double time_origin;
+    };
+
+    /// Opens a phase in the constructor, closes it in the destructor.
+    class HERMES_API ProfilerScope
+    {
+    public:
+      ProfilerScope(const char* name);
+      ~ProfilerScope();
+    };
+
+    /// Enters a parallel region (Profiler::enter_parallel_region) in the constructor, leaves it in the destructor.
+    class HERMES_API ProfilerParallelRegion
+    {
+    public:
+      ProfilerParallelRegion(int parent);
+      ~ProfilerParallelRegion();
+    };
+  }
+
+  /// Global instance used inside Hermes which is also accessible to users.
+  HERMES_COMMON_API extern Hermes::Profiling::Profiler HermesProfiler;
+}
+
+#ifdef WITH_PROFILING
+#define HERMES_PROFILE_CONCATENATE_INNER(a, b) a ## b
+#define HERMES_PROFILE_CONCATENATE(a, b) HERMES_PROFILE_CONCATENATE_INNER(a, b)
+/// Profiles the rest of the enclosing block as the phase 'name'.
+#define HERMES_PROFILE_SCOPE(name) Hermes::Profiling::ProfilerScope HERMES_PROFILE_CONCATENATE(profiler_scope_, __LINE__)(name)
+/// Adds 'amount' to the counter 'name'.
+#define HERMES_PROFILE_COUNT(name, amount) Hermes::HermesProfiler.count(name, amount)
+/// Declares 'parent' - the currently open phase, to be used before "#pragma omp parallel".
+#define HERMES_PROFILE_PARENT_PHASE(parent) int parent = Hermes::HermesProfiler.get_current_phase()
+/// Nests the phases of the rest of the enclosing block (in a parallel region) in 'parent'.
+#define HERMES_PROFILE_PARALLEL_REGION(parent) Hermes::Profiling::ProfilerParallelRegion HERMES_PROFILE_CONCATENATE(profiler_parallel_region_, __LINE__)(parent)
+#else
+#define HERMES_PROFILE_SCOPE(name) do {} while (0)
+#define HERMES_PROFILE_COUNT(name, amount) do {} while (0)
+#define HERMES_PROFILE_PARENT_PHASE(parent) do {} while (0)
+#define HERMES_PROFILE_PARALLEL_REGION(parent) do {} while (0)
+#endif
+
+#endif
@@ -21,6 +21,8 @@
 */
 #include "cs_matrix.h"
 #include "util/memory_handling.h"
+#include "api.h"
+#include <algorithm>
 
 namespace Hermes
 {
@@ -46,6 +48,41 @@ namespace Hermes
       return x.imag();
     }
 
+    void inline atomic_add(double& target, double v)
+    {
+#pragma omp atomic
+      target += v;
+    }
+
+    void inline atomic_add(std::complex<double>& target, std::complex<double> v)
+    {
+      // std::complex<double> is layout-compatible with double[2], the real and imaginary parts
+      // are therefore accumulated by two independent atomic updates instead of a critical section.
+      double* parts = reinterpret_cast<double*>(&target);
+#pragma omp atomic
+      parts[0] += v.real();
+#pragma omp atomic
+      parts[1] += v.imag();
+    }
+
+    /// Maximum number of inner indices of a local matrix that CSMatrix<Scalar>::add_block() sorts on the stack.
+    /// Larger local matrices are added entry by entry.
+    static const int CS_MATRIX_MAX_BLOCK_SIZE = 512;
+
+    /// Matrices with fewer nonzeros are multiplied with vectors by one thread only.
+    static const unsigned int CS_MATRIX_MIN_PARALLEL_SPMV_NNZ = 10000;
+
+    /// Number of vectors multiplied at once by CSMatrix<Scalar>::multiply_rows().
+    static const unsigned int CS_MATRIX_SPMV_VECTOR_BLOCK = 8;
+
+    /// Inner index of a local matrix together with its position in the local matrix.
+    struct BlockIndex
+    {
+      int dof;
+      int local;
+      bool operator<(const BlockIndex& other) const { return dof < other.dof; }
+    };
+
     template<typename Scalar>
     int CSMatrix<Scalar>::find_position(int *Ai, int Alen, unsigned int idx)
     {
@@ -73,12 +110,14 @@ namespace Hermes
     }
 
     template<typename Scalar>
-    CSMatrix<Scalar>::CSMatrix() : SparseMatrix<Scalar>(), nnz(0), Ap(nullptr), Ai(nullptr), Ax(nullptr)
+    CSMatrix<Scalar>::CSMatrix() : SparseMatrix<Scalar>(), nnz(0), Ap(nullptr), Ai(nullptr), Ax(nullptr), thread_private_count(0), thread_private_Ax(nullptr), thread_private_nnz(0), thread_private_active(false),
+      transposed_Ap(nullptr), transposed_Ai(nullptr), transposed_Ax_positions(nullptr)
     {
     }
 
     template<typename Scalar>
-    CSMatrix<Scalar>::CSMatrix(unsigned int size)
+    CSMatrix<Scalar>::CSMatrix(unsigned int size) : thread_private_count(0), thread_private_Ax(nullptr), thread_private_nnz(0), thread_private_active(false),
+      transposed_Ap(nullptr), transposed_Ai(nullptr), transposed_Ax_positions(nullptr)
     {
       this->size = size;
       this->alloc();
@@ -100,6 +139,8 @@ namespace Hermes
     template<typename Scalar>
     void CSMatrix<Scalar>::alloc()
     {
+      this->free_transposed_index();
+
       // initialize the arrays Ap and Ai
       Ap = malloc_with_check<CSMatrix<Scalar>, int>(this->size + 1, this);
       int aisize = this->get_num_indices();
@@ -127,17 +168,114 @@ namespace Hermes
     void CSMatrix<Scalar>::alloc_data()
     {
       Ax = calloc_with_check<CSMatrix<Scalar>, Scalar>(nnz, this);
+
+      // New structure - the copies are allocated again in set_thread_private_accumulation() if their size does not fit.
+      this->thread_private_active = false;
+      if (this->thread_private_nnz != nnz)
+        this->free_thread_private_data();
     }
 
     template<typename Scalar>
     void CSMatrix<Scalar>::free()
     {
+      this->free_thread_private_data();
+      this->free_transposed_index();
       nnz = 0;
       free_with_check(Ap);
       free_with_check(Ai);
       free_with_check(Ax);
     }
 
+    template<typename Scalar>
+    void CSMatrix<Scalar>::alloc_thread_private_data()
+    {
+      this->thread_private_Ax = malloc_with_check<CSMatrix<Scalar>, Scalar*>(this->thread_private_count, this);
+      for (int i = 0; i < this->thread_private_count; i++)
+        this->thread_private_Ax[i] = calloc_with_check<CSMatrix<Scalar>, Scalar>(this->nnz, this);
+      this->thread_private_nnz = this->nnz;
+    }
+
+    template<typename Scalar>
+    void CSMatrix<Scalar>::free_thread_private_data()
+    {
+      if (this->thread_private_Ax)
+      {
+        for (int i = 0; i < this->thread_private_count; i++)
+          free_with_check(this->thread_private_Ax[i]);
+        free_with_check(this->thread_private_Ax);
+      }
+      this->thread_private_count = 0;
+      this->thread_private_nnz = 0;
+      this->thread_private_active = false;
+    }
+
+    template<typename Scalar>
+    Scalar* CSMatrix<Scalar>::get_accumulation_target(bool& atomic)
+    {
+      if (this->thread_private_active)
+      {
+        int thread_number = omp_get_thread_num();
+        if (thread_number < this->thread_private_count)
+        {
+          atomic = false;
+          return this->thread_private_Ax[thread_number];
+        }
+      }
+
+      atomic = true;
+      return this->Ax;
+    }
+
+    template<typename Scalar>
+    void CSMatrix<Scalar>::set_thread_private_accumulation(int num_threads, int memory_limit)
+    {
+      // Only if the data storage (Ax) is ours - subclasses may use their own.
+      // Above the memory limit the copies are not worth it, the atomic additions into Ax are used.
+      if (num_threads < 2 || !this->Ax || (double)num_threads * this->nnz * sizeof(Scalar) > memory_limit * 1048576.)
+      {
+        this->free_thread_private_data();
+        return;
+      }
+
+      if (num_threads != this->thread_private_count || this->nnz != this->thread_private_nnz)
+      {
+        this->free_thread_private_data();
+        this->thread_private_count = num_threads;
+        this->alloc_thread_private_data();
+      }
+      // Not finished (an interrupted assembling) - the copies may hold some values.
+      else if (this->thread_private_active)
+      {
+        for (int i = 0; i < this->thread_private_count; i++)
+          memset(this->thread_private_Ax[i], 0, sizeof(Scalar)* this->nnz);
+      }
+
+      this->thread_private_active = true;
+    }
+
+    template<typename Scalar>
+    void CSMatrix<Scalar>::finish()
+    {
+      if (this->thread_private_active)
+      {
+        // The copies are zeroed in the same pass, ready for the next assembling.
+        int nnz = this->nnz;
+#pragma omp parallel for num_threads(this->thread_private_count)
+        for (int i = 0; i < nnz; i++)
+        {
+          for (int thread_i = 0; thread_i < this->thread_private_count; thread_i++)
+          {
+            this->Ax[i] += this->thread_private_Ax[thread_i][i];
+            this->thread_private_Ax[thread_i][i] = Scalar(0);
+          }
+        }
+
+        this->thread_private_active = false;
+      }
+
+      SparseMatrix<Scalar>::finish();
+    }
+
     template<typename Scalar>
     void CSMatrix<Scalar>::set_row_zero(unsigned int n)
     {
@@ -149,6 +287,11 @@ namespace Hermes
     void CSMatrix<Scalar>::zero()
     {
       memset(Ax, 0, sizeof(Scalar)* nnz);
+      if (this->thread_private_active)
+      {
+        for (int i = 0; i < this->thread_private_count; i++)
+          memset(this->thread_private_Ax[i], 0, sizeof(Scalar)* nnz);
+      }
     }
 
     template<typename Scalar>
@@ -166,6 +309,7 @@ namespace Hermes
     template<typename Scalar>
     void CSMatrix<Scalar>::create(unsigned int size, unsigned int nnz, int* ap, int* ai, Scalar* ax)
     {
+      this->free_transposed_index();
       this->nnz = nnz;
       this->size = size;
       this->Ap = malloc_with_check<CSMatrix<Scalar>, int>(this->size + 1, this);
@@ -179,26 +323,29 @@ namespace Hermes
     template<typename Scalar>
     void CSMatrix<Scalar>::switch_orientation()
     {
+      this->free_transposed_index();
+
       // The variable names are so to reflect CSC -> CSR direction.
       // From the "Ap indexed by columns" to "Ap indexed by rows".
       int* tempAp = malloc_with_check<CSMatrix<Scalar>, int>(this->size + 1, this);
       int* tempAi = malloc_with_check<CSMatrix<Scalar>, int>(nnz, this);
       Scalar* tempAx = malloc_with_check<CSMatrix<Scalar>, Scalar>(nnz, this);
 
-      int run_i = 0;
-      for (int target_row = 0; target_row < this->size; target_row++)
+      // Counting sort by the target rows, traversing the source columns in order leaves the target rows sorted.
+      memset(tempAp, 0, (this->size + 1) * sizeof(int));
+      for (unsigned int i = 0; i < this->nnz; i++)
+        tempAp[this->Ai[i] + 1]++;
+      for (unsigned int target_row = 0; target_row < this->size; target_row++)
+        tempAp[target_row + 1] += tempAp[target_row];
+
+      std::vector<int> next_position(tempAp, tempAp + this->size);
+      for (unsigned int src_column = 0; src_column < this->size; src_column++)
       {
-        tempAp[target_row] = run_i;
-        for (int src_column = 0; src_column < this->size; src_column++)
+        for (int src_row = this->Ap[src_column]; src_row < this->Ap[src_column + 1]; src_row++)
         {
-          for (int src_row = this->Ap[src_column]; src_row < this->Ap[src_column + 1]; src_row++)
-          {
-            if (this->Ai[src_row] == target_row)
-            {
-              tempAi[run_i] = src_column;
-              tempAx[run_i++] = this->Ax[src_row];
-            }
-          }
+          int run_i = next_position[this->Ai[src_row]]++;
+          tempAi[run_i] = src_column;
+          tempAx[run_i] = this->Ax[src_row];
         }
       }
 
@@ -253,8 +400,8 @@ namespace Hermes
       }
     }
 
-    template<>
-    void CSMatrix<double>::add(unsigned int m, unsigned int n, double v)
+    template<typename Scalar>
+    void CSMatrix<Scalar>::add(unsigned int m, unsigned int n, Scalar v)
     {
       if (v != 0.0)   // ignore zero values.
       {
@@ -267,27 +414,102 @@ namespace Hermes
           throw Hermes::Exceptions::Exception("Sparse matrix entry not found: [%i, %i]", m, n);
         }
 
-#pragma omp atomic
-        Ax[Ap[n] + pos] += v;
+        bool atomic;
+        Scalar* target = this->get_accumulation_target(atomic);
+        if (atomic)
+          atomic_add(target[Ap[n] + pos], v);
+        else
+          target[Ap[n] + pos] += v;
       }
     }
 
-    template<>
-    void CSMatrix<std::complex<double> >::add(unsigned int m, unsigned int n, std::complex<double> v)
+    template<typename Scalar>
+    void CSMatrix<Scalar>::add(unsigned int m, unsigned int n, Scalar *mat, int *rows, int *cols, const int size)
     {
-      if (v != 0.0)   // ignore zero values.
+      this->add_block(n, m, mat, cols, rows, size, false);
+    }
+
+    template<typename Scalar>
+    void CSMatrix<Scalar>::add_block(unsigned int outer_count, unsigned int inner_count, Scalar *mat, int *outer, int *inner, const int size, bool transposed)
+    {
+      // Target - either thread-private, or shared (atomic updates).
+      bool atomic;
+      Scalar* target = this->get_accumulation_target(atomic);
+
+      // Too large to sort on the stack - entry by entry (binary search), into the same target.
+      if (inner_count > CS_MATRIX_MAX_BLOCK_SIZE)
       {
-        // Find m-th row in the n-th column.
-        int pos = find_position(Ai + Ap[n], Ap[n + 1] - Ap[n], m);
-        // Make sure we are adding to an existing non-zero entry.
-        if (pos < 0)
+        for (unsigned int o = 0; o < outer_count; o++)
         {
-          this->info("CSMatrix<Scalar>::add(): i = %d, j = %d.", m, n);
-          throw Hermes::Exceptions::Exception("Sparse matrix entry not found: [%i, %i]", m, n);
+          if (outer[o] < 0)
+            continue;
+          for (unsigned int i = 0; i < inner_count; i++)
+          {
+            Scalar v = transposed ? mat[o * size + i] : mat[i * size + o];
+            if (inner[i] < 0 || v == 0.0)
+              continue;
+
+            int pos = find_position(this->Ai + this->Ap[outer[o]], this->Ap[outer[o] + 1] - this->Ap[outer[o]], inner[i]);
+            if (pos < 0)
+            {
+              this->info("CSMatrix<Scalar>::add(): Ai index = %d, Ap index = %d.", inner[i], outer[o]);
+              throw Hermes::Exceptions::Exception("Sparse matrix entry not found: [%i, %i]", inner[i], outer[o]);
+            }
+
+            if (atomic)
+              atomic_add(target[this->Ap[outer[o]] + pos], v);
+            else
+              target[this->Ap[outer[o]] + pos] += v;
+          }
         }
+        return;
+      }
 
-#pragma omp critical (CSMatrixAdd)
-        Ax[Ap[n] + pos] += v;
+      // Sort the inner indices (without Dirichlet ones) once for all outer ones.
+      BlockIndex sorted_inner[CS_MATRIX_MAX_BLOCK_SIZE];
+      int sorted_inner_count = 0;
+      for (unsigned int i = 0; i < inner_count; i++)
+      {
+        if (inner[i] >= 0)
+        {
+          sorted_inner[sorted_inner_count].dof = inner[i];
+          sorted_inner[sorted_inner_count++].local = i;
+        }
+      }
+      std::sort(sorted_inner, sorted_inner + sorted_inner_count);
+
+      for (unsigned int o = 0; o < outer_count; o++)
+      {
+        // Dirichlet DOF.
+        if (outer[o] < 0)
+          continue;
+
+        int position = this->Ap[outer[o]];
+        int end = this->Ap[outer[o] + 1];
+        for (int i = 0; i < sorted_inner_count; i++)
+        {
+          Scalar v = transposed ? mat[o * size + sorted_inner[i].local] : mat[sorted_inner[i].local * size + o];
+
+          // Both Ai within one column (row) and sorted_inner are sorted, walk them simultaneously.
+          while (position < end && this->Ai[position] < sorted_inner[i].dof)
+            position++;
+
+          if (position < end && this->Ai[position] == sorted_inner[i].dof)
+          {
+            if (v != 0.0)
+            {
+              if (atomic)
+                atomic_add(target[position], v);
+              else
+                target[position] += v;
+            }
+          }
+          else if (v != 0.0)
+          {
+            this->info("CSMatrix<Scalar>::add(): Ai index = %d, Ap index = %d.", sorted_inner[i].dof, outer[o]);
+            throw Hermes::Exceptions::Exception("Sparse matrix entry not found: [%i, %i]", sorted_inner[i].dof, outer[o]);
+          }
+        }
       }
     }
 
@@ -337,20 +559,115 @@ namespace Hermes
     }
 
     template<typename Scalar>
-    void CSCMatrix<Scalar>::multiply_with_vector(Scalar* vector_in, Scalar*& vector_out, bool vector_out_initialized) const
+    void CSMatrix<Scalar>::free_transposed_index()
+    {
+      free_with_check(this->transposed_Ap);
+      free_with_check(this->transposed_Ai);
+      free_with_check(this->transposed_Ax_positions);
+    }
+
+    template<typename Scalar>
+    void CSMatrix<Scalar>::build_transposed_index() const
+    {
+      // The check is also done in the critical section - checking transposed_Ap outside of it would not guarantee
+      // that the arrays filled by another thread are visible to this one.
+#pragma omp critical (CSMatrixTransposedIndex)
+      {
+        if (!this->transposed_Ap)
+        {
+          int* index_Ap = calloc_with_check<int>(this->size + 1);
+          this->transposed_Ai = malloc_with_check<int>(this->nnz);
+          this->transposed_Ax_positions = malloc_with_check<int>(this->nnz);
+
+          for (unsigned int i = 0; i < this->nnz; i++)
+            index_Ap[this->Ai[i] + 1]++;
+          for (unsigned int i = 0; i < this->size; i++)
+            index_Ap[i + 1] += index_Ap[i];
+
+          // Traversing Ap in order leaves the indices in each transposed row sorted.
+          std::vector<int> next_position(index_Ap, index_Ap + this->size);
+          for (unsigned int j = 0; j < this->size; j++)
+          {
+            for (int i = this->Ap[j]; i < this->Ap[j + 1]; i++)
+            {
+              int position = next_position[this->Ai[i]]++;
+              this->transposed_Ai[position] = j;
+              this->transposed_Ax_positions[position] = i;
+            }
+          }
+
+          this->transposed_Ap = index_Ap;
+        }
+      }
+    }
+
+    template<typename Scalar>
+    void CSMatrix<Scalar>::multiply_rows(const int* row_Ap, const int* row_Ai, const int* row_Ax_positions, Scalar* vectors_in, Scalar* vectors_out, unsigned int num_vectors) const
     {
-      if (!vector_out_initialized)
-        vector_out = malloc_with_check<Scalar>(this->size);
-      memset(vector_out, 0, sizeof(Scalar)* this->size);
+      int num_threads = this->nnz < CS_MATRIX_MIN_PARALLEL_SPMV_NNZ ? 1 : HermesCommonApi.get_integral_param_value(numThreads);
+      int size = this->size;
+
+#pragma omp parallel num_threads(num_threads)
       {
-        for (int i = 0; i < this->size; i++)
+        // Contiguous block of rows with nnz / num_threads nonzeros.
+        int thread_number = omp_get_thread_num();
+        int threads_used = omp_get_num_threads();
+        int first_row = thread_number == 0 ? 0 : std::upper_bound(row_Ap, row_Ap + size + 1, (int)(((long long)this->nnz * thread_number) / threads_used)) - row_Ap - 1;
+        int last_row = std::upper_bound(row_Ap, row_Ap + size + 1, (int)(((long long)this->nnz * (thread_number + 1)) / threads_used)) - row_Ap - 1;
+        if (thread_number == threads_used - 1)
+          last_row = size;
+
+        Scalar sums[CS_MATRIX_SPMV_VECTOR_BLOCK];
+        for (unsigned int first_vector = 0; first_vector < num_vectors; first_vector += CS_MATRIX_SPMV_VECTOR_BLOCK)
         {
-          for (int j = 0; j < this->Ap[i + 1] - this->Ap[i]; j++)
-            vector_out[this->Ai[this->Ap[i] + j]] += this->Ax[this->Ap[i] + j] * vector_in[i];
+          unsigned int block_size = std::min(CS_MATRIX_SPMV_VECTOR_BLOCK, num_vectors - first_vector);
+          Scalar* block_in = vectors_in + first_vector * size;
+          Scalar* block_out = vectors_out + first_vector * size;
+
+          for (int row = first_row; row < last_row; row++)
+          {
+            for (unsigned int vector_i = 0; vector_i < block_size; vector_i++)
+              sums[vector_i] = Scalar(0);
+
+            for (int i = row_Ap[row]; i < row_Ap[row + 1]; i++)
+            {
+              Scalar value = this->Ax[row_Ax_positions ? row_Ax_positions[i] : i];
+              int column = row_Ai[i];
+              for (unsigned int vector_i = 0; vector_i < block_size; vector_i++)
+                sums[vector_i] += value * block_in[vector_i * size + column];
+            }
+
+            for (unsigned int vector_i = 0; vector_i < block_size; vector_i++)
+              block_out[vector_i * size + row] = sums[vector_i];
+          }
         }
       }
     }
 
+    template<typename Scalar>
+    void CSCMatrix<Scalar>::multiply_with_vector(Scalar* vector_in, Scalar*& vector_out, bool vector_out_initialized) const
+    {
+      this->multiply_with_vectors(vector_in, vector_out, 1, vector_out_initialized);
+    }
+
+    template<typename Scalar>
+    void CSCMatrix<Scalar>::multiply_with_vectors(Scalar* vectors_in, Scalar*& vectors_out, unsigned int num_vectors, bool vectors_out_initialized) const
+    {
+      if (!vectors_out_initialized)
+        vectors_out = malloc_with_check<Scalar>(this->size * num_vectors);
+      this->build_transposed_index();
+      this->multiply_rows(this->transposed_Ap, this->transposed_Ai, this->transposed_Ax_positions, vectors_in, vectors_out, num_vectors);
+    }
+
+    template<typename Scalar>
+    void CSCMatrix<Scalar>::get_row_index(const int*& row_Ap, const int*& row_Ai, const int*& row_Ax_positions) const
+    {
+      this->build_transposed_index();
+      row_Ap = this->transposed_Ap;
+      row_Ai = this->transposed_Ai;
+      row_Ax_positions = this->transposed_Ax_positions;
+    }
+
     static int i_coordinate(int i, int j, bool invert)
     {
       if (invert)
@@ -771,6 +1088,34 @@ namespace Hermes
       CSMatrix<std::complex<double> >::add(n, m, v);
     }
 
+    template<typename Scalar>
+    void CSRMatrix<Scalar>::add(unsigned int m, unsigned int n, Scalar *mat, int *rows, int *cols, const int size)
+    {
+      this->add_block(m, n, mat, rows, cols, size, true);
+    }
+
+    template<typename Scalar>
+    void CSRMatrix<Scalar>::multiply_with_vector(Scalar* vector_in, Scalar*& vector_out, bool vector_out_initialized) const
+    {
+      this->multiply_with_vectors(vector_in, vector_out, 1, vector_out_initialized);
+    }
+
+    template<typename Scalar>
+    void CSRMatrix<Scalar>::multiply_with_vectors(Scalar* vectors_in, Scalar*& vectors_out, unsigned int num_vectors, bool vectors_out_initialized) const
+    {
+      if (!vectors_out_initialized)
+        vectors_out = malloc_with_check<Scalar>(this->size * num_vectors);
+      this->multiply_rows(this->Ap, this->Ai, nullptr, vectors_in, vectors_out, num_vectors);
+    }
+
+    template<typename Scalar>
+    void CSRMatrix<Scalar>::get_row_index(const int*& row_Ap, const int*& row_Ai, const int*& row_Ax_positions) const
+    {
+      row_Ap = this->Ap;
+      row_Ai = this->Ai;
+      row_Ax_positions = nullptr;
+    }
+
     template<typename Scalar>
     Scalar CSRMatrix<Scalar>::get(unsigned int m, unsigned int n) const
     {
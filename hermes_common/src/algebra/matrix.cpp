@@ -72,6 +72,18 @@ namespace Hermes
       }
     }
 
+    template<typename Scalar>
+    void Matrix<Scalar>::multiply_with_vectors(Scalar* vectors_in, Scalar*& vectors_out, unsigned int num_vectors, bool vectors_out_initialized) const
+    {
+      if (!vectors_out_initialized)
+        vectors_out = malloc_with_check<Scalar>(this->size * num_vectors);
+      for (unsigned int i = 0; i < num_vectors; i++)
+      {
+        Scalar* vector_out = vectors_out + i * this->size;
+        this->multiply_with_vector(vectors_in + i * this->size, vector_out, true);
+      }
+    }
+
     template<typename Scalar>
     void Matrix<Scalar>::multiply_with_Scalar(Scalar value)
     {
@@ -365,6 +377,12 @@ namespace Hermes
 #endif
         break;
       }
+      case Hermes::SOLVER_NATIVE_ITERATIVE:
+      {
+        if (use_direct_solver)
+          throw Hermes::Exceptions::Exception("The native iterative solver selected as a direct solver.");
+        return new CSRMatrix < double > ;
+      }
       case Hermes::SOLVER_SUPERLU:
       {
 #ifdef WITH_SUPERLU
@@ -450,6 +468,12 @@ namespace Hermes
 #endif
         break;
       }
+      case Hermes::SOLVER_NATIVE_ITERATIVE:
+      {
+        if (use_direct_solver)
+          throw Hermes::Exceptions::Exception("The native iterative solver selected as a direct solver.");
+        return new CSRMatrix < std::complex<double>  > ;
+      }
       case Hermes::SOLVER_SUPERLU:
       {
 #ifdef WITH_SUPERLU
@@ -461,8 +461,15 @@ namespace Hermes
     template<>
     void SimpleVector<std::complex<double> >::add(unsigned int idx, std::complex<double> y)
     {
-#pragma omp critical (SimpleVector_add)
-      this->v[idx] += y;
+      if (y != 0.0)
+      {
+        // Real and imaginary parts accumulated separately, see CSMatrix<std::complex<double> >::add().
+        double* target = reinterpret_cast<double*>(&this->v[idx]);
+#pragma omp atomic
+        target[0] += y.real();
+#pragma omp atomic
+        target[1] += y.imag();
+      }
     }
 
     template<typename Scalar>
@@ -596,6 +603,12 @@ namespace Hermes
 #endif
         break;
       }
+      case Hermes::SOLVER_NATIVE_ITERATIVE:
+      {
+        if (use_direct_solver)
+          throw Hermes::Exceptions::Exception("The native iterative solver selected as a direct solver.");
+        return new SimpleVector < double > ;
+      }
       case Hermes::SOLVER_SUPERLU:
       {
 #ifdef WITH_SUPERLU
@@ -683,6 +696,12 @@ namespace Hermes
 #endif
         break;
       }
+      case Hermes::SOLVER_NATIVE_ITERATIVE:
+      {
+        if (use_direct_solver)
+          throw Hermes::Exceptions::Exception("The native iterative solver selected as a direct solver.");
+        return new SimpleVector < std::complex<double>  > ;
+      }
       case Hermes::SOLVER_SUPERLU:
       {
 #ifdef WITH_SUPERLU
@@ -74,6 +74,8 @@ namespace Hermes
 #endif
     this->parameters.insert(std::pair<HermesCommonApiParam, Parameter*>(Hermes::useAccelerators, new Parameter(1)));
     this->parameters.insert(std::pair<HermesCommonApiParam, Parameter*>(Hermes::checkMeshesOnLoad, new Parameter(1)));
+    this->parameters.insert(std::pair<HermesCommonApiParam, Parameter*>(Hermes::useThreadPrivateAccumulation, new Parameter(1)));
+    this->parameters.insert(std::pair<HermesCommonApiParam, Parameter*>(Hermes::threadPrivateAccumulationMemoryLimit, new Parameter(1024)));
 
     // Set handlers.
 #ifdef WITH_PARALUTION
@@ -197,6 +197,12 @@ namespace Hermes
       jcn[pos] = n + 1;
     }
 
+    template<typename Scalar>
+    void MumpsMatrix<Scalar>::add(unsigned int m, unsigned int n, Scalar *mat, int *rows, int *cols, const int size)
+    {
+      Matrix<Scalar>::add(m, n, mat, rows, cols, size);
+    }
+
     template<typename Scalar>
     void MumpsMatrix<Scalar>::export_to_file(const char *filename, const char *var_name, MatrixExportFormat fmt, char* number_format)
     {
@@ -24,6 +24,7 @@
 #include "umfpack_solver.h"
 #include "common.h"
 #include "util/memory_handling.h"
+#include "util/profiler.h"
 
 #define umfpack_real_symbolic umfpack_di_symbolic
 #define umfpack_real_numeric umfpack_di_numeric
@@ -71,6 +72,8 @@ namespace Hermes
     template<>
     bool UMFPackLinearMatrixSolver<double>::setup_factorization()
     {
+      HERMES_PROFILE_SCOPE("factorization");
+
       // Perform both factorization phases for the first time.
       if (reuse_scheme != HERMES_CREATE_STRUCTURE_FROM_SCRATCH && symbolic == nullptr && numeric == nullptr)
         reuse_scheme = HERMES_CREATE_STRUCTURE_FROM_SCRATCH;
@@ -120,6 +123,8 @@ namespace Hermes
     template<>
     bool UMFPackLinearMatrixSolver<std::complex<double> >::setup_factorization()
     {
+      HERMES_PROFILE_SCOPE("factorization");
+
       // Perform both factorization phases for the first time.
       int eff_fact_scheme;
       if (reuse_scheme != HERMES_CREATE_STRUCTURE_FROM_SCRATCH && symbolic == nullptr && numeric == nullptr)
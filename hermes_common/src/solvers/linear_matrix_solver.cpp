@@ -27,6 +27,7 @@
 #include "solvers/interfaces/mumps_solver.h"
 #include "solvers/interfaces/aztecoo_solver.h"
 #include "solvers/interfaces/paralution_solver.h"
+#include "solvers/native_iterative_solver.h"
 #include "api.h"
 #include "exceptions.h"
 #include "util/memory_handling.h"
@@ -265,6 +266,13 @@ namespace Hermes
 #endif
         break;
       }
+      case Hermes::SOLVER_NATIVE_ITERATIVE:
+      {
+        if (use_direct_solver)
+          throw Hermes::Exceptions::Exception("The native iterative solver selected as a direct solver.");
+        if (rhs != nullptr) return new NativeIterativeLinearMatrixSolver<double>(static_cast<CSMatrix<double>*>(matrix), static_cast<SimpleVector<double>*>(rhs));
+        else return new NativeIterativeLinearMatrixSolver<double>(static_cast<CSMatrix<double>*>(matrix), static_cast<SimpleVector<double>*>(rhs_dummy));
+      }
       case Hermes::SOLVER_SUPERLU:
       {
 #ifdef WITH_SUPERLU
@@ -360,6 +368,13 @@ namespace Hermes
 #endif
         break;
       }
+      case Hermes::SOLVER_NATIVE_ITERATIVE:
+      {
+        if (use_direct_solver)
+          throw Hermes::Exceptions::Exception("The native iterative solver selected as a direct solver.");
+        if (rhs != nullptr) return new NativeIterativeLinearMatrixSolver<std::complex<double> >(static_cast<CSMatrix<std::complex<double> >*>(matrix), static_cast<SimpleVector<std::complex<double> >*>(rhs));
+        else return new NativeIterativeLinearMatrixSolver<std::complex<double> >(static_cast<CSMatrix<std::complex<double> >*>(matrix), static_cast<SimpleVector<std::complex<double> >*>(rhs_dummy));
+      }
       case Hermes::SOLVER_SUPERLU:
       {
 #ifdef WITH_SUPERLU
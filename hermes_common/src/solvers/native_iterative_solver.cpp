@@ -0,0 +1,751 @@
+// This file is part of HermesCommon
+//
+// Copyright (c) 2009 hp-FEM group at the University of Nevada, Reno (UNR).
+// Email: hpfem-group@unr.edu, home page: http://www.hpfem.org/.
+//
+// Hermes is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published
+// by the Free Software Foundation; either version 2 of the License,
+// or (at your option) any later version.
+//
+// Hermes is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with Hermes; if not, write to the Free Software
+// Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+/*! \file native_iterative_solver.cpp
+\brief Built-in (OpenMP-parallel) Krylov solvers working directly on CS matrices.
+*/
+#include "native_iterative_solver.h"
+#include "common.h"
+#include "api.h"
+#include "util/memory_handling.h"
+
+namespace Hermes
+{
+  /// Vector operations used by the solvers.
+  /// The reductions are summed up in the order of threads, so that the results do not depend on timing.
+  template<typename Scalar>
+  static Scalar vector_dot(int size, const Scalar* a, const Scalar* b, int num_threads)
+  {
+    std::vector<Scalar> partial_sums(num_threads, Scalar(0));
+#pragma omp parallel num_threads(num_threads)
+    {
+      Scalar partial_sum = Scalar(0);
+#pragma omp for schedule(static)
+      for (int i = 0; i < size; i++)
+        partial_sum += conj(a[i]) * b[i];
+      partial_sums[omp_get_thread_num()] = partial_sum;
+    }
+
+    Scalar result = Scalar(0);
+    for (int i = 0; i < num_threads; i++)
+      result += partial_sums[i];
+    return result;
+  }
+
+  template<typename Scalar>
+  static double vector_norm(int size, const Scalar* a, int num_threads)
+  {
+    return std::sqrt(std::abs(vector_dot(size, a, a, num_threads)));
+  }
+
+  /// y = y + alpha * x
+  template<typename Scalar>
+  static void vector_axpy(int size, Scalar alpha, const Scalar* x, Scalar* y, int num_threads)
+  {
+#pragma omp parallel for schedule(static) num_threads(num_threads)
+    for (int i = 0; i < size; i++)
+      y[i] += alpha * x[i];
+  }
+
+  /// y = x + beta * y
+  template<typename Scalar>
+  static void vector_xpby(int size, const Scalar* x, Scalar beta, Scalar* y, int num_threads)
+  {
+#pragma omp parallel for schedule(static) num_threads(num_threads)
+    for (int i = 0; i < size; i++)
+      y[i] = x[i] + beta * y[i];
+  }
+
+  namespace Preconditioners
+  {
+    /// Minimum average number of rows in a level for the level-scheduled triangular solves to run in parallel,
+    /// narrower levels do not pay for the synchronization after each level.
+    static const int NATIVE_PRECOND_MIN_PARALLEL_LEVEL_WIDTH = 64;
+
+    template<typename Scalar>
+    NativePrecond<Scalar>::NativePrecond(PreconditionerType preconditionerType, double omega) : preconditionerType(preconditionerType), applied_type(preconditionerType), omega(omega),
+      size(0), Ap(nullptr), Ai(nullptr), diag_position(nullptr), inv_diag(nullptr), values(nullptr)
+    {
+      if (preconditionerType != Jacobi && preconditionerType != ILU && preconditionerType != SSOR)
+        throw Hermes::Exceptions::Exception("Only Jacobi, ILU and SSOR preconditioners are supported by NativePrecond.");
+      if (preconditionerType == SSOR && (omega <= 0. || omega >= 2.))
+        throw Hermes::Exceptions::ValueException("omega", omega, 0., 2.);
+    }
+
+    template<typename Scalar>
+    NativePrecond<Scalar>::~NativePrecond()
+    {
+      this->free();
+    }
+
+    template<typename Scalar>
+    void NativePrecond<Scalar>::free()
+    {
+      free_with_check(this->diag_position);
+      free_with_check(this->inv_diag);
+      free_with_check(this->values);
+      this->lower_level_Ap.clear();
+      this->lower_level_rows.clear();
+      this->upper_level_Ap.clear();
+      this->upper_level_rows.clear();
+      this->size = 0;
+      this->Ap = nullptr;
+      this->Ai = nullptr;
+    }
+
+    template<typename Scalar>
+    bool NativePrecond<Scalar>::is_computed() const
+    {
+      return this->Ap != nullptr;
+    }
+
+    template<typename Scalar>
+    PreconditionerType NativePrecond<Scalar>::get_type() const
+    {
+      return this->preconditionerType;
+    }
+
+    template<typename Scalar>
+    PreconditionerType NativePrecond<Scalar>::get_applied_type() const
+    {
+      return this->applied_type;
+    }
+
+    template<typename Scalar>
+    void NativePrecond<Scalar>::compute_levels(bool upper, std::vector<int>& level_Ap, std::vector<int>& level_rows) const
+    {
+      // Level of a row = 1 + the maximum level of the rows its off-diagonal entries in the triangle refer to.
+      std::vector<int> row_levels(this->size);
+      int level_count = 0;
+      for (int k = 0; k < this->size; k++)
+      {
+        int i = upper ? this->size - 1 - k : k;
+        int first = upper ? this->diag_position[i] + 1 : this->Ap[i];
+        int last = upper ? this->Ap[i + 1] : this->diag_position[i];
+        int level = 0;
+        for (int p = first; p < last; p++)
+          level = std::max(level, row_levels[this->Ai[p]] + 1);
+        row_levels[i] = level;
+        level_count = std::max(level_count, level + 1);
+      }
+
+      // Counting sort of the rows by levels.
+      level_Ap.assign(level_count + 1, 0);
+      for (int i = 0; i < this->size; i++)
+        level_Ap[row_levels[i] + 1]++;
+      for (int level = 0; level < level_count; level++)
+        level_Ap[level + 1] += level_Ap[level];
+      level_rows.resize(this->size);
+      std::vector<int> next_position(level_Ap.begin(), level_Ap.end() - 1);
+      for (int i = 0; i < this->size; i++)
+        level_rows[next_position[row_levels[i]]++] = i;
+    }
+
+    template<typename Scalar>
+    void NativePrecond<Scalar>::setup(int size, const int* Ap, const int* Ai, const int* Ax_positions, const Scalar* Ax)
+    {
+      this->free();
+      this->size = size;
+      this->Ap = Ap;
+      this->Ai = Ai;
+      this->applied_type = this->preconditionerType;
+
+      // Values in the row-wise order.
+      int nnz = Ap[size];
+      this->values = malloc_with_check<Scalar>(nnz);
+      for (int p = 0; p < nnz; p++)
+        this->values[p] = Ax[Ax_positions ? Ax_positions[p] : p];
+
+      // Diagonal positions.
+      int zero_diagonal_count = 0;
+      this->diag_position = malloc_with_check<int>(size);
+      for (int i = 0; i < size; i++)
+      {
+        this->diag_position[i] = -1;
+        for (int p = Ap[i]; p < Ap[i + 1]; p++)
+        {
+          if (Ai[p] == i)
+          {
+            this->diag_position[i] = p;
+            break;
+          }
+        }
+        if (this->diag_position[i] == -1 || this->values[this->diag_position[i]] == Scalar(0))
+          zero_diagonal_count++;
+      }
+
+      // Saddle-point systems (e.g. the pressure block of Navier-Stokes) - only Jacobi is possible.
+      if (zero_diagonal_count > 0 && this->applied_type != Jacobi)
+      {
+        this->warn("%i zero or missing diagonal entries, %s can not be computed, using Jacobi instead.", zero_diagonal_count, this->applied_type == ILU ? "ILU(0)" : "SSOR");
+        this->applied_type = Jacobi;
+      }
+
+      if (this->applied_type == ILU)
+      {
+        Scalar* LU = this->values;
+
+        // ILU(0) - IKJ variant restricted to the sparsity pattern, column indices in rows are sorted.
+        for (int i = 1; i < size; i++)
+        {
+          for (int p = Ap[i]; p < this->diag_position[i]; p++)
+          {
+            int k = Ai[p];
+            LU[p] /= LU[this->diag_position[k]];
+            Scalar l_ik = LU[p];
+
+            // Row i (entries right of p) -= l_ik * row k (entries right of the diagonal).
+            int p_i = p + 1;
+            for (int p_k = this->diag_position[k] + 1; p_k < Ap[k + 1]; p_k++)
+            {
+              while (p_i < Ap[i + 1] && Ai[p_i] < Ai[p_k])
+                p_i++;
+              if (p_i == Ap[i + 1])
+                break;
+              if (Ai[p_i] == Ai[p_k])
+                LU[p_i] -= l_ik * LU[p_k];
+            }
+          }
+          if (LU[this->diag_position[i]] == Scalar(0))
+          {
+            this->warn("Zero pivot in row %i of the ILU(0) factorization, using Jacobi instead.", i);
+            this->applied_type = Jacobi;
+            break;
+          }
+        }
+      }
+
+      if (this->applied_type == Jacobi || this->applied_type == SSOR)
+      {
+        // Rows with a zero (or missing) diagonal entry are not scaled.
+        if (zero_diagonal_count > 0 && this->preconditionerType == Jacobi)
+          this->warn("%i zero or missing diagonal entries, these rows are not scaled by the Jacobi preconditioner.", zero_diagonal_count);
+        // From Ax - values may hold an interrupted ILU(0) factorization.
+        this->inv_diag = malloc_with_check<Scalar>(size);
+        for (int i = 0; i < size; i++)
+        {
+          Scalar diagonal = this->diag_position[i] == -1 ? Scalar(0) : Ax[Ax_positions ? Ax_positions[this->diag_position[i]] : this->diag_position[i]];
+          this->inv_diag[i] = (diagonal == Scalar(0)) ? Scalar(1) : Scalar(1) / diagonal;
+        }
+      }
+
+      if (this->applied_type == Jacobi)
+        free_with_check(this->values);
+      else
+      {
+        this->compute_levels(false, this->lower_level_Ap, this->lower_level_rows);
+        this->compute_levels(true, this->upper_level_Ap, this->upper_level_rows);
+      }
+    }
+
+    template<typename Scalar>
+    void NativePrecond<Scalar>::apply(Scalar* r, Scalar* z) const
+    {
+      int num_threads = HermesCommonApi.get_integral_param_value(numThreads);
+
+      if (this->applied_type == Jacobi)
+      {
+#pragma omp parallel for schedule(static) num_threads(num_threads)
+        for (int i = 0; i < this->size; i++)
+          z[i] = this->inv_diag[i] * r[i];
+        return;
+      }
+
+      bool ilu = (this->applied_type == ILU);
+      int level_count = std::max(this->lower_level_Ap.size(), this->upper_level_Ap.size()) - 1;
+      if (this->size < NATIVE_PRECOND_MIN_PARALLEL_LEVEL_WIDTH * level_count)
+        num_threads = 1;
+
+      // ILU: L y = r (unit diagonal), U z = y.
+      // SSOR: M = 1 / (omega (2 - omega)) (D + omega L) D^{-1} (D + omega U).
+      // The rows of a level are independent, the implicit barrier at the end of each omp for separates the levels.
+#pragma omp parallel num_threads(num_threads)
+      {
+        for (int level = 0; level < (int)this->lower_level_Ap.size() - 1; level++)
+        {
+#pragma omp for schedule(static)
+          for (int level_i = this->lower_level_Ap[level]; level_i < this->lower_level_Ap[level + 1]; level_i++)
+          {
+            int i = this->lower_level_rows[level_i];
+            Scalar sum = Scalar(0);
+            for (int p = this->Ap[i]; p < this->diag_position[i]; p++)
+              sum += this->values[p] * z[this->Ai[p]];
+            if (ilu)
+              z[i] = r[i] - sum;
+            else
+              z[i] = (r[i] - this->omega * sum) * this->inv_diag[i];
+          }
+        }
+
+        for (int level = 0; level < (int)this->upper_level_Ap.size() - 1; level++)
+        {
+#pragma omp for schedule(static)
+          for (int level_i = this->upper_level_Ap[level]; level_i < this->upper_level_Ap[level + 1]; level_i++)
+          {
+            int i = this->upper_level_rows[level_i];
+            Scalar sum = Scalar(0);
+            for (int p = this->diag_position[i] + 1; p < this->Ap[i + 1]; p++)
+              sum += this->values[p] * z[this->Ai[p]];
+            if (ilu)
+              z[i] = (z[i] - sum) / this->values[this->diag_position[i]];
+            else
+              z[i] -= this->omega * sum * this->inv_diag[i];
+          }
+        }
+
+        if (!ilu)
+        {
+#pragma omp for schedule(static)
+          for (int i = 0; i < this->size; i++)
+            z[i] *= this->omega * (2. - this->omega);
+        }
+      }
+    }
+
+    template class HERMES_API NativePrecond < double > ;
+    template class HERMES_API NativePrecond < std::complex<double> > ;
+  }
+
+  namespace Solvers
+  {
+    template<typename Scalar>
+    NativeIterativeLinearMatrixSolver<Scalar>::NativeIterativeLinearMatrixSolver(CSMatrix<Scalar> *matrix, SimpleVector<Scalar> *rhs) : IterSolver<Scalar>(matrix, rhs), LoopSolver<Scalar>(matrix, rhs),
+      matrix(matrix), rhs(rhs), preconditioner(nullptr), gmres_restart(30), num_iters(0), final_residual(0.), num_threads(1)
+    {
+      this->set_max_iters(1000);
+      this->set_tolerance(1e-8, AbsoluteTolerance);
+      // Matrices coming from assembling are in general not symmetric.
+      this->iterSolverType = GMRES;
+      this->set_precond(new Preconditioners::NativePrecond<Scalar>(ILU));
+    }
+
+    template<typename Scalar>
+    NativeIterativeLinearMatrixSolver<Scalar>::~NativeIterativeLinearMatrixSolver()
+    {
+      this->free();
+      if (this->preconditioner)
+        delete this->preconditioner;
+    }
+
+    template<typename Scalar>
+    void NativeIterativeLinearMatrixSolver<Scalar>::free()
+    {
+      if (this->preconditioner)
+        this->preconditioner->free();
+
+      free_with_check(this->sln);
+    }
+
+    template<typename Scalar>
+    void NativeIterativeLinearMatrixSolver<Scalar>::set_precond(Precond<Scalar> *pc)
+    {
+      Preconditioners::NativePrecond<Scalar>* native_pc = dynamic_cast<Preconditioners::NativePrecond<Scalar>*>(pc);
+      if (pc && !native_pc)
+        throw Hermes::Exceptions::Exception("A wrong preconditioner type passed to NativeIterativeLinearMatrixSolver, use NativePrecond.");
+
+      if (this->preconditioner && this->preconditioner != native_pc)
+        delete this->preconditioner;
+      this->preconditioner = native_pc;
+      this->precond_yes = (native_pc != nullptr);
+
+      // Force the preconditioner computation.
+      if (this->reuse_scheme == HERMES_REUSE_MATRIX_STRUCTURE_COMPLETELY)
+        this->reuse_scheme = HERMES_REUSE_MATRIX_REORDERING;
+    }
+
+    template<typename Scalar>
+    void NativeIterativeLinearMatrixSolver<Scalar>::set_gmres_restart(int restart)
+    {
+      if (restart < 1)
+        throw Hermes::Exceptions::ValueException("restart", restart, 1);
+      this->gmres_restart = restart;
+    }
+
+    template<typename Scalar>
+    int NativeIterativeLinearMatrixSolver<Scalar>::get_matrix_size()
+    {
+      return this->matrix->get_size();
+    }
+
+    template<typename Scalar>
+    int NativeIterativeLinearMatrixSolver<Scalar>::get_num_iters()
+    {
+      return this->num_iters;
+    }
+
+    template<typename Scalar>
+    double NativeIterativeLinearMatrixSolver<Scalar>::get_residual_norm()
+    {
+      return this->final_residual;
+    }
+
+    template<typename Scalar>
+    void NativeIterativeLinearMatrixSolver<Scalar>::setup()
+    {
+      if (!this->preconditioner)
+        return;
+
+      // The matrix (and so the preconditioner) has not changed.
+      if (this->reuse_scheme == HERMES_REUSE_MATRIX_STRUCTURE_COMPLETELY && this->preconditioner->is_computed())
+        return;
+
+      const int* row_Ap;
+      const int* row_Ai;
+      const int* row_Ax_positions;
+      this->matrix->get_row_index(row_Ap, row_Ai, row_Ax_positions);
+      this->preconditioner->setup(this->matrix->get_size(), row_Ap, row_Ai, row_Ax_positions, this->matrix->get_Ax());
+    }
+
+    template<typename Scalar>
+    void NativeIterativeLinearMatrixSolver<Scalar>::spmv(Scalar* x, Scalar* y) const
+    {
+      this->matrix->multiply_with_vector(x, y, true);
+    }
+
+    template<typename Scalar>
+    void NativeIterativeLinearMatrixSolver<Scalar>::precondition(Scalar* r, Scalar* z) const
+    {
+      if (this->preconditioner)
+        this->preconditioner->apply(r, z);
+      else
+        memcpy(z, r, this->matrix->get_size() * sizeof(Scalar));
+    }
+
+    template<typename Scalar>
+    bool NativeIterativeLinearMatrixSolver<Scalar>::converged(double residual_norm, double b_norm, double initial_residual_norm) const
+    {
+      switch (this->toleranceType)
+      {
+      case AbsoluteTolerance:
+        return residual_norm <= this->tolerance;
+      case RelativeTolerance:
+        return residual_norm <= this->tolerance * b_norm;
+      case DivergenceTolerance:
+        // Only stop when diverging, the result is then the last iterate.
+        return this->num_iters > 0 && residual_norm >= this->tolerance * initial_residual_norm;
+      }
+      return false;
+    }
+
+    template<typename Scalar>
+    void NativeIterativeLinearMatrixSolver<Scalar>::solve()
+    {
+      this->solve(nullptr);
+    }
+
+    template<typename Scalar>
+    void NativeIterativeLinearMatrixSolver<Scalar>::solve(Scalar* initial_guess)
+    {
+      assert(this->matrix != nullptr);
+      assert(this->rhs != nullptr);
+      assert(this->matrix->get_size() == this->rhs->get_size());
+
+      this->tick();
+
+      int size = this->matrix->get_size();
+      this->num_threads = HermesCommonApi.get_integral_param_value(numThreads);
+      this->num_iters = 0;
+
+      // Handle sln.
+      if (this->sln && this->sln != initial_guess)
+        free_with_check(this->sln);
+      this->sln = malloc_with_check<NativeIterativeLinearMatrixSolver<Scalar>, Scalar>(size, this);
+
+      // Create initial guess.
+      if (initial_guess)
+        memcpy(this->sln, initial_guess, size * sizeof(Scalar));
+      else
+        memset(this->sln, 0, size * sizeof(Scalar));
+
+      // Handle the situation when rhs == 0(vector).
+      double b_norm = vector_norm(size, this->rhs->v, this->num_threads);
+      if (b_norm < Hermes::HermesEpsilon)
+      {
+        memset(this->sln, 0, size * sizeof(Scalar));
+        this->final_residual = 0.;
+        this->tick();
+        this->time = this->accumulated();
+        return;
+      }
+
+      this->setup();
+
+      bool success = false;
+      switch (this->iterSolverType)
+      {
+      case CG:
+        success = this->solve_cg(this->sln, b_norm);
+        break;
+      case GMRES:
+        success = this->solve_gmres(this->sln, b_norm);
+        break;
+      case BiCGStab:
+        success = this->solve_bicgstab(this->sln, b_norm);
+        break;
+      default:
+        throw Hermes::Exceptions::Exception("A wrong solver type detected in NativeIterativeLinearMatrixSolver, only CG, GMRES and BiCGStab are supported.");
+      }
+
+      this->warn_if(!success, "NativeIterativeLinearMatrixSolver did not converge in %i iterations, residual norm: %g.", this->num_iters, this->final_residual);
+
+      this->tick();
+      this->time = this->accumulated();
+    }
+
+    template<typename Scalar>
+    bool NativeIterativeLinearMatrixSolver<Scalar>::solve_cg(Scalar* x, double b_norm)
+    {
+      int size = this->matrix->get_size();
+      std::vector<Scalar> r(size), z(size), p(size), q(size);
+
+      // r = b - A x
+      this->spmv(x, &q[0]);
+      for (int i = 0; i < size; i++)
+        r[i] = this->rhs->v[i] - q[i];
+
+      double initial_residual = vector_norm(size, &r[0], this->num_threads);
+      this->final_residual = initial_residual;
+      if (this->converged(this->final_residual, b_norm, initial_residual))
+        return true;
+
+      this->precondition(&r[0], &z[0]);
+      p = z;
+      Scalar rz = vector_dot(size, &r[0], &z[0], this->num_threads);
+
+      while (this->num_iters < this->max_iters)
+      {
+        this->spmv(&p[0], &q[0]);
+        Scalar alpha = rz / vector_dot(size, &p[0], &q[0], this->num_threads);
+        vector_axpy(size, alpha, &p[0], x, this->num_threads);
+        vector_axpy(size, -alpha, &q[0], &r[0], this->num_threads);
+
+        this->num_iters++;
+        this->final_residual = vector_norm(size, &r[0], this->num_threads);
+        if (this->converged(this->final_residual, b_norm, initial_residual))
+          return true;
+
+        this->precondition(&r[0], &z[0]);
+        Scalar rz_new = vector_dot(size, &r[0], &z[0], this->num_threads);
+        Scalar beta = rz_new / rz;
+        rz = rz_new;
+        vector_xpby(size, &z[0], beta, &p[0], this->num_threads);
+      }
+
+      return false;
+    }
+
+    template<typename Scalar>
+    bool NativeIterativeLinearMatrixSolver<Scalar>::solve_bicgstab(Scalar* x, double b_norm)
+    {
+      int size = this->matrix->get_size();
+      std::vector<Scalar> r(size), r_hat(size), p(size, Scalar(0)), v(size, Scalar(0)), p_hat(size), s(size), s_hat(size), t(size);
+
+      // r = b - A x
+      this->spmv(x, &t[0]);
+      for (int i = 0; i < size; i++)
+        r[i] = this->rhs->v[i] - t[i];
+      r_hat = r;
+
+      double initial_residual = vector_norm(size, &r[0], this->num_threads);
+      this->final_residual = initial_residual;
+      if (this->converged(this->final_residual, b_norm, initial_residual))
+        return true;
+
+      Scalar rho = Scalar(1), alpha = Scalar(1), omega = Scalar(1);
+      while (this->num_iters < this->max_iters)
+      {
+        Scalar rho_new = vector_dot(size, &r_hat[0], &r[0], this->num_threads);
+        if (rho_new == Scalar(0))
+        {
+          this->warn("BiCGStab breakdown (rho = 0).");
+          return false;
+        }
+
+        Scalar beta = (rho_new / rho) * (alpha / omega);
+        rho = rho_new;
+
+        // p = r + beta (p - omega v)
+#pragma omp parallel for schedule(static) num_threads(this->num_threads)
+        for (int i = 0; i < size; i++)
+          p[i] = r[i] + beta * (p[i] - omega * v[i]);
+
+        this->precondition(&p[0], &p_hat[0]);
+        this->spmv(&p_hat[0], &v[0]);
+        alpha = rho / vector_dot(size, &r_hat[0], &v[0], this->num_threads);
+
+        // s = r - alpha v
+#pragma omp parallel for schedule(static) num_threads(this->num_threads)
+        for (int i = 0; i < size; i++)
+          s[i] = r[i] - alpha * v[i];
+
+        this->num_iters++;
+        double s_norm = vector_norm(size, &s[0], this->num_threads);
+        if (this->converged(s_norm, b_norm, initial_residual))
+        {
+          vector_axpy(size, alpha, &p_hat[0], x, this->num_threads);
+          this->final_residual = s_norm;
+          return true;
+        }
+
+        this->precondition(&s[0], &s_hat[0]);
+        this->spmv(&s_hat[0], &t[0]);
+        omega = vector_dot(size, &t[0], &s[0], this->num_threads) / vector_dot(size, &t[0], &t[0], this->num_threads);
+
+        // x = x + alpha p_hat + omega s_hat, r = s - omega t
+#pragma omp parallel for schedule(static) num_threads(this->num_threads)
+        for (int i = 0; i < size; i++)
+        {
+          x[i] += alpha * p_hat[i] + omega * s_hat[i];
+          r[i] = s[i] - omega * t[i];
+        }
+
+        this->final_residual = vector_norm(size, &r[0], this->num_threads);
+        if (this->converged(this->final_residual, b_norm, initial_residual))
+          return true;
+
+        if (omega == Scalar(0))
+        {
+          this->warn("BiCGStab breakdown (omega = 0).");
+          return false;
+        }
+      }
+
+      return false;
+    }
+
+    template<typename Scalar>
+    bool NativeIterativeLinearMatrixSolver<Scalar>::solve_gmres(Scalar* x, double b_norm)
+    {
+      int size = this->matrix->get_size();
+      int m = this->gmres_restart;
+
+      // Krylov basis, Hessenberg matrix (column-wise, m + 1 rows), Givens rotations, rhs of the least squares problem.
+      std::vector<Scalar> V((m + 1) * size), H((m + 1) * m), cs(m), sn(m), g(m + 1), y(m);
+      std::vector<Scalar> w(size), z(size);
+
+      // r = b - A x
+      this->spmv(x, &w[0]);
+      for (int i = 0; i < size; i++)
+        V[i] = this->rhs->v[i] - w[i];
+      double beta = vector_norm(size, &V[0], this->num_threads);
+      double initial_residual = beta;
+      this->final_residual = beta;
+
+      while (true)
+      {
+        if (this->converged(beta, b_norm, initial_residual))
+          return true;
+        if (this->num_iters >= this->max_iters)
+          return false;
+
+        // V_0 = r / beta
+        for (int i = 0; i < size; i++)
+          V[i] /= beta;
+        std::fill(g.begin(), g.end(), Scalar(0));
+        g[0] = beta;
+
+        int k = 0;
+        bool inner_converged = false;
+        while (k < m && this->num_iters < this->max_iters && !inner_converged)
+        {
+          Scalar* V_k = &V[k * size];
+          Scalar* V_k1 = &V[(k + 1) * size];
+          Scalar* H_k = &H[k * (m + 1)];
+
+          // w = A M^{-1} V_k
+          this->precondition(V_k, &z[0]);
+          this->spmv(&z[0], &w[0]);
+
+          // Modified Gram-Schmidt.
+          for (int j = 0; j <= k; j++)
+          {
+            H_k[j] = vector_dot(size, &V[j * size], &w[0], this->num_threads);
+            vector_axpy(size, -H_k[j], &V[j * size], &w[0], this->num_threads);
+          }
+          double h_norm = vector_norm(size, &w[0], this->num_threads);
+          H_k[k + 1] = h_norm;
+          if (h_norm > 0.)
+          {
+#pragma omp parallel for schedule(static) num_threads(this->num_threads)
+            for (int i = 0; i < size; i++)
+              V_k1[i] = w[i] / h_norm;
+          }
+
+          // Apply the previous rotations.
+          for (int j = 0; j < k; j++)
+          {
+            Scalar temp = cs[j] * H_k[j] + sn[j] * H_k[j + 1];
+            H_k[j + 1] = -conj(sn[j]) * H_k[j] + cs[j] * H_k[j + 1];
+            H_k[j] = temp;
+          }
+
+          // New rotation eliminating H_k[k + 1].
+          double h1_abs = std::abs(H_k[k]);
+          double denominator = std::sqrt(h1_abs * h1_abs + h_norm * h_norm);
+          if (h1_abs == 0.)
+          {
+            cs[k] = Scalar(0);
+            sn[k] = Scalar(1);
+          }
+          else
+          {
+            cs[k] = h1_abs / denominator;
+            sn[k] = (H_k[k] / h1_abs) * h_norm / denominator;
+          }
+          H_k[k] = cs[k] * H_k[k] + sn[k] * H_k[k + 1];
+          H_k[k + 1] = Scalar(0);
+          g[k + 1] = -conj(sn[k]) * g[k];
+          g[k] = cs[k] * g[k];
+
+          k++;
+          this->num_iters++;
+          this->final_residual = std::abs(g[k]);
+          inner_converged = this->converged(this->final_residual, b_norm, initial_residual) || h_norm == 0.;
+        }
+
+        // Solve the upper triangular system H y = g.
+        for (int i = k - 1; i >= 0; i--)
+        {
+          y[i] = g[i];
+          for (int j = i + 1; j < k; j++)
+            y[i] -= H[j * (m + 1) + i] * y[j];
+          y[i] /= H[i * (m + 1) + i];
+        }
+
+        // x = x + M^{-1} V y
+        std::fill(w.begin(), w.end(), Scalar(0));
+        for (int j = 0; j < k; j++)
+          vector_axpy(size, y[j], &V[j * size], &w[0], this->num_threads);
+        this->precondition(&w[0], &z[0]);
+        vector_axpy(size, Scalar(1), &z[0], x, this->num_threads);
+
+        // The true residual for the restart.
+        this->spmv(x, &w[0]);
+        for (int i = 0; i < size; i++)
+          V[i] = this->rhs->v[i] - w[i];
+        beta = vector_norm(size, &V[0], this->num_threads);
+        this->final_residual = beta;
+        if (beta == 0.)
+          return true;
+      }
+    }
+
+    template class HERMES_API NativeIterativeLinearMatrixSolver < double > ;
+    template class HERMES_API NativeIterativeLinearMatrixSolver < std::complex<double> > ;
+  }
+}
@@ -18,6 +18,8 @@
 // Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
 
 #include "newton_matrix_solver.h"
+#include "util/memory_handling.h"
+#include "util/profiler.h"
 
 using namespace Hermes::Algebra;
 
@@ -45,6 +47,329 @@ namespace Hermes
       this->max_steps_with_reused_jacobian = 3;
 
       this->set_tolerance(1e-8, ResidualNormAbsolute);
+
+      this->jacobian_free = false;
+      this->jacobian_free_preconditioning = false;
+      this->forcing_term_max = 0.9;
+      this->forcing_term_gamma = 0.9;
+      this->forcing_term_alpha = 2.0;
+      this->jacobian_free_restart = 30;
+      this->jacobian_free_max_iters = 300;
+      this->forcing_term = -1.;
+      this->jfnk_residual = nullptr;
+      this->jfnk_perturbed_sln = nullptr;
+      this->jfnk_perturbed_residual = nullptr;
+      this->jfnk_step = nullptr;
+    }
+
+    template<typename Scalar>
+    void NewtonMatrixSolver<Scalar>::set_jacobian_free(bool to_set, bool precondition_by_jacobian)
+    {
+      this->jacobian_free = to_set;
+      this->jacobian_free_preconditioning = precondition_by_jacobian;
+      this->jacobian_reusable = false;
+    }
+
+    template<typename Scalar>
+    void NewtonMatrixSolver<Scalar>::set_forcing_term_parameters(double eta_max, double gamma, double alpha)
+    {
+      if (eta_max <= 0.0 || eta_max >= 1.0)
+        throw Exceptions::ValueException("eta_max", eta_max, 0.0, 1.0);
+      if (gamma <= 0.0 || gamma > 1.0)
+        throw Exceptions::ValueException("gamma", gamma, 0.0, 1.0);
+      if (alpha <= 1.0 || alpha > 2.0)
+        throw Exceptions::ValueException("alpha", alpha, 1.0, 2.0);
+      this->forcing_term_max = eta_max;
+      this->forcing_term_gamma = gamma;
+      this->forcing_term_alpha = alpha;
+    }
+
+    template<typename Scalar>
+    void NewtonMatrixSolver<Scalar>::set_jacobian_free_krylov_parameters(int restart, int max_iters)
+    {
+      if (restart < 1)
+        throw Exceptions::ValueException("restart", restart, 1);
+      if (max_iters < 1)
+        throw Exceptions::ValueException("max_iters", max_iters, 1);
+      this->jacobian_free_restart = restart;
+      this->jacobian_free_max_iters = max_iters;
+    }
+
+    template<typename Scalar>
+    void NewtonMatrixSolver<Scalar>::evaluate_residual(Scalar* coeff_vec, Vector<Scalar>* residual)
+    {
+      throw Exceptions::MethodNotOverridenException("NewtonMatrixSolver<Scalar>::evaluate_residual");
+    }
+
+    template<typename Scalar>
+    void NewtonMatrixSolver<Scalar>::init_solving(Scalar* coeff_vec)
+    {
+      NonlinearMatrixSolver<Scalar>::init_solving(coeff_vec);
+
+      this->forcing_term = -1.;
+      if (this->jacobian_free)
+      {
+        this->jfnk_residual = malloc_with_check<NewtonMatrixSolver<Scalar>, Scalar>(this->problem_size, this, true);
+        this->jfnk_perturbed_sln = malloc_with_check<NewtonMatrixSolver<Scalar>, Scalar>(this->problem_size, this, true);
+        this->jfnk_step = malloc_with_check<NewtonMatrixSolver<Scalar>, Scalar>(this->problem_size, this, true);
+        this->jfnk_perturbed_residual = create_vector<Scalar>();
+        this->jfnk_perturbed_residual->alloc(this->problem_size);
+      }
+    }
+
+    template<typename Scalar>
+    void NewtonMatrixSolver<Scalar>::deinit_solving()
+    {
+      free_with_check(this->jfnk_residual, true);
+      free_with_check(this->jfnk_perturbed_sln, true);
+      free_with_check(this->jfnk_step, true);
+      if (this->jfnk_perturbed_residual)
+      {
+        delete this->jfnk_perturbed_residual;
+        this->jfnk_perturbed_residual = nullptr;
+      }
+
+      NonlinearMatrixSolver<Scalar>::deinit_solving();
+    }
+
+    template<typename Scalar>
+    bool NewtonMatrixSolver<Scalar>::force_reuse_jacobian_values(unsigned int& successful_steps_with_reused_jacobian)
+    {
+      if (this->jacobian_free && !this->jacobian_free_preconditioning)
+        return false;
+      return NonlinearMatrixSolver<Scalar>::force_reuse_jacobian_values(successful_steps_with_reused_jacobian);
+    }
+
+    template<typename Scalar>
+    bool NewtonMatrixSolver<Scalar>::jacobian_reused_okay(unsigned int& successful_steps_with_reused_jacobian)
+    {
+      if (this->jacobian_free)
+        return true;
+      return NonlinearMatrixSolver<Scalar>::jacobian_reused_okay(successful_steps_with_reused_jacobian);
+    }
+
+    template<typename Scalar>
+    void NewtonMatrixSolver<Scalar>::solve_linear_system()
+    {
+      if (!this->jacobian_free)
+      {
+        NonlinearMatrixSolver<Scalar>::solve_linear_system();
+        return;
+      }
+
+      // store the previous solution to previous_sln_vector.
+      memcpy(this->previous_sln_vector, this->sln_vector, sizeof(Scalar)*this->problem_size);
+
+      {
+        HERMES_PROFILE_SCOPE("solve");
+        this->get_residual()->extract(this->jfnk_residual);
+        int iterations = this->solve_jacobian_free(this->jfnk_step);
+        // The preconditioner solves use the residual vector as the right hand side.
+        this->get_residual()->set_vector(this->jfnk_residual);
+        this->info("\t\tJacobian-free step: %i GMRES iterations, forcing term: %g.", iterations, this->forcing_term);
+      }
+
+      // 1. store the solution.
+      double solution_change_norm = this->update_solution_return_change_norm(this->jfnk_step);
+
+      // 2. store the solution change.
+      this->get_parameter_value(this->p_solution_change_norms).push_back(solution_change_norm);
+
+      // 3. store the solution norm.
+      this->get_parameter_value(this->p_solution_norms).push_back(get_l2_norm(this->sln_vector, this->problem_size));
+    }
+
+    template<typename Scalar>
+    double NewtonMatrixSolver<Scalar>::calculate_forcing_term()
+    {
+      std::vector<double>& residual_norms = this->get_parameter_value(this->p_residual_norms);
+      double residual_norm = residual_norms.back();
+
+      // The initial one.
+      if (this->forcing_term < 0. || residual_norms.size() < 2)
+        return std::min(0.5, this->forcing_term_max);
+
+      double previous_residual_norm = residual_norms[residual_norms.size() - 2];
+      double eta = this->forcing_term_gamma * std::pow(residual_norm / previous_residual_norm, this->forcing_term_alpha);
+
+      // Safeguard against a too sudden decrease.
+      double eta_safeguard = this->forcing_term_gamma * std::pow(this->forcing_term, this->forcing_term_alpha);
+      if (eta_safeguard > 0.1)
+        eta = std::max(eta, eta_safeguard);
+
+      // No oversolving below the absolute residual tolerance.
+      if (this->tolerance_set[3])
+        eta = std::max(eta, 0.5 * this->tolerance[3] / residual_norm);
+
+      return std::min(eta, this->forcing_term_max);
+    }
+
+    template<typename Scalar>
+    void NewtonMatrixSolver<Scalar>::apply_preconditioner(Scalar* r, Scalar* z)
+    {
+      if (!this->jacobian_free_preconditioning)
+      {
+        memcpy(z, r, this->problem_size * sizeof(Scalar));
+        return;
+      }
+
+      this->get_residual()->set_vector(r);
+      this->linear_matrix_solver->solve();
+      memcpy(z, this->linear_matrix_solver->get_sln_vector(), this->problem_size * sizeof(Scalar));
+
+      // The factorization (or preconditioner) is reused for the rest of the step.
+      this->linear_matrix_solver->set_reuse_scheme(HERMES_REUSE_MATRIX_STRUCTURE_COMPLETELY);
+    }
+
+    template<typename Scalar>
+    void NewtonMatrixSolver<Scalar>::jacobian_vector_product(Scalar* v, Scalar* y)
+    {
+      double v_norm = get_l2_norm(v, this->problem_size);
+      if (v_norm == 0.)
+      {
+        memset(y, 0, this->problem_size * sizeof(Scalar));
+        return;
+      }
+
+      // The usual step size balancing the truncation and the round-off errors.
+      double eps = std::sqrt(std::numeric_limits<double>::epsilon()) * (1. + this->jfnk_sln_norm) / v_norm;
+
+      for (int i = 0; i < this->problem_size; i++)
+        this->jfnk_perturbed_sln[i] = this->sln_vector[i] + eps * v[i];
+      this->evaluate_residual(this->jfnk_perturbed_sln, this->jfnk_perturbed_residual);
+
+      // J v ~ (F(u + eps v) - F(u)) / eps, jfnk_residual holds -F(u).
+      this->jfnk_perturbed_residual->extract(y);
+      for (int i = 0; i < this->problem_size; i++)
+        y[i] = (y[i] + this->jfnk_residual[i]) / eps;
+    }
+
+    template<typename Scalar>
+    int NewtonMatrixSolver<Scalar>::solve_jacobian_free(Scalar* step)
+    {
+      int size = this->problem_size;
+      int m = this->jacobian_free_restart;
+
+      this->forcing_term = this->calculate_forcing_term();
+      this->jfnk_sln_norm = get_l2_norm(this->sln_vector, size);
+
+      // Krylov basis, Hessenberg matrix (column-wise, m + 1 rows), Givens rotations, rhs of the least squares problem.
+      std::vector<Scalar> V((m + 1) * size), H((m + 1) * m), cs(m), sn(m), g(m + 1), y(m);
+      std::vector<Scalar> w(size), z(size);
+
+      // Zero initial guess, r = -F.
+      memset(step, 0, size * sizeof(Scalar));
+      memcpy(&V[0], this->jfnk_residual, size * sizeof(Scalar));
+      double beta = get_l2_norm(&V[0], size);
+      double target_residual = this->forcing_term * beta;
+      double residual = beta;
+
+      int iterations = 0;
+      while (residual > target_residual && iterations < this->jacobian_free_max_iters)
+      {
+        // V_0 = r / beta
+        for (int i = 0; i < size; i++)
+          V[i] /= beta;
+        std::fill(g.begin(), g.end(), Scalar(0));
+        g[0] = beta;
+
+        int k = 0;
+        bool inner_converged = false;
+        while (k < m && iterations < this->jacobian_free_max_iters && !inner_converged)
+        {
+          Scalar* V_k = &V[k * size];
+          Scalar* V_k1 = &V[(k + 1) * size];
+          Scalar* H_k = &H[k * (m + 1)];
+
+          // w = J M^{-1} V_k
+          this->apply_preconditioner(V_k, &z[0]);
+          this->jacobian_vector_product(&z[0], &w[0]);
+
+          // Modified Gram-Schmidt.
+          for (int j = 0; j <= k; j++)
+          {
+            Scalar* V_j = &V[j * size];
+            H_k[j] = Scalar(0);
+            for (int i = 0; i < size; i++)
+              H_k[j] += conj(V_j[i]) * w[i];
+            for (int i = 0; i < size; i++)
+              w[i] -= H_k[j] * V_j[i];
+          }
+          double h_norm = get_l2_norm(&w[0], size);
+          H_k[k + 1] = h_norm;
+          if (h_norm > 0.)
+          {
+            for (int i = 0; i < size; i++)
+              V_k1[i] = w[i] / h_norm;
+          }
+
+          // Apply the previous rotations.
+          for (int j = 0; j < k; j++)
+          {
+            Scalar temp = cs[j] * H_k[j] + sn[j] * H_k[j + 1];
+            H_k[j + 1] = -conj(sn[j]) * H_k[j] + cs[j] * H_k[j + 1];
+            H_k[j] = temp;
+          }
+
+          // New rotation eliminating H_k[k + 1].
+          double h1_abs = std::abs(H_k[k]);
+          double denominator = std::sqrt(h1_abs * h1_abs + h_norm * h_norm);
+          if (h1_abs == 0.)
+          {
+            cs[k] = Scalar(0);
+            sn[k] = Scalar(1);
+          }
+          else
+          {
+            cs[k] = h1_abs / denominator;
+            sn[k] = (H_k[k] / h1_abs) * h_norm / denominator;
+          }
+          H_k[k] = cs[k] * H_k[k] + sn[k] * H_k[k + 1];
+          H_k[k + 1] = Scalar(0);
+          g[k + 1] = -conj(sn[k]) * g[k];
+          g[k] = cs[k] * g[k];
+
+          k++;
+          iterations++;
+          residual = std::abs(g[k]);
+          inner_converged = residual <= target_residual || h_norm == 0.;
+        }
+
+        // Solve the upper triangular system H y = g.
+        for (int i = k - 1; i >= 0; i--)
+        {
+          y[i] = g[i];
+          for (int j = i + 1; j < k; j++)
+            y[i] -= H[j * (m + 1) + i] * y[j];
+          y[i] /= H[i * (m + 1) + i];
+        }
+
+        // step = step + M^{-1} V y
+        std::fill(w.begin(), w.end(), Scalar(0));
+        for (int j = 0; j < k; j++)
+        {
+          for (int i = 0; i < size; i++)
+            w[i] += y[j] * V[j * size + i];
+        }
+        this->apply_preconditioner(&w[0], &z[0]);
+        for (int i = 0; i < size; i++)
+          step[i] += z[i];
+
+        if (inner_converged)
+          break;
+
+        // The true residual for the restart.
+        this->jacobian_vector_product(step, &w[0]);
+        for (int i = 0; i < size; i++)
+          V[i] = this->jfnk_residual[i] - w[i];
+        beta = get_l2_norm(&V[0], size);
+        residual = beta;
+      }
+
+      if (residual > target_residual)
+        this->warn("\t\tJacobian-free step: GMRES did not reach the forcing term in %i iterations.", iterations);
+
+      return iterations;
     }
 
     template<typename Scalar>
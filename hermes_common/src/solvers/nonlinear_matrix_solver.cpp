@@ -22,6 +22,7 @@
 #include "solvers/nonlinear_matrix_solver.h"
 #include "common.h"
 #include "util/memory_handling.h"
+#include "util/profiler.h"
 
 using namespace Hermes::Algebra;
 
@@ -450,7 +451,10 @@ namespace Hermes
       memcpy(this->previous_sln_vector, this->sln_vector, sizeof(Scalar)*this->problem_size);
 
       // Solve, if the solver is iterative, give him the initial guess.
-      this->linear_matrix_solver->solve(this->use_initial_guess_for_iterative_solvers ? this->sln_vector : nullptr);
+      {
+        HERMES_PROFILE_SCOPE("solve");
+        this->linear_matrix_solver->solve(this->use_initial_guess_for_iterative_solvers ? this->sln_vector : nullptr);
+      }
 
       // 1. store the solution.
       double solution_change_norm = this->update_solution_return_change_norm(this->linear_matrix_solver->get_sln_vector());
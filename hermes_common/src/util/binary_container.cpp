@@ -0,0 +1,250 @@
+// This file is part of HermesCommon
+//
+// Copyright (c) 2009 hp-FEM group at the University of Nevada, Reno (UNR).
+// Email: hpfem-group@unr.edu, home page: http://www.hpfem.org/.
+//
+// Hermes2D is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published
+// by the Free Software Foundation; either version 2 of the License,
+// or (at your option) any later version.
+//
+// Hermes2D is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with Hermes2D; if not, write to the Free Software
+// Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+/*! \file binary_container.cpp
+    \brief Versioned little-endian binary container of named flat arrays, read through a memory mapping.
+    */
+#include "util/binary_container.h"
+#if defined(WIN32) || defined(_WINDOWS)
+#include <windows.h>
+#else
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <unistd.h>
+#endif
+
+namespace Hermes
+{
+  namespace BinaryIO
+  {
+    static const char binary_container_magic[8] = { 'H', 'E', 'R', 'M', 'E', 'S', 'B', 'C' };
+    static const unsigned int binary_container_byte_order_mark = 0x01020304;
+
+    /// The container stores the native representation, which has to be the little-endian one.
+    static bool is_little_endian()
+    {
+      unsigned int test = 1;
+      return *((unsigned char*)&test) == 1;
+    }
+
+    /// Offset rounded up to the alignment.
+    static unsigned long long align_offset(unsigned long long offset)
+    {
+      return (offset + HERMES_BINARY_CONTAINER_ALIGNMENT - 1) / HERMES_BINARY_CONTAINER_ALIGNMENT * HERMES_BINARY_CONTAINER_ALIGNMENT;
+    }
+
+    template<> BinaryArrayType binary_array_type<char>() { return BinaryArrayChar; }
+    template<> BinaryArrayType binary_array_type<int>() { return BinaryArrayInt; }
+    template<> BinaryArrayType binary_array_type<double>() { return BinaryArrayDouble; }
+    template<> BinaryArrayType binary_array_type<std::complex<double> >() { return BinaryArrayComplex; }
+
+    BinaryContainerWriter::BinaryContainerWriter()
+    {
+    }
+
+    BinaryContainerWriter::~BinaryContainerWriter()
+    {
+      for (unsigned int i = 0; i < this->items.size(); i++)
+        if (this->items[i].owned)
+        {
+          char* data = (char*)this->items[i].data;
+          free_with_check(data, true);
+        }
+    }
+
+    void BinaryContainerWriter::add_entry(const char* name, BinaryArrayType type, unsigned int element_size, unsigned long long count, const void* data, bool owned)
+    {
+      if (strlen(name) >= HERMES_BINARY_CONTAINER_NAME_LENGTH)
+      {
+        if (owned)
+        {
+          char* owned_data = (char*)data;
+          free_with_check(owned_data, true);
+        }
+        throw Exceptions::Exception("Array name %s too long for Hermes::BinaryIO::BinaryContainerWriter.", name);
+      }
+
+      Item item;
+      memset(&item.entry, 0, sizeof(BinaryContainerEntry));
+      strcpy(item.entry.name, name);
+      item.entry.type = type;
+      item.entry.element_size = element_size;
+      item.entry.count = count;
+      item.data = data;
+      item.owned = owned;
+      this->items.push_back(item);
+    }
+
+    void BinaryContainerWriter::write(const char* filename) const
+    {
+      if (!is_little_endian())
+        throw Exceptions::Exception("Hermes::BinaryIO::BinaryContainerWriter only supports little-endian platforms.");
+
+      BinaryContainerHeader header;
+      memset(&header, 0, sizeof(BinaryContainerHeader));
+      memcpy(header.magic, binary_container_magic, 8);
+      header.version = HERMES_BINARY_CONTAINER_VERSION;
+      header.byte_order_mark = binary_container_byte_order_mark;
+      header.array_count = this->items.size();
+
+      // Table of contents with the offsets.
+      std::vector<BinaryContainerEntry> entries(this->items.size());
+      unsigned long long offset = sizeof(BinaryContainerHeader) + this->items.size() * sizeof(BinaryContainerEntry);
+      for (unsigned int i = 0; i < this->items.size(); i++)
+      {
+        entries[i] = this->items[i].entry;
+        offset = align_offset(offset);
+        entries[i].offset = offset;
+        offset += entries[i].count * entries[i].element_size;
+      }
+
+      FILE* file = fopen(filename, "wb");
+      if (!file)
+        throw Exceptions::IOException(Exceptions::IOException::Write, filename);
+
+      // Every array is one write, only the padding goes through the stdio buffer.
+      static const char padding[HERMES_BINARY_CONTAINER_ALIGNMENT] = { 0 };
+      bool success = fwrite(&header, sizeof(BinaryContainerHeader), 1, file) == 1;
+      if (success && !entries.empty())
+        success = fwrite(&entries[0], sizeof(BinaryContainerEntry), entries.size(), file) == entries.size();
+      offset = sizeof(BinaryContainerHeader) + this->items.size() * sizeof(BinaryContainerEntry);
+      for (unsigned int i = 0; i < this->items.size() && success; i++)
+      {
+        size_t padding_size = entries[i].offset - offset;
+        if (padding_size > 0)
+          success = fwrite(padding, 1, padding_size, file) == padding_size;
+        size_t array_size = entries[i].count * entries[i].element_size;
+        if (success && array_size > 0)
+          success = fwrite(this->items[i].data, 1, array_size, file) == array_size;
+        offset = entries[i].offset + array_size;
+      }
+
+      if (fclose(file) != 0 || !success)
+        throw Exceptions::IOException(Exceptions::IOException::Write, filename);
+    }
+
+    BinaryContainer::BinaryContainer(const char* filename) : filename(filename), data(nullptr), size(0)
+    {
+      if (!is_little_endian())
+        throw Exceptions::Exception("Hermes::BinaryIO::BinaryContainer only supports little-endian platforms.");
+
+#if defined(WIN32) || defined(_WINDOWS)
+      this->mapping_handle = nullptr;
+      this->file_handle = CreateFileA(filename, GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING, FILE_FLAG_SEQUENTIAL_SCAN, nullptr);
+      if (this->file_handle == INVALID_HANDLE_VALUE)
+        throw Exceptions::IOException(Exceptions::IOException::Read, filename);
+      LARGE_INTEGER file_size;
+      GetFileSizeEx(this->file_handle, &file_size);
+      this->size = file_size.QuadPart;
+      if (this->size >= sizeof(BinaryContainerHeader))
+      {
+        this->mapping_handle = CreateFileMappingA(this->file_handle, nullptr, PAGE_WRITECOPY, 0, 0, nullptr);
+        if (this->mapping_handle)
+          this->data = (char*)MapViewOfFile(this->mapping_handle, FILE_MAP_COPY, 0, 0, 0);
+      }
+      if (!this->data)
+      {
+        if (this->mapping_handle)
+          CloseHandle(this->mapping_handle);
+        CloseHandle(this->file_handle);
+        throw Exceptions::IOException(Exceptions::IOException::Read, filename);
+      }
+#else
+      int file_descriptor = open(filename, O_RDONLY);
+      if (file_descriptor == -1)
+        throw Exceptions::IOException(Exceptions::IOException::Read, filename);
+      struct stat file_stat;
+      if (fstat(file_descriptor, &file_stat) == 0 && file_stat.st_size >= (off_t)sizeof(BinaryContainerHeader))
+      {
+        this->size = file_stat.st_size;
+        // Private (copy-on-write) mapping, so that the views may be modified in place.
+        void* mapping = mmap(nullptr, this->size, PROT_READ | PROT_WRITE, MAP_PRIVATE, file_descriptor, 0);
+        if (mapping != MAP_FAILED)
+          this->data = (char*)mapping;
+      }
+      // The mapping stays valid after closing the file.
+      close(file_descriptor);
+      if (!this->data)
+        throw Exceptions::IOException(Exceptions::IOException::Read, filename);
+#endif
+
+      try
+      {
+        BinaryContainerHeader* header = (BinaryContainerHeader*)this->data;
+        if (memcmp(header->magic, binary_container_magic, 8))
+          throw Exceptions::Exception("%s is not a Hermes binary container.", filename);
+        if (header->byte_order_mark != binary_container_byte_order_mark)
+          throw Exceptions::Exception("%s has a different byte order.", filename);
+        if (header->version != HERMES_BINARY_CONTAINER_VERSION)
+          throw Exceptions::Exception("%s has the container version %u, supported is %u.", filename, header->version, HERMES_BINARY_CONTAINER_VERSION);
+        if (header->array_count > (this->size - sizeof(BinaryContainerHeader)) / sizeof(BinaryContainerEntry))
+          throw Exceptions::Exception("%s is truncated.", filename);
+
+        BinaryContainerEntry* entries = (BinaryContainerEntry*)(this->data + sizeof(BinaryContainerHeader));
+        for (unsigned long long i = 0; i < header->array_count; i++)
+        {
+          BinaryContainerEntry* entry = entries + i;
+          entry->name[HERMES_BINARY_CONTAINER_NAME_LENGTH - 1] = '\0';
+          if (entry->offset > this->size || (entry->element_size > 0 && entry->count > (this->size - entry->offset) / entry->element_size))
+            throw Exceptions::Exception("%s is truncated (array %s).", filename, entry->name);
+          this->entries[entry->name] = entry;
+        }
+      }
+      catch (Exceptions::Exception&)
+      {
+#if defined(WIN32) || defined(_WINDOWS)
+        UnmapViewOfFile(this->data);
+        CloseHandle(this->mapping_handle);
+        CloseHandle(this->file_handle);
+#else
+        munmap(this->data, this->size);
+#endif
+        throw;
+      }
+    }
+
+    BinaryContainer::~BinaryContainer()
+    {
+#if defined(WIN32) || defined(_WINDOWS)
+      UnmapViewOfFile(this->data);
+      CloseHandle(this->mapping_handle);
+      CloseHandle(this->file_handle);
+#else
+      munmap(this->data, this->size);
+#endif
+    }
+
+    bool BinaryContainer::has_array(const char* name) const
+    {
+      return this->entries.find(name) != this->entries.end();
+    }
+
+    void* BinaryContainer::get_entry_data(const char* name, BinaryArrayType type, unsigned int element_size, unsigned long long& count) const
+    {
+      std::map<std::string, const BinaryContainerEntry*>::const_iterator it = this->entries.find(name);
+      if (it == this->entries.end())
+        throw Exceptions::Exception("Array %s not present in %s.", name, this->filename.c_str());
+      if (it->second->type != type || it->second->element_size != element_size)
+        throw Exceptions::Exception("Array %s in %s is of a different type.", name, this->filename.c_str());
+
+      count = it->second->count;
+      return this->data + it->second->offset;
+    }
+  }
+}
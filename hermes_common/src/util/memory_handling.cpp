@@ -26,4 +26,62 @@ namespace Hermes
   HERMES_COMMON_API pj_caching_pool HermesCommonMemoryPoolCache;
   HERMES_COMMON_API GlobalPoolCache hermesCommonGlobalPoolCache;
 #endif
+
+  /// Alignment of all the memory returned by MemoryArena.
+  static const size_t H_MEMORY_ARENA_ALIGNMENT = 16;
+
+  MemoryArena::MemoryArena(size_t block_size) : current_block(0), current_offset(0), block_size(block_size)
+  {
+  }
+
+  MemoryArena::~MemoryArena()
+  {
+    for (unsigned int i = 0; i < this->blocks.size(); i++)
+      ::free(this->blocks[i].data);
+  }
+
+  void* MemoryArena::allocate_bytes(size_t size)
+  {
+    if (size == 0)
+      return nullptr;
+
+    size = (size + H_MEMORY_ARENA_ALIGNMENT - 1) & ~(H_MEMORY_ARENA_ALIGNMENT - 1);
+
+    // Find the first (kept) block with enough space, the blocks are allocated on the first use.
+    while (this->current_block == this->blocks.size() || this->current_offset + size > this->blocks[this->current_block].size)
+    {
+      if (this->current_block < this->blocks.size())
+      {
+        this->current_block++;
+        this->current_offset = 0;
+      }
+      if (this->current_block == this->blocks.size())
+      {
+        Block block;
+        block.size = std::max(this->blocks.empty() ? this->block_size : 2 * this->blocks.back().size, size);
+        block.data = (char*)malloc(block.size);
+        if (!block.data)
+          throw Hermes::Exceptions::Exception("MemoryArena failed to allocate %i bytes.", (int)block.size);
+        this->blocks.push_back(block);
+      }
+    }
+
+    void* result = this->blocks[this->current_block].data + this->current_offset;
+    this->current_offset += size;
+    return result;
+  }
+
+  void MemoryArena::reset()
+  {
+    this->current_block = 0;
+    this->current_offset = 0;
+  }
+
+  size_t MemoryArena::get_capacity() const
+  {
+    size_t capacity = 0;
+    for (unsigned int i = 0; i < this->blocks.size(); i++)
+      capacity += this->blocks[i].size;
+    return capacity;
+  }
 }
\ No newline at end of file
@@ -0,0 +1,421 @@
+// This file is part of HermesCommon
+//
+// Copyright (c) 2009 hp-FEM group at the University of Nevada, Reno (UNR).
+// Email: hpfem-group@unr.edu, home page: http://www.hpfem.org/.
+//
+// Hermes2D is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published
+// by the Free Software Foundation; either version 2 of the License,
+// or (at your option) any later version.
+//
+// Hermes2D is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with Hermes2D; if not, write to the Free Software
+// Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+/*! \file profiler.cpp
+    \brief Hierarchical profiling of the phases of a computation (assembling, solving, adaptivity).
+    */
+#include "util/profiler.h"
+#include "exceptions.h"
+
+namespace Hermes
+{
+  namespace Profiling
+  {
+    /// Writes the string with the JSON escapes.
+    static void write_json_string(FILE* file, const char* str)
+    {
+      fputc('"', file);
+      for (; *str; str++)
+      {
+        if (*str == '"' || *str == '\\')
+          fputc('\\', file);
+        fputc(*str, file);
+      }
+      fputc('"', file);
+    }
+
+    Profiler::Phase::Phase(int name, int parent) : name(name), parent(parent)
+    {
+    }
+
+    Profiler::PhaseTime::PhaseTime() : calls(0), total_time(0.)
+    {
+    }
+
+    Profiler::ThreadRecord::ThreadRecord()
+    {
+      this->phase_stack.push_back(0);
+    }
+
+    Profiler::MergedPhase::MergedPhase() : calls(0), total_time(0.)
+    {
+    }
+
+    Profiler::Profiler() : enabled(true), max_trace_events(1000000)
+    {
+      for (int i = 0; i < HERMES_PROFILER_MAX_THREADS; i++)
+        this->thread_records[i] = nullptr;
+      this->reset();
+    }
+
+    Profiler::~Profiler()
+    {
+      for (int i = 0; i < HERMES_PROFILER_MAX_THREADS; i++)
+        delete this->thread_records[i];
+    }
+
+    void Profiler::set_enabled(bool to_set)
+    {
+      this->enabled = to_set;
+    }
+
+    bool Profiler::is_enabled() const
+    {
+      return this->enabled;
+    }
+
+    void Profiler::set_max_trace_events(unsigned int max_trace_events)
+    {
+      this->max_trace_events = max_trace_events;
+    }
+
+    double Profiler::get_time() const
+    {
+      return omp_get_wtime() - this->time_origin;
+    }
+
+    Profiler::ThreadRecord* Profiler::get_thread_record()
+    {
+      int thread_number = omp_get_thread_num();
+      if (thread_number >= HERMES_PROFILER_MAX_THREADS)
+        return nullptr;
+
+      if (!this->thread_records[thread_number])
+      {
+#pragma omp critical (HermesProfilerThreadRecords)
+        {
+          if (!this->thread_records[thread_number])
+            this->thread_records[thread_number] = new ThreadRecord();
+        }
+      }
+
+      return this->thread_records[thread_number];
+    }
+
+    int Profiler::get_name(ThreadRecord* record, const char* name)
+    {
+      // The address is only a lookup key, the string there may have changed since.
+      std::map<const char*, std::pair<int, std::string> >::iterator cached = record->name_cache.find(name);
+      if (cached != record->name_cache.end() && cached->second.second == name)
+        return cached->second.first;
+
+      int index;
+#pragma omp critical (HermesProfilerPhases)
+      {
+        std::map<std::string, int>::iterator it = this->name_indices.find(name);
+        if (it == this->name_indices.end())
+        {
+          index = this->names.size();
+          this->names.push_back(name);
+          this->name_indices.insert(std::pair<std::string, int>(name, index));
+        }
+        else
+          index = it->second;
+      }
+
+      record->name_cache[name] = std::pair<int, std::string>(index, name);
+      return index;
+    }
+
+    int Profiler::get_phase(ThreadRecord* record, int parent, int name)
+    {
+      std::pair<int, int> key(parent, name);
+      std::map<std::pair<int, int>, int>::iterator cached = record->phase_cache.find(key);
+      if (cached != record->phase_cache.end())
+        return cached->second;
+
+      int phase;
+#pragma omp critical (HermesProfilerPhases)
+      {
+        std::map<int, int>::iterator child = this->phases[parent].children.find(name);
+        if (child == this->phases[parent].children.end())
+        {
+          phase = this->phases.size();
+          this->phases[parent].children.insert(std::pair<int, int>(name, phase));
+          this->phases.push_back(Phase(name, parent));
+        }
+        else
+          phase = child->second;
+      }
+
+      record->phase_cache.insert(std::pair<std::pair<int, int>, int>(key, phase));
+      return phase;
+    }
+
+    void Profiler::begin(const char* name)
+    {
+      if (!this->enabled)
+        return;
+      ThreadRecord* record = this->get_thread_record();
+      if (!record)
+        return;
+
+      int name_index = this->get_name(record, name);
+      int phase = this->get_phase(record, record->phase_stack.back(), name_index);
+
+      double time = this->get_time();
+      record->phase_stack.push_back(phase);
+      record->start_stack.push_back(time);
+
+      if (record->events.size() < this->max_trace_events)
+      {
+        Event event = { name_index, time, 0. };
+        record->event_stack.push_back(record->events.size());
+        record->events.push_back(event);
+      }
+      else
+        record->event_stack.push_back(-1);
+    }
+
+    void Profiler::end()
+    {
+      if (!this->enabled)
+        return;
+      ThreadRecord* record = this->get_thread_record();
+      if (!record || record->start_stack.empty())
+        return;
+
+      double duration = this->get_time() - record->start_stack.back();
+
+      unsigned int phase = record->phase_stack.back();
+      if (phase >= record->phase_times.size())
+        record->phase_times.resize(phase + 1);
+      record->phase_times[phase].calls++;
+      record->phase_times[phase].total_time += duration;
+
+      if (record->event_stack.back() != -1)
+        record->events[record->event_stack.back()].duration = duration;
+
+      record->phase_stack.pop_back();
+      record->start_stack.pop_back();
+      record->event_stack.pop_back();
+    }
+
+    int Profiler::get_current_phase()
+    {
+      if (!this->enabled)
+        return 0;
+      ThreadRecord* record = this->get_thread_record();
+      if (!record)
+        return 0;
+
+      return record->phase_stack.back();
+    }
+
+    void Profiler::enter_parallel_region(int parent)
+    {
+      if (!this->enabled)
+        return;
+      ThreadRecord* record = this->get_thread_record();
+      if (!record)
+        return;
+
+      record->phase_stack.push_back(parent);
+    }
+
+    void Profiler::leave_parallel_region()
+    {
+      if (!this->enabled)
+        return;
+      ThreadRecord* record = this->get_thread_record();
+      if (!record || record->phase_stack.size() < 2)
+        return;
+
+      record->phase_stack.pop_back();
+    }
+
+    void Profiler::count(const char* name, unsigned long long amount)
+    {
+      if (!this->enabled)
+        return;
+      ThreadRecord* record = this->get_thread_record();
+      if (!record)
+        return;
+
+      record->counters[this->get_name(record, name)] += amount;
+    }
+
+    void Profiler::reset()
+    {
+#pragma omp critical (HermesProfilerThreadRecords)
+      {
+        for (int i = 0; i < HERMES_PROFILER_MAX_THREADS; i++)
+        {
+          delete this->thread_records[i];
+          this->thread_records[i] = nullptr;
+        }
+      }
+#pragma omp critical (HermesProfilerPhases)
+      {
+        this->names.clear();
+        this->name_indices.clear();
+        this->phases.clear();
+        this->names.push_back("root");
+        this->name_indices.insert(std::pair<std::string, int>("root", 0));
+        this->phases.push_back(Phase(0, -1));
+      }
+      this->time_origin = omp_get_wtime();
+    }
+
+    void Profiler::merge_phase(int phase, MergedPhase& merged) const
+    {
+      for (std::map<int, int>::const_iterator child = this->phases[phase].children.begin(); child != this->phases[phase].children.end(); child++)
+      {
+        MergedPhase& merged_child = merged.children[this->names[child->first]];
+        for (int i = 0; i < HERMES_PROFILER_MAX_THREADS; i++)
+        {
+          if (!this->thread_records[i] || child->second >= (int)this->thread_records[i]->phase_times.size())
+            continue;
+          merged_child.calls += this->thread_records[i]->phase_times[child->second].calls;
+          merged_child.total_time += this->thread_records[i]->phase_times[child->second].total_time;
+        }
+        this->merge_phase(child->second, merged_child);
+      }
+    }
+
+    void Profiler::write_phases_json(FILE* file, const MergedPhase& merged, int indent)
+    {
+      fprintf(file, "[");
+      bool first = true;
+      for (std::map<std::string, MergedPhase>::const_iterator child = merged.children.begin(); child != merged.children.end(); child++)
+      {
+        double children_time = 0.;
+        for (std::map<std::string, MergedPhase>::const_iterator grandchild = child->second.children.begin(); grandchild != child->second.children.end(); grandchild++)
+          children_time += grandchild->second.total_time;
+
+        fprintf(file, "%s\n%*s{ \"name\": ", first ? "" : ",", indent + 2, "");
+        write_json_string(file, child->first.c_str());
+        fprintf(file, ", \"calls\": %llu, \"total_time\": %.9g, \"self_time\": %.9g, \"children\": ", child->second.calls, child->second.total_time, std::max(0., child->second.total_time - children_time));
+        write_phases_json(file, child->second, indent + 2);
+        fprintf(file, " }");
+        first = false;
+      }
+      if (first)
+        fprintf(file, "]");
+      else
+        fprintf(file, "\n%*s]", indent, "");
+    }
+
+    void Profiler::export_json(const char* filename) const
+    {
+      FILE* file = fopen(filename, "w");
+      if (!file)
+        throw Exceptions::IOException(Exceptions::IOException::Write, filename);
+
+      MergedPhase root;
+      std::map<std::string, unsigned long long> counters;
+      int num_threads = 0;
+      for (int i = 0; i < HERMES_PROFILER_MAX_THREADS; i++)
+      {
+        if (!this->thread_records[i])
+          continue;
+        num_threads++;
+        for (std::map<int, unsigned long long>::const_iterator counter = this->thread_records[i]->counters.begin(); counter != this->thread_records[i]->counters.end(); counter++)
+          counters[this->names[counter->first]] += counter->second;
+      }
+      this->merge_phase(0, root);
+
+      fprintf(file, "{\n  \"threads\": %i,\n  \"wall_time\": %.9g,\n  \"phases\": ", num_threads, this->get_time());
+      write_phases_json(file, root, 2);
+      fprintf(file, ",\n  \"counters\": {");
+      bool first = true;
+      for (std::map<std::string, unsigned long long>::const_iterator counter = counters.begin(); counter != counters.end(); counter++)
+      {
+        fprintf(file, "%s\n    ", first ? "" : ",");
+        write_json_string(file, counter->first.c_str());
+        fprintf(file, ": %llu", counter->second);
+        first = false;
+      }
+      fprintf(file, first ? "}\n}\n" : "\n  }\n}\n");
+
+      fclose(file);
+    }
+
+    void Profiler::export_chrome_trace(const char* filename) const
+    {
+      FILE* file = fopen(filename, "w");
+      if (!file)
+        throw Exceptions::IOException(Exceptions::IOException::Write, filename);
+
+      fprintf(file, "{\n  \"displayTimeUnit\": \"ms\",\n  \"traceEvents\": [");
+      bool first = true;
+      std::map<std::string, unsigned long long> counters;
+      for (int i = 0; i < HERMES_PROFILER_MAX_THREADS; i++)
+      {
+        if (!this->thread_records[i])
+          continue;
+
+        const ThreadRecord* record = this->thread_records[i];
+        for (unsigned int event_i = 0; event_i < record->events.size(); event_i++)
+        {
+          fprintf(file, "%s\n    { \"name\": ", first ? "" : ",");
+          write_json_string(file, this->names[record->events[event_i].name].c_str());
+          fprintf(file, ", \"cat\": \"hermes\", \"ph\": \"X\", \"pid\": 0, \"tid\": %i, \"ts\": %.3f, \"dur\": %.3f }", i, record->events[event_i].start * 1e6, record->events[event_i].duration * 1e6);
+          first = false;
+        }
+
+        for (std::map<int, unsigned long long>::const_iterator counter = record->counters.begin(); counter != record->counters.end(); counter++)
+          counters[this->names[counter->first]] += counter->second;
+      }
+
+      // Counters as one counter event at the end.
+      if (!counters.empty())
+      {
+        fprintf(file, "%s\n    { \"name\": \"counters\", \"ph\": \"C\", \"pid\": 0, \"tid\": 0, \"ts\": %.3f, \"args\": {", first ? "" : ",", this->get_time() * 1e6);
+        for (std::map<std::string, unsigned long long>::const_iterator counter = counters.begin(); counter != counters.end(); counter++)
+        {
+          fprintf(file, "%s ", counter == counters.begin() ? "" : ",");
+          write_json_string(file, counter->first.c_str());
+          fprintf(file, ": %llu", counter->second);
+        }
+        fprintf(file, " } }");
+        first = false;
+      }
+
+      fprintf(file, first ? "]\n}\n" : "\n  ]\n}\n");
+
+      fclose(file);
+    }
+
+    ProfilerScope::ProfilerScope(const char* name)
+    {
+      HermesProfiler.begin(name);
+    }
+
+    ProfilerScope::~ProfilerScope()
+    {
+      HermesProfiler.end();
+    }
+
+    ProfilerParallelRegion::ProfilerParallelRegion(int parent)
+    {
+      HermesProfiler.enter_parallel_region(parent);
+    }
+
+    ProfilerParallelRegion::~ProfilerParallelRegion()
+    {
+      HermesProfiler.leave_parallel_region();
+    }
+  }
+
+#if defined(WIN32) || defined(_WINDOWS)
+  __declspec(dllexport) Hermes::Profiling::Profiler HermesProfiler;
+#else
+  Hermes::Profiling::Profiler HermesProfiler;
+#endif
+}